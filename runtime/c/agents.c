@@ -78,10 +78,64 @@ static uint32_t str_hash(const char* str) {
  * AGENT REGISTRY CREATION
  * ============================================================================= */
 
+/*
+ * Directory pages needed to cover agent IDs 1..ids
+ */
+static uint32_t registry_pages_for(uint32_t ids) {
+    return (uint32_t)(((uint64_t)ids + REGISTRY_PAGE_SIZE - 1) >> REGISTRY_PAGE_SHIFT);
+}
+
+/*
+ * Page holding an agent ID; with `create`, allocates it (growing the
+ * directory by doubling) if needed
+ *
+ * @return: Page, or NULL if absent (or allocation failed)
+ */
+static RegistryPage* registry_page(AgentRegistry2* registry, uint32_t agent_id, int create) {
+    uint32_t page = (agent_id - 1) >> REGISTRY_PAGE_SHIFT;
+
+    if (page >= registry->page_count) {
+        if (!create) {
+            return NULL;
+        }
+        uint32_t page_count = registry->page_count ? registry->page_count : 1;
+        while (page_count <= page) {
+            page_count *= 2;
+        }
+        RegistryPage** pages = heap_allocate((size_t)page_count * sizeof(RegistryPage*));
+        if (pages == NULL) {
+            return NULL;
+        }
+        if (registry->pages != NULL) {
+            memcpy(pages, registry->pages, (size_t)registry->page_count * sizeof(RegistryPage*));
+            heap_free(registry->pages, (size_t)registry->page_count * sizeof(RegistryPage*));
+        }
+        registry->pages = pages;
+        registry->page_count = page_count;
+        uint64_t ids = (uint64_t)page_count << REGISTRY_PAGE_SHIFT;
+        registry->capacity = (ids > UINT32_MAX) ? UINT32_MAX : (uint32_t)ids;
+    }
+
+    if (registry->pages[page] == NULL && create) {
+        registry->pages[page] = heap_allocate(sizeof(RegistryPage));
+    }
+    return registry->pages[page];
+}
+
+/* Slot of an agent ID within its page */
+static inline uint32_t registry_page_slot(uint32_t agent_id) {
+    return (agent_id - 1) & (REGISTRY_PAGE_SIZE - 1);
+}
+
+/* Is a page slot registered */
+static inline int registry_slot_active(const RegistryPage* page, uint32_t slot) {
+    return (page->active[slot / 64] >> (slot % 64)) & 1;
+}
+
 /*
  * Create a new agent registry
  *
- * @param capacity: Maximum number of agents
+ * @param capacity: Expected highest agent ID (sizes the directory; it grows)
  * @return: Pointer to registry, or NULL on failure
  */
 AgentRegistry2* registry_create(uint32_t capacity) {
@@ -95,26 +149,19 @@ AgentRegistry2* registry_create(uint32_t capacity) {
         return NULL;
     }
 
-    /* Allocate agent info array */
-    registry->agents = heap_allocate(capacity * sizeof(AgentInfo));
-    if (registry->agents == NULL) {
-        heap_free(registry, sizeof(AgentRegistry2));
-        return NULL;
-    }
-    memset(registry->agents, 0, capacity * sizeof(AgentInfo));
-
-    /* Allocate name lookup table */
-    registry->agent_names = heap_allocate(capacity * sizeof(char*));
-    if (registry->agent_names == NULL) {
-        heap_free(registry->agents, capacity * sizeof(AgentInfo));
+    /* Allocate the directory; pages come with their first agent */
+    registry->page_count = registry_pages_for(capacity);
+    registry->pages = heap_allocate((size_t)registry->page_count * sizeof(RegistryPage*));
+    if (registry->pages == NULL) {
         heap_free(registry, sizeof(AgentRegistry2));
         return NULL;
     }
-    memset(registry->agent_names, 0, capacity * sizeof(char*));
 
     /* Initialize fields */
+    uint64_t ids = (uint64_t)registry->page_count << REGISTRY_PAGE_SHIFT;
+    registry->capacity = (ids > UINT32_MAX) ? UINT32_MAX : (uint32_t)ids;
     registry->agent_count = 0;
-    registry->capacity = capacity;
+    registry->active_count = 0;
     registry->name_to_id = NULL;  /* Optional - can add later for faster lookup */
     registry->name_table_size = 0;
     registry->routing = NULL;
@@ -133,46 +180,64 @@ void registry_destroy(AgentRegistry2* registry) {
     }
 
     /* Free each agent's resources */
-    for (uint32_t i = 0; i < registry->capacity; i++) {
-        AgentInfo* agent = &registry->agents[i];
-
-        if (agent->flags & AGENT_FLAG_ACTIVE) {
-            /* Free agent name */
-            if (agent->name != NULL) {
-                size_t len = 0;
-                while (agent->name[len]) len++;
-                heap_free((void*)agent->name, len + 1);
-            }
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        /* Free agent name */
+        if (agent->name != NULL) {
+            size_t len = 0;
+            while (agent->name[len]) len++;
+            heap_free((void*)agent->name, len + 1);
+        }
 
-            /* Free agent state */
-            if (agent->state != NULL && agent->state_size > 0) {
-                heap_free(agent->state, agent->state_size);
-            }
+        /* Free agent state (slab states go with their slab) */
+        if (!(agent->flags & AGENT_FLAG_SLAB_STATE)) {
+            agent_state_free(agent->state, agent->state_size);
+        }
 
-            /* Destroy queue */
-            if (agent->queue != NULL) {
-                signal_queue_destroy(agent->queue);
-            }
+        /* Destroy queue */
+        if (agent->queue != NULL) {
+            signal_queue_destroy(agent->queue);
+        }
 
-            /* Destroy dispatch table */
-            if (agent->dispatch != NULL) {
-                dispatch_table_destroy(agent->dispatch);
-            }
+        /* Destroy dispatch table (replicas share their primary's, typed
+         * agents their type's) */
+        if (agent->dispatch != NULL &&
+            !(agent->flags & (AGENT_FLAG_REPLICA | AGENT_FLAG_TYPE_DISPATCH))) {
+            dispatch_table_destroy(agent->dispatch);
+        }
+    }
+
+    /* Free agent types and their shared tables */
+    for (uint32_t i = 0; i < registry->type_count; i++) {
+        AgentTypeDef* type = &registry->types[i];
+        if (type->name != NULL) {
+            heap_free((void*)type->name, strlen(type->name) + 1);
+        }
+        if (type->initial_state != NULL) {
+            heap_free((void*)type->initial_state, type->state_size);
         }
+        dispatch_table_destroy(type->dispatch);
     }
+    heap_free(registry->types, registry->type_count * sizeof(AgentTypeDef));
 
     /* Free routing table */
     if (registry->routing != NULL) {
         routing_table_destroy(registry->routing);
     }
 
-    /* Free name lookup table */
-    if (registry->agent_names != NULL) {
-        heap_free(registry->agent_names, registry->capacity * sizeof(char*));
+    heap_free(registry->replicas, registry->replica_count * sizeof(ReplicaDef));
+
+    for (uint32_t i = 0; i < registry->slab_count; i++) {
+        AgentStateSlab* slab = &registry->slabs[i];
+        heap_free_aligned(slab->base, (size_t)slab->capacity * slab->stride, AGENT_STATE_ALIGN);
     }
+    heap_free(registry->slabs, registry->slab_count * sizeof(AgentStateSlab));
 
-    /* Free agents array */
-    heap_free(registry->agents, registry->capacity * sizeof(AgentInfo));
+    /* Free directory pages, then the directory */
+    for (uint32_t i = 0; i < registry->page_count; i++) {
+        heap_free(registry->pages[i], sizeof(RegistryPage));
+    }
+    heap_free(registry->pages, (size_t)registry->page_count * sizeof(RegistryPage*));
 
     /* Free registry struct */
     heap_free(registry, sizeof(AgentRegistry2));
@@ -192,13 +257,17 @@ int registry_register(AgentRegistry2* registry, uint32_t agent_id,
         return TOPOLOGY_ERR_NULL_POINTER;
     }
 
-    if (agent_id == 0 || agent_id > registry->capacity) {
+    if (agent_id == 0) {
         return TOPOLOGY_ERR_CAPACITY;
     }
 
     /* Check if agent already exists */
-    AgentInfo* agent = &registry->agents[agent_id - 1];  /* 1-indexed to 0-indexed */
-    if (agent->flags & AGENT_FLAG_ACTIVE) {
+    RegistryPage* page = registry_page(registry, agent_id, 1);
+    if (page == NULL) {
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+    uint32_t slot = registry_page_slot(agent_id);
+    if (registry_slot_active(page, slot)) {
         return TOPOLOGY_ERR_AGENT_EXISTS;
     }
 
@@ -208,7 +277,14 @@ int registry_register(AgentRegistry2* registry, uint32_t agent_id,
         return TOPOLOGY_ERR_ALLOC_FAILED;
     }
 
+    /* Hot pointers */
+    page->queues[slot] = queue;
+    page->dispatch[slot] = dispatch;
+    page->states[slot] = state;
+    page->active[slot / 64] |= (uint64_t)1 << (slot % 64);
+
     /* Fill in agent info */
+    AgentInfo* agent = &page->info[slot];
     agent->agent_id = agent_id;
     agent->agent_type = 0;
     agent->name = name_copy;
@@ -224,16 +300,12 @@ int registry_register(AgentRegistry2* registry, uint32_t agent_id,
         agent->flags |= AGENT_FLAG_INITIALIZED;
     }
 
-    if (dispatch != NULL) {
+    if (dispatch_get_handler_count(dispatch) > 0) {
         agent->flags |= AGENT_FLAG_HAS_HANDLERS;
     }
 
-    /* Update name lookup table */
-    if (agent_id <= registry->capacity && registry->agent_names != NULL) {
-        registry->agent_names[agent_id - 1] = agent->name;
-    }
-
     /* Update count */
+    registry->active_count++;
     if (agent_id > registry->agent_count) {
         registry->agent_count = agent_id;
     }
@@ -245,20 +317,64 @@ int registry_register(AgentRegistry2* registry, uint32_t agent_id,
  * AGENT LOOKUP
  * ============================================================================= */
 
+/*
+ * Page of a registered agent, or NULL
+ */
+static inline RegistryPage* registry_active_page(AgentRegistry2* registry, uint32_t agent_id) {
+    if (registry == NULL || agent_id == 0) {
+        return NULL;
+    }
+    RegistryPage* page = registry_page(registry, agent_id, 0);
+    if (page == NULL || !registry_slot_active(page, registry_page_slot(agent_id))) {
+        return NULL;
+    }
+    return page;
+}
+
 /*
  * Get agent info by ID
  */
 AgentInfo* registry_get_agent(AgentRegistry2* registry, uint32_t agent_id) {
-    if (registry == NULL || agent_id == 0 || agent_id > registry->capacity) {
-        return NULL;
+    RegistryPage* page = registry_active_page(registry, agent_id);
+    return (page != NULL) ? &page->info[registry_page_slot(agent_id)] : NULL;
+}
+
+/*
+ * Next registered agent ID after `after` (0 starts), in ID order
+ */
+uint32_t registry_next_id(AgentRegistry2* registry, uint32_t after) {
+    if (registry == NULL) {
+        return 0;
     }
 
-    AgentInfo* agent = &registry->agents[agent_id - 1];
-    if (!(agent->flags & AGENT_FLAG_ACTIVE)) {
-        return NULL;
+    /* Scan the pages' registered bitmaps: 128 bytes per 1024 IDs */
+    uint64_t id = (uint64_t)after + 1;
+    while (id <= registry->agent_count) {
+        uint32_t p = (uint32_t)((id - 1) >> REGISTRY_PAGE_SHIFT);
+        RegistryPage* page = registry->pages[p];
+        if (page != NULL) {
+            for (uint32_t slot = (uint32_t)(id - 1) & (REGISTRY_PAGE_SIZE - 1);
+                 slot < REGISTRY_PAGE_SIZE; slot = (slot | 63) + 1) {
+                uint64_t bits = page->active[slot / 64] & (~(uint64_t)0 << (slot % 64));
+                if (bits != 0) {
+                    return (p << REGISTRY_PAGE_SHIFT) + (slot & ~63u) +
+                           (uint32_t)__builtin_ctzll(bits) + 1;
+                }
+            }
+        }
+        id = ((uint64_t)(p + 1) << REGISTRY_PAGE_SHIFT) + 1;     /* Next page */
     }
 
-    return agent;
+    return 0;
+}
+
+/*
+ * Next registered agent in ID order
+ */
+AgentInfo* registry_next(AgentRegistry2* registry, AgentInfo* prev) {
+    uint32_t id = registry_next_id(registry, (prev != NULL) ? prev->agent_id : 0);
+    return (id != 0) ? &registry->pages[(id - 1) >> REGISTRY_PAGE_SHIFT]->info[registry_page_slot(id)]
+                     : NULL;
 }
 
 /*
@@ -270,9 +386,9 @@ AgentInfo* registry_get_agent_by_name(AgentRegistry2* registry, const char* name
     }
 
     /* Linear search through agents */
-    for (uint32_t i = 0; i < registry->capacity; i++) {
-        AgentInfo* agent = &registry->agents[i];
-        if ((agent->flags & AGENT_FLAG_ACTIVE) && str_equal(agent->name, name)) {
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        if (str_equal(agent->name, name)) {
             return agent;
         }
     }
@@ -284,23 +400,122 @@ AgentInfo* registry_get_agent_by_name(AgentRegistry2* registry, const char* name
  * Get agent's signal queue
  */
 SignalQueue* registry_get_queue(AgentRegistry2* registry, uint32_t agent_id) {
-    AgentInfo* agent = registry_get_agent(registry, agent_id);
-    return (agent != NULL) ? agent->queue : NULL;
+    RegistryPage* page = registry_active_page(registry, agent_id);
+    return (page != NULL) ? page->queues[registry_page_slot(agent_id)] : NULL;
 }
 
 /*
  * Get agent's dispatch table
  */
 DispatchTable* registry_get_dispatch(AgentRegistry2* registry, uint32_t agent_id) {
-    AgentInfo* agent = registry_get_agent(registry, agent_id);
-    return (agent != NULL) ? agent->dispatch : NULL;
+    RegistryPage* page = registry_active_page(registry, agent_id);
+    return (page != NULL) ? page->dispatch[registry_page_slot(agent_id)] : NULL;
+}
+
+/*
+ * Drain an agent's queue through its dispatch table, as that agent
+ */
+int registry_process_agent(AgentRegistry2* registry, uint32_t agent_id,
+                           uint32_t max_signals, uint32_t* errors) {
+    if (errors != NULL) {
+        *errors = 0;
+    }
+
+    RegistryPage* page = registry_active_page(registry, agent_id);
+    uint32_t slot = registry_page_slot(agent_id);
+    if (page == NULL || page->queues[slot] == NULL || page->dispatch[slot] == NULL) {
+        return 0;
+    }
+
+    return dispatch_process_batch_for_agent(page->dispatch[slot], agent_id,
+                                            page->states[slot], page->queues[slot],
+                                            max_signals, errors);
+}
+
+/*
+ * Build a dormant agent's state, queue and table (materialize_lock held)
+ */
+static int registry_materialize_locked(AgentRegistry2* registry, RegistryPage* page,
+                                       uint32_t slot, AgentInfo* agent) {
+    AgentTypeDef* type = registry_get_type(registry, agent->agent_type);
+
+    void* state = agent_state_alloc(agent->state_size);
+    if (agent->state_size > 0 && state == NULL) {
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+    if (state != NULL && type != NULL && type->initial_state != NULL) {
+        memcpy(state, type->initial_state,
+               (type->state_size < agent->state_size) ? type->state_size : agent->state_size);
+    }
+
+    SignalQueue* queue = signal_queue_create(agent->queue_capacity);
+    if (queue == NULL) {
+        agent_state_free(state, agent->state_size);
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+
+    DispatchTable* dispatch;
+    if (type != NULL) {
+        dispatch = type->dispatch;
+        agent->flags |= AGENT_FLAG_TYPE_DISPATCH;
+    } else {
+        dispatch = dispatch_table_create(16, agent->agent_id);
+        if (dispatch == NULL) {
+            signal_queue_destroy(queue);
+            agent_state_free(state, agent->state_size);
+            return TOPOLOGY_ERR_ALLOC_FAILED;
+        }
+        dispatch_set_state(dispatch, state);
+    }
+
+    page->states[slot] = state;
+    page->dispatch[slot] = dispatch;
+    agent->state = state;
+    agent->queue = queue;
+    agent->dispatch = dispatch;
+    agent->flags = (agent->flags & ~AGENT_FLAG_DORMANT) |
+                   (dispatch_get_handler_count(dispatch) > 0 ? AGENT_FLAG_HAS_HANDLERS : 0) |
+                   (state != NULL ? AGENT_FLAG_INITIALIZED : 0);
+    registry->dormant_count--;
+
+    /* Publish last: a non-NULL queue means the rest is in place */
+    __atomic_store_n(&page->queues[slot], queue, __ATOMIC_RELEASE);
+    return TOPOLOGY_OK;
+}
+
+/*
+ * Give a dormant agent its state, queue and dispatch table
+ */
+int registry_materialize(AgentRegistry2* registry, uint32_t agent_id) {
+    if (registry == NULL) {
+        return TOPOLOGY_ERR_NULL_POINTER;
+    }
+
+    RegistryPage* page = registry_active_page(registry, agent_id);
+    if (page == NULL) {
+        return TOPOLOGY_ERR_AGENT_NOT_FOUND;
+    }
+    uint32_t slot = registry_page_slot(agent_id);
+
+    /* Materialized (or registered with a queue) already */
+    if (__atomic_load_n(&page->queues[slot], __ATOMIC_ACQUIRE) != NULL) {
+        return TOPOLOGY_OK;
+    }
+
+    int result = TOPOLOGY_OK;
+    runtime_spin_lock(&registry->materialize_lock);
+    if (page->info[slot].flags & AGENT_FLAG_DORMANT) {
+        result = registry_materialize_locked(registry, page, slot, &page->info[slot]);
+    }
+    runtime_spin_unlock(&registry->materialize_lock);
+    return result;
 }
 
 /*
  * Get number of registered agents
  */
 uint32_t registry_get_count(AgentRegistry2* registry) {
-    return (registry != NULL) ? registry->agent_count : 0;
+    return (registry != NULL) ? registry->active_count : 0;
 }
 
 /*
@@ -311,6 +526,85 @@ const char* registry_get_name(AgentRegistry2* registry, uint32_t agent_id) {
     return (agent != NULL) ? agent->name : NULL;
 }
 
+/* =============================================================================
+ * AGENT TYPES
+ * ============================================================================= */
+
+/*
+ * Define an agent type
+ */
+int registry_define_type(AgentRegistry2* registry, const AgentTypeDef* def) {
+    if (registry == NULL || def == NULL) {
+        return TOPOLOGY_ERR_NULL_POINTER;
+    }
+    if (registry_get_type(registry, def->agent_type) != NULL) {
+        return TOPOLOGY_ERR_TYPE_EXISTS;
+    }
+
+    AgentTypeDef* types = heap_allocate((registry->type_count + 1) * sizeof(AgentTypeDef));
+    if (types == NULL) {
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+
+    AgentTypeDef* type = &types[registry->type_count];
+    *type = *def;
+    type->instance_count = 0;
+    type->name = str_copy(def->name);
+    if (def->name != NULL && type->name == NULL) {
+        heap_free(types, (registry->type_count + 1) * sizeof(AgentTypeDef));
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+
+    /* The state template is copied too, so the caller's may go away */
+    type->initial_state = NULL;
+    if (def->initial_state != NULL && def->state_size > 0) {
+        void* template = heap_allocate(def->state_size);
+        if (template == NULL) {
+            heap_free((void*)type->name, type->name ? strlen(type->name) + 1 : 0);
+            heap_free(types, (registry->type_count + 1) * sizeof(AgentTypeDef));
+            return TOPOLOGY_ERR_ALLOC_FAILED;
+        }
+        memcpy(template, def->initial_state, def->state_size);
+        type->initial_state = template;
+    }
+
+    if (type->dispatch == NULL) {
+        type->dispatch = dispatch_table_create(16, 0);
+        if (type->dispatch == NULL) {
+            heap_free((void*)type->initial_state,
+                      type->initial_state ? type->state_size : 0);
+            heap_free((void*)type->name, type->name ? strlen(type->name) + 1 : 0);
+            heap_free(types, (registry->type_count + 1) * sizeof(AgentTypeDef));
+            return TOPOLOGY_ERR_ALLOC_FAILED;
+        }
+    }
+    /* Calls that don't name the running instance profile as "shared" */
+    type->dispatch->agent_id = DISPATCH_AGENT_SHARED;
+
+    if (registry->types != NULL) {
+        memcpy(types, registry->types, registry->type_count * sizeof(AgentTypeDef));
+        heap_free(registry->types, registry->type_count * sizeof(AgentTypeDef));
+    }
+    registry->types = types;
+    registry->type_count++;
+    return TOPOLOGY_OK;
+}
+
+/*
+ * Get a defined agent type
+ */
+AgentTypeDef* registry_get_type(AgentRegistry2* registry, uint32_t agent_type) {
+    if (registry == NULL) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < registry->type_count; i++) {
+        if (registry->types[i].agent_type == agent_type) {
+            return &registry->types[i];
+        }
+    }
+    return NULL;
+}
+
 /* =============================================================================
  * FREQUENCY REGISTRY
  * ============================================================================= */
@@ -393,7 +687,8 @@ void* agent_state_alloc(size_t state_size) {
     if (state_size == 0) {
         return NULL;
     }
-    return heap_allocate(state_size);  /* Already zeroed by heap_allocate */
+    /* Already zeroed by heap_allocate */
+    return heap_allocate_aligned(state_size, AGENT_STATE_ALIGN);
 }
 
 /*
@@ -401,8 +696,124 @@ void* agent_state_alloc(size_t state_size) {
  */
 void agent_state_free(void* state, size_t state_size) {
     if (state != NULL && state_size > 0) {
-        heap_free(state, state_size);
+        heap_free_aligned(state, state_size, AGENT_STATE_ALIGN);
+    }
+}
+
+/* State size rounded up to whole cache lines */
+static inline uint32_t state_stride(size_t state_size) {
+    return (uint32_t)((state_size + AGENT_STATE_ALIGN - 1) & ~(size_t)(AGENT_STATE_ALIGN - 1));
+}
+
+/*
+ * Reserve room for one more state of an agent type in the slab plan
+ *
+ * Slabs are planned (capacity counted) first and allocated in one piece
+ * by registry_allocate_slabs.
+ */
+static int registry_plan_state(AgentRegistry2* registry, uint32_t agent_type,
+                               size_t state_size) {
+    if (state_size == 0) {
+        return TOPOLOGY_OK;
+    }
+    uint32_t stride = state_stride(state_size);
+
+    for (uint32_t i = 0; i < registry->slab_count; i++) {
+        AgentStateSlab* slab = &registry->slabs[i];
+        if (slab->agent_type == agent_type) {
+            if (stride > slab->stride) {
+                slab->stride = stride;
+            }
+            slab->capacity++;
+            return TOPOLOGY_OK;
+        }
+    }
+
+    AgentStateSlab* slabs = heap_allocate((registry->slab_count + 1) * sizeof(AgentStateSlab));
+    if (slabs == NULL) {
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+    if (registry->slabs != NULL) {
+        memcpy(slabs, registry->slabs, registry->slab_count * sizeof(AgentStateSlab));
+        heap_free(registry->slabs, registry->slab_count * sizeof(AgentStateSlab));
+    }
+    slabs[registry->slab_count] = (AgentStateSlab){ .agent_type = agent_type, .stride = stride,
+                                                    .capacity = 1 };
+    registry->slabs = slabs;
+    registry->slab_count++;
+    return TOPOLOGY_OK;
+}
+
+/*
+ * Allocate every planned slab
+ */
+static int registry_allocate_slabs(AgentRegistry2* registry) {
+    for (uint32_t i = 0; i < registry->slab_count; i++) {
+        AgentStateSlab* slab = &registry->slabs[i];
+        if (slab->base == NULL) {
+            slab->base = heap_allocate_aligned((size_t)slab->capacity * slab->stride,
+                                               AGENT_STATE_ALIGN);
+            if (slab->base == NULL) {
+                return TOPOLOGY_ERR_ALLOC_FAILED;
+            }
+        }
+    }
+    return TOPOLOGY_OK;
+}
+
+/*
+ * Zeroed state for an agent: the next slot of its type's slab, or its own
+ * allocation if the slab is full (or there is none)
+ *
+ * @param out_slab: Set to 1 if the state came from a slab
+ */
+static void* registry_state_alloc(AgentRegistry2* registry, uint32_t agent_type,
+                                  size_t state_size, int* out_slab) {
+    *out_slab = 0;
+    if (state_size == 0) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < registry->slab_count; i++) {
+        AgentStateSlab* slab = &registry->slabs[i];
+        if (slab->agent_type == agent_type && slab->base != NULL &&
+            slab->used < slab->capacity && state_size <= slab->stride) {
+            *out_slab = 1;
+            return (char*)slab->base + (size_t)slab->used++ * slab->stride;
+        }
     }
+    return agent_state_alloc(state_size);
+}
+
+/*
+ * State size of an agent definition (its type's if unset)
+ */
+static size_t topology_state_size(AgentRegistry2* registry, const AgentInfo* info) {
+    AgentTypeDef* type = registry_get_type(registry, info->agent_type);
+    return (info->state_size == 0 && type != NULL) ? type->state_size : info->state_size;
+}
+
+/*
+ * Register an agent's metadata only; registry_materialize builds the rest
+ */
+static int topology_register_dormant(AgentRegistry2* registry, const AgentInfo* info,
+                                     AgentTypeDef* type, size_t state_size,
+                                     uint32_t capacity) {
+    int result = registry_register(registry, info->agent_id, info->name,
+                                   NULL, state_size, NULL, NULL);
+    if (result != TOPOLOGY_OK) {
+        return result;
+    }
+
+    AgentInfo* agent = registry_get_agent(registry, info->agent_id);
+    agent->agent_type = info->agent_type;
+    agent->queue_capacity = capacity ? capacity : 256;   /* Default queue size */
+    agent->flags |= AGENT_FLAG_DORMANT;
+    registry->dormant_count++;
+    if (type != NULL) {
+        type->instance_count++;
+    }
+    return TOPOLOGY_OK;
 }
 
 /*
@@ -413,41 +824,69 @@ int topology_init_agent(AgentRegistry2* registry, AgentInfo* info) {
         return TOPOLOGY_ERR_NULL_POINTER;
     }
 
+    /* Unset fields come from the agent's type, if defined */
+    AgentTypeDef* type = registry_get_type(registry, info->agent_type);
+    size_t state_size = info->state_size;
+    uint32_t capacity = info->queue_capacity;
+    if (type != NULL) {
+        if (state_size == 0) {
+            state_size = type->state_size;
+        }
+        if (capacity == 0) {
+            capacity = type->queue_capacity;
+        }
+    }
+
+    /* Dormant unless it brings resources of its own */
+    if ((info->flags & AGENT_FLAG_DORMANT) && info->state == NULL &&
+        info->queue == NULL && info->dispatch == NULL) {
+        return topology_register_dormant(registry, info, type, state_size, capacity);
+    }
+
     /* Allocate state if size specified but state is NULL */
     void* state = info->state;
-    if (state == NULL && info->state_size > 0) {
-        state = agent_state_alloc(info->state_size);
+    int from_slab = 0;
+    if (state == NULL && state_size > 0) {
+        state = registry_state_alloc(registry, info->agent_type, state_size, &from_slab);
         if (state == NULL) {
             return TOPOLOGY_ERR_ALLOC_FAILED;
         }
+        if (type != NULL && type->initial_state != NULL) {
+            memcpy(state, type->initial_state,
+                   (type->state_size < state_size) ? type->state_size : state_size);
+        }
     }
+    int own_state = (state != NULL && info->state == NULL && !from_slab);
 
     /* Create signal queue if not provided */
     SignalQueue* queue = info->queue;
     if (queue == NULL) {
-        uint32_t capacity = info->queue_capacity;
         if (capacity == 0) {
             capacity = 256;  /* Default queue size */
         }
         queue = signal_queue_create(capacity);
         if (queue == NULL) {
-            if (state != NULL && info->state == NULL) {
-                agent_state_free(state, info->state_size);
+            if (own_state) {
+                agent_state_free(state, state_size);
             }
             return TOPOLOGY_ERR_ALLOC_FAILED;
         }
     }
 
-    /* Create dispatch table if not provided */
+    /* Use the type's dispatch table, or create one if not provided */
     DispatchTable* dispatch = info->dispatch;
-    if (dispatch == NULL) {
+    int shared = 0;
+    if (dispatch == NULL && type != NULL) {
+        dispatch = type->dispatch;
+        shared = 1;
+    } else if (dispatch == NULL) {
         dispatch = dispatch_table_create(16, info->agent_id);
         if (dispatch == NULL) {
             if (info->queue == NULL) {
                 signal_queue_destroy(queue);
             }
-            if (state != NULL && info->state == NULL) {
-                agent_state_free(state, info->state_size);
+            if (own_state) {
+                agent_state_free(state, state_size);
             }
             return TOPOLOGY_ERR_ALLOC_FAILED;
         }
@@ -456,20 +895,30 @@ int topology_init_agent(AgentRegistry2* registry, AgentInfo* info) {
 
     /* Register agent */
     int result = registry_register(registry, info->agent_id, info->name,
-                                   state, info->state_size, queue, dispatch);
+                                   state, state_size, queue, dispatch);
     if (result != TOPOLOGY_OK) {
-        if (info->dispatch == NULL) {
+        if (info->dispatch == NULL && !shared) {
             dispatch_table_destroy(dispatch);
         }
         if (info->queue == NULL) {
             signal_queue_destroy(queue);
         }
-        if (state != NULL && info->state == NULL) {
-            agent_state_free(state, info->state_size);
+        if (own_state) {
+            agent_state_free(state, state_size);
         }
         return result;
     }
 
+    AgentInfo* agent = registry_get_agent(registry, info->agent_id);
+    agent->agent_type = info->agent_type;
+    if (from_slab) {
+        agent->flags |= AGENT_FLAG_SLAB_STATE;
+    }
+    if (shared) {
+        agent->flags |= AGENT_FLAG_TYPE_DISPATCH;
+        type->instance_count++;
+    }
+
     return TOPOLOGY_OK;
 }
 
@@ -516,43 +965,144 @@ int topology_build_routes(AgentRegistry2* registry, SocketDef* sockets,
     return TOPOLOGY_OK;
 }
 
+/*
+ * Create an agent's replicas and route its signals across them
+ */
+int topology_replicate_agent(AgentRegistry2* registry, const ReplicaDef* def,
+                             uint32_t first_id) {
+    if (registry == NULL || def == NULL) {
+        return TOPOLOGY_ERR_NULL_POINTER;
+    }
+
+    AgentInfo* primary = registry_get_agent(registry, def->agent_id);
+    if (primary == NULL) {
+        return TOPOLOGY_ERR_AGENT_NOT_FOUND;
+    }
+    if (def->replicas <= 1) {
+        return TOPOLOGY_OK;
+    }
+
+    uint32_t* ids = heap_allocate(def->replicas * sizeof(uint32_t));
+    if (ids == NULL) {
+        return TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+    ids[0] = def->agent_id;
+
+    int result = TOPOLOGY_OK;
+    for (uint32_t r = 1; r < def->replicas && result == TOPOLOGY_OK; r++) {
+        uint32_t id = first_id + r - 1;
+        ids[r] = id;
+
+        /* Each replica starts from a copy of the primary's initial state */
+        void* state = NULL;
+        int from_slab = 0;
+        if (primary->state_size > 0) {
+            state = registry_state_alloc(registry, primary->agent_type, primary->state_size,
+                                         &from_slab);
+            if (state == NULL) {
+                result = TOPOLOGY_ERR_ALLOC_FAILED;
+                break;
+            }
+            if (primary->state != NULL) {
+                memcpy(state, primary->state, primary->state_size);
+            }
+        }
+        SignalQueue* queue = signal_queue_create(primary->queue_capacity ?
+                                                 primary->queue_capacity : 256);
+        if (queue == NULL) {
+            if (!from_slab) {
+                agent_state_free(state, primary->state_size);
+            }
+            result = TOPOLOGY_ERR_ALLOC_FAILED;
+            break;
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "%s#%u", primary->name ? primary->name : "agent", r);
+        result = registry_register(registry, id, name, state, primary->state_size,
+                                   queue, primary->dispatch);
+        if (result != TOPOLOGY_OK) {
+            signal_queue_destroy(queue);
+            if (!from_slab) {
+                agent_state_free(state, primary->state_size);
+            }
+            break;
+        }
+
+        AgentInfo* replica = registry_get_agent(registry, id);
+        replica->agent_type = primary->agent_type;
+        replica->flags |= AGENT_FLAG_REPLICA | (from_slab ? AGENT_FLAG_SLAB_STATE : 0) |
+                          (primary->flags & AGENT_FLAG_TYPE_DISPATCH);
+        if (primary->flags & AGENT_FLAG_TYPE_DISPATCH) {
+            registry_get_type(registry, primary->agent_type)->instance_count++;
+        }
+
+        /* Replicas emit under their own ID: give them the primary's routes */
+        if (registry->routing != NULL &&
+            routing_copy_routes(registry->routing, def->agent_id, id) != SIGNAL_OK) {
+            result = TOPOLOGY_ERR_ALLOC_FAILED;
+        }
+    }
+
+    if (result == TOPOLOGY_OK && registry->routing != NULL &&
+        routing_set_replicas(registry->routing, def->agent_id, def->replicas, ids,
+                             def->key_offset, def->key_size) != SIGNAL_OK) {
+        result = TOPOLOGY_ERR_ALLOC_FAILED;
+    }
+    heap_free(ids, def->replicas * sizeof(uint32_t));
+    return result;
+}
+
+/*
+ * routing_resolve_queues_with lookup over an AgentRegistry2
+ */
+static SignalQueue* topology_queue_lookup(void* ctx, uint32_t agent_id) {
+    return registry_get_queue((AgentRegistry2*)ctx, agent_id);
+}
+
+/*
+ * Delivery-time lookup: materializes dormant agents
+ */
+static SignalQueue* topology_materialize_lookup(void* ctx, uint32_t agent_id) {
+    AgentRegistry2* registry = (AgentRegistry2*)ctx;
+    if (registry_materialize(registry, agent_id) != TOPOLOGY_OK) {
+        return NULL;
+    }
+    return registry_get_queue(registry, agent_id);
+}
+
 /*
  * Resolve all queue pointers in routing table
+ *
+ * Dormant agents' queues stay unresolved until their first delivery.
  */
 void topology_resolve_routes(AgentRegistry2* registry) {
     if (registry == NULL || registry->routing == NULL) {
         return;
     }
 
-    /* Build a temporary AgentRegistry (old format) for routing_resolve_queues */
-    AgentRegistry temp_registry;
-    Agent* temp_agents[256];  /* Stack-allocated for simplicity */
-    Agent agent_wrappers[256];
-
-    temp_registry.agents = temp_agents;
-    temp_registry.count = registry->agent_count;
-    temp_registry.capacity = 256;
-
-    memset(temp_agents, 0, sizeof(temp_agents));
+    routing_resolve_queues_with(registry->routing, topology_queue_lookup, registry);
+    if (registry->dormant_count > 0) {
+        routing_set_queue_resolver(registry->routing, topology_materialize_lookup, registry);
+    }
+}
 
-    /* Create wrapper agents for each registered agent */
-    for (uint32_t i = 0; i < registry->capacity && i < 256; i++) {
-        AgentInfo* info = &registry->agents[i];
-        if (info->flags & AGENT_FLAG_ACTIVE) {
-            agent_wrappers[info->agent_id] = (Agent){
-                .agent_id = info->agent_id,
-                .agent_type = info->agent_type,
-                .state_ptr = info->state,
-                .input_queue = info->queue,
-                .dispatch_table = info->dispatch,
-                .flags = info->flags,
-                .signal_count = info->signal_count
-            };
-            temp_agents[info->agent_id] = &agent_wrappers[info->agent_id];
+/*
+ * Should topology_init register an agent dormant: lazy network, nothing
+ * supplied, and not replicated (replicas copy their primary's state)
+ */
+static int topology_agent_lazy(const NetworkTopology* topology, const AgentInfo* info) {
+    if (!(topology->flags & TOPOLOGY_FLAG_LAZY) || info->state != NULL ||
+        info->queue != NULL || info->dispatch != NULL) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < topology->replica_count; i++) {
+        if (topology->replicas[i].agent_id == info->agent_id &&
+            topology->replicas[i].replicas > 1) {
+            return 0;
         }
     }
-
-    routing_resolve_queues(registry->routing, &temp_registry);
+    return 1;
 }
 
 /*
@@ -563,31 +1113,128 @@ AgentRegistry2* topology_init(NetworkTopology* topology) {
         return NULL;
     }
 
+    /* Replicas take IDs after the highest declared one */
+    uint32_t max_id = topology->agent_count;
+    for (uint32_t i = 0; i < topology->agent_count; i++) {
+        if (topology->agents[i].agent_id > max_id) {
+            max_id = topology->agents[i].agent_id;
+        }
+    }
+    uint32_t extra = 0;
+    for (uint32_t i = 0; i < topology->replica_count; i++) {
+        if (topology->replicas[i].replicas > 1) {
+            extra += topology->replicas[i].replicas - 1;
+        }
+    }
+
     /* Create registry */
-    AgentRegistry2* registry = registry_create(topology->agent_count + 1);
+    AgentRegistry2* registry = registry_create(max_id + extra + 1);
     if (registry == NULL) {
         return NULL;
     }
 
+    /* Types first: agents take their defaults from them */
+    for (uint32_t i = 0; i < topology->type_count; i++) {
+        if (registry_define_type(registry, &topology->types[i]) != TOPOLOGY_OK) {
+            registry_destroy(registry);
+            return NULL;
+        }
+    }
+
+    /* One state slab per agent type, with room for the type's replicas
+     * (dormant agents get their state when materialized) */
+    int planned = TOPOLOGY_OK;
+    for (uint32_t i = 0; i < topology->agent_count && planned == TOPOLOGY_OK; i++) {
+        AgentInfo* info = &topology->agents[i];
+        if (info->state == NULL && !topology_agent_lazy(topology, info)) {
+            planned = registry_plan_state(registry, info->agent_type,
+                                          topology_state_size(registry, info));
+        }
+    }
+    for (uint32_t i = 0; i < topology->replica_count && planned == TOPOLOGY_OK; i++) {
+        ReplicaDef* def = &topology->replicas[i];
+        for (uint32_t j = 0; j < topology->agent_count; j++) {
+            AgentInfo* info = &topology->agents[j];
+            if (info->agent_id != def->agent_id) {
+                continue;
+            }
+            for (uint32_t r = 1; r < def->replicas && planned == TOPOLOGY_OK; r++) {
+                planned = registry_plan_state(registry, info->agent_type,
+                                              topology_state_size(registry, info));
+            }
+            break;
+        }
+    }
+    if (planned != TOPOLOGY_OK || registry_allocate_slabs(registry) != TOPOLOGY_OK) {
+        registry_destroy(registry);
+        return NULL;
+    }
+
     /* Initialize each agent */
     for (uint32_t i = 0; i < topology->agent_count; i++) {
-        int result = topology_init_agent(registry, &topology->agents[i]);
+        AgentInfo info = topology->agents[i];
+        if (topology_agent_lazy(topology, &info)) {
+            info.flags |= AGENT_FLAG_DORMANT;
+        }
+        int result = topology_init_agent(registry, &info);
         if (result != TOPOLOGY_OK) {
             registry_destroy(registry);
             return NULL;
         }
     }
 
-    /* Build routing tables */
+    /* Build routing tables, with room for the replicas' copies of their
+     * primary's outgoing routes */
     if (topology->socket_count > 0) {
+        uint32_t route_count = topology->socket_count;
+        for (uint32_t i = 0; i < topology->replica_count; i++) {
+            ReplicaDef* def = &topology->replicas[i];
+            for (uint32_t j = 0; j < topology->socket_count && def->replicas > 1; j++) {
+                if (topology->sockets[j].source_agent_id == def->agent_id) {
+                    route_count += def->replicas - 1;
+                }
+            }
+        }
+        registry->routing = routing_table_create(route_count * 2);
+        if (registry->routing == NULL) {
+            registry_destroy(registry);
+            return NULL;
+        }
+
         int result = topology_build_routes(registry, topology->sockets,
                                            topology->socket_count);
         if (result != TOPOLOGY_OK) {
             registry_destroy(registry);
             return NULL;
         }
+    }
+
+    /* Replicate agents, then route across the replicas */
+    if (topology->replica_count > 0) {
+        registry->replicas = heap_allocate(topology->replica_count * sizeof(ReplicaDef));
+        if (registry->replicas == NULL) {
+            registry_destroy(registry);
+            return NULL;
+        }
+        memcpy(registry->replicas, topology->replicas,
+               topology->replica_count * sizeof(ReplicaDef));
+        registry->replica_count = topology->replica_count;
+
+        uint32_t next_id = max_id + 1;
+        for (uint32_t i = 0; i < topology->replica_count; i++) {
+            if (topology_replicate_agent(registry, &topology->replicas[i],
+                                         next_id) != TOPOLOGY_OK) {
+                registry_destroy(registry);
+                return NULL;
+            }
+            if (topology->replicas[i].replicas > 1) {
+                next_id += topology->replicas[i].replicas - 1;
+            }
+        }
+    }
 
-        /* Resolve queue pointers */
+    /* Resolve queue pointers */
+    if (registry->routing != NULL) {
         topology_resolve_routes(registry);
     }
 
@@ -598,9 +1245,220 @@ AgentRegistry2* topology_init(NetworkTopology* topology) {
  * Shutdown and cleanup network
  */
 void topology_shutdown(AgentRegistry2* registry) {
+    if (registry == NULL) {
+        return;
+    }
+
+    /* Fold replica state back into each primary */
+    for (uint32_t i = 0; i < registry->replica_count; i++) {
+        ReplicaDef* def = &registry->replicas[i];
+        AgentInfo* primary = registry_get_agent(registry, def->agent_id);
+        uint32_t count;
+        const uint32_t* ids = routing_get_replicas(registry->routing, def->agent_id, &count);
+        if (def->merge == NULL || primary == NULL || ids == NULL) {
+            continue;
+        }
+        for (uint32_t r = 0; r < count; r++) {
+            AgentInfo* replica = registry_get_agent(registry, ids[r]);
+            if (replica != NULL && replica != primary) {
+                def->merge(primary->state, replica->state);
+            }
+        }
+    }
+
     registry_destroy(registry);
 }
 
+/* =============================================================================
+ * TRAFFIC EXPORT
+ * ============================================================================= */
+
+/*
+ * Per-second rate over the measurement window (0 if no window)
+ */
+static double rate_per_sec(uint64_t count, uint64_t elapsed_ns) {
+    if (elapsed_ns == 0) {
+        return 0.0;
+    }
+    return (double)count * 1e9 / (double)elapsed_ns;
+}
+
+/*
+ * Frequency name, or NULL if not registered
+ */
+static const char* export_frequency_name(FrequencyRegistry* frequencies,
+                                         uint32_t frequency_id) {
+    FrequencyInfo* freq = frequency_get(frequencies, frequency_id);
+    return (freq != NULL) ? freq->name : NULL;
+}
+
+/*
+ * Write a string with JSON/DOT escaping of quotes and backslashes
+ */
+static void export_write_escaped(FILE* out, const char* str) {
+    if (str == NULL) {
+        return;
+    }
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*str, out);
+    }
+}
+
+/*
+ * Largest per-edge signal count (for scaling edge widths)
+ */
+static uint64_t export_max_signals(RoutingTable* routing) {
+    uint64_t max_signals = 0;
+
+    for (uint32_t i = 0; i < routing->capacity; i++) {
+        RoutingEntry* entry = &routing->entries[i];
+        if (entry->source_agent_id == 0) {
+            continue;
+        }
+        for (uint32_t d = 0; d < entry->dest_count; d++) {
+            RouteEdgeStats stats;
+            routing_entry_edge_stats(routing, entry, d, &stats);
+            if (stats.signals_delivered > max_signals) {
+                max_signals = stats.signals_delivered;
+            }
+        }
+    }
+
+    return max_signals;
+}
+
+/*
+ * Write topology as a Graphviz DOT graph
+ */
+int topology_export_dot(AgentRegistry2* registry, FrequencyRegistry* frequencies,
+                        FILE* out, uint64_t elapsed_ns) {
+    if (registry == NULL || out == NULL) {
+        return TOPOLOGY_ERR_NULL_POINTER;
+    }
+
+    fprintf(out, "digraph mycelial {\n");
+    fprintf(out, "  rankdir=LR;\n");
+    fprintf(out, "  node [shape=box];\n");
+
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        fprintf(out, "  a%u [label=\"", agent->agent_id);
+        if (agent->name != NULL) {
+            export_write_escaped(out, agent->name);
+        } else {
+            fprintf(out, "agent %u", agent->agent_id);
+        }
+        fprintf(out, "\"];\n");
+    }
+
+    RoutingTable* routing = registry->routing;
+    if (routing != NULL) {
+        uint64_t max_signals = export_max_signals(routing);
+
+        for (uint32_t i = 0; i < routing->capacity; i++) {
+            RoutingEntry* entry = &routing->entries[i];
+            if (entry->source_agent_id == 0) {
+                continue;
+            }
+
+            const char* freq_name = export_frequency_name(frequencies,
+                                                          entry->frequency_id);
+
+            for (uint32_t d = 0; d < entry->dest_count; d++) {
+                RouteEdgeStats stats;
+                routing_entry_edge_stats(routing, entry, d, &stats);
+
+                double width = 1.0;
+                if (max_signals > 0) {
+                    width += 4.0 * (double)stats.signals_delivered /
+                             (double)max_signals;
+                }
+
+                fprintf(out, "  a%u -> a%u [label=\"",
+                        entry->source_agent_id, entry->dest_agent_ids[d]);
+                if (freq_name != NULL) {
+                    export_write_escaped(out, freq_name);
+                } else {
+                    fprintf(out, "freq %u", entry->frequency_id);
+                }
+                fprintf(out, "\\n%lu sig, %lu B",
+                        stats.signals_delivered, stats.bytes_delivered);
+                if (elapsed_ns > 0) {
+                    fprintf(out, "\\n%.0f sig/s, %.0f B/s",
+                            rate_per_sec(stats.signals_delivered, elapsed_ns),
+                            rate_per_sec(stats.bytes_delivered, elapsed_ns));
+                }
+                fprintf(out, "\\ndrops %lu, max depth %u\", penwidth=%.2f];\n",
+                        stats.drops_queue_full, stats.max_queue_depth, width);
+            }
+        }
+    }
+
+    fprintf(out, "}\n");
+    return TOPOLOGY_OK;
+}
+
+/*
+ * Write topology as JSON
+ */
+int topology_export_json(AgentRegistry2* registry, FrequencyRegistry* frequencies,
+                         FILE* out, uint64_t elapsed_ns) {
+    if (registry == NULL || out == NULL) {
+        return TOPOLOGY_ERR_NULL_POINTER;
+    }
+
+    fprintf(out, "{\n  \"elapsed_ns\": %lu,\n  \"nodes\": [", elapsed_ns);
+
+    int first = 1;
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        fprintf(out, "%s\n    {\"id\": %u, \"name\": \"",
+                first ? "" : ",", agent->agent_id);
+        export_write_escaped(out, agent->name);
+        fprintf(out, "\"}");
+        first = 0;
+    }
+
+    fprintf(out, "\n  ],\n  \"edges\": [");
+
+    RoutingTable* routing = registry->routing;
+    first = 1;
+    for (uint32_t i = 0; routing != NULL && i < routing->capacity; i++) {
+        RoutingEntry* entry = &routing->entries[i];
+        if (entry->source_agent_id == 0) {
+            continue;
+        }
+
+        const char* freq_name = export_frequency_name(frequencies,
+                                                      entry->frequency_id);
+
+        for (uint32_t d = 0; d < entry->dest_count; d++) {
+            RouteEdgeStats stats;
+            routing_entry_edge_stats(routing, entry, d, &stats);
+
+            fprintf(out, "%s\n    {\"source\": %u, \"dest\": %u, "
+                    "\"frequency\": %u, \"frequency_name\": \"",
+                    first ? "" : ",", entry->source_agent_id,
+                    entry->dest_agent_ids[d], entry->frequency_id);
+            export_write_escaped(out, freq_name);
+            fprintf(out, "\", \"signals\": %lu, \"bytes\": %lu, "
+                    "\"drops\": %lu, \"max_queue_depth\": %u, "
+                    "\"signals_per_sec\": %.1f, \"bytes_per_sec\": %.1f}",
+                    stats.signals_delivered, stats.bytes_delivered,
+                    stats.drops_queue_full, stats.max_queue_depth,
+                    rate_per_sec(stats.signals_delivered, elapsed_ns),
+                    rate_per_sec(stats.bytes_delivered, elapsed_ns));
+            first = 0;
+        }
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    return TOPOLOGY_OK;
+}
+
 /* =============================================================================
  * DEBUG FUNCTIONS
  * ============================================================================= */
@@ -611,18 +1469,16 @@ void registry_print(AgentRegistry2* registry) {
         return;
     }
 
-    printf("Agent Registry (%u agents, capacity %u):\n",
-           registry->agent_count, registry->capacity);
-
-    for (uint32_t i = 0; i < registry->capacity; i++) {
-        AgentInfo* agent = &registry->agents[i];
-        if (agent->flags & AGENT_FLAG_ACTIVE) {
-            printf("  Agent %u: name='%s', state=%p, queue=%p, dispatch=%p\n",
-                   agent->agent_id,
-                   agent->name ? agent->name : "(null)",
-                   agent->state,
-                   (void*)agent->queue,
-                   (void*)agent->dispatch);
-        }
+    printf("Agent Registry (%u agents, highest ID %u, capacity %u):\n",
+           registry->active_count, registry->agent_count, registry->capacity);
+
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        printf("  Agent %u: name='%s', state=%p, queue=%p, dispatch=%p\n",
+               agent->agent_id,
+               agent->name ? agent->name : "(null)",
+               agent->state,
+               (void*)agent->queue,
+               (void*)agent->dispatch);
     }
 }
@@ -13,6 +13,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /* Forward declarations */
 struct Signal;
@@ -29,7 +30,9 @@ struct RoutingTable;
 /*
  * Agent metadata with name and full integration
  *
- * Layout: 64 bytes
+ * Layout: 64 bytes. In a registry this is the agent's cold record; the
+ * pointers a sweep follows (queue, dispatch, state) are also kept in the
+ * page's dense hot arrays (RegistryPage).
  */
 typedef struct AgentInfo {
     uint32_t agent_id;              /* 0x00: Unique agent ID */
@@ -49,23 +52,81 @@ typedef struct AgentInfo {
 #define AGENT_FLAG_ACTIVE           0x0001  /* Agent is active */
 #define AGENT_FLAG_INITIALIZED      0x0002  /* State initialized */
 #define AGENT_FLAG_HAS_HANDLERS     0x0004  /* Has registered handlers */
+#define AGENT_FLAG_REPLICA          0x0008  /* Replica: shares its primary's dispatch table */
+#define AGENT_FLAG_SLAB_STATE       0x0010  /* State lives in its type's slab (not freed alone) */
+#define AGENT_FLAG_TYPE_DISPATCH    0x0020  /* Uses its type's shared dispatch table */
+#define AGENT_FLAG_DORMANT          0x0040  /* No state, queue or table until first delivery */
+
+/* Agent states start on their own cache line, so agents on different
+ * threads never share one */
+#define AGENT_STATE_ALIGN           64
 
 /* =============================================================================
  * AGENT REGISTRY (ENHANCED)
  *
  * Global registry for all agents in the network.
+ *
+ * Agents live in a two-level ID directory: pages of REGISTRY_PAGE_SIZE
+ * slots, allocated when the first agent in their ID range registers. The
+ * directory grows to any ID, and sparse IDs (say one range per agent type)
+ * only pay for the pages they touch.
+ *
+ * A page is split hot/cold: the queue, dispatch and state pointers sit in
+ * dense arrays next to a bitmap of registered slots, and the full AgentInfo
+ * records (names, sizes, counters) after them. Walking the registry scans
+ * the bitmap; queue and dispatch lookups never touch the cold records.
+ *
+ * States allocated by topology_init come from one slab per agent type,
+ * each state on its own AGENT_STATE_ALIGN boundary, so a sweep over agents
+ * of one type streams through contiguous memory.
+ *
+ * Dormant agents (AGENT_FLAG_DORMANT) are registered with their metadata
+ * only: registry_materialize gives them state, queue and dispatch table,
+ * and the registry's routing table calls it on an agent's first delivery.
  * ============================================================================= */
 
+#define REGISTRY_PAGE_SHIFT         10
+#define REGISTRY_PAGE_SIZE          (1u << REGISTRY_PAGE_SHIFT)    /* Slots per page */
+
+typedef struct RegistryPage {
+    /* Hot: read on every delivery or visit */
+    struct SignalQueue* queues[REGISTRY_PAGE_SIZE];
+    struct DispatchTable* dispatch[REGISTRY_PAGE_SIZE];
+    void* states[REGISTRY_PAGE_SIZE];
+    uint64_t active[REGISTRY_PAGE_SIZE / 64];  /* Bit per registered slot */
+
+    /* Cold: full metadata */
+    AgentInfo info[REGISTRY_PAGE_SIZE];
+} RegistryPage;
+
+/* Contiguous states of one agent type (topology_init) */
+typedef struct AgentStateSlab {
+    uint32_t agent_type;
+    uint32_t stride;                /* State size rounded up to AGENT_STATE_ALIGN */
+    uint32_t used;                  /* States handed out */
+    uint32_t capacity;              /* States the slab holds */
+    void* base;                     /* AGENT_STATE_ALIGN-aligned */
+} AgentStateSlab;
+
 typedef struct AgentRegistry2 {
-    AgentInfo* agents;              /* 0x00: Array of agent info */
-    uint32_t agent_count;           /* 0x08: Number of registered agents */
-    uint32_t capacity;              /* 0x0C: Maximum agents */
-    const char** agent_names;       /* 0x10: Lookup table: ID -> name */
+    RegistryPage** pages;           /* 0x00: ID directory, slot (id-1) (NULL = unused page) */
+    uint32_t agent_count;           /* 0x08: Highest registered agent ID */
+    uint32_t capacity;              /* 0x0C: IDs the directory covers (grows) */
+    uint32_t page_count;            /* 0x10: Length of pages[] */
+    uint32_t active_count;          /* 0x14: Registered agents */
     uint32_t* name_to_id;           /* 0x18: Hash table: name -> ID */
     uint32_t name_table_size;       /* 0x20: Size of name hash table */
-    struct RoutingTable* routing;   /* 0x24: Routing table for this network */
-    uint32_t flags;                 /* 0x28: Registry flags */
-    uint32_t total_signals;         /* 0x2C: Stats: total signals processed */
+    uint32_t flags;                 /* 0x24: Registry flags */
+    struct RoutingTable* routing;   /* 0x28: Routing table for this network */
+    uint32_t total_signals;         /* 0x30: Stats: total signals processed */
+    uint32_t replica_count;         /* 0x34: Number of replica definitions */
+    struct ReplicaDef* replicas;    /* 0x38: Replicated agents (for shutdown merge) */
+    AgentStateSlab* slabs;          /* 0x40: State slabs, one per agent type */
+    uint32_t slab_count;            /* 0x48: Number of slabs */
+    uint32_t type_count;            /* 0x4C: Number of defined agent types */
+    struct AgentTypeDef* types;     /* 0x50: Agent types (tables owned by the registry) */
+    uint32_t dormant_count;         /* 0x58: Agents not materialized yet */
+    uint32_t materialize_lock;      /* 0x5C: Serializes registry_materialize */
 } AgentRegistry2;
 
 /* =============================================================================
@@ -101,6 +162,52 @@ typedef struct SocketDef {
     uint32_t flags;                 /* Socket flags */
 } SocketDef;
 
+/* =============================================================================
+ * REPLICA DEFINITION
+ *
+ * Runs one agent as several replicas, each with its own state (a copy of
+ * the initial state) and queue, sharing the agent's dispatch table. Replica
+ * 0 is the agent itself; the others get IDs after the highest declared one
+ * and names "<name>#<n>". Signals routed to the agent go to one replica,
+ * by shard key hash or round robin (see routing_set_replicas). Replicas
+ * must be dispatched with their own state (dispatch_*_with_state, as the
+ * scheduler does).
+ * ============================================================================= */
+
+/* Fold a replica's state into the primary's (topology_shutdown) */
+typedef void (*ReplicaMergeFn)(void* primary_state, const void* replica_state);
+
+typedef struct ReplicaDef {
+    uint32_t agent_id;              /* Agent to replicate */
+    uint32_t replicas;              /* Total copies, including the agent */
+    uint32_t key_offset;            /* Shard key offset in the payload */
+    uint32_t key_size;              /* Shard key size (0 = stateless, round robin) */
+    ReplicaMergeFn merge;           /* Optional, called per replica at shutdown */
+} ReplicaDef;
+
+/* =============================================================================
+ * AGENT TYPES
+ *
+ * Every instance of a hyphal type has the same handlers, guards and state
+ * layout. An AgentTypeDef holds them once: instances of a defined type get
+ * the type's dispatch table (not one of their own), and own nothing but a
+ * state, initialized from the type's template, and a queue.
+ *
+ * A shared table must be dispatched with the instance's state
+ * (dispatch_*_with_state, as the scheduler does); its cached agent_state
+ * is never set. The registry owns the table and destroys it with itself.
+ * ============================================================================= */
+
+typedef struct AgentTypeDef {
+    uint32_t agent_type;            /* Type ID (AgentInfo.agent_type) */
+    const char* name;               /* Type name (copied; for debugging) */
+    struct DispatchTable* dispatch; /* Handlers and guards (NULL = create an empty one) */
+    size_t state_size;              /* Instance state size */
+    const void* initial_state;      /* state_size-byte template (copied; NULL = zeroed) */
+    uint32_t queue_capacity;        /* Instance queue size (0 = 256) */
+    uint32_t instance_count;        /* Registered instances (maintained by the registry) */
+} AgentTypeDef;
+
 /* =============================================================================
  * NETWORK TOPOLOGY
  *
@@ -115,9 +222,16 @@ typedef struct NetworkTopology {
     FrequencyInfo* frequencies;     /* Frequency definitions */
     uint32_t frequency_count;       /* Number of frequencies */
     const char* network_name;       /* Network name (for debugging) */
-    uint32_t flags;                 /* Network flags */
+    uint32_t flags;                 /* Network flags (TOPOLOGY_FLAG_*) */
+    ReplicaDef* replicas;           /* Replicated agents (optional) */
+    uint32_t replica_count;         /* Number of replica definitions */
+    AgentTypeDef* types;            /* Agent types (optional) */
+    uint32_t type_count;            /* Number of type definitions */
 } NetworkTopology;
 
+/* Network flags */
+#define TOPOLOGY_FLAG_LAZY          0x0001  /* Materialize agents on first delivery */
+
 /* =============================================================================
  * ERROR CODES
  * ============================================================================= */
@@ -129,6 +243,7 @@ typedef struct NetworkTopology {
 #define TOPOLOGY_ERR_AGENT_NOT_FOUND 4
 #define TOPOLOGY_ERR_INVALID_SOCKET 5
 #define TOPOLOGY_ERR_CAPACITY       6
+#define TOPOLOGY_ERR_TYPE_EXISTS    7
 
 /* =============================================================================
  * REGISTRY FUNCTIONS
@@ -137,7 +252,7 @@ typedef struct NetworkTopology {
 /*
  * Create a new agent registry
  *
- * @param capacity: Maximum number of agents
+ * @param capacity: Expected highest agent ID (sizes the directory; it grows)
  * @return: Pointer to registry, or NULL on failure
  */
 AgentRegistry2* registry_create(uint32_t capacity);
@@ -155,7 +270,7 @@ void registry_destroy(AgentRegistry2* registry);
  * @param registry: Agent registry
  * @param agent_id: Unique agent ID
  * @param name: Agent name (will be copied)
- * @param state: Pointer to agent state (or NULL)
+ * @param state: Agent state from agent_state_alloc (or NULL)
  * @param state_size: Size of state struct
  * @param queue: Signal queue (or NULL to create)
  * @param dispatch: Dispatch table (or NULL)
@@ -188,10 +303,23 @@ AgentInfo* registry_get_agent_by_name(AgentRegistry2* registry, const char* name
  *
  * @param registry: Agent registry
  * @param agent_id: Agent ID
- * @return: Signal queue pointer, or NULL if not found
+ * @return: Signal queue pointer, or NULL if not found (or dormant)
  */
 struct SignalQueue* registry_get_queue(AgentRegistry2* registry, uint32_t agent_id);
 
+/*
+ * Give a dormant agent its state, queue and dispatch table
+ *
+ * Built as topology_init would have: state from its type's template (not
+ * from a slab), the type's table or one of its own. Safe to call from any
+ * thread, and a no-op for agents that are not dormant.
+ *
+ * @param registry: Agent registry
+ * @param agent_id: Agent ID
+ * @return: TOPOLOGY_OK, TOPOLOGY_ERR_AGENT_NOT_FOUND, or TOPOLOGY_ERR_ALLOC_FAILED
+ */
+int registry_materialize(AgentRegistry2* registry, uint32_t agent_id);
+
 /*
  * Get agent's dispatch table
  *
@@ -201,11 +329,78 @@ struct SignalQueue* registry_get_queue(AgentRegistry2* registry, uint32_t agent_
  */
 struct DispatchTable* registry_get_dispatch(AgentRegistry2* registry, uint32_t agent_id);
 
+/*
+ * Process up to N signals from an agent's queue with its dispatch table
+ *
+ * Runs the table for this agent's ID and state, so instances sharing a
+ * type's table are profiled separately and get only their own errors.
+ *
+ * @param registry: Agent registry
+ * @param agent_id: Agent ID
+ * @param max_signals: Maximum signals to process
+ * @param errors: Set to failed/unhandled signals (may be NULL)
+ * @return: Signals processed (0 if not found or dormant)
+ */
+int registry_process_agent(AgentRegistry2* registry, uint32_t agent_id,
+                           uint32_t max_signals, uint32_t* errors);
+
 /*
  * Get number of registered agents
  */
 uint32_t registry_get_count(AgentRegistry2* registry);
 
+/*
+ * Iterate registered agents in ID order, skipping unused directory pages
+ *
+ *   for (AgentInfo* a = registry_next(r, NULL); a != NULL; a = registry_next(r, a))
+ *
+ * @param registry: Agent registry
+ * @param prev: Previous agent, or NULL for the first
+ * @return: Next registered agent, or NULL at the end
+ */
+AgentInfo* registry_next(AgentRegistry2* registry, AgentInfo* prev);
+
+/*
+ * Iterate registered agent IDs without touching their AgentInfo records
+ * (pair with registry_get_queue / registry_get_dispatch for hot-only walks)
+ *
+ * @param after: Previous ID, or 0 for the first
+ * @return: Next registered agent ID, or 0 at the end
+ */
+uint32_t registry_next_id(AgentRegistry2* registry, uint32_t after);
+
+/* =============================================================================
+ * AGENT TYPE FUNCTIONS
+ * ============================================================================= */
+
+/*
+ * Define an agent type; agents of it registered through topology_init_agent
+ * afterwards share its dispatch table and start from its state template
+ *
+ * The definition, its name and its state template are copied, so none of
+ * them need outlive the call; the registry takes over def->dispatch and
+ * marks it DISPATCH_AGENT_SHARED (run instances with
+ * registry_process_agent so each is profiled under its own ID).
+ * Defining a type moves the type array: pointers from registry_get_type
+ * become invalid.
+ *
+ * @param registry: Agent registry
+ * @param def: Type definition
+ * @return: TOPOLOGY_OK, TOPOLOGY_ERR_TYPE_EXISTS, or TOPOLOGY_ERR_ALLOC_FAILED
+ */
+int registry_define_type(AgentRegistry2* registry, const AgentTypeDef* def);
+
+/*
+ * Get a defined agent type
+ *
+ * The pointer is valid until the next registry_define_type on the same
+ * registry (which reallocates the type array); look the type up again
+ * rather than keeping it.
+ *
+ * @return: Type, or NULL if not defined
+ */
+AgentTypeDef* registry_get_type(AgentRegistry2* registry, uint32_t agent_type);
+
 /* =============================================================================
  * FREQUENCY REGISTRY FUNCTIONS
  * ============================================================================= */
@@ -239,10 +434,16 @@ FrequencyInfo* frequency_get_by_name(FrequencyRegistry* registry, const char* na
  * Initialize network from topology definition
  *
  * This is the main initialization function. It:
- * 1. Creates agent registry
+ * 1. Creates agent registry and defines the agent types
  * 2. Allocates and initializes agent states
  * 3. Creates signal queues for each agent
  * 4. Builds routing tables from socket definitions
+ * 5. Creates replicas of replicated agents and shards their routes
+ *
+ * With TOPOLOGY_FLAG_LAZY, steps 2 and 3 are deferred: agents that bring
+ * no state, queue or table of their own and are not replicated are
+ * registered dormant and materialized on their first delivery, so startup
+ * costs scale with the agents that ever receive a signal.
  *
  * @param topology: Network topology definition
  * @return: Initialized registry, or NULL on failure
@@ -252,6 +453,11 @@ AgentRegistry2* topology_init(NetworkTopology* topology);
 /*
  * Initialize a single agent
  *
+ * Unset fields (state_size, queue_capacity, dispatch) come from the
+ * agent's type if it is defined; otherwise the agent gets its own
+ * dispatch table. With AGENT_FLAG_DORMANT in info->flags, only the
+ * metadata is registered (see registry_materialize).
+ *
  * @param registry: Agent registry
  * @param info: Agent info to initialize
  * @return: TOPOLOGY_OK on success
@@ -269,6 +475,17 @@ int topology_init_agent(AgentRegistry2* registry, AgentInfo* info);
 int topology_build_routes(AgentRegistry2* registry, SocketDef* sockets,
                           uint32_t socket_count);
 
+/*
+ * Create an agent's replicas and route its signals across them
+ *
+ * @param registry: Agent registry (agent and routes already set up)
+ * @param def: Replica definition
+ * @param first_id: Agent ID of replica 1 (the rest follow)
+ * @return: TOPOLOGY_OK on success
+ */
+int topology_replicate_agent(AgentRegistry2* registry, const ReplicaDef* def,
+                             uint32_t first_id);
+
 /*
  * Resolve all queue pointers in routing table
  *
@@ -279,6 +496,8 @@ void topology_resolve_routes(AgentRegistry2* registry);
 /*
  * Shutdown and cleanup network
  *
+ * Replicas are merged into their primary first (ReplicaDef.merge).
+ *
  * @param registry: Registry to shutdown
  */
 void topology_shutdown(AgentRegistry2* registry);
@@ -290,6 +509,10 @@ void topology_shutdown(AgentRegistry2* registry);
 /*
  * Allocate and zero-initialize agent state
  *
+ * The state starts on an AGENT_STATE_ALIGN boundary. States handed to
+ * registry_register are freed with agent_state_free when the registry is
+ * destroyed, so they must come from here.
+ *
  * @param state_size: Size of state struct in bytes
  * @return: Pointer to zeroed state, or NULL on failure
  */
@@ -303,6 +526,40 @@ void* agent_state_alloc(size_t state_size);
  */
 void agent_state_free(void* state, size_t state_size);
 
+/* =============================================================================
+ * TRAFFIC EXPORT
+ *
+ * Dumps the topology annotated with per-edge traffic counters from the
+ * routing table (see RouteEdgeStats in signal.h).
+ * ============================================================================= */
+
+/*
+ * Write topology as a Graphviz DOT graph
+ *
+ * Edge labels carry frequency, signal/byte counts and rates, drops and the
+ * maximum destination queue depth. Pen width scales with signal count.
+ *
+ * @param registry: Agent registry (with routing table)
+ * @param frequencies: Frequency names (optional, may be NULL)
+ * @param out: Output stream
+ * @param elapsed_ns: Measurement window for rates (0 = omit rates)
+ * @return: TOPOLOGY_OK on success
+ */
+int topology_export_dot(AgentRegistry2* registry, FrequencyRegistry* frequencies,
+                        FILE* out, uint64_t elapsed_ns);
+
+/*
+ * Write topology as JSON ({"nodes": [...], "edges": [...]})
+ *
+ * @param registry: Agent registry (with routing table)
+ * @param frequencies: Frequency names (optional, may be NULL)
+ * @param out: Output stream
+ * @param elapsed_ns: Measurement window for rates (0 = omit rates)
+ * @return: TOPOLOGY_OK on success
+ */
+int topology_export_json(AgentRegistry2* registry, FrequencyRegistry* frequencies,
+                         FILE* out, uint64_t elapsed_ns);
+
 /* =============================================================================
  * DEBUG FUNCTIONS
  * ============================================================================= */
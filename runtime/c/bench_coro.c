@@ -0,0 +1,205 @@
+/*
+ * Coroutine Agent Benchmark
+ *
+ * The orchestrator protocol (lex_complete, then parse_complete, then
+ * link_complete, repeated) written two ways on one agent: as handlers
+ * driving a state machine in agent state, and as a coroutine awaiting each
+ * step. Every build's three signals are queued, the scheduler runs, and
+ * the time per protocol step is reported for both.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_coro bench_coro.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_coro [builds]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FREQ_LEX_COMPLETE       1
+#define FREQ_PARSE_COMPLETE     2
+#define FREQ_LINK_COMPLETE      3
+
+#define BUILDS_PER_RUN          64      /* Builds queued per scheduler_run */
+
+typedef enum {
+    STEP_WAIT_LEX,
+    STEP_WAIT_PARSE,
+    STEP_WAIT_LINK
+} OrchestratorStep;
+
+typedef struct {
+    OrchestratorStep step;
+    uint32_t builds;
+    uint32_t out_of_order;
+    int64_t checksum;
+} OrchestratorState;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int64_t payload_value(Signal* sig) {
+    int64_t value;
+    memcpy(&value, signal_get_payload(sig), sizeof(value));
+    return value;
+}
+
+/* -------------------------------------------------------------------------
+ * State machine: every handler checks and advances the step
+ * ------------------------------------------------------------------------- */
+
+static int on_lex(void* agent_state, Signal* sig) {
+    OrchestratorState* state = (OrchestratorState*)agent_state;
+    if (state->step != STEP_WAIT_LEX) {
+        state->out_of_order++;
+        return 0;
+    }
+    state->checksum += payload_value(sig);
+    state->step = STEP_WAIT_PARSE;
+    return 0;
+}
+
+static int on_parse(void* agent_state, Signal* sig) {
+    OrchestratorState* state = (OrchestratorState*)agent_state;
+    if (state->step != STEP_WAIT_PARSE) {
+        state->out_of_order++;
+        return 0;
+    }
+    state->checksum = state->checksum * 3 + payload_value(sig);
+    state->step = STEP_WAIT_LINK;
+    return 0;
+}
+
+static int on_link(void* agent_state, Signal* sig) {
+    OrchestratorState* state = (OrchestratorState*)agent_state;
+    if (state->step != STEP_WAIT_LINK) {
+        state->out_of_order++;
+        return 0;
+    }
+    state->checksum = state->checksum * 5 + payload_value(sig);
+    state->builds++;
+    state->step = STEP_WAIT_LEX;
+    return 0;
+}
+
+/* -------------------------------------------------------------------------
+ * Coroutine: the same protocol as straight-line code
+ * ------------------------------------------------------------------------- */
+
+static int orchestrate(void* agent_state, AgentCoroutine* coro) {
+    OrchestratorState* state = (OrchestratorState*)agent_state;
+    for (;;) {
+        Signal* sig = coroutine_await(coro, FREQ_LEX_COMPLETE);
+        if (sig == NULL) {
+            return 0;
+        }
+        state->checksum += payload_value(sig);
+
+        if ((sig = coroutine_await(coro, FREQ_PARSE_COMPLETE)) == NULL) {
+            return 0;
+        }
+        state->checksum = state->checksum * 3 + payload_value(sig);
+
+        if ((sig = coroutine_await(coro, FREQ_LINK_COMPLETE)) == NULL) {
+            return 0;
+        }
+        state->checksum = state->checksum * 5 + payload_value(sig);
+        state->builds++;
+    }
+}
+
+static void queue_build(SignalQueue* queue, int64_t build) {
+    static const uint32_t steps[3] = {
+        FREQ_LEX_COMPLETE, FREQ_PARSE_COMPLETE, FREQ_LINK_COMPLETE
+    };
+    for (int i = 0; i < 3; i++) {
+        int64_t value = build * 3 + i;
+        Signal* sig = signal_create(steps[i], 0, &value, sizeof(value));
+        signal_queue_enqueue(queue, sig);
+        signal_free(sig);
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t builds = (argc > 1) ? (uint32_t)atoi(argv[1]) : 1000000;
+    if (builds == 0) {
+        printf("usage: %s [builds]\n", argv[0]);
+        return 1;
+    }
+    builds = (builds + BUILDS_PER_RUN - 1) / BUILDS_PER_RUN * BUILDS_PER_RUN;
+
+    if (!heap_init(64 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    AgentRegistry* registry = agent_registry_create(2);
+    RoutingTable* routing = routing_table_create(4);
+    DispatchTable* dispatch = dispatch_table_create(4, 1);
+    OrchestratorState state;
+    Agent agent = { .agent_id = 1, .state_ptr = &state, .dispatch_table = dispatch,
+                    .input_queue = signal_queue_create(4 * BUILDS_PER_RUN) };
+    agent_registry_add(registry, &agent);
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL COROUTINE AGENTS (%u builds, 3 steps each)\n", builds);
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-14s %12s %12s\n", "orchestrator", "ns/step", "steps/sec");
+
+    int64_t checksums[2];
+    for (int coroutine = 0; coroutine < 2; coroutine++) {
+        memset(&state, 0, sizeof(state));
+        dispatch_unregister(dispatch, FREQ_LEX_COMPLETE);
+        dispatch_unregister(dispatch, FREQ_PARSE_COMPLETE);
+        dispatch_unregister(dispatch, FREQ_LINK_COMPLETE);
+        if (!coroutine) {
+            dispatch_register(dispatch, FREQ_LEX_COMPLETE, on_lex, NULL);
+            dispatch_register(dispatch, FREQ_PARSE_COMPLETE, on_parse, NULL);
+            dispatch_register(dispatch, FREQ_LINK_COMPLETE, on_link, NULL);
+        }
+
+        Scheduler* sched = scheduler_create(registry, routing);
+        if (coroutine && scheduler_spawn_coroutine(sched, 1, orchestrate, 0) != SIGNAL_OK) {
+            printf("spawn failed\n");
+            return 1;
+        }
+
+        uint64_t elapsed = 0;
+        for (uint32_t b = 0; b < builds; b += BUILDS_PER_RUN) {
+            for (uint32_t i = 0; i < BUILDS_PER_RUN; i++) {
+                queue_build(agent.input_queue, b + i);
+            }
+            uint64_t start = now_ns();
+            scheduler_run(sched);
+            elapsed += now_ns() - start;
+        }
+        scheduler_destroy(sched);
+
+        double steps = 3.0 * builds;
+        printf("  %-14s %12.1f %12.0f\n", coroutine ? "coroutine" : "state machine",
+               (double)elapsed / steps, steps / ((double)elapsed / 1e9));
+        if (state.builds != builds || state.out_of_order != 0) {
+            printf("  %u of %u builds completed\n", state.builds, builds);
+            return 1;
+        }
+        checksums[coroutine] = state.checksum;
+    }
+
+    if (checksums[0] != checksums[1]) {
+        printf("  checksum mismatch: state machine %ld, coroutine %ld\n",
+               checksums[0], checksums[1]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * Direct Route Latency Benchmark
+ *
+ * Linear pipeline mirroring tests/pipeline.mycelial (validator ->
+ * processor -> formatter). One input at a time is fed to the validator and
+ * the scheduler runs until quiescent; reports the time from feeding an
+ * input to the formatter handling its result, with queued routes and with
+ * direct routes (ROUTE_FLAG_DIRECT).
+ *
+ * The pipeline is wired both ways round: with ascending agent IDs a queued
+ * signal still reaches the next stage in the same cycle (the ready sweep
+ * runs in ID order), with descending IDs every hop waits a cycle.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_direct bench_direct.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_direct [inputs] [stages]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FREQ_DATA       1
+#define MAX_STAGES      16
+
+typedef struct {
+    uint32_t id;
+    uint32_t seq;
+    int64_t value;
+} StagePayload;
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t next;                  /* Next stage (0 = formatter) */
+    uint64_t arrived_ns;
+    int64_t checksum;
+} StageAgent;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Transform and forward; the last stage records when the input got there
+ */
+static int handle_stage(void* agent_state, Signal* sig) {
+    StageAgent* agent = (StageAgent*)agent_state;
+    StagePayload payload;
+    memcpy(&payload, signal_get_payload(sig), sizeof(payload));
+
+    payload.value = payload.value * 31 + agent->id;
+    if (agent->next == 0) {
+        agent->checksum += payload.value;
+        agent->arrived_ns = now_ns();
+        return 0;
+    }
+    emit_signal(agent->routing, agent->registry, FREQ_DATA, agent->id,
+                &payload, sizeof(payload));
+    return 0;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv) {
+    uint32_t inputs = (argc > 1) ? (uint32_t)atoi(argv[1]) : 100000;
+    uint32_t stages = (argc > 2) ? (uint32_t)atoi(argv[2]) : 3;
+
+    if (inputs == 0 || stages < 2 || stages > MAX_STAGES) {
+        printf("usage: %s [inputs] [stages 2..%d]\n", argv[0], MAX_STAGES);
+        return 1;
+    }
+
+    if (!heap_init(64 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    /* Agent 0 unused: routes from source 0 are not supported */
+    AgentRegistry* registry = agent_registry_create(stages + 1);
+    DispatchTable* dispatch = dispatch_table_create(4, 1);
+    dispatch_register(dispatch, FREQ_DATA, handle_stage, NULL);
+
+    Agent agents[MAX_STAGES + 1];
+    StageAgent states[MAX_STAGES + 1];
+    for (uint32_t id = 1; id <= stages; id++) {
+        states[id] = (StageAgent){ .registry = registry, .id = id };
+        agents[id] = (Agent){ .agent_id = id, .state_ptr = &states[id],
+                              .dispatch_table = dispatch,
+                              .input_queue = signal_queue_create(16) };
+        agent_registry_add(registry, &agents[id]);
+    }
+
+    uint64_t* latency = heap_allocate(inputs * sizeof(uint64_t));
+    if (latency == NULL) {
+        printf("allocation failed\n");
+        return 1;
+    }
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL DIRECT ROUTES (%u-stage pipeline, %u inputs)\n", stages, inputs);
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-10s %-7s %9s %9s %9s %9s %12s\n", "stage ids", "routes", "p50 ns",
+           "p99 ns", "max ns", "cycles", "inputs/sec");
+
+    int failures = 0;
+    for (int descending = 0; descending < 2; descending++) {
+        /* stage k (0 = validator) is agent order[k] */
+        uint32_t order[MAX_STAGES];
+        for (uint32_t k = 0; k < stages; k++) {
+            order[k] = descending ? stages - k : k + 1;
+        }
+
+        RoutingTable* routing = routing_table_create(64);
+        for (uint32_t k = 0; k < stages; k++) {
+            StageAgent* state = &states[order[k]];
+            state->routing = routing;
+            state->next = (k + 1 < stages) ? order[k + 1] : 0;
+            if (state->next != 0) {
+                routing_add_entry(routing, order[k], FREQ_DATA, 1, &state->next);
+            }
+        }
+        routing_resolve_queues(routing, registry);
+        StageAgent* formatter = &states[order[stages - 1]];
+
+        int64_t checksums[2];
+        for (int direct = 0; direct < 2; direct++) {
+            for (uint32_t k = 0; k + 1 < stages; k++) {
+                routing_set_direct(routing, order[k], FREQ_DATA, direct);
+            }
+            formatter->checksum = 0;
+
+            Scheduler* sched = scheduler_create(registry, routing);
+            uint64_t start = now_ns();
+
+            for (uint32_t i = 0; i < inputs; i++) {
+                StagePayload payload = { .id = i, .seq = i, .value = i };
+                uint64_t fed = now_ns();
+                Signal* sig = signal_create(FREQ_DATA, 0, &payload, sizeof(payload));
+                signal_queue_enqueue(agents[order[0]].input_queue, sig);
+                signal_free(sig);
+                scheduler_run(sched);
+                latency[i] = formatter->arrived_ns - fed;
+            }
+
+            double elapsed = (double)(now_ns() - start) / 1e9;
+            uint64_t cycles = scheduler_get_cycle_count(sched);
+            scheduler_destroy(sched);
+
+            qsort(latency, inputs, sizeof(uint64_t), compare_u64);
+            printf("  %-10s %-7s %9lu %9lu %9lu %9lu %12.0f\n",
+                   descending ? "descending" : "ascending", direct ? "direct" : "queued",
+                   latency[inputs / 2], latency[(uint64_t)inputs * 99 / 100],
+                   latency[inputs - 1], cycles, (double)inputs / elapsed);
+            checksums[direct] = formatter->checksum;
+        }
+
+        if (checksums[0] != checksums[1]) {
+            printf("  checksum mismatch: queued %ld, direct %ld\n", checksums[0], checksums[1]);
+            failures++;
+        }
+        routing_table_destroy(routing);
+    }
+
+    return failures;
+}
@@ -0,0 +1,125 @@
+/*
+ * Fair-Share Scheduling Benchmark
+ *
+ * Mixed load: one agent whose handlers take 1 ms next to many agents with
+ * cheap handlers, all with queued work. Runs the same load with count
+ * budgets and with fair share, and reports the worst wait of the cheap
+ * agents, how long until their work was done, and total throughput.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_fair bench_fair.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_fair [cheap_agents] [quantum_us]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FREQ_WORK           1
+#define HEAVY_SPIN_NS       1000000     /* Heavy agent: 1 ms per signal */
+#define CHEAP_SPIN_NS       2000        /* Cheap agents: 2 us per signal */
+#define HEAVY_SIGNALS       32
+#define CHEAP_SIGNALS       256
+#define QUEUE_CAPACITY      256
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int handle_work(void* agent_state, Signal* sig) {
+    (void)sig;
+    uint64_t spin_ns = *(uint64_t*)agent_state;
+    uint64_t start = now_ns();
+    while (now_ns() - start < spin_ns) {
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t cheap = (argc > 1) ? (uint32_t)atoi(argv[1]) : 16;
+    uint64_t quantum_us = (argc > 2) ? (uint64_t)atoi(argv[2]) : 50;
+    if (cheap == 0 || quantum_us == 0) {
+        printf("usage: %s [cheap_agents] [quantum_us]\n", argv[0]);
+        return 1;
+    }
+
+    if (!heap_init(64 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    uint32_t count = cheap + 1;
+    AgentRegistry* registry = agent_registry_create(count + 1);
+    RoutingTable* routing = routing_table_create(4);
+    DispatchTable* dispatch = dispatch_table_create(4, 1);
+    dispatch_register(dispatch, FREQ_WORK, handle_work, NULL);
+    Agent* agents = calloc(count + 1, sizeof(Agent));
+    uint64_t* spin = calloc(count + 1, sizeof(uint64_t));
+    for (uint32_t id = 1; id <= count; id++) {
+        spin[id] = (id == 1) ? HEAVY_SPIN_NS : CHEAP_SPIN_NS;
+        agents[id] = (Agent){ .agent_id = id, .state_ptr = &spin[id],
+                              .dispatch_table = dispatch,
+                              .input_queue = signal_queue_create(QUEUE_CAPACITY) };
+        agent_registry_add(registry, &agents[id]);
+    }
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL FAIR SHARE (1 x 1 ms agent, %u x 2 us agents)\n", cheap);
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-18s %14s %14s %12s\n", "policy", "cheap max wait", "cheap done in", "signals/sec");
+
+    for (int fair = 0; fair < 2; fair++) {
+        Scheduler* sched = scheduler_create(registry, routing);
+        scheduler_set_budget(sched, SCHED_BUDGET_FIXED, 8, 8);
+        if (fair) {
+            scheduler_set_fair_share(sched, quantum_us * 1000);
+        } else {
+            scheduler_set_fairness_stats(sched, 1);
+        }
+
+        for (uint32_t id = 1; id <= count; id++) {
+            uint32_t n = (id == 1) ? HEAVY_SIGNALS : CHEAP_SIGNALS;
+            for (uint32_t i = 0; i < n; i++) {
+                Signal* sig = signal_create(FREQ_WORK, 0, NULL, 0);
+                signal_queue_enqueue(agents[id].input_queue, sig);
+                signal_free(sig);
+            }
+        }
+
+        uint64_t start = now_ns();
+        scheduler_run(sched);
+        uint64_t elapsed = now_ns() - start;
+
+        /* Runnable time runs from the first signal to the end of the last turn */
+        uint64_t cheap_max_wait = 0;
+        uint64_t cheap_done = 0;
+        for (uint32_t id = 2; id <= count; id++) {
+            SchedFairnessStats stats;
+            scheduler_get_fairness(sched, id, &stats);
+            if (stats.max_wait_ns > cheap_max_wait) {
+                cheap_max_wait = stats.max_wait_ns;
+            }
+            if (stats.runnable_ns > cheap_done) {
+                cheap_done = stats.runnable_ns;
+            }
+        }
+
+        uint64_t signals = HEAVY_SIGNALS + (uint64_t)cheap * CHEAP_SIGNALS;
+        char label[32];
+        snprintf(label, sizeof(label), fair ? "fair (%lu us)" : "count budget", quantum_us);
+        printf("  %-18s %11.1f us %11.1f ms %12.0f\n", label, (double)cheap_max_wait / 1000.0,
+               (double)cheap_done / 1e6, (double)signals / ((double)elapsed / 1e9));
+        scheduler_destroy(sched);
+    }
+
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Parallel Scheduler Scaling Benchmark
+ *
+ * Runs the example networks on 1..N worker threads, under the work-stealing
+ * scheduler (plain, and with agents placed from the traffic of earlier
+ * runs and workers pinned) and the deterministic BSP scheduler, and reports
+ * throughput and speedup over one thread. Topologies mirror the test programs:
+ *   pipeline           tests/pipeline.mycelial            V -> P -> F
+ *   map_reduce         tests/map_reduce.mycelial          MAP -> R1..R3 -> AGG
+ *   distributed_search tests/distributed_search.mycelial  C1 -> W1..W3 -> C1
+ *
+ * Each network is instantiated `copies` times so there is enough
+ * independent work to spread across cores.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_parallel bench_parallel.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_parallel [max_threads] [signals] [work_per_signal] [copies]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FREQ_WORK       1
+#define MAX_EDGES       8
+
+/* =============================================================================
+ * NETWORK DESCRIPTIONS
+ * ============================================================================= */
+
+typedef struct {
+    uint32_t source;                /* Node index */
+    uint32_t dest_count;
+    uint32_t dests[4];              /* Node indices */
+} BenchEdge;
+
+typedef struct {
+    const char* name;
+    uint32_t node_count;
+    uint32_t edge_count;
+    BenchEdge edges[MAX_EDGES];
+    uint32_t seed_ttl;              /* Hops each input signal travels */
+    uint32_t signals_per_input;     /* Handler invocations per input signal */
+    uint32_t fan_in;                /* Worst-case queue growth factor */
+} BenchNetwork;
+
+static const BenchNetwork g_networks[] = {
+    { "pipeline", 3, 2,
+      { { 0, 1, { 1 } }, { 1, 1, { 2 } } },
+      2, 3, 1 },
+    { "map_reduce", 5, 4,
+      { { 0, 3, { 1, 2, 3 } }, { 1, 1, { 4 } }, { 2, 1, { 4 } }, { 3, 1, { 4 } } },
+      2, 7, 3 },
+    { "distributed_search", 4, 4,
+      { { 0, 3, { 1, 2, 3 } }, { 1, 1, { 0 } }, { 2, 1, { 0 } }, { 3, 1, { 0 } } },
+      2, 7, 4 },
+};
+
+/* =============================================================================
+ * AGENTS
+ * ============================================================================= */
+
+typedef struct {
+    uint32_t seq;
+    uint32_t ttl;
+} BenchPayload;
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t work;
+    uint64_t checksum;
+} BenchAgent;
+
+/*
+ * Simulated handler work, then forward while the TTL lasts
+ */
+static int handle_work(void* agent_state, Signal* sig) {
+    BenchAgent* agent = (BenchAgent*)agent_state;
+    BenchPayload payload;
+    memcpy(&payload, signal_get_payload(sig), sizeof(payload));
+
+    uint32_t x = payload.seq | 1;
+    for (uint32_t i = 0; i < agent->work; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    agent->checksum += x;
+
+    if (payload.ttl > 0) {
+        payload.ttl--;
+        emit_signal(agent->routing, agent->registry, FREQ_WORK, agent->id,
+                    &payload, sizeof(payload));
+    }
+    return 0;
+}
+
+/* =============================================================================
+ * BENCHMARK DRIVER
+ * ============================================================================= */
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Scheduler variants compared */
+#define MODE_WS         0           /* Work stealing, agents spread by ID */
+#define MODE_PLACED     1           /* Work stealing, placed + pinned */
+#define MODE_BSP        2           /* Deterministic BSP */
+#define MODE_COUNT      3
+
+static const char* g_mode_names[MODE_COUNT] = { "ws", "placed", "bsp" };
+
+/*
+ * Seed every copy's entry node, then run once
+ *
+ * @param mode: MODE_*
+ * @return: Signals processed, or -1 if the scheduler could not be created
+ */
+static int bench_run(const BenchNetwork* net, Agent* agents, AgentRegistry* registry,
+                     RoutingTable* routing, uint32_t per_copy, uint32_t copies,
+                     uint32_t threads, int mode, double* elapsed, SchedulerStats* stats) {
+    for (uint32_t c = 0; c < copies; c++) {
+        Agent* entry = &agents[1 + c * net->node_count];
+        for (uint32_t i = 0; i < per_copy; i++) {
+            BenchPayload payload = { .seq = i, .ttl = net->seed_ttl };
+            Signal* sig = signal_create(FREQ_WORK, 0, &payload, sizeof(payload));
+            signal_queue_enqueue(entry->input_queue, sig);
+            signal_free(sig);
+        }
+    }
+
+    Scheduler* sched = (mode == MODE_BSP) ? scheduler_create_bsp(registry, routing, threads)
+                                          : scheduler_create_parallel(registry, routing, threads);
+    if (sched == NULL) {
+        return -1;
+    }
+
+    /* Plan from the traffic of the runs before this one */
+    if (mode == MODE_PLACED) {
+        scheduler_plan_placement(sched);
+        scheduler_set_affinity(sched, 1);
+    }
+
+    double start = now_seconds();
+    int processed = scheduler_run(sched);
+    *elapsed = now_seconds() - start;
+
+    scheduler_get_stats(sched, stats);
+    scheduler_destroy(sched);
+    return processed;
+}
+
+/*
+ * Build `copies` instances of a network, then run it on 1..max_threads
+ */
+static int bench_network(const BenchNetwork* net, uint32_t max_threads,
+                         uint32_t signals, uint32_t work, uint32_t copies) {
+    /* Agent 0 is left unused: routes from source 0 are not supported */
+    uint32_t agent_count = 1 + copies * net->node_count;
+    uint32_t per_copy = (signals + copies - 1) / copies;
+    uint32_t queue_capacity = next_power_of_two(per_copy * net->fan_in);
+
+    AgentRegistry* registry = agent_registry_create(agent_count);
+    RoutingTable* routing = routing_table_create(next_power_of_two(copies * MAX_EDGES * 2));
+    Agent* agents = heap_allocate(agent_count * sizeof(Agent));
+    BenchAgent* states = heap_allocate(agent_count * sizeof(BenchAgent));
+    DispatchTable** tables = heap_allocate(agent_count * sizeof(DispatchTable*));
+    if (registry == NULL || routing == NULL || agents == NULL ||
+        states == NULL || tables == NULL) {
+        printf("  allocation failed\n");
+        return 1;
+    }
+
+    for (uint32_t id = 1; id < agent_count; id++) {
+        states[id] = (BenchAgent){ .routing = routing, .registry = registry,
+                                   .id = id, .work = work };
+        tables[id] = dispatch_table_create(4, id);
+        dispatch_register(tables[id], FREQ_WORK, handle_work, NULL);
+        agents[id] = (Agent){ .agent_id = id, .state_ptr = &states[id],
+                              .dispatch_table = tables[id],
+                              .input_queue = signal_queue_create(queue_capacity) };
+        if (agents[id].input_queue == NULL) {
+            printf("  queue allocation failed (lower signals)\n");
+            return 1;
+        }
+        agent_registry_add(registry, &agents[id]);
+    }
+
+    for (uint32_t c = 0; c < copies; c++) {
+        uint32_t base = 1 + c * net->node_count;
+        for (uint32_t e = 0; e < net->edge_count; e++) {
+            const BenchEdge* edge = &net->edges[e];
+            uint32_t dests[4];
+            for (uint32_t d = 0; d < edge->dest_count; d++) {
+                dests[d] = base + edge->dests[d];
+            }
+            routing_add_entry(routing, base + edge->source, FREQ_WORK,
+                              edge->dest_count, dests);
+        }
+    }
+
+    printf("\n%s (%u copies x %u agents, %u inputs, %u work/signal)\n",
+           net->name, copies, net->node_count, per_copy * copies, work);
+    printf("  %-6s %-8s %10s %14s %8s %10s\n", "mode", "threads", "seconds",
+           "signals/sec", "speedup", "steals");
+
+    double baseline[MODE_COUNT] = { 0.0 };
+    uint64_t expected = (uint64_t)per_copy * copies * net->signals_per_input;
+
+    for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+        for (int m = 0; m < MODE_COUNT; m++) {
+            const char* mode = g_mode_names[m];
+            double elapsed;
+            SchedulerStats stats;
+            int processed = bench_run(net, agents, registry, routing, per_copy, copies,
+                                      threads, m, &elapsed, &stats);
+            if (processed < 0) {
+                printf("  scheduler creation failed\n");
+                return 1;
+            }
+            if ((uint64_t)processed != expected) {
+                printf("  %-6s %-8u processed %d, expected %lu (queue overflow?)\n",
+                       mode, threads, processed, expected);
+                return 1;
+            }
+
+            if (threads == 1) {
+                baseline[m] = elapsed;
+            }
+            printf("  %-6s %-8u %10.4f %14.0f %7.2fx %10lu\n", mode, threads, elapsed,
+                   (double)processed / elapsed, baseline[m] / elapsed, stats.steals);
+        }
+
+        /* Always include max_threads itself */
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2;
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t max_threads = (argc > 1) ? (uint32_t)atoi(argv[1]) : (uint32_t)(cpus > 0 ? cpus : 1);
+    uint32_t signals = (argc > 2) ? (uint32_t)atoi(argv[2]) : 20000;
+    uint32_t work = (argc > 3) ? (uint32_t)atoi(argv[3]) : 2000;
+    uint32_t copies = (argc > 4) ? (uint32_t)atoi(argv[4]) : 8;
+
+    if (max_threads == 0 || signals == 0 || copies == 0) {
+        printf("usage: %s [max_threads] [signals] [work_per_signal] [copies]\n", argv[0]);
+        return 1;
+    }
+
+    if (!heap_init(512 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL PARALLEL SCHEDULER SCALING (1..%u threads)\n", max_threads);
+    printf("═══════════════════════════════════════════════════════════════\n");
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(g_networks) / sizeof(g_networks[0]); i++) {
+        failures += bench_network(&g_networks[i], max_threads, signals, work, copies);
+    }
+
+    return failures;
+}
@@ -0,0 +1,198 @@
+/*
+ * Agent Pool Benchmark
+ *
+ * A swarm of identical agents, each receiving one impulse signal per
+ * round (one scheduler run): the handler damps the agent's velocity, adds
+ * the impulse and moves it. Runs the same load as separate agents (one state struct each,
+ * one shared dispatch table, one indirect call per signal) and as one
+ * agent pool (velocity and position columns, one handler call per round
+ * over every instance), and reports ns per signal.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_pool bench_pool.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_pool [agents] [rounds] [repeats]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FREQ_IMPULSE    1
+#define DAMPING         0.99f
+
+enum { COL_VELOCITY, COL_POSITION };
+
+typedef struct {
+    float velocity;
+    float position;
+} SwarmState;
+
+static int handle_impulse(void* agent_state, Signal* sig) {
+    SwarmState* state = (SwarmState*)agent_state;
+    float impulse;
+    memcpy(&impulse, signal_get_payload(sig), sizeof(impulse));
+    state->velocity = state->velocity * DAMPING + impulse;
+    state->position += state->velocity;
+    return 0;
+}
+
+/*
+ * The same update over a batch: impulses first, then a loop the compiler
+ * vectorizes (-O3) when the batch is a dense range of instances
+ */
+static int pool_impulse(AgentPool* pool, const uint32_t* instances,
+                        Signal* const* signals, uint32_t count) {
+    float* restrict velocity = agent_pool_column(pool, COL_VELOCITY);
+    float* restrict position = agent_pool_column(pool, COL_POSITION);
+    float* restrict impulse = pool->context;
+
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(&impulse[i], signal_get_payload(signals[i]), sizeof(float));
+    }
+
+    if (instances[count - 1] - instances[0] == count - 1) {
+        float* restrict v = velocity + instances[0];
+        float* restrict x = position + instances[0];
+        for (uint32_t i = 0; i < count; i++) {
+            v[i] = v[i] * DAMPING + impulse[i];
+            x[i] += v[i];
+        }
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t n = instances[i];
+        velocity[n] = velocity[n] * DAMPING + impulse[i];
+        position[n] += velocity[n];
+    }
+    return 0;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Queue one impulse to each of agents[0..count)
+ */
+static void enqueue_impulses(Agent* agents, uint32_t count, uint32_t round) {
+    for (uint32_t i = 0; i < count; i++) {
+        float impulse = (float)((i + round) % 7) - 3.0f;
+        Signal* sig = signal_create(FREQ_IMPULSE, 0, &impulse, sizeof(impulse));
+        signal_queue_enqueue(agents[i].input_queue, sig);
+        signal_free(sig);
+    }
+}
+
+/*
+ * Time `rounds` runs of one impulse per agent
+ *
+ * @return: Elapsed ns, or 0 if not every signal was processed
+ */
+static uint64_t bench_run(AgentRegistry* registry, RoutingTable* routing, Agent* agents,
+                          uint32_t count, uint32_t rounds) {
+    Scheduler* sched = scheduler_create(registry, routing);
+    uint64_t elapsed = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        enqueue_impulses(agents, count, r);
+        uint64_t start = now_ns();
+        scheduler_run(sched);
+        elapsed += now_ns() - start;
+    }
+    int processed = (int)scheduler_get_signals_processed(sched);
+    scheduler_destroy(sched);
+    return ((uint64_t)processed == (uint64_t)count * rounds) ? elapsed : 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 10000;
+    uint32_t rounds = (argc > 2) ? (uint32_t)atoi(argv[2]) : 16;
+    uint32_t repeats = (argc > 3) ? (uint32_t)atoi(argv[3]) : 5;
+    if (count == 0 || rounds == 0 || repeats == 0) {
+        printf("usage: %s [agents] [rounds] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    if (!heap_init(512 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    uint32_t queue_capacity = 4;
+    uint64_t expected = (uint64_t)count * rounds;
+
+    /* Separate agents, IDs 1..count */
+    AgentRegistry* registry = agent_registry_create(count + 1);
+    RoutingTable* routing = routing_table_create(4);
+    DispatchTable* dispatch = dispatch_table_create(4, 1);
+    dispatch_register(dispatch, FREQ_IMPULSE, handle_impulse, NULL);
+    Agent* agents = heap_allocate(count * sizeof(Agent));
+    SwarmState* states = heap_allocate(count * sizeof(SwarmState));
+    if (agents == NULL || states == NULL) {
+        printf("allocation failed\n");
+        return 1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        agents[i] = (Agent){ .agent_id = i + 1, .state_ptr = &states[i],
+                             .dispatch_table = dispatch,
+                             .input_queue = signal_queue_create(queue_capacity) };
+        agent_registry_add(registry, &agents[i]);
+    }
+
+    /* The same swarm as a pool */
+    AgentRegistry* pool_registry = agent_registry_create(count + 1);
+    float* impulses = heap_allocate(count * sizeof(float));
+    AgentPool* pool = agent_pool_create(pool_registry, 1, count, queue_capacity, impulses);
+    if (pool == NULL || impulses == NULL ||
+        agent_pool_add_column(pool, sizeof(float)) != COL_VELOCITY ||
+        agent_pool_add_column(pool, sizeof(float)) != COL_POSITION) {
+        printf("pool creation failed\n");
+        return 1;
+    }
+    agent_pool_register(pool, FREQ_IMPULSE, pool_impulse);
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL AGENT POOL (%u agents x %u impulses, best of %u)\n",
+           count, rounds, repeats);
+    printf("═══════════════════════════════════════════════════════════════\n");
+
+    uint64_t best_agents = UINT64_MAX;
+    uint64_t best_pool = UINT64_MAX;
+    for (uint32_t r = 0; r < repeats; r++) {
+        uint64_t elapsed = bench_run(registry, routing, agents, count, rounds);
+        uint64_t pool_elapsed = bench_run(pool_registry, routing, pool->agents, count, rounds);
+        if (elapsed == 0 || pool_elapsed == 0) {
+            printf("  not every signal was processed\n");
+            return 1;
+        }
+        best_agents = (elapsed < best_agents) ? elapsed : best_agents;
+        best_pool = (pool_elapsed < best_pool) ? pool_elapsed : best_pool;
+    }
+
+    /* Both ran the same arithmetic in the same order per agent */
+    const float* position = agent_pool_column(pool, COL_POSITION);
+    for (uint32_t i = 0; i < count; i++) {
+        if (position[i] != states[i].position) {
+            printf("  results differ at agent %u\n", i + 1);
+            return 1;
+        }
+    }
+
+    printf("  %-10s %14s %14s %10s\n", "layout", "ns/signal", "handler calls", "speedup");
+    printf("  %-10s %14.1f %14lu %9.2fx\n", "agents", (double)best_agents / expected,
+           (unsigned long)expected * repeats, 1.0);
+    printf("  %-10s %14.1f %14lu %9.2fx\n", "pool", (double)best_pool / expected,
+           (unsigned long)pool->handler_calls, (double)best_agents / best_pool);
+
+    return 0;
+}
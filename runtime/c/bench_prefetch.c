@@ -0,0 +1,181 @@
+/*
+ * Scheduler Prefetch Benchmark
+ *
+ * Many agents with one signal each and cold caches: every agent, queue,
+ * state block and signal is allocated in shuffled order so neighbours in
+ * ID order are far apart in memory, and a buffer larger than the last
+ * level cache (twice its size unless given) is swept between enqueueing
+ * and the timed run. Each run is
+ * then one sweep dominated by the dependent misses of reaching each
+ * agent's first signal. Reports ns per agent turn with the sweep's
+ * prefetch pipeline off and at a few distances.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_prefetch bench_prefetch.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_prefetch [agents] [rounds] [evict_mb]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FREQ_TOUCH      1
+#define STATE_BYTES     128
+#define PAYLOAD_BYTES   32
+
+static const uint32_t g_distances[] = { 0, 4, 8, 16 };
+#define DISTANCE_COUNT  (sizeof(g_distances) / sizeof(g_distances[0]))
+
+typedef struct {
+    uint64_t sum;
+    uint8_t pad[STATE_BYTES - sizeof(uint64_t)];
+} TouchState;
+
+/*
+ * Read the payload and update the state: one line of each
+ */
+static int handle_touch(void* agent_state, Signal* sig) {
+    TouchState* state = (TouchState*)agent_state;
+    const uint64_t* payload = (const uint64_t*)signal_get_payload(sig);
+    state->sum += payload[0] + payload[PAYLOAD_BYTES / sizeof(uint64_t) - 1];
+    return 0;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Push everything the sweep touches out of the caches
+ */
+static void evict_caches(volatile uint8_t* buffer, size_t bytes) {
+    for (size_t i = 0; i < bytes; i += 64) {
+        buffer[i]++;
+    }
+}
+
+int main(int argc, char** argv) {
+    uint32_t count = (argc > 1) ? (uint32_t)atoi(argv[1]) : 10000;
+    uint32_t rounds = (argc > 2) ? (uint32_t)atoi(argv[2]) : 10;
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    size_t evict_bytes = (argc > 3) ? (size_t)atoi(argv[3]) * 1024 * 1024
+                       : (llc > 0) ? 2 * (size_t)llc : (size_t)64 * 1024 * 1024;
+    if (count == 0 || rounds == 0 || evict_bytes == 0) {
+        printf("usage: %s [agents] [rounds] [evict_mb]\n", argv[0]);
+        return 1;
+    }
+
+    if (!heap_init(512 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+    volatile uint8_t* evict = malloc(evict_bytes);
+    if (evict == NULL) {
+        printf("eviction buffer allocation failed\n");
+        return 1;
+    }
+    memset((void*)evict, 0, evict_bytes);
+
+    /* Agent IDs 1..count, allocated in shuffled order */
+    uint32_t* order = malloc(count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = i + 1;
+    }
+    srand(42);
+    for (uint32_t i = count - 1; i > 0; i--) {
+        uint32_t j = (uint32_t)rand() % (i + 1);
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    AgentRegistry* registry = agent_registry_create(count + 1);
+    RoutingTable* routing = routing_table_create(4);
+    DispatchTable* dispatch = dispatch_table_create(4, 1);
+    dispatch_register(dispatch, FREQ_TOUCH, handle_touch, NULL);
+    Agent** agents = calloc(count + 1, sizeof(Agent*));
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t id = order[i];
+        Agent* agent = heap_allocate(sizeof(Agent));
+        if (agent == NULL) {
+            printf("allocation failed\n");
+            return 1;
+        }
+        *agent = (Agent){ .agent_id = id, .state_ptr = heap_allocate(sizeof(TouchState)),
+                          .dispatch_table = dispatch, .input_queue = signal_queue_create(4) };
+        agents[id] = agent;
+    }
+    for (uint32_t id = 1; id <= count; id++) {
+        agent_registry_add(registry, agents[id]);
+    }
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL SWEEP PREFETCH (%u agents, %zu MB evicted, %u rounds)\n",
+           count, evict_bytes >> 20, rounds);
+    printf("═══════════════════════════════════════════════════════════════\n");
+
+    uint64_t best[DISTANCE_COUNT];
+    uint64_t total[DISTANCE_COUNT];
+    for (uint32_t d = 0; d < DISTANCE_COUNT; d++) {
+        best[d] = UINT64_MAX;
+        total[d] = 0;
+    }
+
+    /* Interleave the distances so drift hits them all alike */
+    uint64_t payload[PAYLOAD_BYTES / sizeof(uint64_t)] = { 0 };
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t d = 0; d < DISTANCE_COUNT; d++) {
+            /* An empty run first, so the timed one does not start by
+             * scanning (and warming) every agent to track it */
+            Scheduler* sched = scheduler_create(registry, routing);
+            scheduler_set_prefetch(sched, g_distances[d]);
+            scheduler_run(sched);
+
+            /* Signals created in shuffled order too */
+            for (uint32_t i = 0; i < count; i++) {
+                payload[0] = order[i];
+                Signal* sig = signal_create(FREQ_TOUCH, 0, payload, sizeof(payload));
+                signal_queue_enqueue(agents[order[i]]->input_queue, sig);
+                signal_free(sig);
+            }
+            evict_caches(evict, evict_bytes);
+
+            uint64_t start = now_ns();
+            int processed = scheduler_run(sched);
+            uint64_t elapsed = now_ns() - start;
+            scheduler_destroy(sched);
+
+            if (processed != (int)count) {
+                printf("  processed %d of %u\n", processed, count);
+                return 1;
+            }
+            total[d] += elapsed;
+            if (elapsed < best[d]) {
+                best[d] = elapsed;
+            }
+        }
+    }
+
+    printf("  %-10s %14s %14s %10s\n", "distance", "best ns/turn", "mean ns/turn", "speedup");
+    for (uint32_t d = 0; d < DISTANCE_COUNT; d++) {
+        double mean = (double)total[d] / rounds / count;
+        double base = (double)total[0] / rounds / count;
+        char label[16];
+        snprintf(label, sizeof(label), g_distances[d] ? "%u" : "off", g_distances[d]);
+        printf("  %-10s %14.1f %14.1f %9.2fx\n", label, (double)best[d] / count, mean,
+               base / mean);
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Agent Replication Benchmark
+ *
+ * A source forwards every input to a stateless transform stage that does
+ * a fixed amount of work per signal. The stage runs as 1, 2, 4, ... up to
+ * max replicas (round-robin routing) on the work-stealing scheduler with
+ * one worker per replica, and throughput is reported against one replica.
+ * With enough cores the stage should scale linearly until the source's
+ * forwarding cost dominates.
+ *
+ * Build: gcc -O2 -std=gnu11 -pthread -o bench_replica bench_replica.c \
+ *            signal.c memory.c routing.c dispatch.c scheduler.c \
+ *            scheduler_idle.c scheduler_parallel.c scheduler_bsp.c \
+ *            scheduler_timer.c scheduler_placement.c scheduler_offload.c \
+ *            scheduler_coro.c scheduler_class.c scheduler_fair.c \
+ *            scheduler_pool.c
+ * Usage: ./bench_replica [max_replicas] [signals] [work_per_signal]
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FREQ_INPUT      1
+#define FREQ_ITEM       2
+#define AGENT_SOURCE    1
+#define AGENT_STAGE     2           /* Replica 0; replicas 1.. follow */
+#define MAX_REPLICAS    64
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t work;
+    uint64_t checksum;
+} StageState;
+
+static int handle_input(void* agent_state, Signal* sig) {
+    StageState* state = (StageState*)agent_state;
+    emit_signal(state->routing, state->registry, FREQ_ITEM, AGENT_SOURCE,
+                signal_get_payload(sig), signal_get_payload_size(sig));
+    return 0;
+}
+
+static int handle_item(void* agent_state, Signal* sig) {
+    StageState* state = (StageState*)agent_state;
+    uint32_t x;
+    memcpy(&x, signal_get_payload(sig), sizeof(x));
+    x |= 1;
+    for (uint32_t i = 0; i < state->work; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    state->checksum += x;
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t max_replicas = (argc > 1) ? (uint32_t)atoi(argv[1]) : (uint32_t)(cpus > 1 ? cpus : 1);
+    uint32_t signals = (argc > 2) ? (uint32_t)atoi(argv[2]) : 200000;
+    uint32_t work = (argc > 3) ? (uint32_t)atoi(argv[3]) : 2000;
+    if (max_replicas == 0 || max_replicas > MAX_REPLICAS || signals == 0) {
+        printf("usage: %s [max_replicas (1..%d)] [signals] [work_per_signal]\n",
+               argv[0], MAX_REPLICAS);
+        return 1;
+    }
+
+    if (!heap_init(256 * 1024 * 1024)) {
+        printf("heap_init failed\n");
+        return 1;
+    }
+
+    uint32_t agent_count = AGENT_STAGE + max_replicas;
+    uint32_t queue_capacity = next_power_of_two(signals);
+    AgentRegistry* registry = agent_registry_create(agent_count);
+    RoutingTable* routing = routing_table_create(4);
+    DispatchTable* source_dispatch = dispatch_table_create(4, AGENT_SOURCE);
+    DispatchTable* stage_dispatch = dispatch_table_create(4, AGENT_STAGE);
+    dispatch_register(source_dispatch, FREQ_INPUT, handle_input, NULL);
+    dispatch_register(stage_dispatch, FREQ_ITEM, handle_item, NULL);
+    uint32_t stage = AGENT_STAGE;
+    routing_add_entry(routing, AGENT_SOURCE, FREQ_ITEM, 1, &stage);
+
+    Agent* agents = calloc(agent_count, sizeof(Agent));
+    StageState* states = calloc(agent_count, sizeof(StageState));
+    uint32_t* replica_ids = calloc(max_replicas, sizeof(uint32_t));
+    for (uint32_t id = AGENT_SOURCE; id < agent_count; id++) {
+        states[id] = (StageState){ .routing = routing, .registry = registry, .work = work };
+        agents[id] = (Agent){ .agent_id = id, .state_ptr = &states[id],
+                              .dispatch_table = (id == AGENT_SOURCE) ? source_dispatch
+                                                                     : stage_dispatch,
+                              .input_queue = signal_queue_create(queue_capacity) };
+        agent_registry_add(registry, &agents[id]);
+        if (id >= AGENT_STAGE) {
+            replica_ids[id - AGENT_STAGE] = id;
+        }
+    }
+
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  MYCELIAL AGENT REPLICATION (%u signals, work %u, %ld CPUs)\n",
+           signals, work, cpus);
+    printf("═══════════════════════════════════════════════════════════════\n");
+    printf("  %-10s %8s %14s %10s\n", "replicas", "threads", "signals/sec", "speedup");
+
+    double base_rate = 0.0;
+    for (uint32_t replicas = 1; replicas <= max_replicas; replicas *= 2) {
+        routing_set_replicas(routing, AGENT_STAGE, replicas, replica_ids, 0, 0);
+        for (uint32_t i = 0; i < signals; i++) {
+            Signal* sig = signal_create(FREQ_INPUT, 0, &i, sizeof(i));
+            signal_queue_enqueue(agents[AGENT_SOURCE].input_queue, sig);
+            signal_free(sig);
+        }
+
+        Scheduler* sched = (replicas > 1) ? scheduler_create_parallel(registry, routing, replicas)
+                                          : scheduler_create(registry, routing);
+        double start = now_seconds();
+        int processed = scheduler_run(sched);
+        double elapsed = now_seconds() - start;
+        scheduler_destroy(sched);
+
+        if (processed != (int)(2 * signals)) {
+            printf("  %u replicas: processed %d of %u\n", replicas, processed, 2 * signals);
+            return 1;
+        }
+        double rate = (double)signals / elapsed;
+        if (replicas == 1) {
+            base_rate = rate;
+        }
+        printf("  %-10u %8u %14.0f %9.2fx\n", replicas, replicas, rate, rate / base_rate);
+    }
+
+    return 0;
+}
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /* Forward declarations */
 struct Signal;
@@ -46,6 +47,78 @@ typedef int (*signal_handler_fn)(void* agent_state, struct Signal* signal);
  */
 typedef int (*guard_fn)(void* agent_state, struct Signal* signal);
 
+/*
+ * Batch handler function signature
+ *
+ * @param agent_state: Pointer to agent's state structure
+ * @param signals: Contiguous run of signals with the same frequency,
+ *                 in queue order (all have passed the guard, if any)
+ * @param count: Number of signals in the run (1..DISPATCH_BATCH_MAX)
+ * @return: 0 on success, non-zero on error
+ *
+ * Lets stream consumers (e.g. a parser fed by the lexer's token stream)
+ * handle a run of signals with one call instead of one call per signal.
+ */
+typedef int (*batch_handler_fn)(void* agent_state, struct Signal** signals,
+                                uint32_t count);
+
+/* =============================================================================
+ * GUARD PREDICATES
+ *
+ * Declarative form of simple `where` clauses: compare a payload field
+ * against a constant or an agent state field. Unlike opaque guard_fn
+ * pointers the runtime can evaluate these over a whole run of queued
+ * signals at once (gather field into a column, compare the column).
+ * ============================================================================= */
+
+/* Field types */
+#define GUARD_FIELD_U8              0
+#define GUARD_FIELD_I8              1
+#define GUARD_FIELD_U16             2
+#define GUARD_FIELD_I16             3
+#define GUARD_FIELD_U32             4
+#define GUARD_FIELD_I32             5
+#define GUARD_FIELD_U64             6
+#define GUARD_FIELD_I64             7
+
+/* Comparison operators (field OP operand) */
+#define GUARD_OP_EQ                 0
+#define GUARD_OP_NE                 1
+#define GUARD_OP_LT                 2
+#define GUARD_OP_LE                 3
+#define GUARD_OP_GT                 4
+#define GUARD_OP_GE                 5
+
+/* Operand kinds */
+#define GUARD_OPERAND_CONST         0   /* Compare against constant */
+#define GUARD_OPERAND_STATE         1   /* Compare against agent state field */
+
+/*
+ * One comparison: payload[field_offset] OP operand
+ *
+ * Layout: 24 bytes
+ */
+typedef struct GuardPredicate {
+    uint16_t field_offset;          /* 0x00: Byte offset of field in payload */
+    uint8_t  field_type;            /* 0x02: GUARD_FIELD_* */
+    uint8_t  op;                    /* 0x03: GUARD_OP_* */
+    uint8_t  operand_kind;          /* 0x04: GUARD_OPERAND_* */
+    uint8_t  reserved[3];           /* 0x05: Padding */
+    uint32_t state_offset;          /* 0x08: State field offset (same type) */
+    uint32_t reserved2;             /* 0x0C: Padding */
+    int64_t  constant;              /* 0x10: Constant operand */
+} GuardPredicate;
+
+/* Conjunction of predicates attached to a dispatch entry */
+typedef struct GuardPredicateSet {
+    uint32_t count;                 /* Number of predicates (all must pass) */
+    uint32_t flags;                 /* GUARD_SET_* flags */
+    GuardPredicate predicates[];    /* Predicates */
+} GuardPredicateSet;
+
+/* GuardPredicateSet flags */
+#define GUARD_SET_STATE_FREE        0x0001  /* No state operands */
+
 /* =============================================================================
  * DISPATCH TABLE STRUCTURES
  * ============================================================================= */
@@ -53,44 +126,107 @@ typedef int (*guard_fn)(void* agent_state, struct Signal* signal);
 /*
  * Single dispatch entry - maps frequency_id to handler
  *
- * Layout: 24 bytes
+ * Layout: 40 bytes
  * - 4 bytes: frequency_id
  * - 4 bytes: flags (has_guard, etc.)
  * - 8 bytes: handler function pointer
  * - 8 bytes: guard function pointer (NULL if no guard)
+ * - 8 bytes: batch handler function pointer (NULL if none)
+ * - 8 bytes: guard predicates (NULL if none)
  */
 typedef struct DispatchEntry {
     uint32_t frequency_id;          /* 0x00: Signal frequency to match */
     uint32_t flags;                 /* 0x04: Entry flags */
     signal_handler_fn handler;      /* 0x08: Handler function pointer */
     guard_fn guard;                 /* 0x10: Optional guard function */
+    batch_handler_fn batch_handler; /* 0x18: Optional batch handler */
+    GuardPredicateSet* predicates;  /* 0x20: Optional declarative guard */
 } DispatchEntry;
 
 /* DispatchEntry flags */
 #define DISPATCH_FLAG_ACTIVE        0x0001  /* Entry is active */
 #define DISPATCH_FLAG_HAS_GUARD     0x0002  /* Entry has guard clause */
 #define DISPATCH_FLAG_CATCHALL      0x0004  /* Matches any frequency */
+#define DISPATCH_FLAG_BATCH         0x0008  /* Entry has batch handler */
+#define DISPATCH_FLAG_HAS_PREDICATES 0x0010 /* Entry has guard predicates */
+#define DISPATCH_FLAG_BLOCKING      0x0020  /* Handler may block (offloaded) */
+
+/* Longest same-frequency run passed to one batch handler call */
+#define DISPATCH_BATCH_MAX          64
 
 /*
  * Dispatch table for one agent
  *
  * Contains all handlers registered for a single agent.
- * Lookup is O(n) for small tables (< 16 entries) or O(1) with hash.
+ * Lookup is O(1): frequency IDs below DISPATCH_DIRECT_LIMIT index a dense
+ * array of entry slots; larger (sparse) IDs go through a small open-address
+ * hash. Both indexes are rebuilt on register/unregister, never on lookup.
  *
- * Layout: 40 bytes
+ * Layout: 96 bytes
  */
 typedef struct DispatchTable {
     DispatchEntry* entries;         /* 0x00: Array of dispatch entries */
-    uint32_t entry_count;           /* 0x08: Number of active entries */
-    uint32_t capacity;              /* 0x0C: Max entries */
+    uint32_t entry_count;           /* 0x08: Number of used entry slots */
+    uint32_t capacity;              /* 0x0C: Max entries (grows on demand) */
     signal_handler_fn default_handler;  /* 0x10: Called if no match found */
     void* agent_state;              /* 0x18: Cached agent state pointer */
-    uint32_t agent_id;              /* 0x20: Agent this table belongs to */
+    uint32_t agent_id;              /* 0x20: Agent this table belongs to (or DISPATCH_AGENT_SHARED) */
     uint32_t lookup_count;          /* 0x24: Stats: total lookups */
     uint32_t hit_count;             /* 0x28: Stats: successful lookups */
     uint32_t miss_count;            /* 0x2C: Stats: failed lookups */
+    uint16_t* direct;               /* 0x30: freq -> entry slot + 1 (0 = none) */
+    uint32_t direct_size;           /* 0x38: Length of direct[] */
+    uint32_t hash_mask;             /* 0x3C: Sparse hash size - 1 (0 = none) */
+    uint64_t* hash;                 /* 0x40: (freq << 32) | (slot + 1) */
+    struct ProfileDirectory* profiles;  /* 0x48: Per-(agent, slot) profiles (lazy, NULL = none) */
+    struct DispatchTable* profile_next; /* 0x50: Next table in the profiled list */
+    uint32_t error_count;           /* 0x58: Failed/unhandled signals in queue processing (atomic) */
+    uint32_t blocking_count;        /* 0x5C: Entries marked DISPATCH_FLAG_BLOCKING */
 } DispatchTable;
 
+/*
+ * agent_id of a table shared by several agents (agent types). Calls that
+ * don't name the running agent are profiled under it and reported as
+ * "shared"; the *_for_agent calls key profiles by the real agent.
+ */
+#define DISPATCH_AGENT_SHARED       UINT32_MAX
+
+/* Frequencies below this use the direct array; the rest use the hash */
+#define DISPATCH_DIRECT_LIMIT       256
+
+/*
+ * Dispatch statistics (lookup/hit/miss counters)
+ *
+ * Compiled out unless DISPATCH_ENABLE_STATS is defined when building
+ * dispatch.c; the getters then return 0.
+ */
+#ifdef DISPATCH_ENABLE_STATS
+#define DISPATCH_STAT_INC(counter)  ((counter)++)
+#define DISPATCH_STAT_ADD(counter, n) ((counter) += (n))
+#else
+#define DISPATCH_STAT_INC(counter)  ((void)sizeof(counter))
+#define DISPATCH_STAT_ADD(counter, n) ((void)sizeof(counter), (void)(n))
+#endif
+
+/*
+ * Per-handler profile (one per agent and entry slot, allocated on the
+ * agent's first profiled call)
+ *
+ * Layout (280 bytes):
+ *   0x00: invocations (8 bytes) - Signals handled
+ *   0x08: total_cycles (8 bytes) - TSC cycles spent in guard + handler
+ *   0x10: max_cycles (8 bytes) - Slowest single call
+ *   0x18: histogram[32] (256 bytes) - Calls by log2(cycles)
+ */
+#define DISPATCH_PROFILE_BUCKETS    32
+
+typedef struct HandlerProfile {
+    uint64_t invocations;           /* 0x00 */
+    uint64_t total_cycles;          /* 0x08 */
+    uint64_t max_cycles;            /* 0x10 */
+    uint64_t histogram[DISPATCH_PROFILE_BUCKETS];  /* 0x18: bucket b = [2^b, 2^(b+1)) */
+} HandlerProfile;
+
 /* =============================================================================
  * DISPATCH RESULT CODES
  * ============================================================================= */
@@ -101,6 +237,7 @@ typedef struct DispatchTable {
 #define DISPATCH_ERR_NULL_POINTER   3   /* NULL table or signal */
 #define DISPATCH_ERR_HANDLER_FAILED 4   /* Handler returned non-zero */
 #define DISPATCH_ERR_ALLOC_FAILED   5   /* Memory allocation failed */
+#define DISPATCH_ERR_INVALID_ARG    6   /* Malformed argument (e.g. predicate) */
 
 /* =============================================================================
  * DISPATCH TABLE FUNCTIONS
@@ -134,6 +271,77 @@ void dispatch_table_destroy(DispatchTable* table);
 int dispatch_register(DispatchTable* table, uint32_t frequency_id,
                       signal_handler_fn handler, guard_fn guard);
 
+/*
+ * Register a batch handler for a frequency
+ *
+ * When the queue holds consecutive signals of this frequency, the queue
+ * processing functions dequeue the whole run (up to DISPATCH_BATCH_MAX)
+ * and invoke the batch handler once. A single-signal handler registered
+ * for the same frequency is kept and used by dispatch_invoke; without one,
+ * dispatch_invoke calls the batch handler with a run of 1.
+ *
+ * @param table: Dispatch table
+ * @param frequency_id: Signal frequency to handle
+ * @param batch_handler: Batch handler function pointer
+ * @param guard: Optional guard, applied per signal before batching
+ * @return: DISPATCH_OK on success
+ */
+int dispatch_register_batch(DispatchTable* table, uint32_t frequency_id,
+                            batch_handler_fn batch_handler, guard_fn guard);
+
+/*
+ * Attach declarative guard predicates to a registered frequency
+ *
+ * All predicates must pass (AND) in addition to any guard_fn. Signals
+ * whose payload is too short for a field fail the predicate. The
+ * predicates are copied; pass count = 0 to remove them.
+ *
+ * Queue processing evaluates predicates over a whole run of same-frequency
+ * signals before dispatch and discards the ones that fail. For batch
+ * handlers the whole run is filtered up front; for single handlers bulk
+ * filtering is used only when no predicate reads agent state (otherwise
+ * earlier handlers in the run could change the outcome).
+ *
+ * @param table: Dispatch table
+ * @param frequency_id: Registered frequency
+ * @param predicates: Array of predicates
+ * @param count: Number of predicates
+ * @return: DISPATCH_OK, DISPATCH_ERR_NO_HANDLER if frequency not registered
+ */
+int dispatch_set_predicates(DispatchTable* table, uint32_t frequency_id,
+                            const GuardPredicate* predicates, uint32_t count);
+
+/*
+ * Evaluate predicates over a run of signals
+ *
+ * Gathers each predicate's field into a column and compares the column
+ * against the operand, ANDing results into pass[]. Fields up to 4 bytes
+ * use an int32 column compared with SSE2, 16 signals per step.
+ *
+ * @param set: Predicate set
+ * @param agent_state: Agent state (for state operands)
+ * @param signals: Signals to test
+ * @param count: Number of signals (<= DISPATCH_BATCH_MAX)
+ * @param pass: Output: 1 if signal passes all predicates, else 0
+ * @return: Number of passing signals
+ */
+uint32_t dispatch_filter_predicates(const GuardPredicateSet* set, void* agent_state,
+                                    struct Signal** signals, uint32_t count,
+                                    uint8_t* pass);
+
+/*
+ * Mark a registered handler as blocking (file I/O, syscalls that may stall)
+ *
+ * A scheduler with an offload pool (scheduler_set_offload) runs signals
+ * for blocking handlers on a pool thread instead of the tidal loop.
+ *
+ * @param table: Dispatch table
+ * @param frequency_id: Registered frequency
+ * @param blocking: Non-zero to mark, zero to clear
+ * @return: DISPATCH_OK, DISPATCH_ERR_NO_HANDLER if frequency not registered
+ */
+int dispatch_set_blocking(DispatchTable* table, uint32_t frequency_id, int blocking);
+
 /*
  * Unregister a handler from the dispatch table
  *
@@ -212,22 +420,105 @@ int dispatch_invoke(DispatchTable* table, struct Signal* signal);
 int dispatch_invoke_with_state(DispatchTable* table, void* agent_state,
                                struct Signal* signal);
 
+/*
+ * Execute handler for a given agent
+ *
+ * Same as dispatch_invoke_with_state, for tables shared by several agents:
+ * the profile is recorded against agent_id rather than the table's agent.
+ *
+ * @param table: Dispatch table
+ * @param agent_id: Agent the handler runs for
+ * @param agent_state: Agent state pointer
+ * @param signal: Signal to dispatch
+ * @return: DISPATCH_OK on success, error code on failure
+ */
+int dispatch_invoke_for_agent(DispatchTable* table, uint32_t agent_id,
+                              void* agent_state, struct Signal* signal);
+
 /* =============================================================================
  * DISPATCH STATISTICS
  * ============================================================================= */
 
 /*
- * Get dispatch statistics
+ * Get dispatch statistics (always 0 unless built with DISPATCH_ENABLE_STATS)
  */
 uint32_t dispatch_get_lookup_count(DispatchTable* table);
 uint32_t dispatch_get_hit_count(DispatchTable* table);
 uint32_t dispatch_get_miss_count(DispatchTable* table);
 
+/*
+ * Get number of registered handlers (active entries)
+ */
+uint32_t dispatch_get_handler_count(DispatchTable* table);
+
+/*
+ * Get number of failed or unhandled signals seen by queue processing
+ * (always counted, independent of DISPATCH_ENABLE_STATS)
+ */
+uint32_t dispatch_get_error_count(DispatchTable* table);
+
 /*
  * Reset dispatch statistics
  */
 void dispatch_reset_stats(DispatchTable* table);
 
+/* =============================================================================
+ * HANDLER PROFILING
+ *
+ * Off by default. When off, dispatch pays one predictable branch per call.
+ * When on, each handler call is timed with RDTSC and recorded against its
+ * (agent, frequency) entry. The agent is the one being run, not the table's
+ * owner: agents sharing a table (replicas, typed instances) are profiled and
+ * reported separately. Batch runs record one sample of the per-signal
+ * average.
+ * ============================================================================= */
+
+/*
+ * Enable or disable handler profiling (process-wide)
+ *
+ * @param enabled: Non-zero to enable
+ */
+void dispatch_profiling_enable(int enabled);
+
+/*
+ * Check whether handler profiling is enabled
+ */
+int dispatch_profiling_enabled(void);
+
+/*
+ * Get the profile for a handler, as run for the table's own agent
+ *
+ * @param table: Dispatch table
+ * @param frequency_id: Registered frequency
+ * @return: Profile, or NULL if the handler has never been profiled
+ */
+const HandlerProfile* dispatch_get_profile(DispatchTable* table, uint32_t frequency_id);
+
+/*
+ * Get the profile for a handler, as run for a given agent
+ *
+ * @param table: Dispatch table (possibly shared by several agents)
+ * @param agent_id: Agent the handler ran for
+ * @param frequency_id: Registered frequency
+ * @return: Profile, or NULL if the handler never ran profiled for the agent
+ */
+const HandlerProfile* dispatch_get_agent_profile(DispatchTable* table, uint32_t agent_id,
+                                                 uint32_t frequency_id);
+
+/*
+ * Clear all recorded profiles (profiling state is unchanged)
+ */
+void dispatch_profile_reset(void);
+
+/*
+ * Write a report of profiled handlers, ranked by total cycles
+ *
+ * @param out: Output stream
+ * @param max_rows: Maximum handlers to list (0 = all)
+ * @return: Number of handlers listed, or -1 on allocation failure
+ */
+int dispatch_profile_report(FILE* out, uint32_t max_rows);
+
 /* =============================================================================
  * AGENT EVENT LOOP SUPPORT
  * ============================================================================= */
@@ -235,7 +526,8 @@ void dispatch_reset_stats(DispatchTable* table);
 /*
  * Process all signals in an agent's queue
  *
- * Dequeues signals one at a time and dispatches to handlers.
+ * Dequeues signals and dispatches to handlers. Runs of consecutive signals
+ * whose frequency has a batch handler are delivered in one call.
  * Returns number of signals processed.
  *
  * @param table: Dispatch table for the agent
@@ -258,4 +550,40 @@ int dispatch_process_queue(DispatchTable* table, struct SignalQueue* queue);
 int dispatch_process_batch(DispatchTable* table, struct SignalQueue* queue,
                            uint32_t max_signals);
 
+/*
+ * Process up to N signals from queue with explicit state pointer
+ *
+ * Same as dispatch_process_batch but uses the provided state instead of
+ * the table's cached state (for schedulers that own the state pointer).
+ *
+ * @param table: Dispatch table
+ * @param agent_state: Agent state pointer
+ * @param queue: Agent's input queue
+ * @param max_signals: Maximum signals to process
+ * @return: Number of signals actually processed
+ */
+int dispatch_process_batch_with_state(DispatchTable* table, void* agent_state,
+                                      struct SignalQueue* queue,
+                                      uint32_t max_signals);
+
+/*
+ * Process up to N signals from queue for a given agent
+ *
+ * Same as dispatch_process_batch_with_state, for tables shared by several
+ * agents (which may run at once on different workers): profiles are keyed
+ * by agent_id, and this call's errors are returned through errors instead
+ * of being read back from the shared table.
+ *
+ * @param table: Dispatch table
+ * @param agent_id: Agent being run
+ * @param agent_state: Agent state pointer
+ * @param queue: Agent's input queue
+ * @param max_signals: Maximum signals to process
+ * @param errors: Set to this call's failed/unhandled signals (may be NULL)
+ * @return: Number of signals actually processed
+ */
+int dispatch_process_batch_for_agent(DispatchTable* table, uint32_t agent_id,
+                                     void* agent_state, struct SignalQueue* queue,
+                                     uint32_t max_signals, uint32_t* errors);
+
 #endif /* MYCELIAL_DISPATCH_H */
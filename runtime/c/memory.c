@@ -16,6 +16,19 @@
 
 static HeapState g_heap = {0};
 static int g_heap_initialized = 0;
+static uint32_t g_heap_lock = 0;
+
+/* Non-zero while worker threads share the runtime (see signal.h) */
+int g_runtime_threaded = 0;
+
+/*
+ * Enable/disable threaded mode
+ *
+ * @param threaded: Non-zero while a parallel scheduler runs
+ */
+void runtime_set_threaded(int threaded) {
+    g_runtime_threaded = (threaded != 0);
+}
 
 /* =============================================================================
  * LINUX SYSCALL WRAPPERS
@@ -66,7 +79,8 @@ static int sys_munmap(void* ptr, size_t size) {
  * Initialize the heap allocator
  *
  * Design decisions:
- * - Pre-allocate a large contiguous region (default 16MB)
+ * - Pre-allocate a large contiguous region (default 16MB), and add regions
+ *   as needed (heap_grow)
  * - Use bump allocation for speed
  * - Maintain free list for reuse of freed blocks
  *
@@ -100,38 +114,58 @@ int heap_init(size_t initial_size) {
     g_heap.used = 0;
     g_heap.peak_used = 0;
     g_heap.free_list = NULL;
+    memset(g_heap.free_bins, 0, sizeof(g_heap.free_bins));
 
     g_heap_initialized = 1;
     return 1;
 }
 
+/*
+ * Continue in a new region once the current one is used up
+ *
+ * The region doubles the heap (at least `bytes`), so a large network costs
+ * a logarithmic number of mmaps. The unused tail of the old region is
+ * abandoned; blocks in it stay valid and freed ones are still reused via
+ * the free list.
+ *
+ * @param bytes: Allocation that did not fit
+ * @return: 1 on success, 0 if the kernel refused
+ */
+static int heap_grow(size_t bytes) {
+    size_t page_size = 4096;
+    size_t size = (g_heap.total_size > bytes) ? g_heap.total_size : bytes;
+    size = (size + page_size - 1) & ~(page_size - 1);
+
+    void* region = sys_mmap(size);
+    if (region == NULL) {
+        return 0;
+    }
+
+    g_heap.current = region;
+    g_heap.end = (char*)region + size;
+    g_heap.total_size += size;
+    return 1;
+}
+
 /* =============================================================================
  * HEAP ALLOCATION
  *
- * Strategy: Bump allocator with free list
+ * Strategy: Bump allocator with free lists
  * - Fast allocation (just increment pointer)
- * - Freed blocks go to free list for reuse
- * - Best-fit search on free list
+ * - Freed blocks go to free lists for reuse
+ * - Small blocks: one LIFO list per size, so reuse is O(1) however many
+ *   blocks were freed (tearing down a large network frees hundreds of
+ *   thousands, and a shared list would be walked on every later bump)
+ * - Larger blocks: first-fit search on the general free list
  * ============================================================================= */
 
 /*
- * Allocate memory from heap
+ * Allocate memory from heap (caller holds the heap lock in threaded mode)
  *
- * @param bytes: Number of bytes to allocate
+ * @param bytes: Number of bytes to allocate (non-zero)
  * @return: Pointer to allocated memory (zeroed), or NULL on failure
  */
-void* heap_allocate(size_t bytes) {
-    if (!g_heap_initialized) {
-        /* Auto-initialize with default size */
-        if (!heap_init(0)) {
-            return NULL;
-        }
-    }
-
-    if (bytes == 0) {
-        return NULL;
-    }
-
+static void* heap_allocate_unlocked(size_t bytes) {
     /* Align to 8 bytes for proper alignment */
     bytes = (bytes + 7) & ~((size_t)7);
 
@@ -140,9 +174,11 @@ void* heap_allocate(size_t bytes) {
         bytes = sizeof(FreeBlock);
     }
 
-    /* First, check free list for suitable block */
-    FreeBlock** prev = (FreeBlock**)&g_heap.free_list;
-    FreeBlock* block = g_heap.free_list;
+    /* Small blocks come off their size's list, larger ones first-fit off
+     * the general list */
+    FreeBlock** prev = (bytes <= HEAP_BIN_MAX) ? (FreeBlock**)&g_heap.free_bins[bytes >> 3]
+                                               : (FreeBlock**)&g_heap.free_list;
+    FreeBlock* block = *prev;
 
     while (block != NULL) {
         if (block->size >= bytes) {
@@ -168,10 +204,13 @@ void* heap_allocate(size_t bytes) {
     void* ptr = g_heap.current;
     void* new_current = (char*)g_heap.current + bytes;
 
-    /* Check if we have space */
+    /* Check if we have space, else grow into a new region */
     if (new_current > g_heap.end) {
-        /* Out of memory - could expand heap here, but for now fail */
-        return NULL;
+        if (!heap_grow(bytes)) {
+            return NULL;
+        }
+        ptr = g_heap.current;
+        new_current = (char*)g_heap.current + bytes;
     }
 
     /* Advance allocation pointer */
@@ -187,6 +226,34 @@ void* heap_allocate(size_t bytes) {
     return ptr;
 }
 
+/*
+ * Allocate memory from heap
+ *
+ * @param bytes: Number of bytes to allocate
+ * @return: Pointer to allocated memory (zeroed), or NULL on failure
+ */
+void* heap_allocate(size_t bytes) {
+    if (!g_heap_initialized) {
+        /* Auto-initialize with default size */
+        if (!heap_init(0)) {
+            return NULL;
+        }
+    }
+
+    if (bytes == 0) {
+        return NULL;
+    }
+
+    if (!g_runtime_threaded) {
+        return heap_allocate_unlocked(bytes);
+    }
+
+    runtime_spin_lock(&g_heap_lock);
+    void* ptr = heap_allocate_unlocked(bytes);
+    runtime_spin_unlock(&g_heap_lock);
+    return ptr;
+}
+
 /*
  * Free previously allocated memory
  *
@@ -214,17 +281,69 @@ int heap_free(void* ptr, size_t bytes) {
     /* Create free block header in the freed memory */
     FreeBlock* block = (FreeBlock*)ptr;
     block->size = bytes;
-    block->next = g_heap.free_list;
 
-    /* Add to front of free list */
-    g_heap.free_list = block;
+    if (g_runtime_threaded) {
+        runtime_spin_lock(&g_heap_lock);
+    }
+
+    /* Add to front of its free list */
+    if (bytes <= HEAP_BIN_MAX) {
+        block->next = g_heap.free_bins[bytes >> 3];
+        g_heap.free_bins[bytes >> 3] = block;
+    } else {
+        block->next = g_heap.free_list;
+        g_heap.free_list = block;
+    }
 
     /* Update stats */
     g_heap.used -= bytes;
 
+    if (g_runtime_threaded) {
+        runtime_spin_unlock(&g_heap_lock);
+    }
+
     return 0;
 }
 
+/*
+ * Allocate memory on an alignment boundary
+ *
+ * Over-allocates by `alignment` and keeps the underlying block's address
+ * in the word just before the aligned pointer (heap blocks are 8-aligned,
+ * so that word always lies in the padding).
+ *
+ * @param bytes: Number of bytes to allocate
+ * @param alignment: Power of two, at least 8
+ * @return: Aligned pointer to zeroed memory, or NULL on failure
+ */
+void* heap_allocate_aligned(size_t bytes, size_t alignment) {
+    if (bytes == 0 || alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return NULL;
+    }
+
+    char* raw = heap_allocate(bytes + alignment);
+    if (raw == NULL) {
+        return NULL;
+    }
+
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+/*
+ * Free memory from heap_allocate_aligned
+ *
+ * @param bytes, alignment: As passed to heap_allocate_aligned
+ * @return: 0 on success
+ */
+int heap_free_aligned(void* ptr, size_t bytes, size_t alignment) {
+    if (ptr == NULL) {
+        return 0;
+    }
+    return heap_free(((void**)ptr)[-1], bytes + alignment);
+}
+
 /* =============================================================================
  * HEAP STATISTICS
  * ============================================================================= */
@@ -282,7 +401,9 @@ SignalQueue* create_signal_queue(uint32_t capacity) {
     queue->dropped_count = 0;
     queue->owner_agent_id = 0;
     queue->flags = QUEUE_FLAG_ACTIVE;
+    queue->lock = 0;
     queue->reserved = 0;
+    queue->watcher = NULL;
 
     return queue;
 }
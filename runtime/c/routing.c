@@ -7,6 +7,7 @@
  */
 
 #include "signal.h"
+#include "dispatch.h"
 #include <string.h>
 
 /* =============================================================================
@@ -17,8 +18,34 @@
  * - Linear probing for collision resolution
  * - Power-of-2 capacity for fast modulo
  * - Cache queue pointers for fast signal delivery
+ * - Per-edge traffic counters, sharded per thread (no atomics on hot path)
+ * - Replicated destinations are resolved per delivery, only on routes
+ *   flagged ROUTE_FLAG_REPLICATED; edge stats stay on the logical edge
  * ============================================================================= */
 
+/* Stats shard updated by the calling thread (worker index) */
+static _Thread_local uint32_t g_stats_shard = 0;
+
+/* Deferred-delivery outbox of the calling thread (NULL = enqueue directly) */
+static _Thread_local RouteOutbox* g_route_outbox = NULL;
+
+/* Direct calls currently nested on this thread's stack */
+static _Thread_local uint32_t g_direct_depth = 0;
+
+/* Handlers run inline on this thread (and how many failed), until taken
+ * by the scheduler */
+static _Thread_local uint64_t g_direct_handled = 0;
+static _Thread_local uint64_t g_direct_errors = 0;
+
+static void route_flag_replicated(RoutingTable* table, RoutingEntry* entry);
+
+/*
+ * Size in bytes of an entry's edge stats array
+ */
+static size_t edge_stats_size(RoutingTable* table, uint32_t dest_count) {
+    return (size_t)table->stats_shards * dest_count * sizeof(RouteEdgeStats);
+}
+
 /*
  * Create routing table
  *
@@ -53,6 +80,7 @@ RoutingTable* routing_table_create(uint32_t capacity) {
     table->mask = capacity - 1;
     table->entry_count = 0;
     table->collision_count = 0;
+    table->stats_shards = 1;
 
     return table;
 }
@@ -79,12 +107,23 @@ void routing_table_destroy(RoutingTable* table) {
                 heap_free(entry->dest_queues,
                          entry->dest_count * sizeof(SignalQueue*));
             }
+            if (entry->edge_stats != NULL) {
+                heap_free(entry->edge_stats,
+                         edge_stats_size(table, entry->dest_count));
+            }
         }
     }
 
     /* Free entries array */
     heap_free(table->entries, table->capacity * sizeof(RoutingEntry));
 
+    for (uint32_t i = 0; i < table->replica_set_count; i++) {
+        RouteReplicaSet* set = &table->replica_sets[i];
+        heap_free(set->replica_ids, set->replica_count * sizeof(uint32_t));
+        heap_free(set->replica_queues, set->replica_count * sizeof(SignalQueue*));
+    }
+    heap_free(table->replica_sets, table->replica_set_capacity * sizeof(RouteReplicaSet));
+
     /* Free table struct */
     heap_free(table, sizeof(RoutingTable));
 }
@@ -124,8 +163,10 @@ static uint32_t find_slot(RoutingTable* table, uint32_t source_agent_id,
             return index;
         }
 
-        /* Collision - try next slot */
-        table->collision_count++;
+        /* Collision - try next slot (shared counter: skipped under workers) */
+        if (!g_runtime_threaded) {
+            table->collision_count++;
+        }
         index = (index + 1) & table->mask;
 
     } while (index != start);
@@ -175,6 +216,10 @@ int routing_add_entry(RoutingTable* table, uint32_t source_agent_id,
             heap_free(entry->dest_queues,
                      entry->dest_count * sizeof(SignalQueue*));
         }
+        if (entry->edge_stats != NULL) {
+            heap_free(entry->edge_stats,
+                     edge_stats_size(table, entry->dest_count));
+        }
     }
 
     /* Fill in entry fields */
@@ -200,6 +245,18 @@ int routing_add_entry(RoutingTable* table, uint32_t source_agent_id,
     }
     memset(entry->dest_queues, 0, dest_count * sizeof(SignalQueue*));
 
+    /* Allocate traffic counters (zeroed by heap_allocate) */
+    entry->edge_stats = heap_allocate(edge_stats_size(table, dest_count));
+    if (entry->edge_stats == NULL) {
+        heap_free(entry->dest_queues, dest_count * sizeof(SignalQueue*));
+        heap_free(entry->dest_agent_ids, ids_size);
+        entry->dest_queues = NULL;
+        entry->dest_agent_ids = NULL;
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    route_flag_replicated(table, entry);
+
     /* Increment count if new entry */
     if (!found) {
         table->entry_count++;
@@ -264,11 +321,563 @@ static RoutingEntry* routing_get_entry(RoutingTable* table,
     return &table->entries[index];
 }
 
+/* =============================================================================
+ * DEFERRED DELIVERY
+ *
+ * Design decisions:
+ * - The outbox is thread-local state of routing, like the stats shard, so
+ *   emit_signal and generated code need no extra parameter
+ * - Each recorded destination holds its own signal reference; delivery
+ *   hands it to the queue (or drops it if the queue is full)
+ * - Edge stats are counted at delivery time, in the delivering thread's
+ *   shard, exactly as an immediate broadcast would count them
+ * ============================================================================= */
+
+/*
+ * Append one deferred delivery, growing the outbox as needed
+ *
+ * @return: 1 if recorded, 0 if the outbox could not grow
+ */
+static int route_outbox_push(RouteOutbox* outbox, Signal* signal,
+                             RoutingEntry* entry, SignalQueue* queue,
+                             uint32_t dest_index, uint32_t dest_agent_id) {
+    if (outbox->count == outbox->capacity) {
+        uint32_t new_capacity = outbox->capacity ? outbox->capacity * 2 : 16;
+        RouteDelivery* items = heap_allocate(new_capacity * sizeof(RouteDelivery));
+        if (items == NULL) {
+            return 0;
+        }
+        if (outbox->items != NULL) {
+            memcpy(items, outbox->items, outbox->count * sizeof(RouteDelivery));
+            heap_free(outbox->items, outbox->capacity * sizeof(RouteDelivery));
+        }
+        outbox->items = items;
+        outbox->capacity = new_capacity;
+    }
+
+    signal_ref(signal);
+    RouteDelivery* d = &outbox->items[outbox->count++];
+    d->signal = signal;
+    d->entry = entry;
+    d->queue = queue;
+    d->dest_index = dest_index;
+    d->dest_agent_id = dest_agent_id;
+    return 1;
+}
+
+/*
+ * Divert the calling thread's broadcasts into an outbox
+ *
+ * @param outbox: Outbox to record into, or NULL to deliver immediately
+ */
+void routing_set_outbox(RouteOutbox* outbox) {
+    g_route_outbox = outbox;
+}
+
+/*
+ * Enqueue one deferred delivery and drop its reference
+ *
+ * @param table: Routing table the delivery was recorded from
+ * @param delivery: Recorded delivery
+ * @return: SIGNAL_OK, or SIGNAL_ERR_QUEUE_FULL if the signal was dropped
+ */
+int routing_deliver(RoutingTable* table, RouteDelivery* delivery) {
+    RoutingEntry* entry = delivery->entry;
+    uint32_t shard = (g_stats_shard < table->stats_shards) ? g_stats_shard : 0;
+    RouteEdgeStats* stats = &entry->edge_stats[shard * entry->dest_count + delivery->dest_index];
+
+    int result = signal_queue_enqueue(delivery->queue, delivery->signal);
+    if (result == SIGNAL_OK) {
+        stats->signals_delivered++;
+        stats->bytes_delivered += delivery->signal->payload_size;
+        uint32_t depth = signal_queue_count(delivery->queue);
+        if (depth > stats->max_queue_depth) {
+            stats->max_queue_depth = depth;
+        }
+    } else if (result == SIGNAL_ERR_QUEUE_FULL) {
+        stats->drops_queue_full++;
+    }
+
+    signal_free(delivery->signal);
+    return result;
+}
+
+/*
+ * Drop undelivered references and free the outbox buffer
+ *
+ * @param outbox: Outbox to release
+ */
+void routing_outbox_free(RouteOutbox* outbox) {
+    if (outbox == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < outbox->count; i++) {
+        signal_free(outbox->items[i].signal);
+    }
+    heap_free(outbox->items, outbox->capacity * sizeof(RouteDelivery));
+    outbox->items = NULL;
+    outbox->count = 0;
+    outbox->capacity = 0;
+}
+
+/* =============================================================================
+ * DIRECT DELIVERY
+ *
+ * Design decisions:
+ * - Opt-in per route: inline calls change when handlers run relative to
+ *   the rest of the cycle, so only routes the program marks get them
+ * - A direct call is only made when queueing would have been observably
+ *   the same: the destination's queue is empty (no reordering), it has
+ *   no handler on the stack (run-to-completion), we are single-threaded
+ *   and not recording into an outbox (parallel/BSP schedulers)
+ * - Nesting is capped at ROUTE_DIRECT_MAX_DEPTH; deeper hops are queued,
+ *   so long chains and cycles degrade to normal scheduling
+ * - A stack signal owns nothing (no heap flags), so a stray signal_free
+ *   on it is harmless; it is copied to the heap before anything can keep
+ *   a reference (queue or outbox)
+ * ============================================================================= */
+
+/*
+ * Enable/disable direct calls on a route
+ *
+ * @param table: Routing table
+ * @param source_agent_id: Source agent
+ * @param frequency_id: Signal frequency
+ * @param enable: Non-zero to enable
+ * @return: SIGNAL_OK, or SIGNAL_ERR_NO_ROUTE
+ */
+int routing_set_direct(RoutingTable* table, uint32_t source_agent_id,
+                       uint32_t frequency_id, int enable) {
+    RoutingEntry* entry = routing_get_entry(table, source_agent_id, frequency_id);
+    if (entry == NULL) {
+        return SIGNAL_ERR_NO_ROUTE;
+    }
+
+    if (enable) {
+        entry->flags |= ROUTE_FLAG_DIRECT;
+    } else {
+        entry->flags &= ~(uint32_t)ROUTE_FLAG_DIRECT;
+    }
+    return SIGNAL_OK;
+}
+
+/*
+ * Can this thread make direct calls at all right now?
+ */
+static inline int route_direct_allowed(AgentRegistry* agents) {
+    return !g_runtime_threaded && g_route_outbox == NULL && agents != NULL &&
+           g_direct_depth < ROUTE_DIRECT_MAX_DEPTH;
+}
+
+/*
+ * Run a destination's handler inline, if it is idle
+ *
+ * @return: 1 if the handler ran, 0 if the signal must be queued
+ */
+static int route_invoke_direct(AgentRegistry* agents, uint32_t dest_agent_id,
+                               SignalQueue* queue, Signal* signal,
+                               RouteEdgeStats* stats) {
+    if (g_direct_depth >= ROUTE_DIRECT_MAX_DEPTH || !signal_queue_is_empty(queue)) {
+        return 0;
+    }
+
+    Agent* agent = agent_registry_get(agents, dest_agent_id);
+    /* A coroutine agent may be awaiting this signal: leave it to the queue */
+    if (agent == NULL || agent->dispatch_table == NULL ||
+        (agent->flags & (AGENT_FLAG_DISPATCHING | AGENT_FLAG_COROUTINE))) {
+        return 0;
+    }
+
+    DispatchTable* dispatch = (DispatchTable*)agent->dispatch_table;
+
+    agent->flags |= AGENT_FLAG_DISPATCHING;
+    g_direct_depth++;
+    int result = dispatch_invoke_for_agent(dispatch, dest_agent_id, agent->state_ptr, signal);
+    g_direct_depth--;
+    agent->flags &= ~(uint32_t)AGENT_FLAG_DISPATCHING;
+
+    if (result == DISPATCH_ERR_HANDLER_FAILED || result == DISPATCH_ERR_NO_HANDLER) {
+        __atomic_fetch_add(&dispatch->error_count, 1, __ATOMIC_RELAXED);
+        g_direct_errors++;
+    }
+    agent->signal_count++;
+    g_direct_handled++;
+
+    stats->signals_delivered++;
+    stats->bytes_delivered += signal->payload_size;
+    stats->direct_calls++;
+    return 1;
+}
+
+/*
+ * Take this thread's inline handler counts and reset them
+ *
+ * @param handled: Output: handlers run inline since the last take
+ * @param errors: Output: of those, failed or unhandled signals
+ */
+void routing_take_direct_counts(uint64_t* handled, uint64_t* errors) {
+    if (handled != NULL) {
+        *handled = g_direct_handled;
+    }
+    if (errors != NULL) {
+        *errors = g_direct_errors;
+    }
+    g_direct_handled = 0;
+    g_direct_errors = 0;
+}
+
+/*
+ * Heap copy of a stack signal (so it can be queued or recorded)
+ */
+static Signal* route_promote(Signal* signal) {
+    Signal* copy = signal_create(signal->frequency_id, signal->source_agent_id,
+                                 signal->payload_ptr, signal->payload_size);
+    if (copy != NULL) {
+        copy->flags |= signal->flags & SIGNAL_FLAG_BROADCAST;
+    }
+    return copy;
+}
+
+/* =============================================================================
+ * REPLICATED AGENTS
+ *
+ * Design decisions:
+ * - A replica set is keyed by the logical agent ID, so routes are added
+ *   and resolved exactly as before; only entries that reach a set carry
+ *   ROUTE_FLAG_REPLICATED and pay for the lookup (a scan: sets are few)
+ * - Shard keys are hashed with FNV-1a over the key bytes, so one key
+ *   always lands on the same replica and keeps its order
+ * - Round robin uses the set's cursor (atomic under workers: the spread
+ *   matters, not exact alternation). While recording into an outbox it
+ *   uses the outbox's own cursor offset by the sender ID instead, so a
+ *   BSP run picks the same replicas whatever the thread count
+ * ============================================================================= */
+
+/*
+ * Replica set of a logical agent, or NULL
+ */
+static RouteReplicaSet* route_find_replicas(RoutingTable* table, uint32_t logical_agent_id) {
+    for (uint32_t i = 0; i < table->replica_set_count; i++) {
+        if (table->replica_sets[i].logical_agent_id == logical_agent_id) {
+            return &table->replica_sets[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Flag an entry if any of its destinations is replicated
+ */
+static void route_flag_replicated(RoutingTable* table, RoutingEntry* entry) {
+    entry->flags &= ~(uint32_t)ROUTE_FLAG_REPLICATED;
+    for (uint32_t i = 0; i < entry->dest_count; i++) {
+        if (route_find_replicas(table, entry->dest_agent_ids[i]) != NULL) {
+            entry->flags |= ROUTE_FLAG_REPLICATED;
+            return;
+        }
+    }
+}
+
+/*
+ * Free one set's arrays and close the gap in the set list
+ */
+static void route_remove_replicas(RoutingTable* table, RouteReplicaSet* set) {
+    heap_free(set->replica_ids, set->replica_count * sizeof(uint32_t));
+    heap_free(set->replica_queues, set->replica_count * sizeof(SignalQueue*));
+    *set = table->replica_sets[--table->replica_set_count];
+}
+
+/*
+ * Replicate a logical agent
+ *
+ * @param table: Routing table
+ * @param logical_agent_id: Destination ID routes use
+ * @param replica_count: Number of replicas (<= 1 removes the set)
+ * @param replica_ids: Agent ID of each replica (may include the logical ID)
+ * @param key_offset: Shard key offset in the payload
+ * @param key_size: Shard key size in bytes (0 = round robin)
+ * @return: SIGNAL_OK, SIGNAL_ERR_NULL_POINTER or SIGNAL_ERR_ALLOC_FAILED
+ */
+int routing_set_replicas(RoutingTable* table, uint32_t logical_agent_id,
+                         uint32_t replica_count, const uint32_t* replica_ids,
+                         uint32_t key_offset, uint32_t key_size) {
+    if (table == NULL || (replica_count > 1 && replica_ids == NULL)) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    RouteReplicaSet* set = route_find_replicas(table, logical_agent_id);
+    if (set != NULL) {
+        route_remove_replicas(table, set);
+    }
+
+    if (replica_count > 1) {
+        if (table->replica_set_count == table->replica_set_capacity) {
+            uint32_t capacity = table->replica_set_capacity ? table->replica_set_capacity * 2 : 4;
+            RouteReplicaSet* sets = heap_allocate(capacity * sizeof(RouteReplicaSet));
+            if (sets == NULL) {
+                return SIGNAL_ERR_ALLOC_FAILED;
+            }
+            if (table->replica_sets != NULL) {
+                memcpy(sets, table->replica_sets,
+                       table->replica_set_count * sizeof(RouteReplicaSet));
+                heap_free(table->replica_sets,
+                          table->replica_set_capacity * sizeof(RouteReplicaSet));
+            }
+            table->replica_sets = sets;
+            table->replica_set_capacity = capacity;
+        }
+
+        uint32_t* ids = heap_allocate(replica_count * sizeof(uint32_t));
+        SignalQueue** queues = heap_allocate(replica_count * sizeof(SignalQueue*));
+        if (ids == NULL || queues == NULL) {
+            heap_free(ids, replica_count * sizeof(uint32_t));
+            heap_free(queues, replica_count * sizeof(SignalQueue*));
+            return SIGNAL_ERR_ALLOC_FAILED;
+        }
+        memcpy(ids, replica_ids, replica_count * sizeof(uint32_t));
+
+        table->replica_sets[table->replica_set_count++] = (RouteReplicaSet){
+            .logical_agent_id = logical_agent_id,
+            .replica_count = replica_count,
+            .key_offset = key_offset,
+            .key_size = key_size,
+            .replica_ids = ids,
+            .replica_queues = queues,
+        };
+    }
+
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        if (table->entries[i].source_agent_id != 0) {
+            route_flag_replicated(table, &table->entries[i]);
+        }
+    }
+    return SIGNAL_OK;
+}
+
+/*
+ * Copy every route of one source to another
+ *
+ * @param table: Routing table
+ * @param from_agent_id: Source whose routes are copied
+ * @param to_agent_id: New source
+ * @return: SIGNAL_OK, SIGNAL_ERR_NULL_POINTER or SIGNAL_ERR_ALLOC_FAILED
+ */
+int routing_copy_routes(RoutingTable* table, uint32_t from_agent_id, uint32_t to_agent_id) {
+    if (table == NULL || from_agent_id == 0 || to_agent_id == 0) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (from_agent_id == to_agent_id) {
+        return SIGNAL_OK;
+    }
+
+    /* Copies have another source, so the scan skips any it runs into */
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        RoutingEntry* entry = &table->entries[i];
+        if (entry->source_agent_id != from_agent_id) {
+            continue;
+        }
+        int result = routing_add_entry(table, to_agent_id, entry->frequency_id,
+                                       entry->dest_count, entry->dest_agent_ids);
+        if (result != SIGNAL_OK) {
+            return result;
+        }
+        routing_get_entry(table, to_agent_id, entry->frequency_id)->flags |=
+            entry->flags & ROUTE_FLAG_DIRECT;
+    }
+    return SIGNAL_OK;
+}
+
+/*
+ * Replica IDs of a logical agent
+ *
+ * @param table: Routing table
+ * @param logical_agent_id: Destination ID routes use
+ * @param out_count: Output - number of replicas (0 if not replicated)
+ * @return: Replica agent IDs, or NULL if not replicated
+ */
+const uint32_t* routing_get_replicas(RoutingTable* table, uint32_t logical_agent_id,
+                                     uint32_t* out_count) {
+    RouteReplicaSet* set = (table != NULL) ? route_find_replicas(table, logical_agent_id) : NULL;
+    if (out_count != NULL) {
+        *out_count = (set != NULL) ? set->replica_count : 0;
+    }
+    return (set != NULL) ? set->replica_ids : NULL;
+}
+
+/*
+ * Replica index for one signal
+ */
+static uint32_t route_pick_replica(RouteReplicaSet* set, Signal* signal) {
+    if (set->key_size == 0) {
+        uint32_t turn;
+        if (g_route_outbox != NULL) {
+            turn = signal->source_agent_id + g_route_outbox->replica_turn++;
+        } else if (g_runtime_threaded) {
+            turn = __atomic_fetch_add(&set->next, 1, __ATOMIC_RELAXED);
+        } else {
+            turn = set->next++;
+        }
+        return turn % set->replica_count;
+    }
+
+    if (signal->payload_ptr == NULL ||
+        signal->payload_size < set->key_offset + set->key_size) {
+        return 0;
+    }
+    const uint8_t* key = (const uint8_t*)signal->payload_ptr + set->key_offset;
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < set->key_size; i++) {
+        hash ^= key[i];
+        hash *= 16777619u;
+    }
+    return hash % set->replica_count;
+}
+
+/*
+ * Queue of an agent whose pointer is not cached yet: the AgentRegistry's,
+ * else the table's resolver (which may create it)
+ */
+static SignalQueue* route_lookup_queue(RoutingTable* table, AgentRegistry* agents,
+                                       uint32_t agent_id) {
+    SignalQueue* queue = NULL;
+    if (agents != NULL) {
+        queue = agent_get_queue(agents, agent_id);
+    }
+    if (queue == NULL && table->resolve != NULL) {
+        queue = table->resolve(table->resolve_ctx, agent_id);
+    }
+    return queue;
+}
+
+/*
+ * Queue (and agent ID) a signal on an entry's i-th edge goes to
+ *
+ * Resolves and caches queue pointers lazily; picks a replica if the
+ * destination is replicated.
+ */
+static SignalQueue* route_dest_queue(RoutingTable* table, RoutingEntry* entry, uint32_t i,
+                                     Signal* signal, AgentRegistry* agents,
+                                     uint32_t* dest_agent_id) {
+    if (entry->flags & ROUTE_FLAG_REPLICATED) {
+        RouteReplicaSet* set = route_find_replicas(table, entry->dest_agent_ids[i]);
+        if (set != NULL) {
+            uint32_t r = route_pick_replica(set, signal);
+            *dest_agent_id = set->replica_ids[r];
+            SignalQueue* queue = set->replica_queues[r];
+            if (queue == NULL) {
+                queue = route_lookup_queue(table, agents, *dest_agent_id);
+                set->replica_queues[r] = queue;
+            }
+            return queue;
+        }
+    }
+
+    *dest_agent_id = entry->dest_agent_ids[i];
+    SignalQueue* queue = entry->dest_queues[i];
+
+    /* If queue not cached, look it up */
+    if (queue == NULL) {
+        queue = route_lookup_queue(table, agents, *dest_agent_id);
+        entry->dest_queues[i] = queue;  /* Cache for next time */
+    }
+    return queue;
+}
+
+/* =============================================================================
+ * BROADCAST
+ * ============================================================================= */
+
+/*
+ * Deliver a signal along one resolved route
+ *
+ * A stack signal is copied to the heap on first use by a queue or outbox.
+ *
+ * @return: Number of destinations reached
+ */
+static int route_broadcast_entry(RoutingTable* table, RoutingEntry* entry,
+                                 Signal* signal, AgentRegistry* agents) {
+    int delivered = 0;
+    Signal* heap_copy = NULL;
+
+    /* Set broadcast flag before any receiver can see the signal */
+    if (entry->dest_count > 1) {
+        signal->flags |= SIGNAL_FLAG_BROADCAST;
+    }
+
+    /* Deferred: record each destination, delivered later by the owner */
+    RouteOutbox* outbox = g_route_outbox;
+    if (outbox != NULL) {
+        if (signal->flags & SIGNAL_FLAG_STACK) {
+            heap_copy = route_promote(signal);
+            if (heap_copy == NULL) {
+                return 0;
+            }
+            signal = heap_copy;
+        }
+        for (uint32_t i = 0; i < entry->dest_count; i++) {
+            uint32_t dest_agent_id;
+            SignalQueue* queue = route_dest_queue(table, entry, i, signal, agents,
+                                                  &dest_agent_id);
+            if (queue != NULL &&
+                route_outbox_push(outbox, signal, entry, queue, i, dest_agent_id)) {
+                delivered++;
+            }
+        }
+        signal_free(heap_copy);
+        return delivered;
+    }
+
+    /* This thread's row of traffic counters */
+    uint32_t shard = (g_stats_shard < table->stats_shards) ? g_stats_shard : 0;
+    RouteEdgeStats* stats = &entry->edge_stats[shard * entry->dest_count];
+    int direct = (entry->flags & ROUTE_FLAG_DIRECT) && route_direct_allowed(agents);
+
+    /* Enqueue signal to each destination */
+    for (uint32_t i = 0; i < entry->dest_count; i++) {
+        uint32_t dest_agent_id;
+        SignalQueue* queue = route_dest_queue(table, entry, i, signal, agents, &dest_agent_id);
+        if (queue == NULL) {
+            continue;
+        }
+
+        if (direct && route_invoke_direct(agents, dest_agent_id,
+                                          queue, signal, &stats[i])) {
+            delivered++;
+            continue;
+        }
+
+        Signal* queued = signal;
+        if (signal->flags & SIGNAL_FLAG_STACK) {
+            if (heap_copy == NULL && (heap_copy = route_promote(signal)) == NULL) {
+                break;
+            }
+            queued = heap_copy;
+        }
+
+        int result = signal_queue_enqueue(queue, queued);
+        if (result == SIGNAL_OK) {
+            delivered++;
+            stats[i].signals_delivered++;
+            stats[i].bytes_delivered += signal->payload_size;
+            uint32_t depth = signal_queue_count(queue);
+            if (depth > stats[i].max_queue_depth) {
+                stats[i].max_queue_depth = depth;
+            }
+        } else if (result == SIGNAL_ERR_QUEUE_FULL) {
+            stats[i].drops_queue_full++;
+        }
+    }
+
+    signal_free(heap_copy);
+    return delivered;
+}
+
 /*
  * Route signal to all destinations
  *
  * Uses cached queue pointers for fast delivery.
  * Falls back to agent registry lookup if cache not populated.
+ * Direct routes run idle destinations' handlers inline instead.
  *
  * Performance: ~50-100 cycles per destination
  *
@@ -291,32 +900,67 @@ int routing_broadcast(RoutingTable* table, Signal* signal,
         return 0;  /* No route for this signal */
     }
 
-    int delivered = 0;
+    return route_broadcast_entry(table, entry, signal, agents);
+}
 
-    /* Enqueue signal to each destination */
-    for (uint32_t i = 0; i < entry->dest_count; i++) {
-        SignalQueue* queue = entry->dest_queues[i];
+/*
+ * Resolve cached queue pointers for all routes through a lookup function
+ *
+ * Lets registries other than AgentRegistry (agents.h) fill the cache
+ * without building an AgentRegistry view of themselves.
+ *
+ * @param table: Routing table
+ * @param lookup: Returns the queue of an agent ID (NULL = unknown)
+ * @param ctx: Passed to lookup
+ */
+void routing_resolve_queues_with(RoutingTable* table, route_queue_lookup_fn lookup, void* ctx) {
+    if (table == NULL || lookup == NULL) {
+        return;
+    }
 
-        /* If queue not cached, look it up */
-        if (queue == NULL && agents != NULL) {
-            queue = agent_get_queue(agents, entry->dest_agent_ids[i]);
-            entry->dest_queues[i] = queue;  /* Cache for next time */
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        RoutingEntry* entry = &table->entries[i];
+
+        if (entry->source_agent_id == 0) {
+            continue;  /* Empty slot */
         }
 
-        if (queue != NULL) {
-            int result = signal_queue_enqueue(queue, signal);
-            if (result == SIGNAL_OK) {
-                delivered++;
-            }
+        for (uint32_t j = 0; j < entry->dest_count; j++) {
+            entry->dest_queues[j] = lookup(ctx, entry->dest_agent_ids[j]);
         }
     }
 
-    /* Set broadcast flag if multiple destinations */
-    if (entry->dest_count > 1) {
-        signal->flags |= SIGNAL_FLAG_BROADCAST;
+    for (uint32_t i = 0; i < table->replica_set_count; i++) {
+        RouteReplicaSet* set = &table->replica_sets[i];
+        for (uint32_t j = 0; j < set->replica_count; j++) {
+            set->replica_queues[j] = lookup(ctx, set->replica_ids[j]);
+        }
     }
+}
 
-    return delivered;
+/*
+ * Resolve queues that are still uncached at delivery through a lookup
+ *
+ * For registries that create queues on demand: resolve runs on whichever
+ * thread delivers first and must be safe for that; a NULL result drops
+ * the signal for that destination and is retried on the next delivery.
+ *
+ * @param table: Routing table
+ * @param resolve: Returns (creating if needed) the queue of an agent ID
+ * @param ctx: Passed to resolve
+ */
+void routing_set_queue_resolver(RoutingTable* table, route_queue_lookup_fn resolve, void* ctx) {
+    if (table != NULL) {
+        table->resolve = resolve;
+        table->resolve_ctx = ctx;
+    }
+}
+
+/*
+ * routing_resolve_queues lookup over an AgentRegistry
+ */
+static SignalQueue* registry_queue_lookup(void* ctx, uint32_t agent_id) {
+    return agent_get_queue((AgentRegistry*)ctx, agent_id);
 }
 
 /*
@@ -329,20 +973,181 @@ int routing_broadcast(RoutingTable* table, Signal* signal,
  * @param agents: Agent registry
  */
 void routing_resolve_queues(RoutingTable* table, AgentRegistry* agents) {
-    if (table == NULL || agents == NULL) {
+    if (agents == NULL) {
         return;
     }
+    routing_resolve_queues_with(table, registry_queue_lookup, agents);
+}
+
+/* =============================================================================
+ * ROUTING TRAFFIC STATISTICS
+ *
+ * Each edge has one RouteEdgeStats per shard. A thread only ever writes its
+ * own shard, so the hot path is plain increments; readers sum the shards.
+ * ============================================================================= */
+
+/*
+ * Accumulate one counter set into another
+ */
+static void edge_stats_add(RouteEdgeStats* dst, const RouteEdgeStats* src) {
+    dst->signals_delivered += src->signals_delivered;
+    dst->bytes_delivered += src->bytes_delivered;
+    dst->drops_queue_full += src->drops_queue_full;
+    dst->direct_calls += src->direct_calls;
+    if (src->max_queue_depth > dst->max_queue_depth) {
+        dst->max_queue_depth = src->max_queue_depth;
+    }
+}
+
+/*
+ * Set number of per-thread stats shards
+ *
+ * Reallocates every entry's counters. Existing counts are folded into
+ * shard 0 of the new layout so nothing is lost. All new arrays are
+ * allocated before any entry is touched, so on failure the table is left
+ * exactly as it was.
+ *
+ * @param table: Routing table
+ * @param shard_count: Number of shards (1..ROUTING_MAX_STATS_SHARDS)
+ * @return: SIGNAL_OK on success
+ */
+int routing_set_stats_shards(RoutingTable* table, uint32_t shard_count) {
+    if (table == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    if (shard_count == 0) {
+        shard_count = 1;
+    }
+    if (shard_count > ROUTING_MAX_STATS_SHARDS) {
+        shard_count = ROUTING_MAX_STATS_SHARDS;
+    }
+    if (shard_count == table->stats_shards) {
+        return SIGNAL_OK;
+    }
+
+    /* Phase 1: allocate every entry's new counters */
+    size_t fresh_size = (size_t)table->capacity * sizeof(RouteEdgeStats*);
+    RouteEdgeStats** fresh = heap_allocate(fresh_size);
+    if (fresh == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
 
     for (uint32_t i = 0; i < table->capacity; i++) {
         RoutingEntry* entry = &table->entries[i];
+        if (entry->source_agent_id == 0 || entry->edge_stats == NULL) {
+            continue;
+        }
 
-        if (entry->source_agent_id == 0) {
-            continue;  /* Empty slot */
+        fresh[i] = heap_allocate((size_t)shard_count * entry->dest_count *
+                                 sizeof(RouteEdgeStats));
+        if (fresh[i] == NULL) {
+            for (uint32_t j = 0; j < i; j++) {
+                if (fresh[j] != NULL) {
+                    heap_free(fresh[j], (size_t)shard_count *
+                              table->entries[j].dest_count *
+                              sizeof(RouteEdgeStats));
+                }
+            }
+            heap_free(fresh, fresh_size);
+            return SIGNAL_ERR_ALLOC_FAILED;
         }
+    }
 
-        for (uint32_t j = 0; j < entry->dest_count; j++) {
-            entry->dest_queues[j] = agent_get_queue(agents,
-                                                    entry->dest_agent_ids[j]);
+    /* Phase 2: fold old shards into shard 0 of the new arrays and swap */
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        RoutingEntry* entry = &table->entries[i];
+        if (fresh[i] == NULL) {
+            continue;
+        }
+
+        for (uint32_t d = 0; d < entry->dest_count; d++) {
+            for (uint32_t s = 0; s < table->stats_shards; s++) {
+                edge_stats_add(&fresh[i][d],
+                               &entry->edge_stats[s * entry->dest_count + d]);
+            }
+        }
+
+        heap_free(entry->edge_stats, edge_stats_size(table, entry->dest_count));
+        entry->edge_stats = fresh[i];
+    }
+
+    heap_free(fresh, fresh_size);
+    table->stats_shards = shard_count;
+    return SIGNAL_OK;
+}
+
+/*
+ * Select which stats shard the calling thread updates
+ *
+ * @param shard: Shard index (out-of-range values fall back to shard 0)
+ */
+void routing_set_thread_shard(uint32_t shard) {
+    g_stats_shard = shard;
+}
+
+/*
+ * Sum one entry's counters for a destination over all shards
+ *
+ * @param table: Routing table
+ * @param entry: Routing entry
+ * @param dest_index: Index into entry->dest_agent_ids
+ * @param out: Output counters
+ */
+void routing_entry_edge_stats(RoutingTable* table, RoutingEntry* entry,
+                              uint32_t dest_index, RouteEdgeStats* out) {
+    if (out == NULL) {
+        return;
+    }
+    memset(out, 0, sizeof(RouteEdgeStats));
+
+    if (table == NULL || entry == NULL || entry->edge_stats == NULL ||
+        dest_index >= entry->dest_count) {
+        return;
+    }
+
+    for (uint32_t s = 0; s < table->stats_shards; s++) {
+        edge_stats_add(out, &entry->edge_stats[s * entry->dest_count + dest_index]);
+    }
+}
+
+/*
+ * Get traffic counters for one edge
+ *
+ * @param table: Routing table
+ * @param source_agent_id: Source agent ID
+ * @param frequency_id: Signal frequency ID
+ * @param dest_index: Destination index within the route
+ * @param out: Output counters (summed over shards)
+ * @return: SIGNAL_OK on success, SIGNAL_ERR_NO_ROUTE if edge not found
+ */
+int routing_get_edge_stats(RoutingTable* table, uint32_t source_agent_id,
+                           uint32_t frequency_id, uint32_t dest_index,
+                           RouteEdgeStats* out) {
+    RoutingEntry* entry = routing_get_entry(table, source_agent_id, frequency_id);
+    if (entry == NULL || dest_index >= entry->dest_count) {
+        return SIGNAL_ERR_NO_ROUTE;
+    }
+
+    routing_entry_edge_stats(table, entry, dest_index, out);
+    return SIGNAL_OK;
+}
+
+/*
+ * Reset all traffic counters to zero
+ *
+ * @param table: Routing table
+ */
+void routing_reset_stats(RoutingTable* table) {
+    if (table == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        RoutingEntry* entry = &table->entries[i];
+        if (entry->source_agent_id != 0 && entry->edge_stats != NULL) {
+            memset(entry->edge_stats, 0,
+                   edge_stats_size(table, entry->dest_count));
         }
     }
 }
@@ -350,13 +1155,13 @@ void routing_resolve_queues(RoutingTable* table, AgentRegistry* agents) {
 /* =============================================================================
  * AGENT REGISTRY
  *
- * Simple array-based registry for agent lookup by ID.
+ * Simple array-based registry for agent lookup by ID, grown by doubling.
  * ============================================================================= */
 
 /*
  * Create agent registry
  *
- * @param capacity: Maximum number of agents
+ * @param capacity: Initial number of agent slots (grows on demand)
  * @return: Pointer to registry, or NULL on failure
  */
 AgentRegistry* agent_registry_create(uint32_t capacity) {
@@ -382,17 +1187,51 @@ AgentRegistry* agent_registry_create(uint32_t capacity) {
 /*
  * Register an agent in the registry
  *
+ * Growing the registry moves its slot array, so IDs beyond the current
+ * capacity are refused while workers run (threaded mode); schedulers grow
+ * their own per-agent state to match before their next cycle or run.
+ * The array (and every scheduler's per-agent state) is sized by the
+ * highest ID, so IDs are capped at AGENT_REGISTRY_MAX_ID: one stray high
+ * ID would otherwise allocate gigabytes. Sparse ID spaces belong in the
+ * paged AgentRegistry2.
+ *
  * @param registry: Agent registry
  * @param agent: Agent to register
- * @return: SIGNAL_OK on success
+ * @return: SIGNAL_OK on success, SIGNAL_ERR_ID_RANGE for IDs at or above
+ *          AGENT_REGISTRY_MAX_ID, SIGNAL_ERR_BUSY if growth is needed
+ *          while threaded, SIGNAL_ERR_ALLOC_FAILED
  */
 int agent_registry_add(AgentRegistry* registry, Agent* agent) {
     if (registry == NULL || agent == NULL) {
         return SIGNAL_ERR_NULL_POINTER;
     }
 
+    if (agent->agent_id >= AGENT_REGISTRY_MAX_ID) {
+        return SIGNAL_ERR_ID_RANGE;
+    }
+
+    /* Grow by doubling, up to the ID cap */
     if (agent->agent_id >= registry->capacity) {
-        return SIGNAL_ERR_ALLOC_FAILED;
+        if (g_runtime_threaded) {
+            return SIGNAL_ERR_BUSY;
+        }
+        uint32_t capacity = registry->capacity ? registry->capacity : MAX_AGENTS;
+        while (capacity <= agent->agent_id) {
+            capacity *= 2;
+        }
+        if (capacity > AGENT_REGISTRY_MAX_ID) {
+            capacity = AGENT_REGISTRY_MAX_ID;
+        }
+        Agent** agents = heap_allocate((size_t)capacity * sizeof(Agent*));
+        if (agents == NULL) {
+            return SIGNAL_ERR_ALLOC_FAILED;
+        }
+        if (registry->agents != NULL) {
+            memcpy(agents, registry->agents, (size_t)registry->capacity * sizeof(Agent*));
+            heap_free(registry->agents, (size_t)registry->capacity * sizeof(Agent*));
+        }
+        registry->agents = agents;
+        registry->capacity = capacity;
     }
 
     registry->agents[agent->agent_id] = agent;
@@ -441,7 +1280,9 @@ SignalQueue* agent_get_queue(AgentRegistry* registry, uint32_t agent_id) {
 /*
  * Create and emit a signal
  *
- * Combines signal_create + routing_broadcast.
+ * Combines signal_create + routing_broadcast. On a direct route with a
+ * small payload the signal is built on the stack and only copied to the
+ * heap if some destination has to queue it.
  *
  * @param table: Routing table
  * @param agents: Agent registry
@@ -455,6 +1296,32 @@ int emit_signal(RoutingTable* table, AgentRegistry* agents,
                 uint32_t frequency_id, uint32_t source_agent_id,
                 const void* payload, uint32_t payload_size) {
 
+    /* Resolve the route once; no route means nothing to allocate */
+    RoutingEntry* entry = routing_get_entry(table, source_agent_id, frequency_id);
+    if (entry == NULL) {
+        return 0;
+    }
+
+    if ((entry->flags & ROUTE_FLAG_DIRECT) && payload_size <= ROUTE_DIRECT_INLINE_MAX &&
+        route_direct_allowed(agents)) {
+        uint64_t inline_payload[ROUTE_DIRECT_INLINE_MAX / sizeof(uint64_t)];
+        int has_payload = (payload != NULL && payload_size > 0);
+        if (has_payload) {
+            memcpy(inline_payload, payload, payload_size);
+        }
+        Signal sig = {
+            .frequency_id = (uint16_t)frequency_id,
+            .source_agent_id = source_agent_id,
+            .flags = SIGNAL_FLAG_STACK,
+            .ref_count = 1,
+            .payload_ptr = has_payload ? inline_payload : NULL,
+            .payload_size = has_payload ? payload_size : 0,
+            .payload_capacity = has_payload ? ROUTE_DIRECT_INLINE_MAX : 0,
+            .timestamp = get_timestamp(),
+        };
+        return route_broadcast_entry(table, entry, &sig, agents);
+    }
+
     /* Create signal */
     Signal* sig = signal_create(frequency_id, source_agent_id,
                                 payload, payload_size);
@@ -462,17 +1329,8 @@ int emit_signal(RoutingTable* table, AgentRegistry* agents,
         return -SIGNAL_ERR_ALLOC_FAILED;
     }
 
-    /* Route to destinations */
-    int delivered = routing_broadcast(table, sig, agents);
-
-    /* If no destinations, free the signal */
-    if (delivered == 0) {
-        signal_free(sig);
-        return 0;
-    }
-
-    /* Signal ownership transferred to queues via ref_count */
-    /* Decrement our reference */
+    /* Route to destinations; queues hold their own references */
+    int delivered = route_broadcast_entry(table, entry, sig, agents);
     signal_free(sig);
 
     return delivered;
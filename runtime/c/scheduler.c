@@ -8,7 +8,10 @@
 
 #include "scheduler.h"
 #include "signal.h"
+#include "dispatch.h"
+#include <limits.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 /* =============================================================================
@@ -39,6 +42,205 @@ static inline uint64_t cycles_to_ns(uint64_t cycles) {
     return cycles / 3;
 }
 
+/* =============================================================================
+ * READY SET
+ *
+ * Design decisions:
+ * - Enqueue marks the destination ready through the queue's QueueWatcher,
+ *   so idle agents cost nothing per cycle
+ * - Two-level bitmap: ctz over the summary finds non-zero words, ctz over
+ *   a word finds ready agents; 4096 agents per summary word
+ * - A bit stays set while the agent still has signals after its turn
+ * - The same watcher counts signals in flight (enqueued, not yet
+ *   dispatched), so quiescence is a counter test rather than a sweep
+ * ============================================================================= */
+
+/*
+ * Mark an agent ready
+ */
+static inline void scheduler_mark_ready(Scheduler* sched, uint32_t agent_id) {
+    uint32_t word = agent_id >> 6;
+    sched->ready_bits[word] |= (uint64_t)1 << (agent_id & 63);
+    sched->ready_summary[word >> 6] |= (uint64_t)1 << (word & 63);
+}
+
+/*
+ * QueueWatcher callback: a signal was enqueued for agent_id
+ */
+static void scheduler_ready_notify(QueueWatcher* watcher, uint32_t agent_id) {
+    Scheduler* sched = (Scheduler*)((char*)watcher - offsetof(Scheduler, ready_watcher));
+    if (agent_id < sched->ready_words * 64) {
+        scheduler_mark_ready(sched, agent_id);
+        sched->in_flight++;
+    }
+}
+
+/*
+ * Install the ready watcher on one registry slot
+ *
+ * @return: 1 if the slot holds an agent with a queue, 0 if still empty
+ */
+static int scheduler_watch_slot(Scheduler* sched, uint32_t id) {
+    Agent* agent = sched->registry->agents[id];
+    if (agent == NULL || agent->input_queue == NULL) {
+        return 0;
+    }
+    agent->input_queue->owner_agent_id = id;
+    if (agent->flags & AGENT_FLAG_OFFLOADED) {
+        return 1;   /* Watched again by scheduler_resume_agent */
+    }
+    agent->input_queue->watcher = &sched->ready_watcher;
+
+    /* Signals queued before we were watching */
+    uint32_t queued = signal_queue_count(agent->input_queue);
+    if (queued > 0) {
+        scheduler_mark_ready(sched, id);
+        sched->in_flight += queued;
+    }
+    return 1;
+}
+
+/*
+ * Remember a scanned slot that has no agent yet (re-checked every cycle)
+ */
+static void scheduler_remember_empty_slot(Scheduler* sched, uint32_t id) {
+    if (sched->empty_slot_count == sched->empty_slot_capacity) {
+        uint32_t new_capacity = sched->empty_slot_capacity ? sched->empty_slot_capacity * 2 : 8;
+        uint32_t* slots = heap_allocate(new_capacity * sizeof(uint32_t));
+        if (slots == NULL) {
+            return;
+        }
+        if (sched->empty_slots != NULL) {
+            memcpy(slots, sched->empty_slots, sched->empty_slot_count * sizeof(uint32_t));
+            heap_free(sched->empty_slots, sched->empty_slot_capacity * sizeof(uint32_t));
+        }
+        sched->empty_slots = slots;
+        sched->empty_slot_capacity = new_capacity;
+    }
+    sched->empty_slots[sched->empty_slot_count++] = id;
+}
+
+/*
+ * Grow per-agent scheduler state to cover the registry
+ *
+ * Registries grow whenever an agent beyond them registers, so the ready
+ * set (and fair-share table) follow before agents are watched. Only called
+ * between sweeps. On allocation failure the old arrays stay and agents
+ * beyond them are picked up by a later call.
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_sync_capacity(Scheduler* sched) {
+    uint32_t capacity = sched->registry->capacity;
+    if (capacity > sched->ready_words * 64) {
+        uint32_t words = (capacity + 63) / 64;
+        uint32_t summary_words = (words + 63) / 64;
+        uint32_t old_summary_words = (sched->ready_words + 63) / 64;
+
+        uint64_t* bits = heap_allocate(words * sizeof(uint64_t));
+        uint64_t* summary = heap_allocate(summary_words * sizeof(uint64_t));
+        if (bits != NULL && summary != NULL) {
+            memcpy(bits, sched->ready_bits, sched->ready_words * sizeof(uint64_t));
+            memcpy(summary, sched->ready_summary, old_summary_words * sizeof(uint64_t));
+            heap_free(sched->ready_bits, sched->ready_words * sizeof(uint64_t));
+            heap_free(sched->ready_summary, old_summary_words * sizeof(uint64_t));
+            sched->ready_bits = bits;
+            sched->ready_summary = summary;
+            sched->ready_words = words;
+        } else {
+            heap_free(bits, words * sizeof(uint64_t));
+            heap_free(summary, summary_words * sizeof(uint64_t));
+        }
+    }
+
+    scheduler_fair_grow(sched);
+}
+
+/*
+ * Watch queues of agents registered since the last cycle
+ *
+ * O(empty slots) per cycle unless the registry grew; registries are
+ * normally dense, so that is usually just the unused agent 0.
+ */
+static void scheduler_track_new_agents(Scheduler* sched) {
+    scheduler_sync_capacity(sched);
+
+    /* Slots that were empty when scanned may have been filled since */
+    for (uint32_t i = 0; i < sched->empty_slot_count; ) {
+        if (scheduler_watch_slot(sched, sched->empty_slots[i])) {
+            sched->empty_slots[i] = sched->empty_slots[--sched->empty_slot_count];
+        } else {
+            i++;
+        }
+    }
+
+    uint32_t count = sched->registry->count;
+    if (count > sched->ready_words * 64) {
+        count = sched->ready_words * 64;
+    }
+
+    for (uint32_t id = sched->tracked_count; id < count; id++) {
+        if (!scheduler_watch_slot(sched, id)) {
+            scheduler_remember_empty_slot(sched, id);
+        }
+    }
+
+    if (count > sched->tracked_count) {
+        sched->tracked_count = count;
+    }
+}
+
+/*
+ * Forget which agents are watched (rebuilt on the next cycle)
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_reset_ready_set(Scheduler* sched) {
+    memset(sched->ready_bits, 0, sched->ready_words * sizeof(uint64_t));
+    memset(sched->ready_summary, 0, ((sched->ready_words + 63) / 64) * sizeof(uint64_t));
+    sched->tracked_count = 0;
+    sched->empty_slot_count = 0;
+    sched->in_flight = 0;
+}
+
+/*
+ * Take an agent out of the ready set while an offloaded handler owns it
+ *
+ * Its queue stops notifying and its queued signals stop counting as in
+ * flight; scheduler_resume_agent counts whatever is queued by then.
+ *
+ * @param sched: Scheduler state
+ * @param agent: Agent whose handler was offloaded
+ */
+void scheduler_suspend_agent(Scheduler* sched, Agent* agent) {
+    SignalQueue* queue = agent->input_queue;
+    agent->flags |= AGENT_FLAG_OFFLOADED;
+    if (queue->watcher == &sched->ready_watcher) {
+        queue->watcher = NULL;
+        uint32_t queued = signal_queue_count(queue);
+        sched->in_flight -= (queued < sched->in_flight) ? queued : sched->in_flight;
+    }
+}
+
+/*
+ * Put an agent back in the ready set once its offloaded handler returned
+ *
+ * @param sched: Scheduler state
+ * @param agent: Agent from scheduler_suspend_agent
+ */
+void scheduler_resume_agent(Scheduler* sched, Agent* agent) {
+    agent->flags &= ~(uint32_t)AGENT_FLAG_OFFLOADED;
+    uint32_t id = agent->input_queue->owner_agent_id;
+    if (id < sched->tracked_count && sched->registry->agents[id] == agent) {
+        scheduler_watch_slot(sched, id);
+    }
+}
+
+/* Mask of bits 0..bit inclusive */
+static inline uint64_t bits_through(uint32_t bit) {
+    return (bit == 63) ? ~(uint64_t)0 : (((uint64_t)2 << bit) - 1);
+}
+
 /* =============================================================================
  * SCHEDULER CREATION & DESTRUCTION
  * ============================================================================= */
@@ -61,13 +263,44 @@ Scheduler* scheduler_create(AgentRegistry* registry, RoutingTable* routing) {
         return NULL;
     }
 
+    /* Ready set covers every slot the registry can hold (and grows with it,
+     * see scheduler_sync_capacity) */
+    sched->ready_words = (registry->capacity + 63) / 64;
+    if (sched->ready_words == 0) {
+        sched->ready_words = 1;
+    }
+    sched->ready_bits = heap_allocate(sched->ready_words * sizeof(uint64_t));
+    sched->ready_summary = heap_allocate(((sched->ready_words + 63) / 64) * sizeof(uint64_t));
+    if (sched->ready_bits == NULL || sched->ready_summary == NULL) {
+        heap_free(sched->ready_bits, sched->ready_words * sizeof(uint64_t));
+        heap_free(sched->ready_summary, ((sched->ready_words + 63) / 64) * sizeof(uint64_t));
+        heap_free(sched, sizeof(Scheduler));
+        return NULL;
+    }
+    sched->ready_watcher.notify = scheduler_ready_notify;
+    sched->tracked_count = 0;
+    sched->in_flight = 0;
+
+    /* External input inbox + default idle policy (exit when idle) */
+    if (scheduler_idle_init(sched) != SIGNAL_OK) {
+        heap_free(sched->ready_bits, sched->ready_words * sizeof(uint64_t));
+        heap_free(sched->ready_summary, ((sched->ready_words + 63) / 64) * sizeof(uint64_t));
+        heap_free(sched, sizeof(Scheduler));
+        return NULL;
+    }
+
     /* Initialize scheduler state */
     sched->registry = registry;
     sched->routing = routing;
     sched->current_phase = PHASE_REST;
     sched->running = 1;
     sched->empty_cycles = 0;
-    sched->max_empty_cycles = 10;  /* Shutdown after 10 empty cycles */
+
+    /* Drain budget */
+    sched->budget_mode = SCHED_BUDGET_FIXED;
+    sched->budget_min = SCHED_DEFAULT_BUDGET_MIN;
+    sched->budget_max = SCHED_DEFAULT_BUDGET_MAX;
+    sched->prefetch_distance = 0;   /* Opt-in, see scheduler_set_prefetch */
 
     /* Initialize statistics */
     sched->cycle_count = 0;
@@ -75,10 +308,20 @@ Scheduler* scheduler_create(AgentRegistry* registry, RoutingTable* routing) {
     sched->agents_active = 0;
     sched->dispatch_errors = 0;
 
+    /* Inline handler runs from before this scheduler existed are not ours */
+    routing_take_direct_counts(NULL, NULL);
+
     /* Performance tracking */
     sched->start_timestamp = 0;
     sched->end_timestamp = 0;
 
+    /* Single-threaded until scheduler_create_parallel/_bsp attaches workers */
+    sched->parallel = NULL;
+    sched->bsp = NULL;
+    sched->thread_count = 1;
+    sched->agent_runs = 0;
+    sched->steals = 0;
+
     return sched;
 }
 
@@ -95,9 +338,358 @@ void scheduler_destroy(Scheduler* sched) {
     /* Note: We don't free registry or routing here
      * They are owned by the compiled program */
 
+    if (sched->parallel != NULL) {
+        scheduler_parallel_destroy(sched);
+    }
+    if (sched->bsp != NULL) {
+        scheduler_bsp_destroy(sched);
+    }
+
+    /* Waits for offloaded handlers, so nothing still uses agent state */
+    scheduler_offload_destroy(sched);
+
+    /* Suspended coroutines see NULL from their await and unwind */
+    scheduler_coroutines_destroy(sched);
+
+    /* Detach the ready watcher from queues that outlive us */
+    for (uint32_t i = 0; i < sched->tracked_count; i++) {
+        Agent* agent = sched->registry->agents[i];
+        if (agent != NULL && agent->input_queue != NULL &&
+            agent->input_queue->watcher == &sched->ready_watcher) {
+            agent->input_queue->watcher = NULL;
+        }
+    }
+    heap_free(sched->ready_bits, sched->ready_words * sizeof(uint64_t));
+    heap_free(sched->ready_summary, ((sched->ready_words + 63) / 64) * sizeof(uint64_t));
+    heap_free(sched->empty_slots, sched->empty_slot_capacity * sizeof(uint32_t));
+    scheduler_idle_destroy(sched);
+    scheduler_timers_destroy(sched);
+    scheduler_placement_destroy(sched);
+    scheduler_classes_destroy(sched);
+    scheduler_fair_destroy(sched);
+
     heap_free(sched, sizeof(Scheduler));
 }
 
+/* =============================================================================
+ * DRAIN BUDGETS
+ * ============================================================================= */
+
+/*
+ * Configure per-agent drain budget
+ *
+ * @param sched: Scheduler state
+ * @param mode: SCHED_BUDGET_FIXED or SCHED_BUDGET_ADAPTIVE
+ * @param budget_min: Minimum signals per agent per cycle (adaptive only)
+ * @param budget_max: Maximum signals per agent per cycle
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_budget(Scheduler* sched, SchedBudgetMode mode,
+                         uint32_t budget_min, uint32_t budget_max) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    if (budget_max == 0) {
+        budget_max = 1;
+    }
+    if (budget_min == 0) {
+        budget_min = 1;
+    }
+    if (budget_min > budget_max) {
+        budget_min = budget_max;
+    }
+
+    sched->budget_mode = mode;
+    sched->budget_min = budget_min;
+    sched->budget_max = budget_max;
+    return SIGNAL_OK;
+}
+
+/*
+ * Compute how many signals an agent may drain this cycle
+ *
+ * @param sched: Scheduler state
+ * @param depth: Queue depth at the start of the agent's turn
+ * @return: Budget (never more than depth)
+ */
+static inline uint32_t scheduler_agent_budget(Scheduler* sched, uint32_t depth) {
+    uint32_t budget = sched->budget_max;
+
+    if (sched->budget_mode == SCHED_BUDGET_ADAPTIVE) {
+        budget = depth >> SCHED_ADAPTIVE_SHIFT;
+        if (budget < sched->budget_min) {
+            budget = sched->budget_min;
+        }
+        if (budget > sched->budget_max) {
+            budget = sched->budget_max;
+        }
+    }
+
+    return (budget < depth) ? budget : depth;
+}
+
+/*
+ * Budget of an agent's next turn: the common budget times its weight
+ *
+ * @param sched: Scheduler state
+ * @param agent: Agent about to drain
+ * @param depth: Its queue depth (> 0)
+ * @return: Budget (never more than depth)
+ */
+uint32_t scheduler_turn_budget(Scheduler* sched, Agent* agent, uint32_t depth) {
+    uint32_t budget = scheduler_agent_budget(sched, depth);
+    if (sched->classes != NULL && agent->agent_id < sched->class_capacity) {
+        uint32_t weight = sched->classes[agent->agent_id].weight;
+        if (weight > 1) {
+            uint64_t weighted = (uint64_t)budget * weight;
+            budget = (weighted < depth) ? (uint32_t)weighted : depth;
+        }
+    }
+    return budget;
+}
+
+/*
+ * Drain up to count signals of one agent through its dispatch table
+ *
+ * @param sched: Scheduler state
+ * @param agent: Agent to run
+ * @param budget: Signals to drain (<= queued)
+ * @param dispatch_errors: Incremented by failed/unhandled signals
+ * @return: Number of signals drained (fewer if one went to the offload pool)
+ */
+uint32_t scheduler_drain_signals(Scheduler* sched, Agent* agent, uint32_t budget,
+                                 uint64_t* dispatch_errors) {
+    /* ACT: Drain up to budget signals through the dispatch table. The
+     * agent is marked so direct routes never re-enter it mid-handler */
+    uint32_t drained = 0;
+    DispatchTable* dispatch = (DispatchTable*)agent->dispatch_table;
+    agent->flags |= AGENT_FLAG_DISPATCHING;
+
+    if (agent->flags & AGENT_FLAG_POOLED) {
+        /* A pool instance on its own: its pool's handlers, one at a time */
+        drained = scheduler_pool_drain(sched, agent, budget, dispatch_errors);
+    } else if (agent->flags & AGENT_FLAG_COROUTINE) {
+        /* Signals the agent's coroutine awaits resume it, the rest dispatch */
+        drained = scheduler_coroutine_drain(sched, agent, budget, dispatch_errors);
+    } else if (dispatch != NULL) {
+        /* A signal for a blocking handler ends the inline run and goes to
+         * the offload pool (sequential scheduler only) */
+        uint32_t inline_budget = budget;
+        if (sched->offload != NULL && sched->parallel == NULL && sched->bsp == NULL) {
+            inline_budget = scheduler_offload_inline_count(sched, agent, budget);
+        }
+
+        /* The table may be shared (replicas, typed agents) with agents on
+         * other workers: errors come back per call, profiles by agent ID */
+        uint32_t errors = 0;
+        if (inline_budget > 0) {
+            drained = (uint32_t)dispatch_process_batch_for_agent(
+                dispatch, agent->agent_id, agent->state_ptr, agent->input_queue,
+                inline_budget, &errors);
+            *dispatch_errors += errors;
+        }
+        if (drained == inline_budget && inline_budget < budget &&
+            scheduler_offload_submit(sched, agent) != SIGNAL_OK) {
+            /* Pool unavailable: run it here after all */
+            drained += (uint32_t)dispatch_process_batch_for_agent(
+                dispatch, agent->agent_id, agent->state_ptr, agent->input_queue,
+                1, &errors);
+            *dispatch_errors += errors;
+        }
+    } else {
+        /* No handlers: consume and drop */
+        for (; drained < budget; drained++) {
+            Signal* sig = signal_queue_dequeue(agent->input_queue);
+            if (sig == NULL) {
+                break;
+            }
+            signal_free(sig);
+        }
+    }
+
+    agent->flags &= ~(uint32_t)AGENT_FLAG_DISPATCHING;
+    agent->signal_count += drained;
+    return drained;
+}
+
+/*
+ * Give one agent its turn: drain up to its budget through its dispatch table
+ *
+ * Shared by the sequential cycle and the parallel workers.
+ *
+ * @param sched: Scheduler state (budget configuration)
+ * @param agent: Agent to run
+ * @param dispatch_errors: Incremented by failed/unhandled signals
+ * @return: Number of signals drained
+ */
+uint32_t scheduler_drain_agent(Scheduler* sched, Agent* agent,
+                               uint64_t* dispatch_errors) {
+    /* SENSE: Snapshot queue depth to size this agent's turn */
+    uint32_t depth = signal_queue_count(agent->input_queue);
+    if (depth == 0) {
+        return 0;
+    }
+
+    /* Fair share or fairness metrics: a timed turn (scheduler_fair.c) */
+    if (sched->fair != NULL) {
+        return scheduler_fair_turn(sched, agent, depth, dispatch_errors);
+    }
+
+    return scheduler_drain_signals(sched, agent, scheduler_turn_budget(sched, agent, depth),
+                                   dispatch_errors);
+}
+
+/* =============================================================================
+ * PREFETCH PIPELINE
+ *
+ * A ring of the next ready agents after the one being visited, nearest
+ * first. Each visit advances every entry one stage down the load chain:
+ *
+ *   distance D        Agent struct (from registry->agents)
+ *   distance 3D/4     queue header and agent state
+ *   distance D/2      ring slot holding the head signal pointer
+ *   distance D/4      head Signal
+ *   distance 1        its payload
+ *
+ * Each stage reads only lines the previous stage requested one or more
+ * turns ago, so the pipeline itself rarely stalls. Prefetches are hints:
+ * an entry that goes idle before its turn costs a wasted line, nothing else.
+ * ============================================================================= */
+
+/*
+ * Configure how far ahead the sequential sweep prefetches
+ *
+ * @param sched: Scheduler state
+ * @param distance: Ready agents ahead of the current one (0 = off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_prefetch(Scheduler* sched, uint32_t distance) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    sched->prefetch_distance = (distance > SCHED_PREFETCH_MAX) ? SCHED_PREFETCH_MAX : distance;
+    sched->prefetch_count = 0;
+    return SIGNAL_OK;
+}
+
+/*
+ * First ready agent with ID >= from
+ *
+ * @return: Agent ID, or UINT32_MAX if none
+ */
+static uint32_t scheduler_next_ready(Scheduler* sched, uint32_t from) {
+    uint32_t k = from / 64;
+    if (k >= sched->ready_words) {
+        return UINT32_MAX;
+    }
+    uint64_t word = sched->ready_bits[k] & (~(uint64_t)0 << (from % 64));
+    if (word != 0) {
+        return k * 64 + (uint32_t)__builtin_ctzll(word);
+    }
+
+    /* Later words, found through the summary */
+    uint32_t summary_words = (sched->ready_words + 63) / 64;
+    k++;
+    for (uint32_t s = k / 64; s < summary_words; s++) {
+        uint64_t pending = sched->ready_summary[s];
+        if (s == k / 64) {
+            pending &= ~(uint64_t)0 << (k % 64);
+        }
+        while (pending != 0) {
+            uint32_t w = s * 64 + (uint32_t)__builtin_ctzll(pending);
+            if (sched->ready_bits[w] != 0) {
+                return w * 64 + (uint32_t)__builtin_ctzll(sched->ready_bits[w]);
+            }
+            pending &= pending - 1;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/*
+ * Issue the load-chain prefetch of the entry at a given distance
+ *
+ * @param stage: 0 = agent ... 4 = payload
+ */
+static inline void scheduler_prefetch_stage(Scheduler* sched, uint32_t id, int stage) {
+    Agent* agent = sched->registry->agents[id];
+    if (agent == NULL) {
+        return;
+    }
+    if (stage == 0) {
+        __builtin_prefetch(agent, 0, 3);
+        return;
+    }
+
+    SignalQueue* queue = agent->input_queue;
+    if (queue == NULL) {
+        return;
+    }
+    if (stage == 1) {
+        __builtin_prefetch(queue, 1, 3);
+        __builtin_prefetch(agent->state_ptr, 1, 3);
+        return;
+    }
+
+    if (queue->count == 0) {
+        return;
+    }
+    Signal** slot = &queue->buffer[queue->head & queue->mask];
+    if (stage == 2) {
+        __builtin_prefetch(slot, 0, 3);
+        return;
+    }
+    if (stage == 3) {
+        __builtin_prefetch(*slot, 0, 3);
+        return;
+    }
+    __builtin_prefetch((*slot)->payload_ptr, 0, 3);
+}
+
+/*
+ * Advance the pipeline past the agent about to be visited
+ *
+ * Drops entries at or before `id`, tops the ring up with the next ready
+ * agents, then issues one stage for each stage's distance.
+ *
+ * @param sched: Scheduler state (prefetch_distance > 0)
+ * @param id: Agent the sweep is visiting
+ */
+static void scheduler_prefetch_advance(Scheduler* sched, uint32_t id) {
+    const uint32_t mask = SCHED_PREFETCH_MAX - 1;
+    uint32_t distance = sched->prefetch_distance;
+
+    while (sched->prefetch_count > 0 && sched->prefetch_ids[sched->prefetch_head] <= id) {
+        sched->prefetch_head = (sched->prefetch_head + 1) & mask;
+        sched->prefetch_count--;
+    }
+
+    /* Newly queued entries start at the top stage */
+    uint32_t last = (sched->prefetch_count > 0)
+        ? sched->prefetch_ids[(sched->prefetch_head + sched->prefetch_count - 1) & mask]
+        : id;
+    while (sched->prefetch_count < distance) {
+        uint32_t next = scheduler_next_ready(sched, last + 1);
+        if (next == UINT32_MAX) {
+            break;
+        }
+        sched->prefetch_ids[(sched->prefetch_head + sched->prefetch_count) & mask] = next;
+        sched->prefetch_count++;
+        last = next;
+    }
+
+    /* Stage distances, farthest first: D, 3D/4, D/2, D/4, 1 */
+    uint32_t stage_distance[5] = { distance, (distance * 3) / 4, distance / 2, distance / 4, 1 };
+    for (int stage = 0; stage < 5; stage++) {
+        uint32_t d = stage_distance[stage] ? stage_distance[stage] : 1;
+        if (d <= sched->prefetch_count) {
+            uint32_t ahead = sched->prefetch_ids[(sched->prefetch_head + d - 1) & mask];
+            scheduler_prefetch_stage(sched, ahead, stage);
+        }
+    }
+}
+
 /* =============================================================================
  * TIDAL CYCLE EXECUTION
  * ============================================================================= */
@@ -105,8 +697,12 @@ void scheduler_destroy(Scheduler* sched) {
 /*
  * Run one tidal cycle (REST → SENSE → ACT)
  *
- * Fair scheduling: Each agent gets equal processing time.
- * Round-robin through all agents, dequeue and dispatch signals.
+ * Fair scheduling: Each ready agent gets one turn per cycle, bounded by
+ * its drain budget, in agent ID order. Agents that become ready during
+ * the cycle are visited this cycle if their ID is still ahead of the scan,
+ * otherwise next cycle (same order as a full round-robin pass). An agent
+ * pool takes its turn, for all its instances at once, where the scan
+ * reaches its first ready instance.
  *
  * @param sched: Scheduler state
  * @return: Number of signals processed this cycle
@@ -117,57 +713,132 @@ int scheduler_run_cycle(Scheduler* sched) {
     }
 
     int signals_processed = 0;
+    uint64_t deferred_before = sched->fair_deferred;
 
     /* -------------------------------------------------------------------------
      * REST PHASE
      * ------------------------------------------------------------------------- */
     sched->current_phase = PHASE_REST;
 
-    /* For now: REST phase is just bookkeeping
-     * Future: Could call on_rest handlers here */
+    /* Results of offloaded handlers, due timers, then signals injected by
+     * other threads */
+    scheduler_offload_collect(sched);
+    scheduler_fire_timers(sched);
+    scheduler_drain_inbox(sched);
 
     /* -------------------------------------------------------------------------
      * SENSE & ACT PHASES (Combined)
      * ------------------------------------------------------------------------- */
 
-    /* Iterate through all agents in spawn order */
-    for (uint32_t i = 0; i < sched->registry->count; i++) {
-        Agent* agent = sched->registry->agents[i];
-        if (agent == NULL || agent->input_queue == NULL) {
-            continue;
-        }
+    scheduler_track_new_agents(sched);
 
-        /* SENSE: Try to dequeue a signal from this agent's input queue */
-        sched->current_phase = PHASE_SENSE;
-        Signal* sig = signal_queue_dequeue(agent->input_queue);
+    /* Deadline agents first, earliest deadline first */
+    if (sched->deadline_count > 0) {
+        signals_processed += scheduler_run_deadline_agents(sched);
+    }
 
-        if (sig == NULL) {
-            /* No signal for this agent this cycle */
-            continue;
-        }
+    /* Prefetch ahead of the sweep on networks too big to stay cached */
+    int prefetch = sched->prefetch_distance > 0 &&
+                   sched->tracked_count >= SCHED_PREFETCH_MIN_AGENTS;
+    sched->prefetch_count = 0;
+
+    /* Visit ready agents in ID order (summary word -> ready word -> agent) */
+    uint32_t summary_words = (sched->ready_words + 63) / 64;
+    for (uint32_t s = 0; s < summary_words; s++) {
+        uint64_t words_passed = 0;
+        uint64_t pending_words;
 
-        /* ACT: Dispatch signal to handler */
-        sched->current_phase = PHASE_ACT;
+        while ((pending_words = sched->ready_summary[s] & ~words_passed) != 0) {
+            uint32_t wbit = (uint32_t)__builtin_ctzll(pending_words);
+            uint32_t k = s * 64 + wbit;
+            words_passed |= bits_through(wbit);
 
-        /* TODO: Phase 3 integration - call dispatch_invoke()
-         * For now, we just acknowledge we have a signal */
+            uint64_t agents_passed = 0;
+            uint64_t pending;
 
-        /* dispatch_invoke(agent->dispatch, agent->state, sig); */
+            while ((pending = sched->ready_bits[k] & ~agents_passed) != 0) {
+                uint32_t bit = (uint32_t)__builtin_ctzll(pending);
+                uint32_t id = k * 64 + bit;
+                agents_passed |= bits_through(bit);
 
-        /* Signal processed successfully */
-        signal_free(sig);
-        signals_processed++;
-        sched->total_signals_processed++;
+                if (prefetch) {
+                    scheduler_prefetch_advance(sched, id);
+                }
+
+                Agent* agent = sched->registry->agents[id];
+
+                /* SENSE + ACT: drain this agent's budget (deadline agents
+                 * had their turn in the EDF pass) */
+                sched->current_phase = PHASE_SENSE;
+                if (agent != NULL && (agent->flags & AGENT_FLAG_POOLED) && sched->fair == NULL) {
+                    /* The first ready instance runs the whole pool's turn */
+                    AgentPool* pool = (AgentPool*)agent->state_ptr;
+                    if (!pool->turn_taken) {
+                        sched->current_phase = PHASE_ACT;
+                        uint32_t drained = scheduler_pool_turn(sched, pool,
+                                                               &sched->dispatch_errors);
+
+                        signals_processed += (int)drained;
+                        sched->total_signals_processed += drained;
+                        sched->agents_active++;
+                        sched->in_flight -= (drained < sched->in_flight) ? drained : sched->in_flight;
+                    }
+                } else if (agent != NULL && agent->input_queue != NULL &&
+                    !(agent->flags & AGENT_FLAG_DEADLINE) &&
+                    !signal_queue_is_empty(agent->input_queue)) {
+                    sched->current_phase = PHASE_ACT;
+                    uint32_t drained = scheduler_drain_agent(sched, agent,
+                                                             &sched->dispatch_errors);
+
+                    signals_processed += (int)drained;
+                    sched->total_signals_processed += drained;
+                    sched->agents_active++;
+                    sched->in_flight -= (drained < sched->in_flight) ? drained : sched->in_flight;
+                }
+
+                /* Stay ready only while signals remain and the agent is
+                 * not waiting on an offloaded handler */
+                if (agent == NULL || signal_queue_is_empty(agent->input_queue) ||
+                    (agent->flags & AGENT_FLAG_OFFLOADED)) {
+                    sched->ready_bits[k] &= ~((uint64_t)1 << bit);
+                }
+            }
+
+            if (sched->ready_bits[k] == 0) {
+                sched->ready_summary[s] &= ~((uint64_t)1 << wbit);
+            }
+        }
+    }
+
+    /* Pools get one turn per cycle: re-arm the ones that had theirs */
+    while (sched->pool_turns != NULL) {
+        AgentPool* pool = sched->pool_turns;
+        sched->pool_turns = pool->next_turn;
+        pool->next_turn = NULL;
+        pool->turn_taken = 0;
     }
 
+    /* Handlers that direct routes ran inline count as processed here, the
+     * same as if their signals had been queued */
+    uint64_t direct_handled, direct_errors;
+    routing_take_direct_counts(&direct_handled, &direct_errors);
+    signals_processed += (int)direct_handled;
+    sched->total_signals_processed += direct_handled;
+    sched->dispatch_errors += direct_errors;
+
     /* Update cycle statistics */
     sched->cycle_count++;
 
-    if (signals_processed > 0) {
-        sched->agents_active += signals_processed;
+    if (signals_processed > 0 || sched->fair_deferred != deferred_before) {
+        /* Agents that sat out their turn in deficit still have work */
         sched->empty_cycles = 0;
     } else {
-        sched->empty_cycles++;
+        /* Every ready agent was visited and had nothing: resync the count in
+         * case signals were drained outside the scheduler */
+        sched->in_flight = 0;
+        if (sched->empty_cycles < INT_MAX) {
+            sched->empty_cycles++;
+        }
     }
 
     return signals_processed;
@@ -177,9 +848,14 @@ int scheduler_run_cycle(Scheduler* sched) {
  * Run scheduler until termination
  *
  * Termination conditions:
- * - max_empty_cycles consecutive cycles with no signals (graceful shutdown)
+ * - SCHED_IDLE_EXIT: the network is quiescent (no signals in flight, no
+ *   pending timers, empty inbox, no open inputs), checked after every
+ *   cycle so the run ends on the cycle that handled the last signal
  * - sched->running set to 0 (manual shutdown)
  *
+ * Other idle modes back off between empty cycles (spin, yield, park) and
+ * keep waiting for injected signals until shutdown.
+ *
  * @param sched: Scheduler state
  * @return: Total signals processed, or negative error code
  */
@@ -188,11 +864,18 @@ int scheduler_run(Scheduler* sched) {
         return SIGNAL_ERR_NULL_POINTER;
     }
 
+    if (sched->parallel != NULL) {
+        return scheduler_parallel_run(sched);
+    }
+    if (sched->bsp != NULL) {
+        return scheduler_bsp_run(sched);
+    }
+
     /* Record start time */
     sched->start_timestamp = get_cpu_timestamp();
 
     /* Main event loop */
-    while (sched->running) {
+    while (__atomic_load_n(&sched->running, __ATOMIC_RELAXED)) {
         /* Run one tidal cycle */
         int processed = scheduler_run_cycle(sched);
 
@@ -202,19 +885,35 @@ int scheduler_run(Scheduler* sched) {
             continue;
         }
 
-        /* Check termination condition: consecutive empty cycles */
-        if (sched->empty_cycles >= sched->max_empty_cycles) {
-            /* No signals for N cycles, graceful shutdown */
+        if (processed > 0) {
+            scheduler_idle_end(sched);
+        }
+
+        /* Signals left for the next cycle, or `on cycle` timers that need
+         * the cycles to keep coming */
+        if (sched->in_flight > 0 || scheduler_cycle_timers_pending(sched) > 0) {
+            continue;
+        }
+
+        /* Agents registered during the cycle may have arrived with signals */
+        scheduler_track_new_agents(sched);
+        if (sched->in_flight > 0) {
+            continue;
+        }
+
+        /* Quiescent: nothing queued, running, scheduled or attached */
+        if (sched->idle_mode == SCHED_IDLE_EXIT &&
+            !scheduler_external_pending(sched) &&
+            scheduler_next_wall_deadline(sched) == 0) {
             break;
         }
 
-        /* Optional: Small sleep to prevent busy-waiting
-         * Uncomment if you want to reduce CPU usage */
-        /* if (processed == 0) {
-            usleep(100);
-        } */
+        /* Wait for input without burning the core */
+        scheduler_idle_wait(sched);
     }
 
+    scheduler_idle_end(sched);
+
     /* Record end time */
     sched->end_timestamp = get_cpu_timestamp();
 
@@ -262,7 +961,8 @@ int scheduler_run_cycles(Scheduler* sched, uint64_t max_cycles) {
  */
 void scheduler_shutdown(Scheduler* sched) {
     if (sched != NULL) {
-        sched->running = 0;
+        __atomic_store_n(&sched->running, 0, __ATOMIC_RELAXED);
+        scheduler_wake(sched);
     }
 }
 
@@ -312,6 +1012,30 @@ void scheduler_get_stats(Scheduler* sched, SchedulerStats* stats) {
     stats->signals_processed = sched->total_signals_processed;
     stats->agents_active = sched->agents_active;
     stats->dispatch_errors = sched->dispatch_errors;
+    stats->threads = sched->thread_count;
+    stats->agent_runs = sched->agent_runs;
+    stats->steals = sched->steals;
+
+    /* Idle behaviour */
+    stats->idle_mode = sched->idle_mode;
+    stats->idle_parks = sched->idle_parks;
+    stats->wakeups = sched->wakeups;
+    stats->wake_latency_avg_ns = sched->wakeups ?
+        sched->wake_latency_total_ns / sched->wakeups : 0;
+    stats->wake_latency_max_ns = sched->wake_latency_max_ns;
+    stats->idle_wall_ns = sched->idle_wall_ns;
+    stats->idle_cpu_ns = sched->idle_cpu_ns;
+    stats->timers_fired = sched->timers_fired;
+    stats->placement_traffic = sched->placement_traffic;
+    stats->placement_cut = sched->placement_cut;
+    stats->offloaded = sched->offloaded;
+    stats->offload_wall_ns = sched->offload_wall_ns;
+    stats->offload_max_ns = sched->offload_max_ns;
+    stats->deadline_signals = sched->deadline_signals;
+    stats->deadline_misses = sched->deadline_misses;
+    stats->deadline_max_late_ns = sched->deadline_max_late_ns;
+    stats->fair_deferred = sched->fair_deferred;
+    scheduler_fair_summary(sched, &stats->max_wait_ns, &stats->max_wait_agent);
 
     /* Calculate timing stats */
     uint64_t total_cycles = sched->end_timestamp - sched->start_timestamp;
@@ -358,6 +1082,43 @@ void scheduler_print_stats(Scheduler* sched) {
     printf("  Signals processed: %lu\n", stats.signals_processed);
     printf("  Agents active:     %lu\n", stats.agents_active);
     printf("  Dispatch errors:   %lu\n", stats.dispatch_errors);
+    if (stats.timers_fired > 0) {
+        printf("  Timers fired:      %lu\n", stats.timers_fired);
+    }
+    if (stats.offloaded > 0) {
+        printf("  Offloaded calls:   %lu (avg %lu ns, max %lu ns)\n", stats.offloaded,
+               stats.offload_wall_ns / stats.offloaded, stats.offload_max_ns);
+    }
+    if (stats.deadline_signals > 0) {
+        printf("  Deadline misses:   %lu of %lu (worst %lu ns late)\n", stats.deadline_misses,
+               stats.deadline_signals, stats.deadline_max_late_ns);
+    }
+    if (sched->fair != NULL) {
+        printf("  Max wait:          %lu ns (agent %u)\n", stats.max_wait_ns,
+               stats.max_wait_agent);
+        printf("  Deferred turns:    %lu\n", stats.fair_deferred);
+    }
+    if (stats.threads > 1) {
+        printf("  Worker threads:    %u\n", stats.threads);
+        printf("  Agent runs:        %lu\n", stats.agent_runs);
+        printf("  Steals:            %lu\n", stats.steals);
+        if (stats.placement_traffic > 0) {
+            printf("  Placement cut:     %lu of %lu signals (%.1f%%)\n",
+                   stats.placement_cut, stats.placement_traffic,
+                   100.0 * (double)stats.placement_cut / (double)stats.placement_traffic);
+        }
+    }
+    if (stats.idle_mode != SCHED_IDLE_EXIT) {
+        static const char* idle_names[] = { "exit", "spin", "yield", "park" };
+        printf("\n");
+        printf("  Idle policy:       %s\n", idle_names[stats.idle_mode]);
+        printf("  Wake-ups:          %lu (avg %lu ns, max %lu ns)\n",
+               stats.wakeups, stats.wake_latency_avg_ns, stats.wake_latency_max_ns);
+        printf("  Parks:             %lu\n", stats.idle_parks);
+        printf("  Idle CPU:          %.1f%% of %.3f s idle\n",
+               stats.idle_wall_ns ? 100.0 * (double)stats.idle_cpu_ns / (double)stats.idle_wall_ns : 0.0,
+               (double)stats.idle_wall_ns / 1000000000.0);
+    }
     printf("\n");
     printf("  Memory used:       %lu bytes (%.2f MB)\n",
            stats.memory_allocated,
@@ -22,6 +22,280 @@ typedef enum {
     PHASE_ACT = 2     /* Agents execute handlers, emit signals */
 } TidalPhase;
 
+/* =============================================================================
+ * DRAIN BUDGETS
+ *
+ * Each agent drains at most `budget` signals per cycle. The budget never
+ * exceeds the queue depth seen at the start of the agent's turn, so signals
+ * an agent sends to itself wait for the next cycle and every agent gets its
+ * turn before any agent runs again.
+ * ============================================================================= */
+
+typedef enum {
+    SCHED_BUDGET_FIXED = 0,     /* budget = budget_max */
+    SCHED_BUDGET_ADAPTIVE = 1   /* budget = depth / 4, clamped to [min, max] */
+} SchedBudgetMode;
+
+#define SCHED_DEFAULT_BUDGET_MIN    1
+#define SCHED_DEFAULT_BUDGET_MAX    64
+#define SCHED_ADAPTIVE_SHIFT        2   /* Adaptive drains 1/4 of the backlog */
+
+/* =============================================================================
+ * PREFETCH
+ *
+ * Reaching the next agent's first signal is a chain of dependent loads
+ * (agent, queue header, queue slot, signal, payload), each a likely cache
+ * miss once the network outgrows the cache. The sequential sweep runs a
+ * prefetch pipeline ahead of itself over the ready set, issuing one link
+ * of the chain per step for each upcoming agent, so the lines have arrived
+ * by the time its turn comes. Small networks stay cached and skip it.
+ * Off by default: out-of-order cores already overlap part of these misses
+ * and the gain depends on the machine, so measure with bench_prefetch.
+ * ============================================================================= */
+
+#define SCHED_PREFETCH_DISTANCE     8       /* Suggested ready agents ahead */
+#define SCHED_PREFETCH_MAX          32      /* Pipeline size (power of two) */
+#define SCHED_PREFETCH_MIN_AGENTS   512     /* Below this the sweep skips it */
+
+/* =============================================================================
+ * SCHEDULING CLASSES
+ *
+ * Every agent is best effort by default: one turn per cycle, in ID order,
+ * with the common budget. A weighted agent drains weight times the budget
+ * per turn. Deadline agents give a target latency from a signal's
+ * timestamp to its dispatch; each cycle they take their turns before
+ * everyone else, earliest deadline first, and late signals are counted as
+ * misses. See scheduler_class.c.
+ * ============================================================================= */
+
+typedef enum {
+    SCHED_CLASS_BEST_EFFORT = 0,
+    SCHED_CLASS_WEIGHTED = 1,       /* Budget x weight */
+    SCHED_CLASS_DEADLINE = 2        /* EDF pass before the ID-order sweep */
+} SchedClass;
+
+#define SCHED_WEIGHT_MAX            64
+
+/* =============================================================================
+ * FAIR SHARE
+ *
+ * Count budgets ignore how long handlers take: an agent with 1 ms handlers
+ * holds every other agent up for its whole budget. In fair-share mode each
+ * turn is charged the handler time it actually used (deficit round robin):
+ * an agent earns quantum x weight per turn and sits out turns while it is
+ * in debt. Per-agent wait/run metrics come with it, or can be collected
+ * on their own. See scheduler_fair.c.
+ * ============================================================================= */
+
+#define SCHED_FAIR_CHUNK_MAX        64      /* Signals per timed chunk */
+
+/* Per-agent fairness metrics */
+typedef struct {
+    uint64_t turns;                 /* Turns that ran signals */
+    uint64_t deferred;              /* Turns sat out in deficit */
+    uint64_t signals;               /* Signals drained */
+    uint64_t run_ns;                /* Time in handlers */
+    uint64_t wait_ns;               /* Runnable but not running */
+    uint64_t runnable_ns;           /* run_ns + wait_ns */
+    uint64_t max_wait_ns;           /* Longest runnable stretch before a turn */
+} SchedFairnessStats;
+
+/* Per-agent class (indexed by agent slot) */
+typedef struct SchedAgentClass {
+    uint32_t cls;                   /* SchedClass */
+    uint32_t weight;                /* Budget multiplier (1 = none) */
+    uint64_t target_ns;             /* Deadline: target latency */
+    uint64_t target_tsc;            /* ... in timestamp (TSC) ticks */
+    uint64_t signals;               /* Deadline: signals dispatched */
+    uint64_t misses;                /* ... of which after their deadline */
+} SchedAgentClass;
+
+/* =============================================================================
+ * IDLE POLICY & EXTERNAL INPUT
+ *
+ * What scheduler_run does when a cycle finds no work. SCHED_IDLE_EXIT
+ * returns as soon as the network is quiescent: no signal queued or being
+ * handled, no pending timer, nothing in the inbox and no open external
+ * input. The other modes wait for input until scheduler_shutdown(),
+ * escalating from spinning to yielding to sleeping on a futex.
+ *
+ * Other threads (fruiting bodies, I/O callbacks) feed a running network
+ * with scheduler_inject(): signals go through a small locked inbox that
+ * the scheduler thread drains at the start of each cycle, so the queues,
+ * heap and ready set stay single-threaded. A producer that injects over
+ * time brackets its lifetime with scheduler_open_input/_close_input so the
+ * network is not considered finished between its signals.
+ * ============================================================================= */
+
+typedef enum {
+    SCHED_IDLE_EXIT = 0,        /* Return once quiescent (default) */
+    SCHED_IDLE_SPIN = 1,        /* Wait for input, busy-spinning */
+    SCHED_IDLE_YIELD = 2,       /* Spin, then sched_yield() */
+    SCHED_IDLE_PARK = 3         /* Spin, yield, then sleep until woken */
+} SchedIdleMode;
+
+#define SCHED_DEFAULT_IDLE_SPIN     64      /* Empty cycles spent spinning */
+#define SCHED_DEFAULT_IDLE_YIELD    128     /* Then empty cycles spent yielding */
+#define SCHED_INBOX_CAPACITY        256     /* Injected signals awaiting a cycle */
+#define SCHED_INBOX_PAYLOAD_MAX     40      /* Largest injectable payload */
+
+/*
+ * Injected signal awaiting the scheduler thread
+ *
+ * Layout: 64 bytes
+ */
+typedef struct SchedInboxSlot {
+    uint32_t agent_id;              /* 0x00: Destination agent */
+    uint32_t frequency_id;          /* 0x04: Signal frequency */
+    uint32_t source_agent_id;       /* 0x08: Reported sender */
+    uint32_t payload_size;          /* 0x0C: Bytes used in payload[] */
+    uint64_t inject_ns;             /* 0x10: CLOCK_MONOTONIC at inject */
+    uint8_t payload[SCHED_INBOX_PAYLOAD_MAX]; /* 0x18: Payload copy */
+} SchedInboxSlot;
+
+/* =============================================================================
+ * TIMERS
+ *
+ * `on cycle N` and periodic handlers. A timer runs its handler with the
+ * agent's state at the start (REST phase) of a cycle. Cycle timers fire
+ * in the cycle whose number (scheduler_get_cycle_count() at the start of
+ * the cycle) equals their due cycle; wall-clock timers fire in the first
+ * cycle after their deadline. The work-stealing scheduler has no cycles
+ * and does not fire timers. See scheduler_timer.c.
+ * ============================================================================= */
+
+/* Timer handler: agent state and the current cycle number
+ * Returns: 0 on success, non-zero counts as a dispatch error */
+typedef int (*timer_handler_fn)(void* agent_state, uint64_t cycle);
+
+/* Wall-clock wheel resolution: 2^20 ns (~1 ms) per tick */
+#define SCHED_WALL_TICK_SHIFT       20
+
+/*
+ * Pending timer (intrusive wheel node)
+ *
+ * Layout: 48 bytes
+ */
+typedef struct SchedTimer {
+    struct SchedTimer* next;        /* 0x00: Slot list */
+    struct SchedTimer* prev;        /* 0x08: Slot list */
+    uint64_t due;                   /* 0x10: Due tick (cycle or wall tick) */
+    uint64_t period;                /* 0x18: Ticks between firings (0 = once) */
+    timer_handler_fn handler;       /* 0x20: Handler */
+    uint32_t agent_id;              /* 0x28: Agent whose state is passed */
+    uint8_t level;                  /* 0x2C: Wheel level */
+    uint8_t slot;                   /* 0x2D: Slot within level */
+    uint8_t flags;                  /* 0x2E: TIMER_FLAG_* (scheduler_timer.c) */
+    uint8_t reserved;               /* 0x2F */
+} SchedTimer;
+
+/* =============================================================================
+ * COROUTINE AGENTS
+ *
+ * A multi-step protocol (the orchestrator waiting on lex_complete, then
+ * parse_complete, then link_complete) can be written as straight-line code
+ * instead of a state machine in agent state. The body runs on its own
+ * stack and suspends in coroutine_await() until the agent receives a
+ * signal of the awaited frequency; meanwhile the agent's other signals
+ * dispatch through its handler table as usual. See scheduler_coro.c.
+ * ============================================================================= */
+
+#define SCHED_CORO_STACK_SIZE       (64 * 1024)     /* Default stack */
+#define SCHED_CORO_MAX_AWAIT        8               /* Frequencies per await */
+
+typedef struct AgentCoroutine AgentCoroutine;
+
+/* Coroutine body: returns like a handler (non-zero counts as an error) */
+typedef int (*coroutine_fn)(void* agent_state, AgentCoroutine* coro);
+
+/* =============================================================================
+ * BLOCKING HANDLER OFFLOAD
+ *
+ * Handlers that may block (file I/O, slow syscalls) are marked with
+ * dispatch_set_blocking() per frequency or AGENT_FLAG_BLOCKING per agent.
+ * With an offload pool the sequential scheduler hands such a signal to a
+ * pool thread and keeps cycling; the agent is busy (takes no signals,
+ * timers wait) until the handler returns, and the signals it emitted are
+ * delivered at the start of the next cycle. See scheduler_offload.c.
+ * ============================================================================= */
+
+#define SCHED_OFFLOAD_MAX_THREADS   64
+
+/* =============================================================================
+ * AGENT PLACEMENT
+ *
+ * Which worker each agent calls home under the work-stealing scheduler.
+ * A plan partitions the observed traffic graph (routing edge counters, or
+ * a profile saved from an earlier run) so chatty agents share a worker
+ * and their signals stay in one core's cache. Without a plan agents are
+ * spread by ID. See scheduler_placement.c.
+ * ============================================================================= */
+
+#define SCHED_PLACEMENT_IMBALANCE   10      /* Max % over an even share of load */
+#define SCHED_PLACEMENT_PASSES      8       /* Refinement passes per plan */
+#define SCHED_CPU_MASK_WORDS        16      /* CPU mask size (1024 CPUs) */
+#define SCHED_PLACEMENT_PROFILE_HEADER "# mycelial traffic profile v1"
+
+/* =============================================================================
+ * AGENT POOLS
+ *
+ * Many instances of one agent (a swarm of hyphae, the voters of a
+ * consensus round) as a single pool. Instance state is kept as
+ * structure-of-arrays columns, and each pool handler is called once per
+ * round with every instance whose next signal has its frequency, so the
+ * loop over instances is the handler's own (and can vectorize) instead of
+ * one indirect call per instance. Instances are ordinary agents to routing
+ * and the registry: agent IDs first_id .. first_id + count - 1, each with
+ * its own queue. See scheduler_pool.c.
+ * ============================================================================= */
+
+#define POOL_MAX_COLUMNS            16
+#define POOL_MAX_HANDLERS           16
+#define POOL_COLUMN_ALIGN           64      /* Columns start on a cache line */
+
+typedef struct AgentPool AgentPool;
+
+/* Pool handler: instances[i] (pool indices, ascending) received signals[i]
+ * Returns: number of signals that failed (counted as dispatch errors) */
+typedef int (*pool_handler_fn)(AgentPool* pool, const uint32_t* instances,
+                               Signal* const* signals, uint32_t count);
+
+typedef struct PoolHandler {
+    uint32_t frequency_id;
+    pool_handler_fn handler;
+} PoolHandler;
+
+struct AgentPool {
+    uint32_t first_id;              /* Instance i is agent first_id + i */
+    uint32_t count;                 /* Instances */
+    Agent* agents;                  /* Instance agents (registered) */
+    void* context;                  /* Shared by all instances (routing, ...) */
+
+    /* Instance state, one column per field */
+    void* columns[POOL_MAX_COLUMNS];
+    uint32_t column_sizes[POOL_MAX_COLUMNS]; /* Bytes per element */
+    uint32_t column_count;
+
+    PoolHandler handlers[POOL_MAX_HANDLERS];
+    uint32_t handler_count;
+
+    /* Round buffers, count entries each: signals gathered in instance
+     * order, then grouped by handler */
+    uint32_t* gather_instances;
+    Signal** gather_signals;
+    uint8_t* gather_handlers;
+    uint32_t* batch_instances;
+    Signal** batch_signals;
+
+    int turn_taken;                 /* Had its turn this cycle */
+    AgentPool* next_turn;           /* Scheduler's list of pools that did */
+
+    /* Statistics (batched turns of the sequential scheduler) */
+    uint64_t rounds;                /* Rounds run */
+    uint64_t handler_calls;         /* Batched handler invocations */
+    uint64_t signals;               /* Signals they covered */
+};
+
 /* =============================================================================
  * SCHEDULER STATE
  * ============================================================================= */
@@ -35,17 +309,115 @@ typedef struct {
     TidalPhase current_phase;       /* Current phase of tidal cycle */
     int running;                    /* 1 = running, 0 = shutdown */
     int empty_cycles;               /* Consecutive cycles with no signals */
-    int max_empty_cycles;           /* Shutdown after this many empty cycles */
+
+    /* Ready set: one bit per agent with queued signals, so cycles only
+     * visit agents that have work. A summary bit per non-zero word keeps
+     * the scan cost independent of idle agents. */
+    QueueWatcher ready_watcher;     /* Installed on every tracked agent queue */
+    uint64_t* ready_bits;           /* Bit i = agent i may have signals */
+    uint64_t* ready_summary;        /* Bit k = ready_bits[k] != 0 */
+    uint32_t ready_words;           /* Length of ready_bits[] */
+    uint32_t tracked_count;         /* Slots [0, tracked_count) were scanned */
+    uint32_t* empty_slots;          /* Scanned slots that had no agent yet */
+    uint32_t empty_slot_count;
+    uint32_t empty_slot_capacity;
+    uint64_t in_flight;             /* Signals in tracked queues, not yet dispatched */
+
+    /* Idle policy (see scheduler_idle.c) */
+    SchedIdleMode idle_mode;
+    uint32_t idle_spin_cycles;      /* Empty cycles spent spinning */
+    uint32_t idle_yield_cycles;     /* Then empty cycles spent yielding */
+    uint32_t wake_seq;              /* Futex word, bumped by inject/shutdown */
+    uint32_t parked;                /* 1 while the run loop sleeps */
+
+    /* External input inbox (ring, producers serialize on inbox_lock) */
+    SchedInboxSlot* inbox;
+    uint32_t inbox_lock;
+    uint32_t inbox_head;            /* Next slot the scheduler drains */
+    uint32_t inbox_tail;            /* Next slot a producer fills */
+    uint32_t open_inputs;           /* External producers still attached */
+
+    /* Scheduling classes (NULL = everyone best effort) */
+    SchedAgentClass* classes;       /* By agent slot */
+    uint32_t class_capacity;
+    struct DeadlineTurn* deadline_turns; /* Deadline agents, sorted per cycle */
+    uint32_t deadline_count;
+    uint32_t deadline_capacity;
+
+    /* Fair share and fairness metrics (NULL = count budgets, no metrics) */
+    struct FairShare* fair;
+    uint64_t fair_deferred;         /* Turns sat out in deficit */
+
+    /* Suspended coroutines by agent slot (NULL until the first spawn) */
+    AgentCoroutine** coroutines;
+    uint32_t coroutine_capacity;
+
+    /* Blocking-handler pool (NULL = blocking handlers run inline) */
+    struct OffloadPool* offload;
+
+    /* Timer wheels (NULL until the first timer of that kind) */
+    struct TimerWheel* cycle_timers;
+    struct TimerWheel* wall_timers;
+
+    /* Agent pools that had their turn this cycle (re-armed at its end) */
+    AgentPool* pool_turns;
+
+    /* Prefetch pipeline of the sequential sweep (see scheduler_run_cycle) */
+    uint32_t prefetch_distance;     /* Ready agents ahead (0 = off) */
+    uint32_t prefetch_head;         /* Ring index of the nearest entry */
+    uint32_t prefetch_count;        /* Entries queued */
+    uint32_t prefetch_ids[SCHED_PREFETCH_MAX];
+
+    /* Per-agent drain budget */
+    SchedBudgetMode budget_mode;    /* Fixed or adaptive */
+    uint32_t budget_min;            /* Adaptive lower bound */
+    uint32_t budget_max;            /* Fixed budget / adaptive upper bound */
 
     /* Statistics */
     uint64_t cycle_count;           /* Total tidal cycles executed */
     uint64_t total_signals_processed; /* Total signals dispatched */
-    uint64_t agents_active;         /* Agents that received signals */
+    uint64_t agents_active;         /* Agent turns that processed signals */
     uint64_t dispatch_errors;       /* Errors during dispatch */
+    uint64_t timers_fired;          /* Timer handler invocations */
+    uint64_t offloaded;             /* Handler calls run on the offload pool */
+    uint64_t offload_wall_ns;       /* Time those calls took, summed */
+    uint64_t offload_max_ns;        /* Slowest offloaded call */
+    uint64_t deadline_signals;      /* Signals dispatched by deadline agents */
+    uint64_t deadline_misses;       /* ... after their deadline */
+    uint64_t deadline_max_late_ns;  /* Worst lateness */
 
     /* Performance tracking */
     uint64_t start_timestamp;       /* RDTSC at scheduler start */
     uint64_t end_timestamp;         /* RDTSC at scheduler end */
+
+    /* Parallel execution (NULL = single-threaded) */
+    struct ParallelScheduler* parallel;
+    struct BspScheduler* bsp;       /* Deterministic bulk-synchronous mode */
+    uint32_t thread_count;          /* Worker threads (1 = sequential) */
+    uint64_t agent_runs;            /* Parallel: agent turns executed */
+    uint64_t steals;                /* Parallel: agents stolen by idle workers */
+
+    /* Agent placement (NULL = spread by ID, see scheduler_placement.c) */
+    uint32_t* placement;            /* Home worker per agent slot */
+    uint32_t placement_capacity;
+    int pin_workers;                /* Pin worker i to its own CPU */
+    uint64_t placement_min_signals; /* Auto re-plan threshold (0 = off) */
+    uint64_t placement_planned_at;  /* Routed signals when last planned */
+    uint64_t placement_traffic;     /* Signals in the last plan's graph */
+    uint64_t placement_cut;         /* ... of which cross workers */
+    uint64_t placement_plans;       /* Plans made */
+
+    /* Idle statistics */
+    uint64_t idle_spins;            /* Empty cycles followed by a pause */
+    uint64_t idle_yields;           /* Empty cycles followed by sched_yield */
+    uint64_t idle_parks;            /* Times the run loop slept */
+    uint64_t wakeups;               /* Injected signals that ended an idle period */
+    uint64_t wake_latency_total_ns; /* Inject -> drained, summed over wakeups */
+    uint64_t wake_latency_max_ns;
+    uint64_t idle_wall_ns;          /* Wall time spent idle */
+    uint64_t idle_cpu_ns;           /* Thread CPU time burned while idle */
+    uint64_t idle_start_wall_ns;    /* Current idle period (0 = not idle) */
+    uint64_t idle_start_cpu_ns;
 } Scheduler;
 
 /* =============================================================================
@@ -60,6 +432,28 @@ typedef struct {
     uint64_t memory_allocated;
     uint64_t total_time_ns;
     uint64_t throughput_sig_per_sec;
+    uint32_t threads;
+    uint64_t agent_runs;
+    uint64_t steals;
+    SchedIdleMode idle_mode;
+    uint64_t idle_parks;
+    uint64_t wakeups;
+    uint64_t wake_latency_avg_ns;
+    uint64_t wake_latency_max_ns;
+    uint64_t idle_wall_ns;
+    uint64_t idle_cpu_ns;
+    uint64_t timers_fired;
+    uint64_t placement_traffic;
+    uint64_t placement_cut;
+    uint64_t offloaded;
+    uint64_t offload_wall_ns;
+    uint64_t offload_max_ns;
+    uint64_t deadline_signals;
+    uint64_t deadline_misses;
+    uint64_t deadline_max_late_ns;
+    uint64_t fair_deferred;
+    uint64_t max_wait_ns;           /* Fairness metrics: worst wait of any agent */
+    uint32_t max_wait_agent;
 } SchedulerStats;
 
 /* =============================================================================
@@ -75,6 +469,46 @@ typedef struct {
  */
 Scheduler* scheduler_create(AgentRegistry* registry, RoutingTable* routing);
 
+/*
+ * Create a multi-threaded work-stealing scheduler
+ *
+ * scheduler_run() then executes agents on nthreads workers (the calling
+ * thread is worker 0). Runnable agents are tasks on per-worker deques and
+ * idle workers steal from busy ones. An agent runs on at most one worker
+ * at a time, so agent state needs no locks, and queues stay FIFO, so
+ * signals from one source arrive in send order.
+ *
+ * Handlers must only touch their own agent's state and send via
+ * emit_signal/routing_broadcast.
+ *
+ * @param registry: Agent registry (all agents in network)
+ * @param routing: Routing table (signal routing rules)
+ * @param nthreads: Worker count (0 = one per online CPU)
+ * @return: Pointer to scheduler, or NULL on failure
+ */
+Scheduler* scheduler_create_parallel(AgentRegistry* registry, RoutingTable* routing,
+                                     uint32_t nthreads);
+
+/*
+ * Create a deterministic bulk-synchronous parallel (BSP) scheduler
+ *
+ * scheduler_run() then executes tidal cycles on nthreads workers with one
+ * barrier per phase. Signals sent during ACT are delivered to next-cycle
+ * queues at the end of the cycle, in sender ID order, so every agent with
+ * input runs in parallel and results are identical for any thread count
+ * (including 1). Runs until no agent has input or until shutdown.
+ *
+ * Handlers must only touch their own agent's state and send via
+ * emit_signal/routing_broadcast.
+ *
+ * @param registry: Agent registry (all agents in network)
+ * @param routing: Routing table (signal routing rules)
+ * @param nthreads: Worker count (0 = one per online CPU)
+ * @return: Pointer to scheduler, or NULL on failure
+ */
+Scheduler* scheduler_create_bsp(AgentRegistry* registry, RoutingTable* routing,
+                                uint32_t nthreads);
+
 /*
  * Destroy scheduler and free resources
  *
@@ -82,10 +516,373 @@ Scheduler* scheduler_create(AgentRegistry* registry, RoutingTable* routing);
  */
 void scheduler_destroy(Scheduler* sched);
 
+/*
+ * Configure per-agent drain budget
+ *
+ * @param sched: Scheduler state
+ * @param mode: SCHED_BUDGET_FIXED or SCHED_BUDGET_ADAPTIVE
+ * @param budget_min: Minimum signals per agent per cycle (adaptive only)
+ * @param budget_max: Maximum signals per agent per cycle
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_budget(Scheduler* sched, SchedBudgetMode mode,
+                         uint32_t budget_min, uint32_t budget_max);
+
+/*
+ * Configure how far ahead the sequential sweep prefetches
+ *
+ * Applies once the network has SCHED_PREFETCH_MIN_AGENTS agent slots.
+ * Visit order and results are the same with any distance.
+ *
+ * @param sched: Scheduler state
+ * @param distance: Ready agents ahead of the current one (0 = off,
+ *                  clamped to SCHED_PREFETCH_MAX)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_prefetch(Scheduler* sched, uint32_t distance);
+
+/*
+ * Configure what scheduler_run does when there is no work
+ *
+ * With any mode but SCHED_IDLE_EXIT, scheduler_run waits for injected
+ * signals until scheduler_shutdown(). Applies to the sequential and BSP
+ * schedulers; the work-stealing scheduler always returns once quiescent.
+ *
+ * @param sched: Scheduler state
+ * @param mode: Idle mode
+ * @param spin_cycles: Empty cycles spent spinning before yielding
+ * @param yield_cycles: Empty cycles spent yielding before parking
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_idle_policy(Scheduler* sched, SchedIdleMode mode,
+                              uint32_t spin_cycles, uint32_t yield_cycles);
+
+/*
+ * Send a signal into the network from any thread
+ *
+ * The payload is copied; the signal reaches the agent's queue at the start
+ * of the next cycle. Wakes a parked scheduler.
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Destination agent
+ * @param frequency_id: Signal frequency
+ * @param source_agent_id: Sender reported to the handler
+ * @param payload: Payload bytes (may be NULL if payload_size is 0)
+ * @param payload_size: At most SCHED_INBOX_PAYLOAD_MAX bytes
+ * @return: 0 on success, SIGNAL_ERR_QUEUE_FULL if the inbox is full,
+ *          SIGNAL_ERR_PAYLOAD_TOO_LARGE, or SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_inject(Scheduler* sched, uint32_t agent_id, uint32_t frequency_id,
+                     uint32_t source_agent_id, const void* payload,
+                     uint32_t payload_size);
+
+/*
+ * Attach an external producer (any thread)
+ *
+ * While any input is open the network is not quiescent, so an exiting
+ * scheduler waits for it instead of returning between its signals.
+ *
+ * @param sched: Scheduler state
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_open_input(Scheduler* sched);
+
+/*
+ * Detach an external producer (any thread); wakes a waiting scheduler
+ *
+ * @param sched: Scheduler state
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_close_input(Scheduler* sched);
+
+/*
+ * Run blocking handlers on a pool of nthreads threads
+ *
+ * Call between runs. Replaces any existing pool (waiting for its handlers
+ * to finish); nthreads = 0 removes it. Only the sequential scheduler
+ * offloads: parallel workers already keep running around a blocked one.
+ *
+ * @param sched: Scheduler state
+ * @param nthreads: Pool threads (at most SCHED_OFFLOAD_MAX_THREADS)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_offload(Scheduler* sched, uint32_t nthreads);
+
+/*
+ * Set an agent's scheduling class
+ *
+ * Call between runs. Weights apply to every scheduler; the deadline pass
+ * is sequential only (parallel and BSP runs treat deadline agents as best
+ * effort).
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @param cls: SCHED_CLASS_*
+ * @param param: Weight (1..SCHED_WEIGHT_MAX) for SCHED_CLASS_WEIGHTED,
+ *               target latency in ns for SCHED_CLASS_DEADLINE
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_agent_class(Scheduler* sched, uint32_t agent_id, SchedClass cls,
+                              uint64_t param);
+
+/*
+ * Deadline misses of one agent
+ *
+ * A signal misses when the turn that dispatches it starts after its
+ * timestamp plus the agent's target latency.
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @return: Signals dispatched late (0 if not a deadline agent)
+ */
+uint64_t scheduler_deadline_misses(Scheduler* sched, uint32_t agent_id);
+
+/*
+ * Charge turns by measured handler time (deficit round robin)
+ *
+ * Each turn adds quantum_ns x the agent's weight (SCHED_CLASS_WEIGHTED,
+ * else 1) to its deficit; the turn drains signals until the handler time
+ * spent uses it up, and an agent in debt sits out turns. Turns on BSP
+ * schedulers are measured but never deferred (that would break replay),
+ * nor are deadline agents'. Call between runs.
+ *
+ * @param sched: Scheduler state
+ * @param quantum_ns: Handler time per turn and unit of weight (0 = back to
+ *                    count budgets; metrics stay on if enabled)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_fair_share(Scheduler* sched, uint64_t quantum_ns);
+
+/*
+ * Collect per-agent wait and run metrics (implied by fair share)
+ *
+ * @param sched: Scheduler state
+ * @param enable: Non-zero to collect
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_fairness_stats(Scheduler* sched, int enable);
+
+/*
+ * Fairness metrics of one agent
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @param stats: Filled in (zeros if metrics are off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_get_fairness(Scheduler* sched, uint32_t agent_id, SchedFairnessStats* stats);
+
+/*
+ * Start a coroutine for an agent
+ *
+ * The body runs at once, up to its first coroutine_await(); from then on
+ * the scheduler resumes it with each awaited signal the agent receives.
+ * Call between runs or from a handler (sequential scheduler).
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent whose state the body receives
+ * @param body: Coroutine body
+ * @param stack_size: Stack bytes (0 = SCHED_CORO_STACK_SIZE)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED,
+ *          SIGNAL_ERR_BUSY if the agent already has a coroutine
+ */
+int scheduler_spawn_coroutine(Scheduler* sched, uint32_t agent_id,
+                              coroutine_fn body, size_t stack_size);
+
+/*
+ * Suspend the calling coroutine until its agent receives a signal of the
+ * given frequency
+ *
+ * The signal is owned by the runtime and valid until the next await or
+ * until the body returns.
+ *
+ * @param coro: The calling coroutine
+ * @param frequency_id: Frequency to wait for
+ * @return: The signal, or NULL if the scheduler is being destroyed (the
+ *          body should return)
+ */
+Signal* coroutine_await(AgentCoroutine* coro, uint32_t frequency_id);
+
+/*
+ * Suspend until a signal of any of several frequencies arrives
+ *
+ * @param coro: The calling coroutine
+ * @param frequency_ids: Frequencies to wait for
+ * @param count: Number of frequencies (1..SCHED_CORO_MAX_AWAIT)
+ * @return: The signal, or NULL if cancelled or count is out of range
+ */
+Signal* coroutine_await_any(AgentCoroutine* coro, const uint32_t* frequency_ids,
+                            uint32_t count);
+
+/*
+ * Does the agent have a suspended coroutine?
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @return: Non-zero while its coroutine has not returned
+ */
+int scheduler_coroutine_active(Scheduler* sched, uint32_t agent_id);
+
+/*
+ * Run a handler at the start of a given cycle, optionally repeating
+ *
+ * Handles stay valid until cancelled, or until a one-shot timer fires.
+ * Pending cycle timers keep scheduler_run cycling.
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent whose state the handler receives
+ * @param cycle: First cycle to fire in (past cycles fire next cycle)
+ * @param period: Cycles between firings (0 = once)
+ * @param handler: Timer handler
+ * @return: Timer handle, or NULL on failure
+ */
+SchedTimer* scheduler_add_timer(Scheduler* sched, uint32_t agent_id, uint64_t cycle,
+                                uint64_t period, timer_handler_fn handler);
+
+/*
+ * Run a handler after a wall-clock delay, optionally repeating
+ *
+ * A parked scheduler wakes up for the deadline.
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent whose state the handler receives
+ * @param delay_ns: Nanoseconds from now (rounded up to the wall tick)
+ * @param period_ns: Nanoseconds between firings (0 = once)
+ * @param handler: Timer handler
+ * @return: Timer handle, or NULL on failure
+ */
+SchedTimer* scheduler_add_wall_timer(Scheduler* sched, uint32_t agent_id,
+                                     uint64_t delay_ns, uint64_t period_ns,
+                                     timer_handler_fn handler);
+
+/*
+ * Cancel a pending timer (also from inside a timer handler)
+ *
+ * @param sched: Scheduler state
+ * @param timer: Timer handle
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_cancel_timer(Scheduler* sched, SchedTimer* timer);
+
+/*
+ * Place agents on workers from the traffic seen so far
+ *
+ * Partitions the routing edge counters into thread_count groups that
+ * minimise cross-worker traffic with balanced load. Call between runs,
+ * after a run (or a warm-up) has produced traffic.
+ *
+ * @param sched: Scheduler state
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_plan_placement(Scheduler* sched);
+
+/*
+ * Save the traffic seen so far as a placement profile (text file)
+ *
+ * @param sched: Scheduler state
+ * @param path: File to write
+ * @return: 0 on success, SIGNAL_ERR_IO, SIGNAL_ERR_NULL_POINTER,
+ *          SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_save_placement(Scheduler* sched, const char* path);
+
+/*
+ * Place agents on workers from a saved profile (e.g. at startup)
+ *
+ * @param sched: Scheduler state
+ * @param path: File written by scheduler_save_placement
+ * @return: 0 on success, SIGNAL_ERR_IO, SIGNAL_ERR_NULL_POINTER,
+ *          SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_load_placement(Scheduler* sched, const char* path);
+
+/*
+ * Re-plan at the start of a parallel run once enough new traffic is seen
+ *
+ * @param sched: Scheduler state
+ * @param min_signals: Routed signals since the last plan (0 = off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_set_auto_placement(Scheduler* sched, uint64_t min_signals);
+
+/*
+ * Pin each worker thread to its own CPU while running
+ *
+ * @param sched: Scheduler state
+ * @param enable: Non-zero to pin
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_set_affinity(Scheduler* sched, int enable);
+
+/*
+ * Home worker of an agent
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @return: Worker index
+ */
+uint32_t scheduler_agent_worker(Scheduler* sched, uint32_t agent_id);
+
+/*
+ * Create a pool of count instances and register them as agents
+ *
+ * Create pools before the schedulers that run them, like any agent.
+ * Instances start with empty queues, no columns and no handlers.
+ *
+ * @param registry: Registry the instances are added to
+ * @param first_id: Agent ID of instance 0 (IDs up to first_id + count - 1
+ *                  must be free)
+ * @param count: Instances
+ * @param queue_capacity: Input queue capacity of each instance
+ * @param context: Passed to handlers as pool->context
+ * @return: Pool, or NULL on failure (IDs taken, allocation failed)
+ */
+AgentPool* agent_pool_create(AgentRegistry* registry, uint32_t first_id, uint32_t count,
+                             uint32_t queue_capacity, void* context);
+
+/*
+ * Unregister the instances and free the pool (after its schedulers)
+ *
+ * @param pool: Pool from agent_pool_create
+ * @param registry: Registry it was created in
+ */
+void agent_pool_destroy(AgentPool* pool, AgentRegistry* registry);
+
+/*
+ * Add a state column: one zeroed element of elem_size bytes per instance
+ *
+ * @param pool: Pool
+ * @param elem_size: Bytes per instance
+ * @return: Column index, or SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ *          (also when POOL_MAX_COLUMNS are in use)
+ */
+int agent_pool_add_column(AgentPool* pool, size_t elem_size);
+
+/*
+ * Base of a state column (POOL_COLUMN_ALIGN-aligned), indexed by instance
+ *
+ * @return: Column, or NULL if there is no such column
+ */
+void* agent_pool_column(AgentPool* pool, uint32_t column);
+
+/*
+ * Set the handler of a frequency (replaces an existing one)
+ *
+ * Signals with no handler are dropped and counted as dispatch errors.
+ * The sequential scheduler calls handlers in batches; parallel, BSP and
+ * fair-share turns call them with one instance at a time, so a handler
+ * must only write its own instances' elements.
+ *
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ *          (POOL_MAX_HANDLERS frequencies already handled)
+ */
+int agent_pool_register(AgentPool* pool, uint32_t frequency_id, pool_handler_fn handler);
+
 /*
  * Run one tidal cycle (REST → SENSE → ACT)
  *
- * Processes all queued signals for all agents.
+ * Due timers fire and injected signals are delivered first, then each
+ * agent drains up to its budget through its dispatch table.
  *
  * @param sched: Scheduler state
  * @return: Number of signals processed this cycle
@@ -95,9 +892,10 @@ int scheduler_run_cycle(Scheduler* sched);
 /*
  * Run scheduler until termination
  *
- * Runs cycles until one of:
- * - max_empty_cycles consecutive cycles with no signals
- * - sched->running set to 0
+ * Runs until sched->running is set to 0 or, with SCHED_IDLE_EXIT, until
+ * the network is quiescent: no signal queued or being handled, no pending
+ * timer, empty inbox and no open input. Detection is exact, so no empty
+ * sweeps are spent confirming it.
  *
  * @param sched: Scheduler state
  * @return: Total signals processed, or negative error code
@@ -116,7 +914,8 @@ int scheduler_run_cycles(Scheduler* sched, uint64_t max_cycles);
 /*
  * Shutdown scheduler gracefully
  *
- * Sets running = 0, causing scheduler_run() to exit.
+ * Sets running = 0, causing scheduler_run() to exit. Safe to call from
+ * another thread; wakes a parked scheduler.
  *
  * @param sched: Scheduler state
  */
@@ -157,4 +956,100 @@ void scheduler_get_stats(Scheduler* sched, SchedulerStats* stats);
  */
 void scheduler_print_stats(Scheduler* sched);
 
+/* =============================================================================
+ * INTERNAL (shared by scheduler.c and scheduler_parallel.c)
+ * ============================================================================= */
+
+/*
+ * Give one agent its turn: drain up to its budget through its dispatch table
+ *
+ * @return: Number of signals drained
+ */
+uint32_t scheduler_drain_agent(Scheduler* sched, Agent* agent,
+                               uint64_t* dispatch_errors);
+
+/*
+ * Grow per-agent state (ready set, fair-share table) to the registry's
+ * current capacity; call between cycles/runs, never while workers run
+ */
+void scheduler_sync_capacity(Scheduler* sched);
+
+/*
+ * Forget which agents are watched; the next cycle re-installs the ready
+ * watcher on every queue and rebuilds the ready set from queue depths
+ */
+void scheduler_reset_ready_set(Scheduler* sched);
+
+/* Idle-policy hooks for the run loop (scheduler_idle.c) */
+int scheduler_idle_init(Scheduler* sched);
+void scheduler_idle_destroy(Scheduler* sched);
+uint32_t scheduler_drain_inbox(Scheduler* sched);
+void scheduler_idle_wait(Scheduler* sched);
+void scheduler_idle_end(Scheduler* sched);
+void scheduler_wake(Scheduler* sched);
+
+/* Inbox not empty or inputs still open (any thread) */
+int scheduler_external_pending(Scheduler* sched);
+
+/* Timer hooks (scheduler_timer.c) */
+void scheduler_fire_timers(Scheduler* sched);
+uint32_t scheduler_cycle_timers_pending(Scheduler* sched);
+uint64_t scheduler_next_wall_deadline(Scheduler* sched);
+void scheduler_timers_destroy(Scheduler* sched);
+
+/* Take an agent out of / back into the ready set around an offloaded call */
+void scheduler_suspend_agent(Scheduler* sched, Agent* agent);
+void scheduler_resume_agent(Scheduler* sched, Agent* agent);
+
+/* Drain budget of an agent's next turn (depth > 0) */
+uint32_t scheduler_turn_budget(Scheduler* sched, Agent* agent, uint32_t depth);
+
+/* Drain a given number of an agent's signals (the ACT part of a turn) */
+uint32_t scheduler_drain_signals(Scheduler* sched, Agent* agent, uint32_t budget,
+                                 uint64_t* dispatch_errors);
+
+/* Timestamp (TSC) ticks per ns, measured on first use (scheduler_class.c) */
+double scheduler_tsc_per_ns(void);
+
+/* Fair-share hooks (scheduler_fair.c) */
+uint32_t scheduler_fair_turn(Scheduler* sched, Agent* agent, uint32_t depth,
+                             uint64_t* dispatch_errors);
+void scheduler_fair_summary(Scheduler* sched, uint64_t* max_wait_ns, uint32_t* max_wait_agent);
+void scheduler_fair_grow(Scheduler* sched);
+void scheduler_fair_destroy(Scheduler* sched);
+
+/* Class hooks (scheduler_class.c) */
+int scheduler_run_deadline_agents(Scheduler* sched);
+void scheduler_classes_destroy(Scheduler* sched);
+
+/* Coroutine hooks (scheduler_coro.c) */
+uint32_t scheduler_coroutine_drain(Scheduler* sched, Agent* agent, uint32_t budget,
+                                   uint64_t* dispatch_errors);
+void scheduler_coroutines_destroy(Scheduler* sched);
+
+/* Offload hooks (scheduler_offload.c) */
+uint32_t scheduler_offload_inline_count(Scheduler* sched, Agent* agent, uint32_t budget);
+int scheduler_offload_submit(Scheduler* sched, Agent* agent);
+uint32_t scheduler_offload_collect(Scheduler* sched);
+int scheduler_offload_pending(Scheduler* sched);
+void scheduler_offload_destroy(Scheduler* sched);
+
+/* Pool hooks (scheduler_pool.c): a batched turn over a whole pool, and
+ * the one-instance turn of every other path */
+uint32_t scheduler_pool_turn(Scheduler* sched, AgentPool* pool, uint64_t* dispatch_errors);
+uint32_t scheduler_pool_drain(Scheduler* sched, Agent* agent, uint32_t budget,
+                              uint64_t* dispatch_errors);
+
+/* Placement hooks (scheduler_placement.c) */
+void scheduler_placement_refresh(Scheduler* sched);
+int scheduler_pin_thread(Scheduler* sched, uint32_t index, uint64_t* saved);
+void scheduler_unpin_thread(const uint64_t* saved);
+void scheduler_placement_destroy(Scheduler* sched);
+
+/* Run/destroy the parallel part of a scheduler */
+int scheduler_parallel_run(Scheduler* sched);
+void scheduler_parallel_destroy(Scheduler* sched);
+int scheduler_bsp_run(Scheduler* sched);
+void scheduler_bsp_destroy(Scheduler* sched);
+
 #endif /* MYCELIAL_SCHEDULER_H */
@@ -0,0 +1,489 @@
+/*
+ * Mycelial Bulk-Synchronous (BSP) Scheduler
+ *
+ * Runs tidal cycles in parallel with results that do not depend on the
+ * number of threads or on timing.
+ *
+ * Design decisions:
+ * - Signals emitted during ACT go to the sender's outbox (deferred
+ *   delivery in routing.c), not to the destination queue. No agent sees a
+ *   signal in the cycle it was sent, so every agent with input at the
+ *   start of a cycle can run at once
+ * - One barrier per phase: REST (thread 0 builds the run list) → ACT
+ *   (agents in parallel) → DELIVER (outboxes to next-cycle queues)
+ * - DELIVER is partitioned by destination agent and replays outboxes in
+ *   sender ID order, so each queue receives the same signals in the same
+ *   order whatever the thread count: a 1-thread run is the reference
+ * - The run list comes from a bitmap set by the queue watcher and by
+ *   agents left with input after their budget; scanning it with ctz gives
+ *   ascending IDs for free
+ * - The runtime is in threaded mode during the run (heap and ref counts
+ *   are shared); queues are only touched by one thread per phase
+ * - At REST every signal sent so far sits in a queue, so an empty run
+ *   list with no timers, inbox signals or open inputs is exact quiescence
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+/* Agents claimed per grab from the shared run list during ACT */
+#define BSP_ACT_CHUNK           16
+
+/* Spins at a barrier before yielding the CPU */
+#define BSP_BARRIER_SPINS       64
+
+typedef struct BspWorker {
+    struct BspScheduler* bs;        /* Owning scheduler */
+    pthread_t thread;               /* Thread (worker 0 = caller) */
+    uint32_t index;                 /* Worker number / delivery partition */
+    uint32_t reserved;
+    uint64_t signals_processed;     /* Signals drained by this worker */
+    uint64_t dispatch_errors;       /* Failed/unhandled signals */
+    uint64_t agent_runs;            /* Agent turns executed */
+    uint8_t pad[16];                /* Pad to 64 bytes (no false sharing) */
+} BspWorker;
+
+typedef struct BspScheduler {
+    QueueWatcher watcher;           /* Must be first (notify casts back) */
+    Scheduler* sched;               /* Owning scheduler */
+    uint32_t thread_count;          /* Workers requested */
+    uint32_t participants;          /* Workers actually running this run */
+    uint32_t agent_capacity;        /* Length of per-agent arrays (grows between runs) */
+    uint32_t words;                 /* Length of next_bits[] */
+    uint64_t* next_bits;            /* Agents with input for the next cycle */
+    uint32_t* run_list;             /* This cycle's agents, ascending ID */
+    uint32_t run_count;
+    uint32_t act_next;              /* Next run_list index to claim (ACT) */
+    RouteOutbox* outboxes;          /* Per-agent deferred deliveries */
+    BspWorker* workers;             /* [thread_count] */
+    uint32_t barrier_count;         /* Arrivals at the current barrier */
+    uint32_t barrier_gen;           /* Bumped when a barrier opens */
+    int done;                       /* Set in REST: no work or shutdown */
+} BspScheduler;
+
+/* =============================================================================
+ * BARRIER & RUN SET
+ * ============================================================================= */
+
+/*
+ * Wait until all participants arrive (spin, then yield)
+ */
+static void bsp_barrier(BspScheduler* bs) {
+    uint32_t gen = __atomic_load_n(&bs->barrier_gen, __ATOMIC_ACQUIRE);
+
+    uint32_t parts = __atomic_load_n(&bs->participants, __ATOMIC_RELAXED);
+    if (__atomic_add_fetch(&bs->barrier_count, 1, __ATOMIC_ACQ_REL) == parts) {
+        __atomic_store_n(&bs->barrier_count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&bs->barrier_gen, gen + 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    uint32_t spins = 0;
+    while (__atomic_load_n(&bs->barrier_gen, __ATOMIC_ACQUIRE) == gen) {
+        if (++spins < BSP_BARRIER_SPINS) {
+            __builtin_ia32_pause();
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+static inline void bsp_mark_next(BspScheduler* bs, uint32_t agent_id) {
+    __atomic_fetch_or(&bs->next_bits[agent_id >> 6],
+                      (uint64_t)1 << (agent_id & 63), __ATOMIC_RELAXED);
+}
+
+/*
+ * QueueWatcher callback: agent_id has input for the next cycle
+ */
+static void bsp_notify(QueueWatcher* watcher, uint32_t agent_id) {
+    BspScheduler* bs = (BspScheduler*)watcher;
+    if (agent_id < bs->agent_capacity) {
+        bsp_mark_next(bs, agent_id);
+    }
+}
+
+/* =============================================================================
+ * PHASES
+ * ============================================================================= */
+
+/*
+ * REST (worker 0 only): recycle outboxes, take external input, build the
+ * ascending run list for the next cycle
+ */
+static void bsp_rest(BspScheduler* bs) {
+    Scheduler* sched = bs->sched;
+
+    /* Last cycle's outboxes were fully delivered */
+    for (uint32_t i = 0; i < bs->run_count; i++) {
+        bs->outboxes[bs->run_list[i]].count = 0;
+    }
+
+    uint32_t count;
+    for (;;) {
+        /* Timers fire before the run list is built, so what they send to
+         * other agents runs this cycle (deterministic: REST is single-threaded) */
+        scheduler_fire_timers(sched);
+        scheduler_drain_inbox(sched);
+
+        count = 0;
+        for (uint32_t k = 0; k < bs->words; k++) {
+            uint64_t bits = bs->next_bits[k];
+            bs->next_bits[k] = 0;
+            while (bits != 0) {
+                uint32_t bit = (uint32_t)__builtin_ctzll(bits);
+                bits &= bits - 1;
+                bs->run_list[count++] = k * 64 + bit;
+            }
+        }
+
+        if (count > 0 || scheduler_cycle_timers_pending(sched) > 0) {
+            sched->empty_cycles = 0;
+            bs->done = !__atomic_load_n(&sched->running, __ATOMIC_RELAXED);
+            break;
+        }
+
+        /* Every signal is delivered by now, so no runnable agent and no
+         * external source means quiescent */
+        bs->done = !__atomic_load_n(&sched->running, __ATOMIC_RELAXED) ||
+                   (sched->idle_mode == SCHED_IDLE_EXIT &&
+                    !scheduler_external_pending(sched) &&
+                    scheduler_next_wall_deadline(sched) == 0);
+        if (bs->done) {
+            break;
+        }
+
+        /* Waiting on inputs or wall timers; the others wait at the barrier */
+        if (sched->empty_cycles < INT_MAX) {
+            sched->empty_cycles++;
+        }
+        scheduler_idle_wait(sched);
+    }
+    scheduler_idle_end(sched);
+
+    bs->run_count = count;
+    bs->act_next = 0;
+    if (!bs->done) {
+        sched->cycle_count++;
+    }
+}
+
+/*
+ * ACT: run claimed agents; their sends are recorded in their outboxes
+ */
+static void bsp_act(BspWorker* worker) {
+    BspScheduler* bs = worker->bs;
+    Scheduler* sched = bs->sched;
+    AgentRegistry* registry = sched->registry;
+
+    for (;;) {
+        uint32_t start = __atomic_fetch_add(&bs->act_next, BSP_ACT_CHUNK, __ATOMIC_RELAXED);
+        if (start >= bs->run_count) {
+            break;
+        }
+        uint32_t end = start + BSP_ACT_CHUNK;
+        if (end > bs->run_count) {
+            end = bs->run_count;
+        }
+
+        for (uint32_t i = start; i < end; i++) {
+            uint32_t id = bs->run_list[i];
+            Agent* agent = registry->agents[id];
+            if (agent == NULL || agent->input_queue == NULL) {
+                continue;
+            }
+
+            routing_set_outbox(&bs->outboxes[id]);
+            uint32_t drained = scheduler_drain_agent(sched, agent, &worker->dispatch_errors);
+            routing_set_outbox(NULL);
+
+            worker->signals_processed += drained;
+            worker->agent_runs++;
+
+            /* Budget left input behind: run again next cycle */
+            if (!signal_queue_is_empty(agent->input_queue)) {
+                bsp_mark_next(bs, id);
+            }
+        }
+    }
+}
+
+/*
+ * DELIVER: replay outboxes in sender order, for this worker's destinations
+ */
+static void bsp_deliver(BspWorker* worker) {
+    BspScheduler* bs = worker->bs;
+    RoutingTable* routing = bs->sched->routing;
+    uint32_t parts = bs->participants;
+
+    for (uint32_t i = 0; i < bs->run_count; i++) {
+        RouteOutbox* outbox = &bs->outboxes[bs->run_list[i]];
+        for (uint32_t j = 0; j < outbox->count; j++) {
+            RouteDelivery* delivery = &outbox->items[j];
+            if (delivery->dest_agent_id % parts == worker->index) {
+                routing_deliver(routing, delivery);
+            }
+        }
+    }
+}
+
+/*
+ * Worker main loop: REST → ACT → DELIVER with a barrier after each phase
+ */
+static void* bsp_worker_main(void* arg) {
+    BspWorker* worker = (BspWorker*)arg;
+    BspScheduler* bs = worker->bs;
+
+    routing_set_thread_shard(worker->index);
+
+    /* Worker 0 is the caller's thread: give its mask back afterwards */
+    uint64_t saved_mask[SCHED_CPU_MASK_WORDS];
+    int pinned = scheduler_pin_thread(bs->sched, worker->index, saved_mask);
+
+    for (;;) {
+        if (worker->index == 0) {
+            bsp_rest(bs);
+        }
+        bsp_barrier(bs);
+        if (bs->done) {
+            break;
+        }
+
+        bsp_act(worker);
+        bsp_barrier(bs);
+
+        bsp_deliver(worker);
+        bsp_barrier(bs);
+    }
+
+    if (pinned && worker->index == 0) {
+        scheduler_unpin_thread(saved_mask);
+    }
+    routing_set_thread_shard(0);
+    return NULL;
+}
+
+/* =============================================================================
+ * CREATION & DESTRUCTION
+ * ============================================================================= */
+
+/*
+ * Create a deterministic bulk-synchronous parallel scheduler
+ *
+ * @param registry: Agent registry (all agents in network)
+ * @param routing: Routing table (signal routing rules)
+ * @param nthreads: Worker count (0 = one per online CPU)
+ * @return: Pointer to scheduler, or NULL on failure
+ */
+Scheduler* scheduler_create_bsp(AgentRegistry* registry, RoutingTable* routing,
+                                uint32_t nthreads) {
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (cpus > 0) ? (uint32_t)cpus : 1;
+    }
+
+    Scheduler* sched = scheduler_create(registry, routing);
+    if (sched == NULL) {
+        return NULL;
+    }
+
+    BspScheduler* bs = heap_allocate(sizeof(BspScheduler));
+    if (bs == NULL) {
+        scheduler_destroy(sched);
+        return NULL;
+    }
+    sched->bsp = bs;
+    sched->thread_count = nthreads;
+
+    bs->watcher.notify = bsp_notify;
+    bs->sched = sched;
+    bs->thread_count = nthreads;
+    bs->agent_capacity = (registry->capacity > 0) ? registry->capacity : 1;
+    bs->words = (bs->agent_capacity + 63) / 64;
+
+    bs->next_bits = heap_allocate(bs->words * sizeof(uint64_t));
+    bs->run_list = heap_allocate(bs->agent_capacity * sizeof(uint32_t));
+    bs->outboxes = heap_allocate(bs->agent_capacity * sizeof(RouteOutbox));
+    bs->workers = heap_allocate(nthreads * sizeof(BspWorker));
+    if (bs->next_bits == NULL || bs->run_list == NULL ||
+        bs->outboxes == NULL || bs->workers == NULL) {
+        scheduler_destroy(sched);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        bs->workers[i].bs = bs;
+        bs->workers[i].index = i;
+    }
+
+    /* One traffic-stats row per worker so edge counters never contend */
+    if (nthreads > 1) {
+        routing_set_stats_shards(routing, nthreads);
+    }
+
+    return sched;
+}
+
+/*
+ * Free the BSP part of a scheduler (called by scheduler_destroy)
+ *
+ * @param sched: Scheduler with sched->bsp set
+ */
+void scheduler_bsp_destroy(Scheduler* sched) {
+    BspScheduler* bs = sched->bsp;
+    if (bs == NULL) {
+        return;
+    }
+
+    if (bs->outboxes != NULL) {
+        for (uint32_t i = 0; i < bs->agent_capacity; i++) {
+            routing_outbox_free(&bs->outboxes[i]);
+        }
+        heap_free(bs->outboxes, bs->agent_capacity * sizeof(RouteOutbox));
+    }
+    heap_free(bs->next_bits, bs->words * sizeof(uint64_t));
+    heap_free(bs->run_list, bs->agent_capacity * sizeof(uint32_t));
+    heap_free(bs->workers, bs->thread_count * sizeof(BspWorker));
+
+    heap_free(bs, sizeof(BspScheduler));
+    sched->bsp = NULL;
+}
+
+/* =============================================================================
+ * EXECUTION
+ * ============================================================================= */
+
+/*
+ * Grow per-agent arrays to cover a registry that grew since creation
+ *
+ * Only between runs. Outboxes move over with their buffers; a failure
+ * leaves the scheduler unchanged.
+ *
+ * @return: SIGNAL_OK, or SIGNAL_ERR_ALLOC_FAILED
+ */
+static int bsp_grow(BspScheduler* bs, uint32_t capacity) {
+    if (capacity <= bs->agent_capacity) {
+        return SIGNAL_OK;
+    }
+
+    uint32_t words = (capacity + 63) / 64;
+    uint64_t* next_bits = heap_allocate(words * sizeof(uint64_t));
+    uint32_t* run_list = heap_allocate(capacity * sizeof(uint32_t));
+    RouteOutbox* outboxes = heap_allocate(capacity * sizeof(RouteOutbox));
+    if (next_bits == NULL || run_list == NULL || outboxes == NULL) {
+        heap_free(next_bits, words * sizeof(uint64_t));
+        heap_free(run_list, capacity * sizeof(uint32_t));
+        heap_free(outboxes, capacity * sizeof(RouteOutbox));
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    memcpy(outboxes, bs->outboxes, bs->agent_capacity * sizeof(RouteOutbox));
+    heap_free(bs->outboxes, bs->agent_capacity * sizeof(RouteOutbox));
+    heap_free(bs->next_bits, bs->words * sizeof(uint64_t));
+    heap_free(bs->run_list, bs->agent_capacity * sizeof(uint32_t));
+    bs->next_bits = next_bits;
+    bs->run_list = run_list;
+    bs->outboxes = outboxes;
+    bs->words = words;
+    bs->agent_capacity = capacity;
+    return SIGNAL_OK;
+}
+
+/*
+ * Run BSP cycles until no agent has input or the scheduler is shut down
+ *
+ * @param sched: Scheduler created by scheduler_create_bsp
+ * @return: Total signals processed, or negative error code
+ */
+int scheduler_bsp_run(Scheduler* sched) {
+    BspScheduler* bs = sched->bsp;
+    AgentRegistry* registry = sched->registry;
+
+    /* Agents registered since the last run may lie beyond our arrays */
+    if (bsp_grow(bs, registry->capacity) != SIGNAL_OK) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    scheduler_sync_capacity(sched);
+
+    uint32_t agent_count = registry->count;
+    if (agent_count > bs->agent_capacity) {
+        agent_count = bs->agent_capacity;
+    }
+
+    sched->start_timestamp = get_timestamp();
+
+    /* Outboxes record queue pointers: resolve them all up front */
+    routing_resolve_queues(sched->routing, registry);
+
+    /* Watch every agent's queue; agents with input run in the first cycle */
+    memset(bs->next_bits, 0, bs->words * sizeof(uint64_t));
+    bs->run_count = 0;
+    for (uint32_t id = 0; id < agent_count; id++) {
+        Agent* agent = registry->agents[id];
+        if (agent == NULL || agent->input_queue == NULL) {
+            continue;
+        }
+        agent->input_queue->owner_agent_id = id;
+        agent->input_queue->watcher = &bs->watcher;
+
+        if (!signal_queue_is_empty(agent->input_queue)) {
+            bsp_mark_next(bs, id);
+        }
+    }
+
+    runtime_set_threaded(1);
+
+    /* Workers 1..N-1 on new threads, worker 0 on this one. Worker 0 is
+     * always the last to reach the first barrier, so the head count can be
+     * settled after spawning (results do not depend on it) */
+    bs->barrier_count = 0;
+    bs->participants = bs->thread_count;
+    uint32_t started = 1;
+    for (uint32_t i = 1; i < bs->thread_count; i++) {
+        if (pthread_create(&bs->workers[i].thread, NULL,
+                           bsp_worker_main, &bs->workers[i]) != 0) {
+            break;
+        }
+        started++;
+    }
+    __atomic_store_n(&bs->participants, started, __ATOMIC_RELAXED);
+    bsp_worker_main(&bs->workers[0]);
+    for (uint32_t i = 1; i < started; i++) {
+        pthread_join(bs->workers[i].thread, NULL);
+    }
+
+    runtime_set_threaded(0);
+
+    /* Detach our watchers; a later sequential cycle re-installs the ready set's */
+    for (uint32_t id = 0; id < agent_count; id++) {
+        Agent* agent = registry->agents[id];
+        if (agent != NULL && agent->input_queue != NULL) {
+            agent->input_queue->watcher = NULL;
+        }
+    }
+    scheduler_reset_ready_set(sched);
+
+    /* Fold worker counters into the scheduler */
+    for (uint32_t i = 0; i < bs->thread_count; i++) {
+        BspWorker* worker = &bs->workers[i];
+        sched->total_signals_processed += worker->signals_processed;
+        sched->dispatch_errors += worker->dispatch_errors;
+        sched->agent_runs += worker->agent_runs;
+        sched->agents_active += worker->agent_runs;
+        worker->signals_processed = 0;
+        worker->dispatch_errors = 0;
+        worker->agent_runs = 0;
+    }
+
+    sched->end_timestamp = get_timestamp();
+    return (int)sched->total_signals_processed;
+}
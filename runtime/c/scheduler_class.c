@@ -0,0 +1,287 @@
+/*
+ * Mycelial Scheduling Classes
+ *
+ * Best-effort, weighted-share and deadline agents on the tidal scheduler.
+ *
+ * Design decisions:
+ * - Classes are per agent slot in a side table; a network without classes
+ *   never allocates it and pays one NULL test per turn
+ * - Weighted share scales the agent's drain budget (turns stay one per
+ *   cycle, so a heavy agent cannot starve the rest, it just gets more done
+ *   per turn). Applies to the sequential, parallel and BSP schedulers
+ * - Deadline agents run in a pass of their own at the start of ACT, sorted
+ *   by the deadline of their head signal (signal timestamp + target
+ *   latency); the ID-order sweep then skips them. One turn per cycle each,
+ *   so sorting once per cycle is exact EDF over the set. The list is
+ *   insertion-sorted in place: it is short and nearly sorted from the
+ *   previous cycle
+ * - Deadlines are compared in timestamp (TSC) ticks, so the pass reads
+ *   rdtsc once per agent and never converts per signal. The TSC rate is
+ *   measured against CLOCK_MONOTONIC once, when the first deadline is set
+ * - A signal misses if the turn that dispatches it starts after its
+ *   deadline; misses are counted per agent and in SchedulerStats
+ * - The deadline pass is sequential-only. Parallel and BSP runs treat
+ *   deadline agents as best effort
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <string.h>
+#include <time.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+/* One deadline agent's place in the per-cycle EDF order */
+typedef struct DeadlineTurn {
+    uint64_t deadline;              /* Head signal's deadline (UINT64_MAX = idle) */
+    uint32_t agent_id;
+    uint32_t reserved;
+} DeadlineTurn;
+
+/* Timestamp ticks per ns, measured once (0 = not yet) */
+static double g_tsc_per_ns;
+
+/*
+ * Measure the timestamp counter against CLOCK_MONOTONIC (~2 ms, once)
+ */
+double scheduler_tsc_per_ns(void) {
+    if (g_tsc_per_ns > 0.0) {
+        return g_tsc_per_ns;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t start_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    uint64_t start_tsc = get_timestamp();
+    uint64_t now_ns;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        now_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    } while (now_ns - start_ns < 2000000);
+
+    double rate = (double)(get_timestamp() - start_tsc) / (double)(now_ns - start_ns);
+    g_tsc_per_ns = (rate > 0.0) ? rate : 1.0;
+    return g_tsc_per_ns;
+}
+
+/* =============================================================================
+ * CONFIGURATION
+ * ============================================================================= */
+
+/*
+ * Make room for agent_id in the class table (new slots are best effort)
+ */
+static int class_reserve(Scheduler* sched, uint32_t agent_id) {
+    if (agent_id < sched->class_capacity) {
+        return SIGNAL_OK;
+    }
+
+    uint32_t capacity = sched->class_capacity ? sched->class_capacity : 16;
+    while (capacity <= agent_id) {
+        capacity *= 2;
+    }
+    SchedAgentClass* classes = heap_allocate(capacity * sizeof(SchedAgentClass));
+    if (classes == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    if (sched->classes != NULL) {
+        memcpy(classes, sched->classes, sched->class_capacity * sizeof(SchedAgentClass));
+        heap_free(sched->classes, sched->class_capacity * sizeof(SchedAgentClass));
+    }
+    for (uint32_t i = sched->class_capacity; i < capacity; i++) {
+        classes[i].weight = 1;
+    }
+    sched->classes = classes;
+    sched->class_capacity = capacity;
+    return SIGNAL_OK;
+}
+
+/*
+ * Add or remove an agent from the deadline list
+ */
+static int class_set_deadline_member(Scheduler* sched, uint32_t agent_id, int member) {
+    for (uint32_t i = 0; i < sched->deadline_count; i++) {
+        if (sched->deadline_turns[i].agent_id == agent_id) {
+            if (!member) {
+                sched->deadline_turns[i] = sched->deadline_turns[--sched->deadline_count];
+            }
+            return SIGNAL_OK;
+        }
+    }
+    if (!member) {
+        return SIGNAL_OK;
+    }
+
+    if (sched->deadline_count == sched->deadline_capacity) {
+        uint32_t capacity = sched->deadline_capacity ? sched->deadline_capacity * 2 : 8;
+        DeadlineTurn* turns = heap_allocate(capacity * sizeof(DeadlineTurn));
+        if (turns == NULL) {
+            return SIGNAL_ERR_ALLOC_FAILED;
+        }
+        if (sched->deadline_turns != NULL) {
+            memcpy(turns, sched->deadline_turns, sched->deadline_count * sizeof(DeadlineTurn));
+            heap_free(sched->deadline_turns, sched->deadline_capacity * sizeof(DeadlineTurn));
+        }
+        sched->deadline_turns = turns;
+        sched->deadline_capacity = capacity;
+    }
+    sched->deadline_turns[sched->deadline_count++] =
+        (DeadlineTurn){ .deadline = UINT64_MAX, .agent_id = agent_id };
+    return SIGNAL_OK;
+}
+
+/*
+ * Set an agent's scheduling class
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @param cls: SCHED_CLASS_*
+ * @param param: Weight (1..SCHED_WEIGHT_MAX) for SCHED_CLASS_WEIGHTED,
+ *               target latency in ns for SCHED_CLASS_DEADLINE
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_agent_class(Scheduler* sched, uint32_t agent_id, SchedClass cls,
+                              uint64_t param) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    Agent* agent = agent_registry_get(sched->registry, agent_id);
+    if (agent == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (class_reserve(sched, agent_id) != SIGNAL_OK ||
+        class_set_deadline_member(sched, agent_id, cls == SCHED_CLASS_DEADLINE) != SIGNAL_OK) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    SchedAgentClass* entry = &sched->classes[agent_id];
+    *entry = (SchedAgentClass){ .cls = cls, .weight = 1 };
+    agent->flags &= ~(uint32_t)AGENT_FLAG_DEADLINE;
+
+    switch (cls) {
+        case SCHED_CLASS_WEIGHTED:
+            entry->weight = (param < 1) ? 1 : (param > SCHED_WEIGHT_MAX) ? SCHED_WEIGHT_MAX
+                                                                       : (uint32_t)param;
+            break;
+        case SCHED_CLASS_DEADLINE:
+            entry->target_ns = param;
+            entry->target_tsc = (uint64_t)((double)param * scheduler_tsc_per_ns());
+            agent->flags |= AGENT_FLAG_DEADLINE;
+            break;
+        default:
+            entry->cls = SCHED_CLASS_BEST_EFFORT;
+            break;
+    }
+    return SIGNAL_OK;
+}
+
+/*
+ * Deadline misses of one agent
+ */
+uint64_t scheduler_deadline_misses(Scheduler* sched, uint32_t agent_id) {
+    if (sched == NULL || agent_id >= sched->class_capacity) {
+        return 0;
+    }
+    return sched->classes[agent_id].misses;
+}
+
+/*
+ * Free the class table and clear the deadline flag on agents that outlive
+ * the scheduler (called by scheduler_destroy)
+ */
+void scheduler_classes_destroy(Scheduler* sched) {
+    for (uint32_t i = 0; i < sched->deadline_count; i++) {
+        Agent* agent = agent_registry_get(sched->registry, sched->deadline_turns[i].agent_id);
+        if (agent != NULL) {
+            agent->flags &= ~(uint32_t)AGENT_FLAG_DEADLINE;
+        }
+    }
+    heap_free(sched->deadline_turns, sched->deadline_capacity * sizeof(DeadlineTurn));
+    heap_free(sched->classes, sched->class_capacity * sizeof(SchedAgentClass));
+    sched->deadline_turns = NULL;
+    sched->deadline_count = 0;
+    sched->deadline_capacity = 0;
+    sched->classes = NULL;
+    sched->class_capacity = 0;
+}
+
+/* =============================================================================
+ * EDF PASS
+ * ============================================================================= */
+
+/*
+ * Give every deadline agent with signals its turn, earliest deadline first
+ *
+ * @param sched: Scheduler state (sequential cycle, start of ACT)
+ * @return: Number of signals processed
+ */
+int scheduler_run_deadline_agents(Scheduler* sched) {
+    DeadlineTurn* turns = sched->deadline_turns;
+    uint32_t count = sched->deadline_count;
+
+    /* Deadline of each agent's head signal */
+    for (uint32_t i = 0; i < count; i++) {
+        Agent* agent = agent_registry_get(sched->registry, turns[i].agent_id);
+        turns[i].deadline = UINT64_MAX;
+        if (agent == NULL || agent->input_queue == NULL ||
+            signal_queue_is_empty(agent->input_queue) ||
+            (agent->flags & AGENT_FLAG_OFFLOADED)) {
+            continue;
+        }
+        SignalQueue* queue = agent->input_queue;
+        Signal* head = queue->buffer[queue->head & queue->mask];
+        turns[i].deadline = head->timestamp + sched->classes[turns[i].agent_id].target_tsc;
+    }
+
+    /* Insertion sort: short list, mostly in last cycle's order */
+    for (uint32_t i = 1; i < count; i++) {
+        DeadlineTurn turn = turns[i];
+        uint32_t j = i;
+        while (j > 0 && turns[j - 1].deadline > turn.deadline) {
+            turns[j] = turns[j - 1];
+            j--;
+        }
+        turns[j] = turn;
+    }
+
+    int processed = 0;
+    for (uint32_t i = 0; i < count && turns[i].deadline != UINT64_MAX; i++) {
+        Agent* agent = agent_registry_get(sched->registry, turns[i].agent_id);
+        SchedAgentClass* entry = &sched->classes[turns[i].agent_id];
+        SignalQueue* queue = agent->input_queue;
+
+        /* An earlier turn may have emptied or offloaded it */
+        uint32_t depth = signal_queue_count(queue);
+        if (depth == 0 || (agent->flags & AGENT_FLAG_OFFLOADED)) {
+            continue;
+        }
+
+        /* Misses among the signals this turn will take */
+        uint32_t budget = scheduler_turn_budget(sched, agent, depth);
+        uint64_t now = get_timestamp();
+        for (uint32_t k = 0; k < budget; k++) {
+            Signal* sig = queue->buffer[(queue->head + k) & queue->mask];
+            uint64_t deadline = sig->timestamp + entry->target_tsc;
+            if (now > deadline) {
+                entry->misses++;
+                sched->deadline_misses++;
+                uint64_t late_ns = (uint64_t)((double)(now - deadline) / scheduler_tsc_per_ns());
+                if (late_ns > sched->deadline_max_late_ns) {
+                    sched->deadline_max_late_ns = late_ns;
+                }
+            }
+        }
+
+        uint32_t drained = scheduler_drain_agent(sched, agent, &sched->dispatch_errors);
+        entry->signals += drained;
+        sched->deadline_signals += drained;
+        processed += (int)drained;
+        sched->total_signals_processed += drained;
+        sched->agents_active++;
+        sched->in_flight -= (drained < sched->in_flight) ? drained : sched->in_flight;
+    }
+
+    return processed;
+}
@@ -0,0 +1,353 @@
+/*
+ * Mycelial Fair-Share Scheduling
+ *
+ * Deficit round robin over measured handler time, and the per-agent wait
+ * and run metrics that show whether anyone is starving.
+ *
+ * Design decisions:
+ * - Turns stay one per agent per cycle in ID order; only their length
+ *   changes. Each turn adds quantum x weight to the agent's deficit and
+ *   drains while the deficit lasts, so an agent with slow handlers gets
+ *   the same time per cycle as one with fast handlers, not the same count
+ * - Handler time is read with rdtsc around chunks of signals, not each
+ *   signal: the chunk is sized from the agent's running average cost so it
+ *   just fits the remaining deficit (capped at SCHED_FAIR_CHUNK_MAX). An
+ *   expensive handler overshoots by at most one signal, and the overshoot
+ *   is carried as debt into the agent's next turns
+ * - An agent in debt sits out its turn (counted as deferred; the cycle
+ *   still counts as active so SCHED_IDLE_EXIT does not end the run). An
+ *   agent whose queue empties drops its credit, so idle agents cannot
+ *   hoard a burst; unused credit carried between turns is capped at one
+ *   quantum
+ * - Deadline agents are charged but never deferred (EDF decides their
+ *   turns), nor is anyone on a BSP scheduler, whose replay depends on
+ *   turns depending only on queue contents
+ * - Wait is measured from the later of the head signal's timestamp and
+ *   the end of the agent's previous turn to the start of its next one:
+ *   the time it had work and was not running. Metrics alone (no quantum)
+ *   cost two rdtsc per turn
+ * - Per-agent state is touched only by the turn that owns the agent, so
+ *   parallel workers need no locking; the deferred total is atomic
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <string.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+/* Per-agent accounting, in timestamp ticks */
+typedef struct FairAgent {
+    int64_t deficit;                /* Handler time still owed this agent */
+    uint64_t avg_cost;              /* Running average ticks per signal */
+    uint64_t last_turn_end;         /* 0 = never ran */
+    uint64_t run_tsc;
+    uint64_t wait_tsc;
+    uint64_t max_wait_tsc;
+    uint64_t turns;
+    uint64_t deferred;
+    uint64_t signals;
+} FairAgent;
+
+typedef struct FairShare {
+    uint64_t quantum_tsc;           /* 0 = metrics only */
+    int stats_on;                   /* Metrics requested on their own */
+    uint32_t capacity;              /* Agent slots covered */
+    FairAgent* agents;
+} FairShare;
+
+/* =============================================================================
+ * CONFIGURATION
+ * ============================================================================= */
+
+/*
+ * Create the fair-share state, sized to the registry
+ */
+static FairShare* fair_create(Scheduler* sched) {
+    if (sched->fair != NULL) {
+        return sched->fair;
+    }
+
+    FairShare* fair = heap_allocate(sizeof(FairShare));
+    if (fair == NULL) {
+        return NULL;
+    }
+    fair->capacity = sched->registry->capacity;
+    fair->agents = heap_allocate((size_t)fair->capacity * sizeof(FairAgent));
+    if (fair->agents == NULL && fair->capacity > 0) {
+        heap_free(fair, sizeof(FairShare));
+        return NULL;
+    }
+
+    /* Measure the TSC rate now, not from a worker mid-run */
+    scheduler_tsc_per_ns();
+    sched->fair = fair;
+    return fair;
+}
+
+/*
+ * Drop the state once neither fair share nor metrics want it
+ */
+static void fair_release_if_unused(Scheduler* sched) {
+    FairShare* fair = sched->fair;
+    if (fair != NULL && fair->quantum_tsc == 0 && !fair->stats_on) {
+        scheduler_fair_destroy(sched);
+    }
+}
+
+/*
+ * Charge turns by measured handler time
+ *
+ * @param sched: Scheduler state (between runs)
+ * @param quantum_ns: Handler time per turn and unit of weight (0 = off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_fair_share(Scheduler* sched, uint64_t quantum_ns) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (quantum_ns == 0) {
+        if (sched->fair != NULL) {
+            sched->fair->quantum_tsc = 0;
+            fair_release_if_unused(sched);
+        }
+        return SIGNAL_OK;
+    }
+
+    FairShare* fair = fair_create(sched);
+    if (fair == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    uint64_t quantum_tsc = (uint64_t)((double)quantum_ns * scheduler_tsc_per_ns());
+    fair->quantum_tsc = quantum_tsc ? quantum_tsc : 1;
+    return SIGNAL_OK;
+}
+
+/*
+ * Collect per-agent wait and run metrics
+ *
+ * @param sched: Scheduler state (between runs)
+ * @param enable: Non-zero to collect
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_fairness_stats(Scheduler* sched, int enable) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (!enable) {
+        if (sched->fair != NULL) {
+            sched->fair->stats_on = 0;
+            fair_release_if_unused(sched);
+        }
+        return SIGNAL_OK;
+    }
+
+    FairShare* fair = fair_create(sched);
+    if (fair == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    fair->stats_on = 1;
+    return SIGNAL_OK;
+}
+
+/*
+ * Fairness metrics of one agent
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @param stats: Filled in (zeros if metrics are off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_get_fairness(Scheduler* sched, uint32_t agent_id, SchedFairnessStats* stats) {
+    if (sched == NULL || stats == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    *stats = (SchedFairnessStats){ 0 };
+    FairShare* fair = sched->fair;
+    if (fair == NULL || agent_id >= fair->capacity) {
+        return SIGNAL_OK;
+    }
+
+    FairAgent* fa = &fair->agents[agent_id];
+    double tsc_per_ns = scheduler_tsc_per_ns();
+    stats->turns = fa->turns;
+    stats->deferred = fa->deferred;
+    stats->signals = fa->signals;
+    stats->run_ns = (uint64_t)((double)fa->run_tsc / tsc_per_ns);
+    stats->wait_ns = (uint64_t)((double)fa->wait_tsc / tsc_per_ns);
+    stats->runnable_ns = stats->run_ns + stats->wait_ns;
+    stats->max_wait_ns = (uint64_t)((double)fa->max_wait_tsc / tsc_per_ns);
+    return SIGNAL_OK;
+}
+
+/*
+ * Worst wait over all agents (for SchedulerStats)
+ */
+void scheduler_fair_summary(Scheduler* sched, uint64_t* max_wait_ns, uint32_t* max_wait_agent) {
+    *max_wait_ns = 0;
+    *max_wait_agent = 0;
+    FairShare* fair = sched->fair;
+    if (fair == NULL) {
+        return;
+    }
+
+    uint64_t worst = 0;
+    for (uint32_t i = 0; i < fair->capacity; i++) {
+        if (fair->agents[i].max_wait_tsc > worst) {
+            worst = fair->agents[i].max_wait_tsc;
+            *max_wait_agent = i;
+        }
+    }
+    *max_wait_ns = (uint64_t)((double)worst / scheduler_tsc_per_ns());
+}
+
+/*
+ * Extend the per-agent table to a grown registry (between runs)
+ *
+ * On allocation failure agents beyond the table keep running unaccounted,
+ * as scheduler_fair_turn does for any ID outside it.
+ */
+void scheduler_fair_grow(Scheduler* sched) {
+    FairShare* fair = sched->fair;
+    uint32_t capacity = sched->registry->capacity;
+    if (fair == NULL || capacity <= fair->capacity) {
+        return;
+    }
+
+    FairAgent* agents = heap_allocate((size_t)capacity * sizeof(FairAgent));
+    if (agents == NULL) {
+        return;
+    }
+    if (fair->agents != NULL) {
+        memcpy(agents, fair->agents, (size_t)fair->capacity * sizeof(FairAgent));
+        heap_free(fair->agents, (size_t)fair->capacity * sizeof(FairAgent));
+    }
+    fair->agents = agents;
+    fair->capacity = capacity;
+}
+
+/*
+ * Free the fair-share state (called by scheduler_destroy)
+ */
+void scheduler_fair_destroy(Scheduler* sched) {
+    FairShare* fair = sched->fair;
+    if (fair == NULL) {
+        return;
+    }
+    heap_free(fair->agents, (size_t)fair->capacity * sizeof(FairAgent));
+    heap_free(fair, sizeof(FairShare));
+    sched->fair = NULL;
+}
+
+/* =============================================================================
+ * TURNS
+ * ============================================================================= */
+
+/*
+ * Give one agent a timed turn
+ *
+ * @param sched: Scheduler with fair share or metrics on
+ * @param agent: Agent to run
+ * @param depth: Its queue depth (> 0)
+ * @param dispatch_errors: Incremented by failed/unhandled signals
+ * @return: Number of signals drained (0 if the turn was deferred)
+ */
+uint32_t scheduler_fair_turn(Scheduler* sched, Agent* agent, uint32_t depth,
+                             uint64_t* dispatch_errors) {
+    FairShare* fair = sched->fair;
+    if (agent->agent_id >= fair->capacity) {
+        /* Registered after fair share was set up: untracked */
+        return scheduler_drain_signals(sched, agent, scheduler_turn_budget(sched, agent, depth),
+                                       dispatch_errors);
+    }
+
+    FairAgent* fa = &fair->agents[agent->agent_id];
+    int may_defer = sched->bsp == NULL && !(agent->flags & AGENT_FLAG_DEADLINE);
+
+    /* Earn this turn's share; in debt, sit it out */
+    if (fair->quantum_tsc > 0) {
+        uint32_t weight = 1;
+        if (sched->classes != NULL && agent->agent_id < sched->class_capacity) {
+            weight = sched->classes[agent->agent_id].weight;
+        }
+        fa->deficit += (int64_t)(fair->quantum_tsc * weight);
+        if (fa->deficit <= 0 && may_defer) {
+            fa->deferred++;
+            __atomic_fetch_add(&sched->fair_deferred, 1, __ATOMIC_RELAXED);
+            return 0;
+        }
+    }
+
+    /* Waited since its head signal arrived or its last turn ended */
+    uint64_t start = get_timestamp();
+    SignalQueue* queue = agent->input_queue;
+    uint64_t wait_start = queue->buffer[queue->head & queue->mask]->timestamp;
+    if (wait_start < fa->last_turn_end) {
+        wait_start = fa->last_turn_end;
+    }
+    uint64_t wait = (start > wait_start) ? start - wait_start : 0;
+    fa->wait_tsc += wait;
+    if (wait > fa->max_wait_tsc) {
+        fa->max_wait_tsc = wait;
+    }
+
+    uint32_t drained = 0;
+    uint64_t now = start;
+    if (fair->quantum_tsc == 0) {
+        /* Metrics only: the usual count budget */
+        drained = scheduler_drain_signals(sched, agent, scheduler_turn_budget(sched, agent, depth),
+                                          dispatch_errors);
+        now = get_timestamp();
+    } else {
+        /* Chunks sized to the remaining deficit until it is spent. A deadline
+         * or BSP turn always takes at least one chunk */
+        uint32_t remaining = depth;
+        do {
+            uint32_t chunk = SCHED_FAIR_CHUNK_MAX;
+            if (fa->avg_cost > 0 && fa->deficit > 0 &&
+                (uint64_t)fa->deficit / fa->avg_cost < chunk) {
+                chunk = (uint32_t)((uint64_t)fa->deficit / fa->avg_cost);
+            }
+            if (chunk == 0 || fa->avg_cost == 0) {
+                chunk = 1;      /* Unknown or overshooting cost: one at a time */
+            }
+            if (chunk > remaining) {
+                chunk = remaining;
+            }
+
+            uint64_t chunk_start = now;
+            uint32_t n = scheduler_drain_signals(sched, agent, chunk, dispatch_errors);
+            now = get_timestamp();
+            if (n == 0) {
+                break;
+            }
+
+            uint64_t cost = now - chunk_start;
+            fa->deficit -= (int64_t)cost;
+            fa->avg_cost = fa->avg_cost ? (fa->avg_cost * 7 + cost / n) / 8 : cost / n;
+            if (fa->avg_cost == 0) {
+                fa->avg_cost = 1;
+            }
+            drained += n;
+            remaining -= n;
+        } while (remaining > 0 && fa->deficit > 0 && !(agent->flags & AGENT_FLAG_OFFLOADED));
+
+        /* Idle agents keep no credit; busy ones carry at most a quantum */
+        if (signal_queue_is_empty(queue)) {
+            if (fa->deficit > 0) {
+                fa->deficit = 0;
+            }
+        } else if (fa->deficit > (int64_t)fair->quantum_tsc) {
+            fa->deficit = (int64_t)fair->quantum_tsc;
+        }
+    }
+
+    fa->run_tsc += now - start;
+    fa->last_turn_end = now;
+    fa->turns++;
+    fa->signals += drained;
+    return drained;
+}
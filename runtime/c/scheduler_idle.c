@@ -0,0 +1,379 @@
+/*
+ * Mycelial Scheduler Idle Policy & External Input
+ *
+ * Decides what the sequential run loop does when a cycle finds no work,
+ * and lets other threads feed signals into a running network.
+ *
+ * Design decisions:
+ * - Escalating backoff: spin (pause) for idle_spin_cycles empty cycles,
+ *   then sched_yield for idle_yield_cycles, then park on a futex. Short
+ *   gaps stay cheap to resume from; long gaps cost no CPU
+ * - External producers never touch queues or the heap: scheduler_inject
+ *   copies the payload into a locked inbox ring and the scheduler thread
+ *   creates and enqueues the signal at the start of its next cycle
+ * - Parks are bounded by the next wall-clock timer deadline
+ * - Quiescence (SCHED_IDLE_EXIT) counts open inputs as well as the inbox:
+ *   a producer between two injects keeps the network alive, and closing
+ *   the last input wakes the scheduler so it can return
+ * - Lost-wakeup freedom: the sleeper publishes `parked` before reading
+ *   wake_seq, producers bump wake_seq before reading `parked`, and the
+ *   futex only sleeps if wake_seq is unchanged
+ * - Idle periods are timed with CLOCK_MONOTONIC and
+ *   CLOCK_THREAD_CPUTIME_ID (two clock reads per period), so each policy
+ *   reports its wake-up latency and the CPU it burns while waiting
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/* =============================================================================
+ * CLOCKS & FUTEX
+ * ============================================================================= */
+
+static inline uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Sleep while *word == expected (returns early on wake, signal or timeout)
+ *
+ * @param timeout_ns: Maximum sleep, 0 = no limit
+ */
+static void futex_wait(uint32_t* word, uint32_t expected, uint64_t timeout_ns) {
+#ifdef __linux__
+    struct timespec timeout = { .tv_sec = (time_t)(timeout_ns / 1000000000ULL),
+                                .tv_nsec = (long)(timeout_ns % 1000000000ULL) };
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected,
+            timeout_ns ? &timeout : NULL, NULL, 0);
+#else
+    (void)timeout_ns;
+    if (__atomic_load_n(word, __ATOMIC_ACQUIRE) == expected) {
+        usleep(50);
+    }
+#endif
+}
+
+static void futex_wake(uint32_t* word) {
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+/* =============================================================================
+ * SETUP
+ * ============================================================================= */
+
+/*
+ * Allocate the inbox and install the default policy (called by create)
+ *
+ * @param sched: Scheduler being created
+ * @return: 0 on success, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_idle_init(Scheduler* sched) {
+    sched->inbox = heap_allocate(SCHED_INBOX_CAPACITY * sizeof(SchedInboxSlot));
+    if (sched->inbox == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    sched->inbox_lock = 0;
+    sched->inbox_head = 0;
+    sched->inbox_tail = 0;
+
+    sched->idle_mode = SCHED_IDLE_EXIT;
+    sched->idle_spin_cycles = SCHED_DEFAULT_IDLE_SPIN;
+    sched->idle_yield_cycles = SCHED_DEFAULT_IDLE_YIELD;
+    sched->wake_seq = 0;
+    sched->parked = 0;
+    return SIGNAL_OK;
+}
+
+/*
+ * Free the inbox (signals still in it are discarded)
+ *
+ * @param sched: Scheduler being destroyed
+ */
+void scheduler_idle_destroy(Scheduler* sched) {
+    heap_free(sched->inbox, SCHED_INBOX_CAPACITY * sizeof(SchedInboxSlot));
+    sched->inbox = NULL;
+}
+
+/*
+ * Configure the idle policy
+ *
+ * @param sched: Scheduler state
+ * @param mode: Idle mode
+ * @param spin_cycles: Empty cycles spent spinning before yielding
+ * @param yield_cycles: Empty cycles spent yielding before parking
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER if sched is NULL
+ */
+int scheduler_set_idle_policy(Scheduler* sched, SchedIdleMode mode,
+                              uint32_t spin_cycles, uint32_t yield_cycles) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    sched->idle_mode = mode;
+    sched->idle_spin_cycles = spin_cycles;
+    sched->idle_yield_cycles = yield_cycles;
+    return SIGNAL_OK;
+}
+
+/* =============================================================================
+ * EXTERNAL INPUT
+ * ============================================================================= */
+
+/*
+ * Wake the run loop if it is parked
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_wake(Scheduler* sched) {
+    __atomic_add_fetch(&sched->wake_seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sched->parked, __ATOMIC_SEQ_CST)) {
+        futex_wake(&sched->wake_seq);
+    }
+}
+
+/*
+ * Send a signal into the network from any thread
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Destination agent
+ * @param frequency_id: Signal frequency
+ * @param source_agent_id: Sender reported to the handler
+ * @param payload: Payload bytes (may be NULL if payload_size is 0)
+ * @param payload_size: At most SCHED_INBOX_PAYLOAD_MAX bytes
+ * @return: 0 on success, or error code
+ */
+int scheduler_inject(Scheduler* sched, uint32_t agent_id, uint32_t frequency_id,
+                     uint32_t source_agent_id, const void* payload,
+                     uint32_t payload_size) {
+    if (sched == NULL || (payload == NULL && payload_size > 0)) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (payload_size > SCHED_INBOX_PAYLOAD_MAX) {
+        return SIGNAL_ERR_PAYLOAD_TOO_LARGE;
+    }
+
+    uint64_t now = clock_ns(CLOCK_MONOTONIC);
+
+    runtime_spin_lock(&sched->inbox_lock);
+
+    uint32_t tail = sched->inbox_tail;
+    uint32_t head = __atomic_load_n(&sched->inbox_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= SCHED_INBOX_CAPACITY) {
+        runtime_spin_unlock(&sched->inbox_lock);
+        return SIGNAL_ERR_QUEUE_FULL;
+    }
+
+    SchedInboxSlot* slot = &sched->inbox[tail & (SCHED_INBOX_CAPACITY - 1)];
+    slot->agent_id = agent_id;
+    slot->frequency_id = frequency_id;
+    slot->source_agent_id = source_agent_id;
+    slot->payload_size = payload_size;
+    slot->inject_ns = now;
+    if (payload_size > 0) {
+        memcpy(slot->payload, payload, payload_size);
+    }
+    __atomic_store_n(&sched->inbox_tail, tail + 1, __ATOMIC_RELEASE);
+
+    runtime_spin_unlock(&sched->inbox_lock);
+
+    scheduler_wake(sched);
+    return SIGNAL_OK;
+}
+
+/*
+ * Deliver injected signals to their agents' queues (scheduler thread only)
+ *
+ * Stops early if a destination queue is full; the rest stay in the inbox,
+ * in order, for the next cycle. Signals for unknown agents are dropped and
+ * counted as dispatch errors.
+ *
+ * @param sched: Scheduler state
+ * @return: Number of signals delivered
+ */
+uint32_t scheduler_drain_inbox(Scheduler* sched) {
+    uint32_t head = sched->inbox_head;
+    uint32_t tail = __atomic_load_n(&sched->inbox_tail, __ATOMIC_ACQUIRE);
+    uint32_t delivered = 0;
+
+    while (head != tail) {
+        SchedInboxSlot* slot = &sched->inbox[head & (SCHED_INBOX_CAPACITY - 1)];
+
+        Agent* agent = NULL;
+        if (slot->agent_id < sched->registry->count) {
+            agent = sched->registry->agents[slot->agent_id];
+        }
+        if (agent == NULL || agent->input_queue == NULL) {
+            sched->dispatch_errors++;
+            head++;
+            continue;
+        }
+
+        Signal* sig = signal_create(slot->frequency_id, slot->source_agent_id,
+                                    slot->payload, slot->payload_size);
+        if (sig == NULL) {
+            break;
+        }
+        if (signal_queue_enqueue(agent->input_queue, sig) != SIGNAL_OK) {
+            signal_free(sig);
+            break;
+        }
+        signal_free(sig);   /* Queue holds its own reference */
+
+        /* The oldest signal in an idle period is the one that woke us */
+        if (sched->idle_start_wall_ns != 0 && delivered == 0) {
+            uint64_t latency = clock_ns(CLOCK_MONOTONIC) - slot->inject_ns;
+            sched->wakeups++;
+            sched->wake_latency_total_ns += latency;
+            if (latency > sched->wake_latency_max_ns) {
+                sched->wake_latency_max_ns = latency;
+            }
+        }
+
+        delivered++;
+        head++;
+    }
+
+    __atomic_store_n(&sched->inbox_head, head, __ATOMIC_RELEASE);
+    return delivered;
+}
+
+static inline int inbox_pending(Scheduler* sched) {
+    return __atomic_load_n(&sched->inbox_tail, __ATOMIC_ACQUIRE) !=
+           __atomic_load_n(&sched->inbox_head, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Attach an external producer
+ *
+ * @param sched: Scheduler state
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_open_input(Scheduler* sched) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    __atomic_add_fetch(&sched->open_inputs, 1, __ATOMIC_SEQ_CST);
+    return SIGNAL_OK;
+}
+
+/*
+ * Detach an external producer and wake the scheduler to re-check quiescence
+ *
+ * @param sched: Scheduler state
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_close_input(Scheduler* sched) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    __atomic_sub_fetch(&sched->open_inputs, 1, __ATOMIC_SEQ_CST);
+    scheduler_wake(sched);
+    return SIGNAL_OK;
+}
+
+/*
+ * Can anything outside the network still produce a signal?
+ *
+ * Producers inject before closing their input, so reading open_inputs
+ * first means a signal injected by the last producer is always seen.
+ * Offloaded handlers hold an input open and publish their result first.
+ *
+ * @param sched: Scheduler state
+ * @return: Non-zero if the inbox has signals, an input is open or an
+ *          offloaded handler's result is waiting
+ */
+int scheduler_external_pending(Scheduler* sched) {
+    if (__atomic_load_n(&sched->open_inputs, __ATOMIC_SEQ_CST) != 0) {
+        return 1;
+    }
+    return inbox_pending(sched) || scheduler_offload_pending(sched);
+}
+
+/* =============================================================================
+ * IDLE WAITING
+ * ============================================================================= */
+
+/*
+ * Sleep until scheduler_inject or scheduler_shutdown bumps wake_seq, or
+ * until the next wall-clock timer is due
+ */
+static void scheduler_park(Scheduler* sched) {
+    uint64_t timeout = 0;
+    uint64_t deadline = scheduler_next_wall_deadline(sched);
+    if (deadline != 0) {
+        uint64_t now = clock_ns(CLOCK_MONOTONIC);
+        if (deadline <= now) {
+            return;
+        }
+        timeout = deadline - now;
+    }
+
+    __atomic_store_n(&sched->parked, 1, __ATOMIC_SEQ_CST);
+    uint32_t seq = __atomic_load_n(&sched->wake_seq, __ATOMIC_SEQ_CST);
+
+    if (!inbox_pending(sched) && !scheduler_offload_pending(sched) &&
+        __atomic_load_n(&sched->running, __ATOMIC_RELAXED) &&
+        (sched->idle_mode != SCHED_IDLE_EXIT ||
+         __atomic_load_n(&sched->open_inputs, __ATOMIC_SEQ_CST) != 0 || timeout != 0)) {
+        futex_wait(&sched->wake_seq, seq, timeout);
+        sched->idle_parks++;
+    }
+
+    __atomic_store_n(&sched->parked, 0, __ATOMIC_RELAXED);
+}
+
+/*
+ * Back off after an empty cycle according to the idle policy
+ *
+ * @param sched: Scheduler state (empty_cycles >= 1)
+ */
+void scheduler_idle_wait(Scheduler* sched) {
+    if (sched->idle_start_wall_ns == 0) {
+        sched->idle_start_wall_ns = clock_ns(CLOCK_MONOTONIC);
+        sched->idle_start_cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    }
+
+    uint64_t empty = (uint64_t)sched->empty_cycles;
+    uint64_t spin_limit = sched->idle_spin_cycles;
+    uint64_t yield_limit = spin_limit + sched->idle_yield_cycles;
+
+    if (sched->idle_mode == SCHED_IDLE_SPIN || empty <= spin_limit) {
+        __builtin_ia32_pause();
+        sched->idle_spins++;
+    } else if (sched->idle_mode == SCHED_IDLE_YIELD || empty <= yield_limit) {
+        sched_yield();
+        sched->idle_yields++;
+    } else {
+        scheduler_park(sched);
+    }
+}
+
+/*
+ * Close the current idle period (if any) and account its time
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_idle_end(Scheduler* sched) {
+    if (sched->idle_start_wall_ns == 0) {
+        return;
+    }
+
+    sched->idle_wall_ns += clock_ns(CLOCK_MONOTONIC) - sched->idle_start_wall_ns;
+    sched->idle_cpu_ns += clock_ns(CLOCK_THREAD_CPUTIME_ID) - sched->idle_start_cpu_ns;
+    sched->idle_start_wall_ns = 0;
+}
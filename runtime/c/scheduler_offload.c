@@ -0,0 +1,346 @@
+/*
+ * Mycelial Blocking-Handler Offload Pool
+ *
+ * Runs handlers marked as blocking (file reads/writes in the linker and
+ * main agents) on a small pool of threads, so a slow disk stalls one agent
+ * instead of the whole tidal loop.
+ *
+ * Design decisions:
+ * - Unit of work is one signal: the scheduler dequeues it, takes the agent
+ *   out of the ready set (scheduler_suspend_agent) and queues a job. Later
+ *   signals for that agent wait in its queue, so per-agent order and
+ *   exclusive access to agent state are kept; other agents run on
+ * - The handler sends through a per-job outbox (deferred delivery in
+ *   routing.c), never touching queues. The scheduler thread replays the
+ *   outbox at the start of the next cycle, in emission order, then
+ *   resumes the agent
+ * - Heap and ref counts are shared with the pool thread, so the runtime is
+ *   in threaded mode while any job is outstanding and back to the
+ *   lock-free paths as soon as the last result is collected. A job does
+ *   all its heap work before publishing its result
+ * - Each outstanding job holds an input open (scheduler_open_input), so
+ *   SCHED_IDLE_EXIT waits for it and a parked loop is woken by its result
+ * - The pool is bounded (nthreads); jobs beyond that queue FIFO. At most
+ *   one job per agent exists, so the job queue is bounded by the number
+ *   of agents with blocking handlers
+ * - Timers of a busy agent are held back a tick at a time until it is
+ *   resumed (scheduler_timer.c)
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include "dispatch.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+typedef struct OffloadJob {
+    struct OffloadJob* next;        /* Pending or done list */
+    Agent* agent;                   /* Busy until collected */
+    DispatchTable* dispatch;
+    Signal* signal;                 /* Holds the queue's reference */
+    RouteOutbox outbox;             /* Signals the handler emitted */
+    int result;                     /* DISPATCH_* */
+    uint64_t wall_ns;               /* Time in the handler */
+} OffloadJob;
+
+typedef struct OffloadPool {
+    Scheduler* sched;
+    pthread_t threads[SCHED_OFFLOAD_MAX_THREADS];
+    uint32_t thread_count;
+    uint32_t outstanding;           /* Submitted, not yet collected (scheduler thread) */
+    pthread_mutex_t lock;           /* Guards the lists and `stopping` */
+    pthread_cond_t work;            /* Signalled on submit and stop */
+    OffloadJob* pending_head;       /* Waiting for a thread, FIFO */
+    OffloadJob* pending_tail;
+    OffloadJob* done_head;          /* Finished, completion order */
+    OffloadJob* done_tail;
+    int stopping;
+} OffloadPool;
+
+static inline uint64_t offload_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* =============================================================================
+ * POOL THREADS
+ * ============================================================================= */
+
+static void* offload_thread_main(void* arg) {
+    OffloadPool* pool = (OffloadPool*)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->pending_head == NULL && !pool->stopping) {
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        OffloadJob* job = pool->pending_head;
+        if (job != NULL) {
+            pool->pending_head = job->next;
+            if (pool->pending_head == NULL) {
+                pool->pending_tail = NULL;
+            }
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        if (job == NULL) {
+            break;      /* Stopping and nothing left */
+        }
+
+        uint64_t start = offload_clock_ns();
+        routing_set_outbox(&job->outbox);
+        job->result = dispatch_invoke_for_agent(job->dispatch, job->agent->agent_id,
+                                                job->agent->state_ptr, job->signal);
+        routing_set_outbox(NULL);
+        signal_free(job->signal);
+        job->signal = NULL;
+        job->wall_ns = offload_clock_ns() - start;
+
+        /* Publish, then release the input: quiescence checks inputs first */
+        pthread_mutex_lock(&pool->lock);
+        job->next = NULL;
+        if (pool->done_tail != NULL) {
+            pool->done_tail->next = job;
+        } else {
+            __atomic_store_n(&pool->done_head, job, __ATOMIC_RELEASE);
+        }
+        pool->done_tail = job;
+        pthread_mutex_unlock(&pool->lock);
+
+        scheduler_close_input(pool->sched);
+    }
+
+    return NULL;
+}
+
+/*
+ * Stop and join the pool threads (queued jobs are run first)
+ */
+static void offload_stop(OffloadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->thread_count = 0;
+}
+
+/* =============================================================================
+ * CONFIGURATION
+ * ============================================================================= */
+
+/*
+ * Run blocking handlers on a pool of nthreads threads
+ *
+ * @param sched: Scheduler state (between runs)
+ * @param nthreads: Pool threads, 0 = run blocking handlers inline
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_set_offload(Scheduler* sched, uint32_t nthreads) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    scheduler_offload_destroy(sched);
+    if (nthreads == 0) {
+        return SIGNAL_OK;
+    }
+    if (nthreads > SCHED_OFFLOAD_MAX_THREADS) {
+        nthreads = SCHED_OFFLOAD_MAX_THREADS;
+    }
+
+    OffloadPool* pool = heap_allocate(sizeof(OffloadPool));
+    if (pool == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    pool->sched = sched;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, offload_thread_main, pool) != 0) {
+            break;
+        }
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        pthread_cond_destroy(&pool->work);
+        pthread_mutex_destroy(&pool->lock);
+        heap_free(pool, sizeof(OffloadPool));
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    sched->offload = pool;
+    return SIGNAL_OK;
+}
+
+/*
+ * Wait for offloaded handlers, deliver their results and free the pool
+ * (called by scheduler_destroy and scheduler_set_offload)
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_offload_destroy(Scheduler* sched) {
+    OffloadPool* pool = sched->offload;
+    if (pool == NULL) {
+        return;
+    }
+
+    offload_stop(pool);
+    scheduler_offload_collect(sched);
+
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    heap_free(pool, sizeof(OffloadPool));
+    sched->offload = NULL;
+}
+
+/* =============================================================================
+ * SCHEDULER HOOKS
+ * ============================================================================= */
+
+/*
+ * How many of an agent's next signals can run inline
+ *
+ * @param sched: Scheduler with an offload pool
+ * @param agent: Agent about to drain
+ * @param budget: Signals it may drain this turn
+ * @return: Leading signals (<= budget) whose handlers do not block; if
+ *          less than budget, the signal after them should be offloaded
+ */
+uint32_t scheduler_offload_inline_count(Scheduler* sched, Agent* agent, uint32_t budget) {
+    (void)sched;
+    if (agent->flags & AGENT_FLAG_BLOCKING) {
+        return 0;
+    }
+
+    DispatchTable* dispatch = (DispatchTable*)agent->dispatch_table;
+    if (dispatch->blocking_count == 0) {
+        return budget;
+    }
+
+    /* Only the scheduler thread consumes this queue: read it in place */
+    SignalQueue* queue = agent->input_queue;
+    for (uint32_t i = 0; i < budget; i++) {
+        Signal* sig = queue->buffer[(queue->head + i) & queue->mask];
+        DispatchEntry* entry = dispatch_lookup_entry(dispatch, sig->frequency_id);
+        if (entry != NULL && (entry->flags & DISPATCH_FLAG_BLOCKING)) {
+            return i;
+        }
+    }
+    return budget;
+}
+
+/*
+ * Hand the agent's next signal to the pool and mark the agent busy
+ *
+ * @param sched: Scheduler with an offload pool (scheduler thread)
+ * @param agent: Agent whose queue head is for a blocking handler
+ * @return: SIGNAL_OK, or SIGNAL_ERR_ALLOC_FAILED (signal left queued)
+ */
+int scheduler_offload_submit(Scheduler* sched, Agent* agent) {
+    OffloadPool* pool = sched->offload;
+
+    OffloadJob* job = heap_allocate(sizeof(OffloadJob));
+    if (job == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    job->agent = agent;
+    job->dispatch = (DispatchTable*)agent->dispatch_table;
+    job->signal = signal_queue_dequeue(agent->input_queue);
+    if (sched->in_flight > 0) {
+        sched->in_flight--;
+    }
+    scheduler_suspend_agent(sched, agent);
+
+    /* First job out: the pool now shares the heap and ref counts. Route
+     * queue pointers are cached lazily, so resolve them while we are alone */
+    if (pool->outstanding++ == 0) {
+        routing_resolve_queues(sched->routing, sched->registry);
+        runtime_set_threaded(1);
+    }
+    scheduler_open_input(sched);
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->pending_tail != NULL) {
+        pool->pending_tail->next = job;
+    } else {
+        pool->pending_head = job;
+    }
+    pool->pending_tail = job;
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+
+    return SIGNAL_OK;
+}
+
+/*
+ * Deliver finished handlers' signals and resume their agents (REST phase)
+ *
+ * @param sched: Scheduler state (scheduler thread)
+ * @return: Number of offloaded handler calls collected
+ */
+uint32_t scheduler_offload_collect(Scheduler* sched) {
+    OffloadPool* pool = sched->offload;
+    if (pool == NULL || __atomic_load_n(&pool->done_head, __ATOMIC_ACQUIRE) == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    OffloadJob* job = pool->done_head;
+    pool->done_head = NULL;
+    pool->done_tail = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    uint32_t collected = 0;
+    while (job != NULL) {
+        OffloadJob* next = job->next;
+
+        for (uint32_t i = 0; i < job->outbox.count; i++) {
+            routing_deliver(sched->routing, &job->outbox.items[i]);
+        }
+        job->outbox.count = 0;
+        routing_outbox_free(&job->outbox);
+
+        if (job->result != DISPATCH_OK) {
+            __atomic_fetch_add(&job->dispatch->error_count, 1, __ATOMIC_RELAXED);
+            sched->dispatch_errors++;
+        }
+        sched->total_signals_processed++;
+        sched->offloaded++;
+        sched->offload_wall_ns += job->wall_ns;
+        if (job->wall_ns > sched->offload_max_ns) {
+            sched->offload_max_ns = job->wall_ns;
+        }
+        job->agent->signal_count++;
+        scheduler_resume_agent(sched, job->agent);
+
+        heap_free(job, sizeof(OffloadJob));
+        collected++;
+        job = next;
+    }
+
+    /* Last result in: back to the single-threaded fast paths */
+    pool->outstanding -= collected;
+    if (pool->outstanding == 0) {
+        runtime_set_threaded(0);
+    }
+    return collected;
+}
+
+/*
+ * Is an offloaded handler's result waiting to be collected? (any thread)
+ */
+int scheduler_offload_pending(Scheduler* sched) {
+    OffloadPool* pool = sched->offload;
+    return pool != NULL && __atomic_load_n(&pool->done_head, __ATOMIC_ACQUIRE) != NULL;
+}
@@ -0,0 +1,583 @@
+/*
+ * Mycelial Work-Stealing Scheduler
+ *
+ * Runs agents on N worker threads. Each runnable agent is a task on one
+ * worker's deque; idle workers steal from the others.
+ *
+ * Design decisions:
+ * - Per-agent run state (IDLE/SCHEDULED/RUNNING/DIRTY) guarantees an agent
+ *   is queued at most once and runs on at most one worker at a time, so
+ *   agent state and the consumer side of its queue need no locks
+ * - Enqueue wakes the owner through the queue's QueueWatcher: IDLE agents
+ *   get scheduled, RUNNING agents are marked DIRTY and rescheduled by their
+ *   worker when the turn ends
+ * - Owners push/pop at the bottom (LIFO: the agent just fed runs next while
+ *   its input is cache-hot); thieves take the oldest task from the top
+ * - Agents that exhaust their drain budget go back on the top, so they
+ *   yield to every other runnable agent on that worker
+ * - Termination: `active` counts SCHEDULED + RUNNING agents. Only running
+ *   agents and external producers produce signals, so active == 0 with an
+ *   empty inbox and no open input means the network is quiescent. An
+ *   agent-level count is used instead of a per-signal one: it is raised in
+ *   the emitter's notify while the emitter is still RUNNING, so it cannot
+ *   read zero while a signal is between enqueue and notify
+ * - Worker 0 drains the external inbox when it runs out of work and every
+ *   WORKER_INBOX_INTERVAL turns, so the inbox keeps a single consumer
+ * - With a placement plan (scheduler_placement.c) a runnable agent goes to
+ *   its home worker's deque, wherever it was woken from, so agents that
+ *   talk a lot keep running on the same core; stealing still balances
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+/* Agent run states */
+#define AGENT_RUN_IDLE          0   /* Not queued, not running */
+#define AGENT_RUN_SCHEDULED     1   /* On some worker's deque */
+#define AGENT_RUN_RUNNING       2   /* Executing on a worker */
+#define AGENT_RUN_DIRTY         3   /* Running, and new signals arrived */
+
+/* Spins before an idle worker starts yielding the CPU */
+#define WORKER_IDLE_SPINS       64
+
+/* Agent turns between worker 0's inbox checks while busy */
+#define WORKER_INBOX_INTERVAL   64
+
+/*
+ * Per-worker deque of runnable agent IDs (ring buffer, spinlocked)
+ *
+ * Layout: 64 bytes (one cache line, so neighbouring deques never share)
+ */
+typedef struct WorkDeque {
+    uint32_t* slots;                /* 0x00: Agent IDs */
+    uint32_t lock;                  /* 0x08: Spinlock */
+    uint32_t mask;                  /* 0x0C: Capacity - 1 */
+    uint32_t top;                   /* 0x10: Steal end (oldest) */
+    uint32_t bottom;                /* 0x14: Owner end (newest) */
+    uint8_t pad[40];                /* 0x18: Pad to 64 bytes */
+} WorkDeque;
+
+typedef struct Worker {
+    struct ParallelScheduler* ps;   /* Owning scheduler */
+    pthread_t thread;               /* Thread (worker 0 = caller) */
+    uint32_t index;                 /* Worker number / deque index */
+    uint32_t rng;                   /* Victim selection state */
+    uint64_t signals_processed;     /* Signals drained by this worker */
+    uint64_t dispatch_errors;       /* Failed/unhandled signals */
+    uint64_t agent_runs;            /* Agent turns executed */
+    uint64_t steals;                /* Successful steals */
+} Worker;
+
+typedef struct ParallelScheduler {
+    QueueWatcher watcher;           /* Must be first (notify casts back) */
+    Scheduler* sched;               /* Owning scheduler */
+    uint32_t thread_count;          /* Workers */
+    uint32_t agent_capacity;        /* Length of run_state[] (grows between runs) */
+    uint32_t* run_state;            /* Per-agent AGENT_RUN_* */
+    WorkDeque* deques;              /* [thread_count] */
+    Worker* workers;                /* [thread_count] */
+    uint32_t active;                /* Agents SCHEDULED or RUNNING */
+    uint32_t deque_capacity;        /* Slots per deque */
+} ParallelScheduler;
+
+/* Worker running on this thread (NULL outside workers) */
+static _Thread_local Worker* t_worker = NULL;
+
+/* =============================================================================
+ * WORK DEQUES
+ *
+ * top/bottom change only under the lock but are peeked without it, so all
+ * writes to them are (relaxed) atomic stores.
+ * ============================================================================= */
+
+static void deque_push_bottom(WorkDeque* deque, uint32_t agent_id) {
+    runtime_spin_lock(&deque->lock);
+    deque->slots[deque->bottom & deque->mask] = agent_id;
+    __atomic_store_n(&deque->bottom, deque->bottom + 1, __ATOMIC_RELAXED);
+    runtime_spin_unlock(&deque->lock);
+}
+
+static void deque_push_top(WorkDeque* deque, uint32_t agent_id) {
+    runtime_spin_lock(&deque->lock);
+    uint32_t top = deque->top - 1;
+    deque->slots[top & deque->mask] = agent_id;
+    __atomic_store_n(&deque->top, top, __ATOMIC_RELAXED);
+    runtime_spin_unlock(&deque->lock);
+}
+
+static int deque_pop_bottom(WorkDeque* deque, uint32_t* agent_id) {
+    /* Cheap unlocked emptiness check first */
+    if (__atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) ==
+        __atomic_load_n(&deque->top, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+
+    int found = 0;
+    runtime_spin_lock(&deque->lock);
+    if (deque->bottom != deque->top) {
+        uint32_t bottom = deque->bottom - 1;
+        *agent_id = deque->slots[bottom & deque->mask];
+        __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+        found = 1;
+    }
+    runtime_spin_unlock(&deque->lock);
+    return found;
+}
+
+static int deque_pop_top(WorkDeque* deque, uint32_t* agent_id) {
+    if (__atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) ==
+        __atomic_load_n(&deque->top, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+
+    int found = 0;
+    runtime_spin_lock(&deque->lock);
+    if (deque->bottom != deque->top) {
+        *agent_id = deque->slots[deque->top & deque->mask];
+        __atomic_store_n(&deque->top, deque->top + 1, __ATOMIC_RELAXED);
+        found = 1;
+    }
+    runtime_spin_unlock(&deque->lock);
+    return found;
+}
+
+/* =============================================================================
+ * AGENT SCHEDULING
+ * ============================================================================= */
+
+/*
+ * Put a SCHEDULED agent on a deque
+ *
+ * Placed agents go to their home worker. Otherwise workers use their own
+ * deque and other threads spread agents by ID.
+ *
+ * @param yield: Non-zero to queue behind every other runnable agent
+ */
+static void parallel_push_agent(ParallelScheduler* ps, uint32_t agent_id, int yield) {
+    Scheduler* sched = ps->sched;
+    Worker* worker = t_worker;
+    uint32_t target;
+    if (sched->placement != NULL && agent_id < sched->placement_capacity) {
+        target = sched->placement[agent_id] % ps->thread_count;
+    } else if (worker != NULL && worker->ps == ps) {
+        target = worker->index;
+    } else {
+        target = agent_id % ps->thread_count;
+    }
+
+    if (yield) {
+        deque_push_top(&ps->deques[target], agent_id);
+    } else {
+        deque_push_bottom(&ps->deques[target], agent_id);
+    }
+}
+
+/*
+ * QueueWatcher callback: a signal was enqueued for agent_id
+ */
+static void parallel_notify(QueueWatcher* watcher, uint32_t agent_id) {
+    ParallelScheduler* ps = (ParallelScheduler*)watcher;
+    if (agent_id >= ps->agent_capacity) {
+        return;
+    }
+
+    /* Order the enqueue before reading the run state (pairs with the
+     * worker's exchange to RUNNING before it reads the queue) */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    uint32_t* state = &ps->run_state[agent_id];
+    uint32_t current = __atomic_load_n(state, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        if (current == AGENT_RUN_IDLE) {
+            if (__atomic_compare_exchange_n(state, &current, AGENT_RUN_SCHEDULED, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_add_fetch(&ps->active, 1, __ATOMIC_ACQ_REL);
+                parallel_push_agent(ps, agent_id, 0);
+                return;
+            }
+        } else if (current == AGENT_RUN_RUNNING) {
+            if (__atomic_compare_exchange_n(state, &current, AGENT_RUN_DIRTY, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                return;
+            }
+        } else {
+            /* Already SCHEDULED or DIRTY: the signal will be seen */
+            return;
+        }
+    }
+}
+
+/*
+ * Execute one agent turn on a worker
+ */
+static void parallel_run_agent(Worker* worker, uint32_t agent_id) {
+    ParallelScheduler* ps = worker->ps;
+    Scheduler* sched = ps->sched;
+    Agent* agent = sched->registry->agents[agent_id];
+    uint32_t* state = &ps->run_state[agent_id];
+
+    /* SCHEDULED -> RUNNING (full barrier before reading the queue) */
+    __atomic_exchange_n(state, AGENT_RUN_RUNNING, __ATOMIC_SEQ_CST);
+
+    worker->signals_processed += scheduler_drain_agent(sched, agent,
+                                                       &worker->dispatch_errors);
+    worker->agent_runs++;
+
+    if (!signal_queue_is_empty(agent->input_queue)) {
+        /* Budget exhausted: go behind the other runnable agents */
+        __atomic_store_n(state, AGENT_RUN_SCHEDULED, __ATOMIC_RELEASE);
+        parallel_push_agent(ps, agent_id, 1);
+        return;
+    }
+
+    uint32_t expected = AGENT_RUN_RUNNING;
+    if (__atomic_compare_exchange_n(state, &expected, AGENT_RUN_IDLE, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        __atomic_sub_fetch(&ps->active, 1, __ATOMIC_ACQ_REL);
+        return;
+    }
+
+    /* DIRTY: signals arrived after we checked the queue */
+    __atomic_store_n(state, AGENT_RUN_SCHEDULED, __ATOMIC_RELEASE);
+    parallel_push_agent(ps, agent_id, 0);
+}
+
+/*
+ * Try to steal the oldest runnable agent from another worker
+ *
+ * @return: 1 if an agent was stolen into *agent_id
+ */
+static int parallel_steal(Worker* worker, uint32_t* agent_id) {
+    ParallelScheduler* ps = worker->ps;
+    uint32_t n = ps->thread_count;
+    if (n < 2) {
+        return 0;
+    }
+
+    /* xorshift32: random starting victim spreads contention */
+    worker->rng ^= worker->rng << 13;
+    worker->rng ^= worker->rng >> 17;
+    worker->rng ^= worker->rng << 5;
+    uint32_t start = worker->rng % n;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t victim = (start + i) % n;
+        if (victim == worker->index) {
+            continue;
+        }
+        if (deque_pop_top(&ps->deques[victim], agent_id)) {
+            worker->steals++;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Worker main loop
+ */
+static void* parallel_worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    ParallelScheduler* ps = worker->ps;
+    WorkDeque* own = &ps->deques[worker->index];
+
+    t_worker = worker;
+    routing_set_thread_shard(worker->index);
+
+    /* Worker 0 is the caller's thread: give its mask back afterwards */
+    uint64_t saved_mask[SCHED_CPU_MASK_WORDS];
+    int pinned = scheduler_pin_thread(ps->sched, worker->index, saved_mask);
+
+    uint32_t idle_spins = 0;
+    uint32_t agent_id;
+
+    while (__atomic_load_n(&ps->sched->running, __ATOMIC_RELAXED)) {
+        if (deque_pop_bottom(own, &agent_id) || parallel_steal(worker, &agent_id)) {
+            parallel_run_agent(worker, agent_id);
+            idle_spins = 0;
+            if (worker->index == 0 && worker->agent_runs % WORKER_INBOX_INTERVAL == 0) {
+                scheduler_drain_inbox(ps->sched);
+            }
+            continue;
+        }
+
+        /* Nothing runnable anywhere we looked */
+        if (worker->index == 0 && scheduler_drain_inbox(ps->sched) > 0) {
+            continue;
+        }
+
+        /* Inputs first: a drain raises `active` before it empties the inbox */
+        if (!scheduler_external_pending(ps->sched) &&
+            __atomic_load_n(&ps->active, __ATOMIC_ACQUIRE) == 0) {
+            break;
+        }
+
+        if (++idle_spins < WORKER_IDLE_SPINS) {
+            __builtin_ia32_pause();
+        } else {
+            sched_yield();
+        }
+    }
+
+    if (pinned && worker->index == 0) {
+        scheduler_unpin_thread(saved_mask);
+    }
+    routing_set_thread_shard(0);
+    t_worker = NULL;
+    return NULL;
+}
+
+/* =============================================================================
+ * CREATION & DESTRUCTION
+ * ============================================================================= */
+
+/*
+ * Create a multi-threaded work-stealing scheduler
+ *
+ * @param registry: Agent registry (all agents in network)
+ * @param routing: Routing table (signal routing rules)
+ * @param nthreads: Worker count (0 = one per online CPU)
+ * @return: Pointer to scheduler, or NULL on failure
+ */
+Scheduler* scheduler_create_parallel(AgentRegistry* registry, RoutingTable* routing,
+                                     uint32_t nthreads) {
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (cpus > 0) ? (uint32_t)cpus : 1;
+    }
+
+    Scheduler* sched = scheduler_create(registry, routing);
+    if (sched == NULL) {
+        return NULL;
+    }
+
+    ParallelScheduler* ps = heap_allocate(sizeof(ParallelScheduler));
+    if (ps == NULL) {
+        scheduler_destroy(sched);
+        return NULL;
+    }
+    sched->parallel = ps;
+    sched->thread_count = nthreads;
+
+    ps->watcher.notify = parallel_notify;
+    ps->sched = sched;
+    ps->thread_count = nthreads;
+    ps->agent_capacity = (registry->capacity > 0) ? registry->capacity : 1;
+    ps->active = 0;
+
+    /* Every agent is on at most one deque, so capacity bounds each deque */
+    ps->deque_capacity = next_power_of_two(ps->agent_capacity);
+
+    ps->run_state = heap_allocate(ps->agent_capacity * sizeof(uint32_t));
+    ps->deques = heap_allocate(nthreads * sizeof(WorkDeque));
+    ps->workers = heap_allocate(nthreads * sizeof(Worker));
+    if (ps->run_state == NULL || ps->deques == NULL || ps->workers == NULL) {
+        scheduler_destroy(sched);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < nthreads; i++) {
+        ps->deques[i].slots = heap_allocate(ps->deque_capacity * sizeof(uint32_t));
+        if (ps->deques[i].slots == NULL) {
+            scheduler_destroy(sched);
+            return NULL;
+        }
+        ps->deques[i].mask = ps->deque_capacity - 1;
+
+        ps->workers[i].ps = ps;
+        ps->workers[i].index = i;
+        ps->workers[i].rng = 2463534242u + i * 2654435761u;
+    }
+
+    /* One traffic-stats row per worker so edge counters never contend */
+    if (nthreads > 1) {
+        routing_set_stats_shards(routing, nthreads);
+    }
+
+    return sched;
+}
+
+/*
+ * Free the parallel part of a scheduler (called by scheduler_destroy)
+ *
+ * @param sched: Scheduler with sched->parallel set
+ */
+void scheduler_parallel_destroy(Scheduler* sched) {
+    ParallelScheduler* ps = sched->parallel;
+    if (ps == NULL) {
+        return;
+    }
+
+    if (ps->deques != NULL) {
+        for (uint32_t i = 0; i < ps->thread_count; i++) {
+            if (ps->deques[i].slots != NULL) {
+                heap_free(ps->deques[i].slots, ps->deque_capacity * sizeof(uint32_t));
+            }
+        }
+        heap_free(ps->deques, ps->thread_count * sizeof(WorkDeque));
+    }
+    if (ps->workers != NULL) {
+        heap_free(ps->workers, ps->thread_count * sizeof(Worker));
+    }
+    if (ps->run_state != NULL) {
+        heap_free(ps->run_state, ps->agent_capacity * sizeof(uint32_t));
+    }
+
+    heap_free(ps, sizeof(ParallelScheduler));
+    sched->parallel = NULL;
+}
+
+/* =============================================================================
+ * EXECUTION
+ * ============================================================================= */
+
+/*
+ * Grow run states and deques to cover a registry that grew since creation
+ *
+ * Only between runs (deques empty). Everything is allocated before the
+ * old arrays are released, so a failure leaves the scheduler unchanged.
+ *
+ * @return: SIGNAL_OK, or SIGNAL_ERR_ALLOC_FAILED
+ */
+static int parallel_grow(ParallelScheduler* ps, uint32_t capacity) {
+    if (capacity <= ps->agent_capacity) {
+        return SIGNAL_OK;
+    }
+
+    uint32_t deque_capacity = next_power_of_two(capacity);
+    uint32_t* run_state = heap_allocate(capacity * sizeof(uint32_t));
+    uint32_t** slots = heap_allocate(ps->thread_count * sizeof(uint32_t*));
+    int ok = (run_state != NULL && slots != NULL);
+    for (uint32_t i = 0; ok && i < ps->thread_count; i++) {
+        slots[i] = heap_allocate(deque_capacity * sizeof(uint32_t));
+        ok = (slots[i] != NULL);
+    }
+    if (!ok) {
+        for (uint32_t i = 0; slots != NULL && i < ps->thread_count; i++) {
+            heap_free(slots[i], deque_capacity * sizeof(uint32_t));
+        }
+        heap_free(slots, ps->thread_count * sizeof(uint32_t*));
+        heap_free(run_state, capacity * sizeof(uint32_t));
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    for (uint32_t i = 0; i < ps->thread_count; i++) {
+        heap_free(ps->deques[i].slots, ps->deque_capacity * sizeof(uint32_t));
+        ps->deques[i].slots = slots[i];
+        ps->deques[i].mask = deque_capacity - 1;
+    }
+    heap_free(slots, ps->thread_count * sizeof(uint32_t*));
+    heap_free(ps->run_state, ps->agent_capacity * sizeof(uint32_t));
+    ps->run_state = run_state;
+    ps->agent_capacity = capacity;
+    ps->deque_capacity = deque_capacity;
+    return SIGNAL_OK;
+}
+
+/*
+ * Run the network on all workers until quiescent or shut down
+ *
+ * @param sched: Scheduler created by scheduler_create_parallel
+ * @return: Total signals processed, or negative error code
+ */
+int scheduler_parallel_run(Scheduler* sched) {
+    ParallelScheduler* ps = sched->parallel;
+    AgentRegistry* registry = sched->registry;
+
+    /* Agents registered since the last run may lie beyond our arrays */
+    if (parallel_grow(ps, registry->capacity) != SIGNAL_OK) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    scheduler_sync_capacity(sched);
+
+    uint32_t agent_count = registry->count;
+    if (agent_count > ps->agent_capacity) {
+        agent_count = ps->agent_capacity;
+    }
+
+    sched->start_timestamp = get_timestamp();
+
+    /* Reset run state and deques (a shutdown may have left tasks behind) */
+    memset(ps->run_state, 0, ps->agent_capacity * sizeof(uint32_t));
+    for (uint32_t i = 0; i < ps->thread_count; i++) {
+        ps->deques[i].top = 0;
+        ps->deques[i].bottom = 0;
+        ps->deques[i].lock = 0;
+    }
+    ps->active = 0;
+
+    /* Traffic from earlier runs may call for a new placement */
+    scheduler_placement_refresh(sched);
+
+    /* Signals injected before the run */
+    scheduler_drain_inbox(sched);
+
+    /* Watch every agent's queue; seed agents that already have work */
+    for (uint32_t id = 0; id < agent_count; id++) {
+        Agent* agent = registry->agents[id];
+        if (agent == NULL || agent->input_queue == NULL) {
+            continue;
+        }
+        agent->input_queue->owner_agent_id = id;
+        agent->input_queue->watcher = &ps->watcher;
+
+        if (!signal_queue_is_empty(agent->input_queue)) {
+            ps->run_state[id] = AGENT_RUN_SCHEDULED;
+            ps->active++;
+            deque_push_bottom(&ps->deques[scheduler_agent_worker(sched, id)], id);
+        }
+    }
+
+    runtime_set_threaded(1);
+
+    /* Workers 1..N-1 on new threads, worker 0 on this one */
+    uint32_t started = 1;
+    for (uint32_t i = 1; i < ps->thread_count; i++) {
+        if (pthread_create(&ps->workers[i].thread, NULL,
+                           parallel_worker_main, &ps->workers[i]) != 0) {
+            break;  /* Run with the workers we have; others get stolen from */
+        }
+        started++;
+    }
+    parallel_worker_main(&ps->workers[0]);
+    for (uint32_t i = 1; i < started; i++) {
+        pthread_join(ps->workers[i].thread, NULL);
+    }
+
+    runtime_set_threaded(0);
+
+    /* Detach our watchers; a later sequential cycle re-installs the ready set's */
+    for (uint32_t id = 0; id < agent_count; id++) {
+        Agent* agent = registry->agents[id];
+        if (agent != NULL && agent->input_queue != NULL) {
+            agent->input_queue->watcher = NULL;
+        }
+    }
+    scheduler_reset_ready_set(sched);
+
+    /* Fold worker counters into the scheduler */
+    for (uint32_t i = 0; i < ps->thread_count; i++) {
+        Worker* worker = &ps->workers[i];
+        sched->total_signals_processed += worker->signals_processed;
+        sched->dispatch_errors += worker->dispatch_errors;
+        sched->agent_runs += worker->agent_runs;
+        sched->agents_active += worker->agent_runs;
+        sched->steals += worker->steals;
+        worker->signals_processed = 0;
+        worker->dispatch_errors = 0;
+        worker->agent_runs = 0;
+        worker->steals = 0;
+    }
+
+    sched->end_timestamp = get_timestamp();
+    return (int)sched->total_signals_processed;
+}
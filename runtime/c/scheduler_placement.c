@@ -0,0 +1,695 @@
+/*
+ * Mycelial Agent Placement
+ *
+ * Assigns agents to worker threads so that agents which talk a lot share
+ * a worker, and pins workers to CPUs.
+ *
+ * Design decisions:
+ * - The traffic graph comes from the routing table's per-edge counters
+ *   (signals_delivered, which includes direct calls), or from a profile
+ *   saved by an earlier run. Edges are undirected for the cut; an agent's
+ *   load is 1 + the signals it received
+ * - Two-step partition: grow each worker's set from a seed by repeatedly
+ *   taking the frontier agent with the most traffic into the set, until it
+ *   holds its share of the load; then greedy refinement passes move single
+ *   agents to the worker they talk to most while that worker stays within
+ *   SCHED_PLACEMENT_IMBALANCE percent of an even share. Cheap enough to
+ *   re-run between runs, and good on the pipeline/cluster shapes networks
+ *   actually have
+ * - A placement is a hint: the work-stealing scheduler pushes a runnable
+ *   agent onto its home worker's deque, and idle workers still steal, so a
+ *   stale or unbalanced plan costs locality, never progress
+ * - Plans change only between runs (explicitly, or at run start once
+ *   enough new traffic has been seen), so workers read the table unlocked
+ * - Pinning uses sched_setaffinity on each worker thread: worker i takes
+ *   the i-th CPU of the affinity mask it inherited, so taskset/cgroup
+ *   limits are respected. The calling thread (worker 0) gets its original
+ *   mask back when the run ends
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* =============================================================================
+ * TRAFFIC GRAPH
+ * ============================================================================= */
+
+/* Observed traffic from one agent to another */
+typedef struct PlacementEdge {
+    uint32_t source;
+    uint32_t dest;
+    uint64_t signals;
+} PlacementEdge;
+
+/* Growable edge list */
+typedef struct PlacementEdges {
+    PlacementEdge* items;
+    uint32_t count;
+    uint32_t capacity;
+} PlacementEdges;
+
+/* Undirected adjacency (CSR) plus per-agent load */
+typedef struct PlacementGraph {
+    uint32_t n;                     /* Agent slots */
+    uint32_t arcs;                  /* 2 x edges kept */
+    uint32_t* offsets;              /* [n + 1] */
+    uint32_t* neighbors;            /* [arcs] */
+    uint64_t* weights;              /* [arcs] */
+    uint64_t* load;                 /* [n], 0 = no agent in slot */
+    uint64_t total_load;
+} PlacementGraph;
+
+static int edges_push(PlacementEdges* edges, uint32_t source, uint32_t dest,
+                      uint64_t signals) {
+    if (edges->count == edges->capacity) {
+        uint32_t capacity = edges->capacity ? edges->capacity * 2 : 64;
+        PlacementEdge* items = heap_allocate(capacity * sizeof(PlacementEdge));
+        if (items == NULL) {
+            return SIGNAL_ERR_ALLOC_FAILED;
+        }
+        if (edges->count > 0) {
+            memcpy(items, edges->items, edges->count * sizeof(PlacementEdge));
+        }
+        heap_free(edges->items, edges->capacity * sizeof(PlacementEdge));
+        edges->items = items;
+        edges->capacity = capacity;
+    }
+    edges->items[edges->count++] = (PlacementEdge){ source, dest, signals };
+    return SIGNAL_OK;
+}
+
+static void edges_free(PlacementEdges* edges) {
+    heap_free(edges->items, edges->capacity * sizeof(PlacementEdge));
+    edges->items = NULL;
+    edges->count = 0;
+    edges->capacity = 0;
+}
+
+/*
+ * Collect every routing edge that carried traffic
+ *
+ * @param total: Out: signals over all edges (self-sends included)
+ */
+static int edges_from_routing(RoutingTable* routing, PlacementEdges* edges,
+                              uint64_t* total) {
+    *total = 0;
+    for (uint32_t i = 0; i < routing->capacity; i++) {
+        RoutingEntry* entry = &routing->entries[i];
+        if (entry->source_agent_id == 0) {
+            continue;
+        }
+        for (uint32_t d = 0; d < entry->dest_count; d++) {
+            RouteEdgeStats stats;
+            routing_entry_edge_stats(routing, entry, d, &stats);
+            if (stats.signals_delivered == 0) {
+                continue;
+            }
+            *total += stats.signals_delivered;
+            if (edges != NULL &&
+                edges_push(edges, entry->source_agent_id, entry->dest_agent_ids[d],
+                           stats.signals_delivered) != SIGNAL_OK) {
+                return SIGNAL_ERR_ALLOC_FAILED;
+            }
+        }
+    }
+    return SIGNAL_OK;
+}
+
+static void graph_free(PlacementGraph* graph) {
+    heap_free(graph->offsets, (graph->n + 1) * sizeof(uint32_t));
+    heap_free(graph->neighbors, graph->arcs * sizeof(uint32_t));
+    heap_free(graph->weights, graph->arcs * sizeof(uint64_t));
+    heap_free(graph->load, graph->n * sizeof(uint64_t));
+}
+
+/*
+ * Build the undirected traffic graph over registry slots [0, n)
+ *
+ * Self-sends and edges to slots outside the registry are dropped: they
+ * never cross workers.
+ */
+static int graph_build(PlacementGraph* graph, AgentRegistry* registry, uint32_t n,
+                       const PlacementEdges* edges) {
+    memset(graph, 0, sizeof(PlacementGraph));
+    graph->n = n;
+
+    graph->offsets = heap_allocate((n + 1) * sizeof(uint32_t));
+    graph->load = heap_allocate(n * sizeof(uint64_t));
+    if (graph->offsets == NULL || graph->load == NULL) {
+        graph_free(graph);
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    for (uint32_t v = 0; v < n && v < registry->capacity; v++) {
+        if (registry->agents[v] != NULL) {
+            graph->load[v] = 1;
+        }
+    }
+
+    /* Degrees, then prefix sums */
+    for (uint32_t e = 0; e < edges->count; e++) {
+        const PlacementEdge* edge = &edges->items[e];
+        if (edge->source >= n || edge->dest >= n || edge->source == edge->dest ||
+            graph->load[edge->source] == 0 || graph->load[edge->dest] == 0) {
+            continue;
+        }
+        graph->offsets[edge->source + 1]++;
+        graph->offsets[edge->dest + 1]++;
+        graph->arcs += 2;
+    }
+    for (uint32_t v = 0; v < n; v++) {
+        graph->offsets[v + 1] += graph->offsets[v];
+    }
+
+    graph->neighbors = heap_allocate((graph->arcs ? graph->arcs : 1) * sizeof(uint32_t));
+    graph->weights = heap_allocate((graph->arcs ? graph->arcs : 1) * sizeof(uint64_t));
+    uint32_t* fill = heap_allocate(n * sizeof(uint32_t));
+    if (graph->neighbors == NULL || graph->weights == NULL || fill == NULL) {
+        heap_free(fill, n * sizeof(uint32_t));
+        graph->arcs = graph->arcs ? graph->arcs : 1;
+        graph_free(graph);
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    memcpy(fill, graph->offsets, n * sizeof(uint32_t));
+
+    for (uint32_t e = 0; e < edges->count; e++) {
+        const PlacementEdge* edge = &edges->items[e];
+        if (edge->source >= n || edge->dest >= n || edge->source == edge->dest ||
+            graph->load[edge->source] == 0 || graph->load[edge->dest] == 0) {
+            continue;
+        }
+        uint32_t a = fill[edge->source]++;
+        graph->neighbors[a] = edge->dest;
+        graph->weights[a] = edge->signals;
+        uint32_t b = fill[edge->dest]++;
+        graph->neighbors[b] = edge->source;
+        graph->weights[b] = edge->signals;
+
+        graph->load[edge->dest] += edge->signals;
+    }
+    heap_free(fill, n * sizeof(uint32_t));
+
+    /* Keep the real size for graph_free */
+    if (graph->arcs == 0) {
+        graph->arcs = 1;
+    }
+
+    for (uint32_t v = 0; v < n; v++) {
+        graph->total_load += graph->load[v];
+    }
+    return SIGNAL_OK;
+}
+
+/* =============================================================================
+ * PARTITIONING
+ * ============================================================================= */
+
+#define PLACEMENT_UNASSIGNED    UINT32_MAX
+
+/*
+ * Grow parts one at a time from the lowest unassigned agent, always
+ * adding the frontier agent most connected to the part
+ *
+ * @param assign: Out: part per agent slot (PLACEMENT_UNASSIGNED for empty slots)
+ * @param part_load: Out: load per part
+ */
+static int partition_grow(const PlacementGraph* graph, uint32_t parts, uint64_t target,
+                          uint32_t* assign, uint64_t* part_load) {
+    uint32_t n = graph->n;
+    uint64_t* conn = heap_allocate(n * sizeof(uint64_t));
+    uint32_t* frontier = heap_allocate(n * sizeof(uint32_t));
+    if (conn == NULL || frontier == NULL) {
+        heap_free(conn, n * sizeof(uint64_t));
+        heap_free(frontier, n * sizeof(uint32_t));
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    for (uint32_t v = 0; v < n; v++) {
+        assign[v] = PLACEMENT_UNASSIGNED;
+    }
+
+    uint32_t cursor = 0;            /* Lowest slot that may be unassigned */
+    for (uint32_t p = 0; p < parts; p++) {
+        uint32_t frontier_count = 0;
+        part_load[p] = 0;
+
+        for (;;) {
+            /* Last part takes everything left */
+            if (p + 1 < parts && part_load[p] >= target) {
+                break;
+            }
+
+            /* Best-connected frontier agent (drop ones assigned meanwhile) */
+            uint32_t pick = PLACEMENT_UNASSIGNED;
+            uint32_t pick_index = 0;
+            for (uint32_t i = 0; i < frontier_count; i++) {
+                uint32_t v = frontier[i];
+                if (assign[v] != PLACEMENT_UNASSIGNED) {
+                    frontier[i--] = frontier[--frontier_count];
+                    continue;
+                }
+                if (pick == PLACEMENT_UNASSIGNED || conn[v] > conn[pick]) {
+                    pick = v;
+                    pick_index = i;
+                }
+            }
+            if (pick != PLACEMENT_UNASSIGNED) {
+                frontier[pick_index] = frontier[--frontier_count];
+            } else {
+                /* Disconnected from the part so far: start a new seed */
+                while (cursor < n && (graph->load[cursor] == 0 ||
+                                      assign[cursor] != PLACEMENT_UNASSIGNED)) {
+                    cursor++;
+                }
+                if (cursor == n) {
+                    break;
+                }
+                pick = cursor;
+            }
+
+            /* An agent that overshoots the share badly waits for a later part */
+            if (p + 1 < parts && part_load[p] > 0 &&
+                part_load[p] + graph->load[pick] > target + target / 2) {
+                conn[pick] = 0;
+                break;
+            }
+
+            assign[pick] = p;
+            part_load[p] += graph->load[pick];
+            conn[pick] = 0;
+            for (uint32_t a = graph->offsets[pick]; a < graph->offsets[pick + 1]; a++) {
+                uint32_t u = graph->neighbors[a];
+                if (assign[u] != PLACEMENT_UNASSIGNED) {
+                    continue;
+                }
+                if (conn[u] == 0) {
+                    frontier[frontier_count++] = u;
+                }
+                conn[u] += graph->weights[a];
+            }
+        }
+
+        for (uint32_t i = 0; i < frontier_count; i++) {
+            conn[frontier[i]] = 0;
+        }
+    }
+
+    heap_free(conn, n * sizeof(uint64_t));
+    heap_free(frontier, n * sizeof(uint32_t));
+    return SIGNAL_OK;
+}
+
+/*
+ * Move single agents to the part they exchange the most traffic with,
+ * while that part stays under max_load
+ *
+ * @return: SIGNAL_OK, or SIGNAL_ERR_ALLOC_FAILED
+ */
+static int partition_refine(const PlacementGraph* graph, uint32_t parts, uint64_t max_load,
+                            uint32_t* assign, uint64_t* part_load) {
+    uint64_t* conn = heap_allocate(parts * sizeof(uint64_t));
+    if (conn == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    for (uint32_t pass = 0; pass < SCHED_PLACEMENT_PASSES; pass++) {
+        uint32_t moved = 0;
+
+        for (uint32_t v = 0; v < graph->n; v++) {
+            if (graph->load[v] == 0 || graph->offsets[v] == graph->offsets[v + 1]) {
+                continue;
+            }
+
+            memset(conn, 0, parts * sizeof(uint64_t));
+            for (uint32_t a = graph->offsets[v]; a < graph->offsets[v + 1]; a++) {
+                conn[assign[graph->neighbors[a]]] += graph->weights[a];
+            }
+
+            uint32_t from = assign[v];
+            uint32_t best = from;
+            for (uint32_t q = 0; q < parts; q++) {
+                if (conn[q] > conn[best] &&
+                    part_load[q] + graph->load[v] <= max_load) {
+                    best = q;
+                }
+            }
+            if (best != from) {
+                assign[v] = best;
+                part_load[from] -= graph->load[v];
+                part_load[best] += graph->load[v];
+                moved++;
+            }
+        }
+
+        if (moved == 0) {
+            break;
+        }
+    }
+
+    heap_free(conn, parts * sizeof(uint64_t));
+    return SIGNAL_OK;
+}
+
+/*
+ * Partition the traffic graph into sched->thread_count workers and
+ * install it as the scheduler's placement
+ */
+static int placement_plan_edges(Scheduler* sched, const PlacementEdges* edges) {
+    AgentRegistry* registry = sched->registry;
+    uint32_t n = (registry->capacity > 0) ? registry->capacity : 1;
+    uint32_t parts = (sched->thread_count > 0) ? sched->thread_count : 1;
+
+    PlacementGraph graph;
+    int result = graph_build(&graph, registry, n, edges);
+    if (result != SIGNAL_OK) {
+        return result;
+    }
+
+    uint32_t* assign = heap_allocate(n * sizeof(uint32_t));
+    uint64_t* part_load = heap_allocate(parts * sizeof(uint64_t));
+    if (assign == NULL || part_load == NULL) {
+        result = SIGNAL_ERR_ALLOC_FAILED;
+        goto done;
+    }
+
+    uint64_t target = (graph.total_load + parts - 1) / parts;
+    uint64_t max_load = target + target * SCHED_PLACEMENT_IMBALANCE / 100;
+
+    result = partition_grow(&graph, parts, target, assign, part_load);
+    if (result == SIGNAL_OK) {
+        result = partition_refine(&graph, parts, max_load, assign, part_load);
+    }
+    if (result != SIGNAL_OK) {
+        goto done;
+    }
+
+    if (sched->placement == NULL) {
+        sched->placement = heap_allocate(n * sizeof(uint32_t));
+        if (sched->placement == NULL) {
+            result = SIGNAL_ERR_ALLOC_FAILED;
+            goto done;
+        }
+        sched->placement_capacity = n;
+    }
+
+    /* Empty slots keep the ID spread, in case an agent is added later */
+    for (uint32_t v = 0; v < n; v++) {
+        sched->placement[v] = (assign[v] != PLACEMENT_UNASSIGNED) ? assign[v] : v % parts;
+    }
+
+    sched->placement_traffic = 0;
+    sched->placement_cut = 0;
+    for (uint32_t e = 0; e < edges->count; e++) {
+        const PlacementEdge* edge = &edges->items[e];
+        sched->placement_traffic += edge->signals;
+        if (edge->source < n && edge->dest < n &&
+            sched->placement[edge->source] != sched->placement[edge->dest]) {
+            sched->placement_cut += edge->signals;
+        }
+    }
+    sched->placement_plans++;
+
+done:
+    heap_free(assign, n * sizeof(uint32_t));
+    heap_free(part_load, parts * sizeof(uint64_t));
+    graph_free(&graph);
+    return result;
+}
+
+/* =============================================================================
+ * PLACEMENT API
+ * ============================================================================= */
+
+/*
+ * Place agents on workers from the traffic seen so far
+ *
+ * @param sched: Scheduler state (between runs)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_plan_placement(Scheduler* sched) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    PlacementEdges edges = { 0 };
+    uint64_t total;
+    int result = edges_from_routing(sched->routing, &edges, &total);
+    if (result == SIGNAL_OK) {
+        result = placement_plan_edges(sched, &edges);
+    }
+    if (result == SIGNAL_OK) {
+        sched->placement_planned_at = total;
+    }
+    edges_free(&edges);
+    return result;
+}
+
+/*
+ * Write the traffic seen so far as a profile for scheduler_load_placement
+ *
+ * One "source dest signals" line per routing edge that carried traffic.
+ *
+ * @param sched: Scheduler state
+ * @param path: File to (over)write
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_IO,
+ *          SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_save_placement(Scheduler* sched, const char* path) {
+    if (sched == NULL || path == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    PlacementEdges edges = { 0 };
+    uint64_t total;
+    int result = edges_from_routing(sched->routing, &edges, &total);
+    if (result != SIGNAL_OK) {
+        edges_free(&edges);
+        return result;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        edges_free(&edges);
+        return SIGNAL_ERR_IO;
+    }
+    fprintf(file, "%s\n", SCHED_PLACEMENT_PROFILE_HEADER);
+    for (uint32_t e = 0; e < edges.count; e++) {
+        fprintf(file, "%u %u %lu\n", edges.items[e].source, edges.items[e].dest,
+                edges.items[e].signals);
+    }
+    if (fclose(file) != 0) {
+        result = SIGNAL_ERR_IO;
+    }
+
+    edges_free(&edges);
+    return result;
+}
+
+/*
+ * Place agents on workers from a saved traffic profile
+ *
+ * @param sched: Scheduler state (between runs)
+ * @param path: Profile written by scheduler_save_placement
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER, SIGNAL_ERR_IO (missing
+ *          or malformed file), SIGNAL_ERR_ALLOC_FAILED
+ */
+int scheduler_load_placement(Scheduler* sched, const char* path) {
+    if (sched == NULL || path == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return SIGNAL_ERR_IO;
+    }
+
+    PlacementEdges edges = { 0 };
+    int result = SIGNAL_OK;
+    char line[128];
+
+    if (fgets(line, sizeof(line), file) == NULL ||
+        strncmp(line, SCHED_PLACEMENT_PROFILE_HEADER,
+                strlen(SCHED_PLACEMENT_PROFILE_HEADER)) != 0) {
+        result = SIGNAL_ERR_IO;
+    }
+    while (result == SIGNAL_OK && fgets(line, sizeof(line), file) != NULL) {
+        uint32_t source, dest;
+        unsigned long signals;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "%u %u %lu", &source, &dest, &signals) != 3) {
+            result = SIGNAL_ERR_IO;
+            break;
+        }
+        result = edges_push(&edges, source, dest, signals);
+    }
+    fclose(file);
+
+    if (result == SIGNAL_OK) {
+        result = placement_plan_edges(sched, &edges);
+    }
+    edges_free(&edges);
+    return result;
+}
+
+/*
+ * Re-plan automatically at the start of each parallel run
+ *
+ * @param sched: Scheduler state
+ * @param min_signals: New routed signals since the last plan that trigger
+ *                     a re-plan (0 = off)
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_set_auto_placement(Scheduler* sched, uint64_t min_signals) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    sched->placement_min_signals = min_signals;
+    return SIGNAL_OK;
+}
+
+/*
+ * Pin each worker thread to its own CPU during runs
+ *
+ * @param sched: Scheduler state
+ * @param enable: Non-zero to pin
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_set_affinity(Scheduler* sched, int enable) {
+    if (sched == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    sched->pin_workers = enable ? 1 : 0;
+    return SIGNAL_OK;
+}
+
+/*
+ * Worker an agent is placed on
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent slot
+ * @return: Home worker index (agent_id % threads without a plan)
+ */
+uint32_t scheduler_agent_worker(Scheduler* sched, uint32_t agent_id) {
+    if (sched == NULL) {
+        return 0;
+    }
+    uint32_t threads = (sched->thread_count > 0) ? sched->thread_count : 1;
+    if (sched->placement != NULL && agent_id < sched->placement_capacity) {
+        return sched->placement[agent_id] % threads;
+    }
+    return agent_id % threads;
+}
+
+/* =============================================================================
+ * RUN HOOKS
+ * ============================================================================= */
+
+/*
+ * Re-plan if auto placement is on and enough traffic is new (run start)
+ */
+void scheduler_placement_refresh(Scheduler* sched) {
+    if (sched->placement_min_signals == 0 || sched->thread_count < 2) {
+        return;
+    }
+
+    uint64_t total;
+    edges_from_routing(sched->routing, NULL, &total);
+    if (total < sched->placement_planned_at) {
+        /* Stats were reset: count from zero */
+        sched->placement_planned_at = 0;
+    }
+    if (total - sched->placement_planned_at >= sched->placement_min_signals) {
+        scheduler_plan_placement(sched);
+    }
+}
+
+/*
+ * Pin the calling thread to worker `index`'s CPU, if pinning is on
+ *
+ * @param saved: Out: the thread's previous mask (SCHED_CPU_MASK_WORDS words)
+ * @return: 1 if the thread was pinned (restore with scheduler_unpin_thread)
+ */
+int scheduler_pin_thread(Scheduler* sched, uint32_t index, uint64_t* saved) {
+#ifdef __linux__
+    if (!sched->pin_workers) {
+        return 0;
+    }
+
+    uint64_t mask[SCHED_CPU_MASK_WORDS];
+    memset(mask, 0, sizeof(mask));
+    long bytes = syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask);
+    if (bytes <= 0) {
+        return 0;
+    }
+
+    uint32_t allowed = 0;
+    for (uint32_t w = 0; w < SCHED_CPU_MASK_WORDS; w++) {
+        allowed += (uint32_t)__builtin_popcountll(mask[w]);
+    }
+    if (allowed == 0) {
+        return 0;
+    }
+
+    /* The (index % allowed)-th CPU we may run on */
+    uint32_t skip = index % allowed;
+    uint32_t cpu = 0;
+    for (uint32_t w = 0; w < SCHED_CPU_MASK_WORDS; w++) {
+        uint32_t ones = (uint32_t)__builtin_popcountll(mask[w]);
+        if (skip >= ones) {
+            skip -= ones;
+            continue;
+        }
+        uint64_t bits = mask[w];
+        while (skip-- > 0) {
+            bits &= bits - 1;
+        }
+        cpu = w * 64 + (uint32_t)__builtin_ctzll(bits);
+        break;
+    }
+
+    uint64_t pinned[SCHED_CPU_MASK_WORDS];
+    memset(pinned, 0, sizeof(pinned));
+    pinned[cpu / 64] = (uint64_t)1 << (cpu % 64);
+    if (syscall(SYS_sched_setaffinity, 0, sizeof(pinned), pinned) != 0) {
+        return 0;
+    }
+    if (saved != NULL) {
+        memcpy(saved, mask, sizeof(mask));
+    }
+    return 1;
+#else
+    (void)sched;
+    (void)index;
+    (void)saved;
+    return 0;
+#endif
+}
+
+/*
+ * Give the calling thread back the mask saved by scheduler_pin_thread
+ */
+void scheduler_unpin_thread(const uint64_t* saved) {
+#ifdef __linux__
+    syscall(SYS_sched_setaffinity, 0, SCHED_CPU_MASK_WORDS * sizeof(uint64_t), saved);
+#else
+    (void)saved;
+#endif
+}
+
+/*
+ * Free the placement table (called by scheduler_destroy)
+ */
+void scheduler_placement_destroy(Scheduler* sched) {
+    heap_free(sched->placement, sched->placement_capacity * sizeof(uint32_t));
+    sched->placement = NULL;
+    sched->placement_capacity = 0;
+}
@@ -0,0 +1,385 @@
+/*
+ * Mycelial Agent Pools
+ *
+ * Identical agents run as one pool: structure-of-arrays instance state
+ * and handlers called once per frequency over every instance with work.
+ *
+ * Design decisions:
+ * - Instances stay real agents (own ID, queue and Agent struct with
+ *   AGENT_FLAG_POOLED and state_ptr = pool), so routing, direct routes,
+ *   inject and the ready set need no pool awareness; a pooled agent has
+ *   no dispatch table, so direct routes always queue to it
+ * - The sequential sweep gives the whole pool its turn when it reaches
+ *   the first ready instance, and passes over the others for the rest of
+ *   the cycle. A turn is up to budget_max rounds; each round takes the
+ *   head signal of every ready instance (so each instance still sees its
+ *   signals in FIFO order), groups them by handler with a counting sort
+ *   (ascending instances within a group) and makes one call per handler
+ * - Ready instances are read straight from the scheduler's ready bits
+ *   over the pool's ID range: no second pending set to keep in step, and
+ *   a signal emitted to an instance during a round makes it ready for
+ *   the next one
+ * - Columns are 64-byte aligned and zeroed, so a handler that sees
+ *   instances[count - 1] - instances[0] == count - 1 has a dense range
+ *   it can process with plain vector loops
+ * - Parallel, BSP, fair-share and deadline turns are per agent and run
+ *   a pooled agent one signal at a time (batch of one, no shared
+ *   buffers): correct everywhere, batched where the sweep owns the pool
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <string.h>
+
+#define POOL_NO_HANDLER     0xFF    /* gather_handlers[] value: drop */
+
+/* =============================================================================
+ * POOL CREATION & DESTRUCTION
+ * ============================================================================= */
+
+/*
+ * Free a pool and whatever it holds (registry entries are the caller's)
+ */
+static void pool_free(AgentPool* pool) {
+    if (pool->agents != NULL) {
+        for (uint32_t i = 0; i < pool->count; i++) {
+            signal_queue_destroy(pool->agents[i].input_queue);
+        }
+    }
+    for (uint32_t c = 0; c < pool->column_count; c++) {
+        heap_free_aligned(pool->columns[c], (size_t)pool->column_sizes[c] * pool->count,
+                          POOL_COLUMN_ALIGN);
+    }
+    heap_free(pool->agents, (size_t)pool->count * sizeof(Agent));
+    heap_free(pool->gather_instances, (size_t)pool->count * sizeof(uint32_t));
+    heap_free(pool->gather_signals, (size_t)pool->count * sizeof(Signal*));
+    heap_free(pool->gather_handlers, (size_t)pool->count);
+    heap_free(pool->batch_instances, (size_t)pool->count * sizeof(uint32_t));
+    heap_free(pool->batch_signals, (size_t)pool->count * sizeof(Signal*));
+    heap_free(pool, sizeof(AgentPool));
+}
+
+/*
+ * Create a pool of count instances and register them as agents
+ */
+AgentPool* agent_pool_create(AgentRegistry* registry, uint32_t first_id, uint32_t count,
+                             uint32_t queue_capacity, void* context) {
+    if (registry == NULL || count == 0 || first_id == 0 ||
+        first_id > UINT32_MAX - count) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t id = first_id + i;
+        if (id < registry->capacity && registry->agents[id] != NULL) {
+            return NULL;
+        }
+    }
+
+    AgentPool* pool = heap_allocate(sizeof(AgentPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->first_id = first_id;
+    pool->count = count;
+    pool->context = context;
+    pool->agents = heap_allocate((size_t)count * sizeof(Agent));
+    pool->gather_instances = heap_allocate((size_t)count * sizeof(uint32_t));
+    pool->gather_signals = heap_allocate((size_t)count * sizeof(Signal*));
+    pool->gather_handlers = heap_allocate((size_t)count);
+    pool->batch_instances = heap_allocate((size_t)count * sizeof(uint32_t));
+    pool->batch_signals = heap_allocate((size_t)count * sizeof(Signal*));
+    if (pool->agents == NULL || pool->gather_instances == NULL ||
+        pool->gather_signals == NULL || pool->gather_handlers == NULL ||
+        pool->batch_instances == NULL || pool->batch_signals == NULL) {
+        pool_free(pool);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        Agent* agent = &pool->agents[i];
+        agent->agent_id = first_id + i;
+        agent->state_ptr = pool;
+        agent->flags = AGENT_FLAG_POOLED;
+        agent->input_queue = signal_queue_create(queue_capacity);
+        if (agent->input_queue == NULL) {
+            pool_free(pool);
+            return NULL;
+        }
+    }
+
+    /* Highest ID first: the registry grows once (schedulers follow before
+     * their next cycle or run) */
+    uint32_t count_before = registry->count;
+    for (uint32_t i = count; i-- > 0; ) {
+        if (agent_registry_add(registry, &pool->agents[i]) != SIGNAL_OK) {
+            for (uint32_t j = i + 1; j < count; j++) {
+                registry->agents[first_id + j] = NULL;
+            }
+            registry->count = count_before;
+            pool_free(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+/*
+ * Unregister the instances and free the pool
+ */
+void agent_pool_destroy(AgentPool* pool, AgentRegistry* registry) {
+    if (pool == NULL) {
+        return;
+    }
+    if (registry != NULL) {
+        for (uint32_t i = 0; i < pool->count; i++) {
+            uint32_t id = pool->first_id + i;
+            if (id < registry->capacity && registry->agents[id] == &pool->agents[i]) {
+                registry->agents[id] = NULL;
+            }
+        }
+    }
+    pool_free(pool);
+}
+
+/* =============================================================================
+ * COLUMNS & HANDLERS
+ * ============================================================================= */
+
+/*
+ * Add a zeroed state column of elem_size bytes per instance
+ */
+int agent_pool_add_column(AgentPool* pool, size_t elem_size) {
+    if (pool == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    if (pool->column_count == POOL_MAX_COLUMNS || elem_size == 0 || elem_size > UINT32_MAX) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+
+    void* column = heap_allocate_aligned(elem_size * pool->count, POOL_COLUMN_ALIGN);
+    if (column == NULL) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    pool->columns[pool->column_count] = column;
+    pool->column_sizes[pool->column_count] = (uint32_t)elem_size;
+    return (int)pool->column_count++;
+}
+
+/*
+ * Base of a state column
+ */
+void* agent_pool_column(AgentPool* pool, uint32_t column) {
+    if (pool == NULL || column >= pool->column_count) {
+        return NULL;
+    }
+    return pool->columns[column];
+}
+
+/*
+ * Set the handler of a frequency
+ */
+int agent_pool_register(AgentPool* pool, uint32_t frequency_id, pool_handler_fn handler) {
+    if (pool == NULL || handler == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+    for (uint32_t h = 0; h < pool->handler_count; h++) {
+        if (pool->handlers[h].frequency_id == frequency_id) {
+            pool->handlers[h].handler = handler;
+            return SIGNAL_OK;
+        }
+    }
+    if (pool->handler_count == POOL_MAX_HANDLERS) {
+        return SIGNAL_ERR_ALLOC_FAILED;
+    }
+    pool->handlers[pool->handler_count++] = (PoolHandler){ frequency_id, handler };
+    return SIGNAL_OK;
+}
+
+/*
+ * Handler slot of a frequency
+ *
+ * @return: Index into pool->handlers, or POOL_NO_HANDLER
+ */
+static inline uint32_t pool_handler_slot(const AgentPool* pool, uint32_t frequency_id) {
+    for (uint32_t h = 0; h < pool->handler_count; h++) {
+        if (pool->handlers[h].frequency_id == frequency_id) {
+            return h;
+        }
+    }
+    return POOL_NO_HANDLER;
+}
+
+/* =============================================================================
+ * POOL TURNS
+ * ============================================================================= */
+
+/*
+ * Take the head signal of every ready instance
+ *
+ * Instances left with an empty queue drop out of the ready set (a signal
+ * emitted to them later puts them back).
+ *
+ * @return: Signals gathered into pool->gather_*
+ */
+static uint32_t pool_gather(Scheduler* sched, AgentPool* pool, uint32_t* per_handler) {
+    uint32_t gathered = 0;
+    uint64_t lo = pool->first_id;
+    uint64_t hi = (uint64_t)pool->first_id + pool->count;     /* Exclusive */
+    if (hi > (uint64_t)sched->ready_words * 64) {
+        /* Not yet covered (the ready set grows before the next sweep) */
+        hi = (uint64_t)sched->ready_words * 64;
+    }
+
+    for (uint64_t base = lo & ~(uint64_t)63; base < hi; base += 64) {
+        uint32_t k = (uint32_t)(base >> 6);
+        uint64_t word = sched->ready_bits[k];
+        if (base < lo) {
+            word &= ~(uint64_t)0 << (lo - base);
+        }
+        if (hi - base < 64) {
+            word &= ((uint64_t)1 << (hi - base)) - 1;
+        }
+
+        while (word != 0) {
+            uint32_t bit = (uint32_t)__builtin_ctzll(word);
+            word &= word - 1;
+            uint32_t instance = (uint32_t)(base + bit - lo);
+            SignalQueue* queue = pool->agents[instance].input_queue;
+
+            Signal* sig = signal_queue_dequeue(queue);
+            if (signal_queue_is_empty(queue)) {
+                sched->ready_bits[k] &= ~((uint64_t)1 << bit);
+            }
+            if (sig == NULL) {
+                continue;
+            }
+
+            uint32_t slot = pool_handler_slot(pool, sig->frequency_id);
+            pool->gather_instances[gathered] = instance;
+            pool->gather_signals[gathered] = sig;
+            pool->gather_handlers[gathered] = (uint8_t)slot;
+            if (slot != POOL_NO_HANDLER) {
+                per_handler[slot]++;
+            }
+            gathered++;
+        }
+    }
+    return gathered;
+}
+
+/*
+ * One round: every ready instance's head signal, one call per handler
+ *
+ * @return: Signals consumed
+ */
+static uint32_t pool_round(Scheduler* sched, AgentPool* pool, uint64_t* dispatch_errors) {
+    uint32_t per_handler[POOL_MAX_HANDLERS] = { 0 };
+    uint32_t gathered = pool_gather(sched, pool, per_handler);
+    if (gathered == 0) {
+        return 0;
+    }
+
+    /* Group by handler, keeping instance order within each group */
+    uint32_t offset[POOL_MAX_HANDLERS];
+    uint32_t next = 0;
+    for (uint32_t h = 0; h < pool->handler_count; h++) {
+        offset[h] = next;
+        next += per_handler[h];
+    }
+    for (uint32_t i = 0; i < gathered; i++) {
+        uint32_t slot = pool->gather_handlers[i];
+        if (slot == POOL_NO_HANDLER) {
+            (*dispatch_errors)++;
+            continue;
+        }
+        pool->batch_instances[offset[slot]] = pool->gather_instances[i];
+        pool->batch_signals[offset[slot]] = pool->gather_signals[i];
+        offset[slot]++;
+    }
+
+    next = 0;
+    for (uint32_t h = 0; h < pool->handler_count; h++) {
+        uint32_t n = per_handler[h];
+        if (n == 0) {
+            continue;
+        }
+        int failed = pool->handlers[h].handler(pool, &pool->batch_instances[next],
+                                               &pool->batch_signals[next], n);
+        if (failed > 0) {
+            *dispatch_errors += (uint32_t)failed;
+        }
+        pool->handler_calls++;
+        next += n;
+    }
+
+    for (uint32_t i = 0; i < gathered; i++) {
+        pool->agents[pool->gather_instances[i]].signal_count++;
+        signal_free(pool->gather_signals[i]);
+    }
+
+    pool->rounds++;
+    pool->signals += next;
+    return gathered;
+}
+
+/*
+ * Give a pool its turn in the sequential sweep
+ *
+ * Up to budget_max rounds over the ready instances; the pool is passed
+ * over until the cycle ends and the scheduler re-arms it. The ready bits of
+ * instances that empty are cleared here; the sweep's own visit to an
+ * instance that still has signals leaves them for the next cycle.
+ *
+ * @param sched: Scheduler state (sequential)
+ * @param pool: Pool of the first ready instance the sweep reached
+ * @param dispatch_errors: Incremented by failed/unhandled signals
+ * @return: Signals drained
+ */
+uint32_t scheduler_pool_turn(Scheduler* sched, AgentPool* pool, uint64_t* dispatch_errors) {
+    pool->turn_taken = 1;
+    pool->next_turn = sched->pool_turns;
+    sched->pool_turns = pool;
+
+    uint32_t drained = 0;
+    for (uint32_t round = 0; round < sched->budget_max; round++) {
+        uint32_t consumed = pool_round(sched, pool, dispatch_errors);
+        if (consumed == 0) {
+            break;
+        }
+        drained += consumed;
+    }
+    return drained;
+}
+
+/*
+ * Drain one pooled agent's signals, one handler call each
+ *
+ * @param sched: Scheduler state (unused; any scheduler)
+ * @param agent: Pool instance (AGENT_FLAG_POOLED)
+ * @param budget: Signals at most
+ * @param dispatch_errors: Incremented by failed/unhandled signals
+ * @return: Signals drained
+ */
+uint32_t scheduler_pool_drain(Scheduler* sched, Agent* agent, uint32_t budget,
+                              uint64_t* dispatch_errors) {
+    (void)sched;
+    AgentPool* pool = (AgentPool*)agent->state_ptr;
+    uint32_t instance = agent->agent_id - pool->first_id;
+    uint32_t drained = 0;
+
+    for (; drained < budget; drained++) {
+        Signal* sig = signal_queue_dequeue(agent->input_queue);
+        if (sig == NULL) {
+            break;
+        }
+        uint32_t slot = pool_handler_slot(pool, sig->frequency_id);
+        if (slot == POOL_NO_HANDLER) {
+            (*dispatch_errors)++;
+        } else if (pool->handlers[slot].handler(pool, &instance, &sig, 1) > 0) {
+            (*dispatch_errors)++;
+        }
+        signal_free(sig);
+    }
+    return drained;
+}
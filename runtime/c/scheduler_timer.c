@@ -0,0 +1,416 @@
+/*
+ * Mycelial Scheduler Timers
+ *
+ * `on cycle N` and periodic handlers, keyed by tidal cycle number or by
+ * wall-clock time.
+ *
+ * Design decisions:
+ * - Hierarchical timer wheel: 4 levels x 64 slots. Level k holds timers
+ *   due within 64^(k+1) ticks and is cascaded one level down when the
+ *   clock reaches a multiple of 64^k. Farther timers park in the top
+ *   level and are re-bucketed as they come into range
+ * - Add, cancel and fire are O(1) (intrusive doubly-linked slot lists);
+ *   the wheel is per scheduler, so agents without timers cost nothing and
+ *   a network without timers never allocates a wheel
+ * - Per-level occupancy bitmaps let the clock jump straight to the next
+ *   tick with work, so idle stretches cost O(levels), not O(ticks)
+ * - Two wheels: cycles (advanced once per tidal cycle) and wall time
+ *   (CLOCK_MONOTONIC, ~1 ms ticks). A parked scheduler sleeps until the
+ *   next wall tick that has work instead of polling a timerfd
+ */
+
+#include "scheduler.h"
+#include "signal.h"
+#include <string.h>
+#include <time.h>
+
+/* =============================================================================
+ * TYPES
+ * ============================================================================= */
+
+#define TIMER_WHEEL_LEVELS      4
+#define TIMER_WHEEL_BITS        6
+#define TIMER_WHEEL_SLOTS       (1u << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK        (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_RANGE       ((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+/* SchedTimer.flags */
+#define TIMER_FLAG_WALL         0x01    /* Lives on the wall-clock wheel */
+#define TIMER_FLAG_FIRING       0x02    /* Handler running (unlinked) */
+#define TIMER_FLAG_CANCELLED    0x04    /* Cancelled by its own handler */
+
+typedef struct TimerWheel {
+    SchedTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    uint64_t occupied[TIMER_WHEEL_LEVELS];  /* Bit i = slots[k][i] non-empty */
+    uint64_t now;                           /* Next tick to process */
+    uint32_t count;                         /* Timers on the wheel */
+} TimerWheel;
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* =============================================================================
+ * WHEEL OPERATIONS
+ * ============================================================================= */
+
+/*
+ * Link a timer into the slot for its due tick (due < now fires at now)
+ */
+static void wheel_insert(TimerWheel* wheel, SchedTimer* timer) {
+    if (timer->due < wheel->now) {
+        timer->due = wheel->now;
+    }
+
+    uint64_t delta = timer->due - wheel->now;
+    uint64_t key = timer->due;
+    uint32_t level = 0;
+
+    if (delta >= TIMER_WHEEL_RANGE) {
+        /* Out of range: park at the top level's farthest slot */
+        level = TIMER_WHEEL_LEVELS - 1;
+        key = wheel->now + TIMER_WHEEL_RANGE - 1;
+    } else {
+        while (level < TIMER_WHEEL_LEVELS - 1 &&
+               delta >= ((uint64_t)1 << (TIMER_WHEEL_BITS * (level + 1)))) {
+            level++;
+        }
+    }
+
+    uint32_t slot = (uint32_t)(key >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    SchedTimer** head = &wheel->slots[level][slot];
+
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = timer;
+    }
+    *head = timer;
+    wheel->occupied[level] |= (uint64_t)1 << slot;
+}
+
+/*
+ * Unlink a timer from its slot
+ */
+static void wheel_remove(TimerWheel* wheel, SchedTimer* timer) {
+    SchedTimer** head = &wheel->slots[timer->level][timer->slot];
+
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        *head = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    if (*head == NULL) {
+        wheel->occupied[timer->level] &= ~((uint64_t)1 << timer->slot);
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/*
+ * Earliest tick >= now at which a slot fires or cascades
+ *
+ * @return: Tick, or UINT64_MAX if the wheel is empty
+ */
+static uint64_t wheel_next_tick(TimerWheel* wheel) {
+    uint64_t best = UINT64_MAX;
+
+    for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        uint64_t bits = wheel->occupied[level];
+        if (bits == 0) {
+            continue;
+        }
+
+        uint32_t shift = TIMER_WHEEL_BITS * level;
+        uint64_t block = wheel->now >> shift;
+        uint32_t current = (uint32_t)block & TIMER_WHEEL_MASK;
+
+        /* Distance (in blocks) to the nearest occupied slot, rotating from current */
+        uint64_t rotated = (bits >> current) | (current ? bits << (TIMER_WHEEL_SLOTS - current) : 0);
+        uint64_t distance = (uint64_t)__builtin_ctzll(rotated);
+
+        /* A higher-level slot at distance 0 cascades at the current block's
+         * start, which has passed unless now is exactly on it */
+        if (distance == 0 && level > 0 && (wheel->now & (((uint64_t)1 << shift) - 1)) != 0) {
+            uint64_t rest = rotated & ~(uint64_t)1;
+            distance = rest ? (uint64_t)__builtin_ctzll(rest) : TIMER_WHEEL_SLOTS;
+        }
+
+        uint64_t tick = (level == 0) ? wheel->now + distance : (block + distance) << shift;
+        if (tick < best) {
+            best = tick;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Fire one timer (already unlinked): run its handler, re-arm if periodic
+ */
+static void timer_fire(Scheduler* sched, TimerWheel* wheel, SchedTimer* timer) {
+    Agent* agent = NULL;
+    if (timer->agent_id < sched->registry->count) {
+        agent = sched->registry->agents[timer->agent_id];
+    }
+
+    /* An offloaded handler owns the agent's state: try again next tick */
+    if (agent != NULL && (agent->flags & AGENT_FLAG_OFFLOADED)) {
+        timer->due = wheel->now + 1;
+        wheel_insert(wheel, timer);
+        return;
+    }
+
+    timer->flags |= TIMER_FLAG_FIRING;
+    void* state = NULL;
+    if (agent != NULL) {
+        state = agent->state_ptr;
+        agent->flags |= AGENT_FLAG_DISPATCHING;
+    }
+    if (timer->handler(state, sched->cycle_count) != 0) {
+        sched->dispatch_errors++;
+    }
+    if (agent != NULL) {
+        agent->flags &= ~(uint32_t)AGENT_FLAG_DISPATCHING;
+    }
+    sched->timers_fired++;
+
+    timer->flags &= (uint8_t)~TIMER_FLAG_FIRING;
+    if (timer->period > 0 && !(timer->flags & TIMER_FLAG_CANCELLED)) {
+        timer->due += timer->period;
+        wheel_insert(wheel, timer);
+    } else {
+        wheel->count--;
+        heap_free(timer, sizeof(SchedTimer));
+    }
+}
+
+/*
+ * Process every tick up to and including `to`
+ */
+static void wheel_advance(Scheduler* sched, TimerWheel* wheel, uint64_t to) {
+    while (wheel->now <= to) {
+        uint64_t tick = wheel_next_tick(wheel);
+        if (tick > to) {
+            wheel->now = to + 1;
+            return;
+        }
+        wheel->now = tick;
+
+        /* Cascade from the top so re-bucketed timers land in lower slots
+         * that are cascaded/fired later in this same tick */
+        for (uint32_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            uint32_t shift = TIMER_WHEEL_BITS * level;
+            if ((tick & (((uint64_t)1 << shift) - 1)) != 0) {
+                continue;
+            }
+            uint32_t slot = (uint32_t)(tick >> shift) & TIMER_WHEEL_MASK;
+            SchedTimer* timer = wheel->slots[level][slot];
+            wheel->slots[level][slot] = NULL;
+            wheel->occupied[level] &= ~((uint64_t)1 << slot);
+            while (timer != NULL) {
+                SchedTimer* next = timer->next;
+                wheel_insert(wheel, timer);
+                timer = next;
+            }
+        }
+
+        /* Fire everything due now; handlers may add or cancel timers */
+        uint32_t slot = (uint32_t)tick & TIMER_WHEEL_MASK;
+        SchedTimer* timer;
+        while ((timer = wheel->slots[0][slot]) != NULL) {
+            wheel_remove(wheel, timer);
+            timer_fire(sched, wheel, timer);
+        }
+
+        wheel->now = tick + 1;
+    }
+}
+
+/* =============================================================================
+ * TIMER API
+ * ============================================================================= */
+
+/*
+ * Allocate a timer and put it on a wheel (created on first use)
+ */
+static SchedTimer* timer_add(Scheduler* sched, TimerWheel** wheel_ptr, uint64_t now,
+                             uint32_t agent_id, uint64_t due, uint64_t period,
+                             timer_handler_fn handler, uint8_t flags) {
+    if (sched == NULL || handler == NULL) {
+        return NULL;
+    }
+
+    if (*wheel_ptr == NULL) {
+        *wheel_ptr = heap_allocate(sizeof(TimerWheel));
+        if (*wheel_ptr == NULL) {
+            return NULL;
+        }
+        (*wheel_ptr)->now = now;
+    }
+    TimerWheel* wheel = *wheel_ptr;
+
+    SchedTimer* timer = heap_allocate(sizeof(SchedTimer));
+    if (timer == NULL) {
+        return NULL;
+    }
+    timer->due = due;
+    timer->period = period;
+    timer->handler = handler;
+    timer->agent_id = agent_id;
+    timer->flags = flags;
+
+    wheel_insert(wheel, timer);
+    wheel->count++;
+    return timer;
+}
+
+/*
+ * Run a handler at the start of a given cycle, optionally repeating
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent whose state the handler receives
+ * @param cycle: First cycle to fire in (past cycles fire next cycle)
+ * @param period: Cycles between firings (0 = once)
+ * @param handler: Timer handler
+ * @return: Timer handle, or NULL on failure
+ */
+SchedTimer* scheduler_add_timer(Scheduler* sched, uint32_t agent_id, uint64_t cycle,
+                                uint64_t period, timer_handler_fn handler) {
+    if (sched == NULL) {
+        return NULL;
+    }
+    return timer_add(sched, &sched->cycle_timers, sched->cycle_count,
+                     agent_id, cycle, period, handler, 0);
+}
+
+/*
+ * Run a handler after a wall-clock delay, optionally repeating
+ *
+ * @param sched: Scheduler state
+ * @param agent_id: Agent whose state the handler receives
+ * @param delay_ns: Nanoseconds from now (rounded up to the wall tick)
+ * @param period_ns: Nanoseconds between firings (0 = once)
+ * @param handler: Timer handler
+ * @return: Timer handle, or NULL on failure
+ */
+SchedTimer* scheduler_add_wall_timer(Scheduler* sched, uint32_t agent_id,
+                                     uint64_t delay_ns, uint64_t period_ns,
+                                     timer_handler_fn handler) {
+    if (sched == NULL) {
+        return NULL;
+    }
+
+    uint64_t tick_ns = (uint64_t)1 << SCHED_WALL_TICK_SHIFT;
+    uint64_t now = monotonic_ns() >> SCHED_WALL_TICK_SHIFT;
+    uint64_t delay = (delay_ns + tick_ns - 1) >> SCHED_WALL_TICK_SHIFT;
+    uint64_t period = (period_ns + tick_ns - 1) >> SCHED_WALL_TICK_SHIFT;
+    if (period_ns > 0 && period == 0) {
+        period = 1;
+    }
+
+    return timer_add(sched, &sched->wall_timers, now, agent_id, now + delay,
+                     period, handler, TIMER_FLAG_WALL);
+}
+
+/*
+ * Cancel a pending timer
+ *
+ * May be called from any timer handler, including the timer's own.
+ *
+ * @param sched: Scheduler state
+ * @param timer: Handle from scheduler_add_timer/scheduler_add_wall_timer
+ * @return: 0 on success, SIGNAL_ERR_NULL_POINTER
+ */
+int scheduler_cancel_timer(Scheduler* sched, SchedTimer* timer) {
+    if (sched == NULL || timer == NULL) {
+        return SIGNAL_ERR_NULL_POINTER;
+    }
+
+    if (timer->flags & TIMER_FLAG_FIRING) {
+        /* Freed by timer_fire once the handler returns */
+        timer->flags |= TIMER_FLAG_CANCELLED;
+        return SIGNAL_OK;
+    }
+
+    TimerWheel* wheel = (timer->flags & TIMER_FLAG_WALL) ? sched->wall_timers
+                                                         : sched->cycle_timers;
+    wheel_remove(wheel, timer);
+    wheel->count--;
+    heap_free(timer, sizeof(SchedTimer));
+    return SIGNAL_OK;
+}
+
+/* =============================================================================
+ * SCHEDULER HOOKS
+ * ============================================================================= */
+
+/*
+ * Fire timers due at the current cycle and wall time (REST phase)
+ *
+ * @param sched: Scheduler state
+ */
+void scheduler_fire_timers(Scheduler* sched) {
+    if (sched->cycle_timers != NULL && sched->cycle_timers->count > 0) {
+        wheel_advance(sched, sched->cycle_timers, sched->cycle_count);
+    }
+    if (sched->wall_timers != NULL && sched->wall_timers->count > 0) {
+        wheel_advance(sched, sched->wall_timers, monotonic_ns() >> SCHED_WALL_TICK_SHIFT);
+    }
+}
+
+/*
+ * Number of pending cycle timers (cycles must keep running for them)
+ */
+uint32_t scheduler_cycle_timers_pending(Scheduler* sched) {
+    return (sched->cycle_timers != NULL) ? sched->cycle_timers->count : 0;
+}
+
+/*
+ * CLOCK_MONOTONIC time of the next wall tick with work
+ *
+ * @return: Nanoseconds, or 0 if no wall timers are pending
+ */
+uint64_t scheduler_next_wall_deadline(Scheduler* sched) {
+    if (sched->wall_timers == NULL || sched->wall_timers->count == 0) {
+        return 0;
+    }
+    return wheel_next_tick(sched->wall_timers) << SCHED_WALL_TICK_SHIFT;
+}
+
+/*
+ * Free both wheels and every pending timer (called by scheduler_destroy)
+ *
+ * @param sched: Scheduler being destroyed
+ */
+void scheduler_timers_destroy(Scheduler* sched) {
+    TimerWheel* wheels[2] = { sched->cycle_timers, sched->wall_timers };
+
+    for (int w = 0; w < 2; w++) {
+        TimerWheel* wheel = wheels[w];
+        if (wheel == NULL) {
+            continue;
+        }
+        for (uint32_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+            for (uint32_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+                SchedTimer* timer = wheel->slots[level][slot];
+                while (timer != NULL) {
+                    SchedTimer* next = timer->next;
+                    heap_free(timer, sizeof(SchedTimer));
+                    timer = next;
+                }
+            }
+        }
+        heap_free(wheel, sizeof(TimerWheel));
+    }
+
+    sched->cycle_timers = NULL;
+    sched->wall_timers = NULL;
+}
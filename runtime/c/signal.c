@@ -13,7 +13,7 @@
  * SIGNAL ALLOCATION
  *
  * Design decisions:
- * - Signal headers are 32 bytes (cache-line friendly)
+ * - Signal headers are 40 bytes (32-bit source agent ID)
  * - Payloads are separately allocated and pointed to
  * - Reference counting enables zero-copy sharing
  * ============================================================================= */
@@ -53,8 +53,34 @@ Signal* signal_alloc(void) {
  */
 void signal_ref(Signal* sig) {
     if (sig != NULL) {
-        sig->ref_count++;
+        if (g_runtime_threaded) {
+            __atomic_add_fetch(&sig->ref_count, 1, __ATOMIC_RELAXED);
+        } else {
+            sig->ref_count++;
+        }
+    }
+}
+
+/*
+ * Drop one reference (never below zero)
+ *
+ * @return: References remaining
+ */
+static inline uint16_t signal_release_ref(Signal* sig) {
+    if (!g_runtime_threaded) {
+        if (sig->ref_count > 0) {
+            sig->ref_count--;
+        }
+        return sig->ref_count;
+    }
+
+    uint16_t current = __atomic_load_n(&sig->ref_count, __ATOMIC_RELAXED);
+    while (current > 0 &&
+           !__atomic_compare_exchange_n(&sig->ref_count, &current, current - 1, 1,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        /* current reloaded by the failed CAS */
     }
+    return (current > 0) ? (uint16_t)(current - 1) : 0;
 }
 
 /*
@@ -72,13 +98,8 @@ void signal_free(Signal* sig) {
         return;
     }
 
-    /* Decrement reference count */
-    if (sig->ref_count > 0) {
-        sig->ref_count--;
-    }
-
-    /* Only free when no more references */
-    if (sig->ref_count > 0) {
+    /* Decrement reference count; only free when no more references */
+    if (signal_release_ref(sig) > 0) {
         return;
     }
 
@@ -124,7 +145,7 @@ Signal* signal_create(uint32_t frequency_id, uint32_t source_agent_id,
 
     /* Fill in signal fields */
     sig->frequency_id = (uint16_t)frequency_id;
-    sig->source_agent_id = (uint16_t)source_agent_id;
+    sig->source_agent_id = source_agent_id;
 
     /* Allocate and copy payload if present */
     if (payload != NULL && payload_size > 0) {
@@ -155,9 +176,24 @@ Signal* signal_create(uint32_t frequency_id, uint32_t source_agent_id,
  * - Power-of-2 capacity for fast modulo (bitwise AND)
  * - Store signal pointers (not signals) for O(1) operations
  * - Queue full: Return error (caller decides what to do)
- * - Lock-free single-producer single-consumer (no locks needed for now)
+ * - Single-threaded: no locks. Threaded mode: per-queue spinlock, so any
+ *   number of producers can feed the one consumer (the owning agent)
+ * - count is read without the lock by status queries, so it is written
+ *   with atomic stores
  * ============================================================================= */
 
+static inline void queue_lock(SignalQueue* queue) {
+    if (g_runtime_threaded) {
+        runtime_spin_lock(&queue->lock);
+    }
+}
+
+static inline void queue_unlock(SignalQueue* queue) {
+    if (g_runtime_threaded) {
+        runtime_spin_unlock(&queue->lock);
+    }
+}
+
 /*
  * Create a new signal queue
  *
@@ -197,7 +233,9 @@ SignalQueue* signal_queue_create(uint32_t capacity) {
     queue->dropped_count = 0;
     queue->owner_agent_id = 0;
     queue->flags = QUEUE_FLAG_ACTIVE;
+    queue->lock = 0;
     queue->reserved = 0;
+    queue->watcher = NULL;
 
     return queue;
 }
@@ -248,10 +286,13 @@ int signal_queue_enqueue(SignalQueue* queue, Signal* signal) {
         return SIGNAL_ERR_NULL_POINTER;
     }
 
+    queue_lock(queue);
+
     /* Check if full */
     if (queue->count >= queue->capacity) {
         queue->dropped_count++;
         queue->flags |= QUEUE_FLAG_OVERFLOW;
+        queue_unlock(queue);
         return SIGNAL_ERR_QUEUE_FULL;
     }
 
@@ -266,9 +307,16 @@ int signal_queue_enqueue(SignalQueue* queue, Signal* signal) {
 
     /* Update queue state */
     queue->tail++;
-    queue->count++;
+    __atomic_store_n(&queue->count, queue->count + 1, __ATOMIC_RELAXED);
     queue->total_enqueued++;
 
+    queue_unlock(queue);
+
+    /* Tell the scheduler the owner has work */
+    if (queue->watcher != NULL) {
+        queue->watcher->notify(queue->watcher, queue->owner_agent_id);
+    }
+
     return SIGNAL_OK;
 }
 
@@ -288,8 +336,11 @@ Signal* signal_queue_dequeue(SignalQueue* queue) {
         return NULL;
     }
 
+    queue_lock(queue);
+
     /* Check if empty */
     if (queue->count == 0) {
+        queue_unlock(queue);
         return NULL;
     }
 
@@ -304,9 +355,11 @@ Signal* signal_queue_dequeue(SignalQueue* queue) {
 
     /* Update queue state */
     queue->head++;
-    queue->count--;
+    __atomic_store_n(&queue->count, queue->count - 1, __ATOMIC_RELAXED);
     queue->total_dequeued++;
 
+    queue_unlock(queue);
+
     return sig;
 }
 
@@ -317,12 +370,15 @@ Signal* signal_queue_dequeue(SignalQueue* queue) {
  * @return: Signal pointer, or NULL if empty
  */
 Signal* signal_queue_peek(SignalQueue* queue) {
-    if (queue == NULL || queue->count == 0) {
+    if (queue == NULL) {
         return NULL;
     }
 
-    uint32_t index = queue->head & queue->mask;
-    return queue->buffer[index];
+    queue_lock(queue);
+    Signal* sig = (queue->count > 0) ? queue->buffer[queue->head & queue->mask] : NULL;
+    queue_unlock(queue);
+
+    return sig;
 }
 
 /* =============================================================================
@@ -330,7 +386,7 @@ Signal* signal_queue_peek(SignalQueue* queue) {
  * ============================================================================= */
 
 uint32_t signal_queue_count(SignalQueue* queue) {
-    return (queue != NULL) ? queue->count : 0;
+    return (queue != NULL) ? __atomic_load_n(&queue->count, __ATOMIC_RELAXED) : 0;
 }
 
 uint32_t signal_queue_capacity(SignalQueue* queue) {
@@ -338,11 +394,11 @@ uint32_t signal_queue_capacity(SignalQueue* queue) {
 }
 
 int signal_queue_is_full(SignalQueue* queue) {
-    return (queue != NULL) ? (queue->count >= queue->capacity) : 1;
+    return (queue != NULL) ? (signal_queue_count(queue) >= queue->capacity) : 1;
 }
 
 int signal_queue_is_empty(SignalQueue* queue) {
-    return (queue != NULL) ? (queue->count == 0) : 1;
+    return (queue != NULL) ? (signal_queue_count(queue) == 0) : 1;
 }
 
 uint32_t signal_queue_get_dropped(SignalQueue* queue) {
@@ -414,7 +470,7 @@ uint16_t signal_get_frequency(Signal* sig) {
 /*
  * Get signal source agent ID
  */
-uint16_t signal_get_source(Signal* sig) {
+uint32_t signal_get_source(Signal* sig) {
     return (sig != NULL) ? sig->source_agent_id : 0;
 }
 
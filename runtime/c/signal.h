@@ -16,11 +16,12 @@
  * CONFIGURATION CONSTANTS
  * ============================================================================= */
 
-#define SIGNAL_HEADER_SIZE      32
+#define SIGNAL_HEADER_SIZE      40
 #define SIGNAL_QUEUE_CAPACITY   1024
 #define MAX_PAYLOAD_SIZE        (64 * 1024)     /* 64KB max payload */
 #define DEFAULT_HEAP_SIZE       (16 * 1024 * 1024)  /* 16MB default heap */
-#define MAX_AGENTS              256
+#define MAX_AGENTS              256     /* Initial registry size (registries grow) */
+#define AGENT_REGISTRY_MAX_ID   (1u << 22)  /* IDs an AgentRegistry (flat array) accepts */
 #define MAX_ROUTES              256
 
 /* Signal flags */
@@ -28,6 +29,15 @@
 #define SIGNAL_FLAG_HEAP_ALLOCATED  0x0002
 #define SIGNAL_FLAG_PROCESSED       0x0004
 #define SIGNAL_FLAG_BROADCAST       0x0008
+#define SIGNAL_FLAG_STACK           0x0010  /* Direct call: lives on the emitter's stack */
+
+/* Route flags */
+#define ROUTE_FLAG_DIRECT           0x0001  /* Invoke idle destinations inline */
+#define ROUTE_FLAG_REPLICATED       0x0002  /* A destination is a replica set */
+
+/* Direct calls: nesting limit, largest payload carried on the stack */
+#define ROUTE_DIRECT_MAX_DEPTH      8
+#define ROUTE_DIRECT_INLINE_MAX     64
 
 /* Queue flags */
 #define QUEUE_FLAG_ACTIVE           0x0001
@@ -41,26 +51,70 @@
 #define SIGNAL_ERR_ALLOC_FAILED     4
 #define SIGNAL_ERR_PAYLOAD_TOO_LARGE 5
 #define SIGNAL_ERR_NO_ROUTE         6
+#define SIGNAL_ERR_IO               7
+#define SIGNAL_ERR_BUSY             8
+#define SIGNAL_ERR_ID_RANGE         9   /* Agent ID >= AGENT_REGISTRY_MAX_ID */
+
+/* =============================================================================
+ * THREADED MODE
+ *
+ * The runtime is single-threaded by default. A parallel scheduler switches
+ * on threaded mode while its workers run; the heap, signal queues and
+ * signal ref counts then use spinlocks/atomics. Off, those paths cost one
+ * well-predicted branch.
+ * ============================================================================= */
+
+extern int g_runtime_threaded;
+
+/* Enable/disable threaded mode (call only while no other thread runs) */
+void runtime_set_threaded(int threaded);
+
+static inline void runtime_spin_lock(uint32_t* lock) {
+    while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(lock, __ATOMIC_RELAXED)) {
+            __builtin_ia32_pause();
+        }
+    }
+}
+
+static inline void runtime_spin_unlock(uint32_t* lock) {
+    __atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
 
 /* =============================================================================
- * SIGNAL STRUCTURE (32 bytes, cache-aligned)
+ * SIGNAL STRUCTURE (40 bytes)
+ *
+ * source_agent_id is 32 bits like every other agent ID, so routing by the
+ * header's source works for any registered agent.
  * ============================================================================= */
 
 typedef struct Signal {
     uint16_t frequency_id;          /* 0x00: Signal type identifier */
-    uint16_t source_agent_id;       /* 0x02: Sending agent ID */
-    uint16_t flags;                 /* 0x04: Signal flags */
-    uint16_t ref_count;             /* 0x06: Reference count for shared payloads */
+    uint16_t flags;                 /* 0x02: Signal flags */
+    uint32_t source_agent_id;       /* 0x04: Sending agent ID */
     void*    payload_ptr;           /* 0x08: Pointer to payload data */
     uint32_t payload_size;          /* 0x10: Size of payload in bytes */
     uint32_t payload_capacity;      /* 0x14: Allocated capacity */
     uint64_t timestamp;             /* 0x18: CPU cycle counter (RDTSC) */
+    uint16_t ref_count;             /* 0x20: Reference count for shared payloads */
+    uint16_t reserved;              /* 0x22: Padding */
+    uint32_t reserved2;             /* 0x24: Padding */
 } Signal;
 
 /* =============================================================================
  * SIGNAL QUEUE (Ring Buffer, 64 bytes)
  * ============================================================================= */
 
+/*
+ * Enqueue observer (installed by schedulers that track runnable agents)
+ *
+ * notify() runs after every successful enqueue, outside the queue lock,
+ * with the queue's owner_agent_id.
+ */
+typedef struct QueueWatcher {
+    void (*notify)(struct QueueWatcher* watcher, uint32_t agent_id);
+} QueueWatcher;
+
 typedef struct SignalQueue {
     Signal** buffer;                /* 0x00: Ring buffer of signal pointers */
     uint32_t capacity;              /* 0x08: Max signals (power of 2) */
@@ -73,13 +127,30 @@ typedef struct SignalQueue {
     uint32_t dropped_count;         /* 0x24: Signals dropped (overflow) */
     uint32_t owner_agent_id;        /* 0x28: Agent that owns this queue */
     uint32_t flags;                 /* 0x2C: Queue state flags */
-    uint64_t reserved;              /* 0x30: Padding/future use */
+    uint32_t lock;                  /* 0x30: Spinlock (threaded mode only) */
+    uint32_t reserved;              /* 0x34: Padding/future use */
+    QueueWatcher* watcher;          /* 0x38: Enqueue observer (NULL = none) */
 } SignalQueue;
 
 /* =============================================================================
  * ROUTING STRUCTURES
  * ============================================================================= */
 
+/*
+ * Per-edge traffic counters (one edge = source -> frequency -> destination)
+ *
+ * Padded to a full cache line so that per-thread shards of the same edge
+ * never share a line when updated concurrently.
+ */
+typedef struct RouteEdgeStats {
+    uint64_t signals_delivered;     /* Signals enqueued on this edge */
+    uint64_t bytes_delivered;       /* Payload bytes enqueued on this edge */
+    uint64_t drops_queue_full;      /* Deliveries rejected by a full queue */
+    uint32_t max_queue_depth;       /* Deepest destination queue observed */
+    uint64_t direct_calls;          /* Deliveries handled inline (ROUTE_FLAG_DIRECT) */
+    uint32_t pad[6];                /* Pad to 64 bytes */
+} RouteEdgeStats;
+
 typedef struct RoutingEntry {
     uint32_t source_agent_id;       /* Source agent */
     uint32_t frequency_id;          /* Signal frequency */
@@ -87,28 +158,85 @@ typedef struct RoutingEntry {
     uint32_t flags;                 /* Route flags */
     uint32_t* dest_agent_ids;       /* Array of destination agent IDs */
     SignalQueue** dest_queues;      /* Cached queue pointers for fast routing */
+    RouteEdgeStats* edge_stats;     /* [stats_shards][dest_count] counters */
 } RoutingEntry;
 
+/*
+ * Replicas of one logical agent (routing_set_replicas)
+ *
+ * A signal routed to the logical agent goes to exactly one replica: the
+ * one owning the hash of its shard key, or the next in turn if the agent
+ * is stateless (key_size 0).
+ */
+typedef struct RouteReplicaSet {
+    uint32_t logical_agent_id;      /* Destination ID routes name */
+    uint32_t replica_count;
+    uint32_t key_offset;            /* Shard key: payload bytes [offset, offset + size) */
+    uint32_t key_size;              /* 0 = round robin */
+    uint32_t* replica_ids;          /* Agent ID of each replica */
+    SignalQueue** replica_queues;   /* Cached queue pointers */
+    uint32_t next;                  /* Round-robin cursor */
+    uint32_t reserved;
+} RouteReplicaSet;
+
+/* Queue of an agent ID in some registry (NULL = unknown) */
+typedef SignalQueue* (*route_queue_lookup_fn)(void* ctx, uint32_t agent_id);
+
 typedef struct RoutingTable {
     RoutingEntry* entries;          /* Hash table entries */
     uint32_t capacity;              /* Table size (power of 2) */
     uint32_t mask;                  /* capacity - 1 */
     uint32_t entry_count;           /* Active entries */
     uint32_t collision_count;       /* For performance stats */
+    uint32_t stats_shards;          /* Per-thread copies of each edge's stats */
+    uint32_t replica_set_count;
+    uint32_t replica_set_capacity;
+    RouteReplicaSet* replica_sets;  /* Replicated destinations (few, scanned) */
+    route_queue_lookup_fn resolve;  /* Queues not cached or in the AgentRegistry */
+    void* resolve_ctx;              /* (e.g. agents materialized on first delivery) */
 } RoutingTable;
 
+/* Maximum per-thread stats shards per routing table */
+#define ROUTING_MAX_STATS_SHARDS    64
+
+/*
+ * Deferred delivery recorded by routing_broadcast while an outbox is set
+ *
+ * Layout: 32 bytes
+ */
+typedef struct RouteDelivery {
+    Signal* signal;                 /* 0x00: Holds one reference until delivered */
+    RoutingEntry* entry;            /* 0x08: Route taken (for edge stats) */
+    SignalQueue* queue;             /* 0x10: Destination queue */
+    uint32_t dest_index;            /* 0x18: Edge index within entry */
+    uint32_t dest_agent_id;         /* 0x1C: Destination agent */
+} RouteDelivery;
+
+/* Growable list of deferred deliveries, in emission order */
+typedef struct RouteOutbox {
+    RouteDelivery* items;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t replica_turn;          /* Round-robin cursor of this sender */
+} RouteOutbox;
+
 /* =============================================================================
  * HEAP STATE
  * ============================================================================= */
 
+/* Freed blocks up to this size are kept on exact-size lists (8-byte steps)
+ * so allocating them never walks the free list */
+#define HEAP_BIN_MAX    1024
+
 typedef struct HeapState {
-    void*    base;                  /* Start of heap region */
+    void*    base;                  /* Start of the first heap region */
     void*    current;               /* Current allocation point */
-    void*    end;                   /* End of heap region */
-    size_t   total_size;            /* Total heap size */
+    void*    end;                   /* End of the current region */
+    size_t   total_size;            /* Total size of all regions */
     size_t   used;                  /* Bytes currently allocated */
     size_t   peak_used;             /* Peak usage (watermark) */
-    void*    free_list;             /* List of freed blocks for reuse */
+    void*    free_list;             /* Freed blocks above HEAP_BIN_MAX */
+    void*    free_bins[HEAP_BIN_MAX / 8 + 1];  /* Freed small blocks, one list per size */
 } HeapState;
 
 typedef struct FreeBlock {
@@ -120,6 +248,14 @@ typedef struct FreeBlock {
  * AGENT REGISTRY (for routing)
  * ============================================================================= */
 
+/* Agent.flags bits owned by the runtime (agents.h flags use the low bits) */
+#define AGENT_FLAG_DISPATCHING      0x0100  /* A handler of this agent is on the stack */
+#define AGENT_FLAG_BLOCKING         0x0200  /* Every handler may block (offloaded) */
+#define AGENT_FLAG_OFFLOADED        0x0400  /* A handler runs on the offload pool */
+#define AGENT_FLAG_COROUTINE        0x0800  /* A coroutine of this agent is suspended */
+#define AGENT_FLAG_DEADLINE         0x1000  /* Deadline class: runs in the EDF pass */
+#define AGENT_FLAG_POOLED           0x2000  /* Instance of an AgentPool (state_ptr = pool) */
+
 typedef struct Agent {
     uint32_t agent_id;
     uint32_t agent_type;
@@ -152,6 +288,12 @@ void* heap_allocate(size_t bytes);
  * Returns: 0 on success */
 int heap_free(void* ptr, size_t bytes);
 
+/* Allocate N zeroed bytes starting on an `alignment` boundary (power of two,
+ * e.g. 64 for a cache line); free with heap_free_aligned and the same sizes
+ * Returns: Pointer to allocated memory, or NULL on failure */
+void* heap_allocate_aligned(size_t bytes, size_t alignment);
+int heap_free_aligned(void* ptr, size_t bytes, size_t alignment);
+
 /* Get heap statistics */
 size_t heap_get_used(void);
 size_t heap_get_peak(void);
@@ -215,7 +357,7 @@ uint32_t signal_queue_get_total_dequeued(SignalQueue* queue);
 void* signal_get_payload(Signal* sig);
 uint32_t signal_get_payload_size(Signal* sig);
 uint16_t signal_get_frequency(Signal* sig);
-uint16_t signal_get_source(Signal* sig);
+uint32_t signal_get_source(Signal* sig);
 uint64_t signal_get_timestamp(Signal* sig);
 
 /* Mark signal as processed (sets flag and decrements ref_count) */
@@ -255,6 +397,109 @@ int routing_broadcast(RoutingTable* table, Signal* signal,
  * Call after all agents are created */
 void routing_resolve_queues(RoutingTable* table, AgentRegistry* agents);
 
+/* Set cached queue pointers from any registry, via lookup(ctx, agent_id) */
+void routing_resolve_queues_with(RoutingTable* table, route_queue_lookup_fn lookup, void* ctx);
+
+/* Look up queues still unresolved at delivery through resolve(ctx, agent_id)
+ * (any delivering thread; the result is cached) */
+void routing_set_queue_resolver(RoutingTable* table, route_queue_lookup_fn resolve, void* ctx);
+
+/* =============================================================================
+ * ROUTING TRAFFIC STATISTICS (routing.c)
+ * ============================================================================= */
+
+/* Set number of per-thread stats shards (1 = single-threaded)
+ * Existing counters are merged into the new layout.
+ * Returns: SIGNAL_OK on success */
+int routing_set_stats_shards(RoutingTable* table, uint32_t shard_count);
+
+/* Select which stats shard the calling thread updates
+ * Worker threads call this once with their worker index. */
+void routing_set_thread_shard(uint32_t shard);
+
+/* Get traffic counters for one edge, summed over all shards
+ * Returns: SIGNAL_OK on success, SIGNAL_ERR_NO_ROUTE if edge not found */
+int routing_get_edge_stats(RoutingTable* table, uint32_t source_agent_id,
+                           uint32_t frequency_id, uint32_t dest_index,
+                           RouteEdgeStats* out);
+
+/* Sum one entry's counters for a destination index over all shards */
+void routing_entry_edge_stats(RoutingTable* table, RoutingEntry* entry,
+                              uint32_t dest_index, RouteEdgeStats* out);
+
+/* Reset all traffic counters to zero */
+void routing_reset_stats(RoutingTable* table);
+
+/* =============================================================================
+ * DEFERRED DELIVERY (routing.c)
+ *
+ * While a thread has an outbox set, routing_broadcast resolves routes but
+ * records (signal, destination) pairs instead of enqueueing. The owner
+ * later replays them with routing_deliver, in whatever order it needs.
+ * ============================================================================= */
+
+/* Divert the calling thread's routing_broadcast into outbox
+ * (NULL = deliver immediately again) */
+void routing_set_outbox(RouteOutbox* outbox);
+
+/* Enqueue one deferred delivery and drop its reference
+ * Returns: SIGNAL_OK, or SIGNAL_ERR_QUEUE_FULL (signal dropped) */
+int routing_deliver(RoutingTable* table, RouteDelivery* delivery);
+
+/* Drop undelivered references and free the outbox buffer */
+void routing_outbox_free(RouteOutbox* outbox);
+
+/* =============================================================================
+ * DIRECT DELIVERY (routing.c)
+ *
+ * A route marked direct hands a signal straight to the destination's
+ * handler, run to completion inside the emit, when that is
+ * indistinguishable from queueing it: single-threaded mode, no outbox,
+ * destination queue empty, destination not already on the stack, and
+ * fewer than ROUTE_DIRECT_MAX_DEPTH direct calls nested. Otherwise the
+ * signal is enqueued as usual. emit_signal builds the signal on the stack
+ * for payloads up to ROUTE_DIRECT_INLINE_MAX bytes; handlers must not keep
+ * a reference to it (re-broadcasting it is fine, it is copied first).
+ * ============================================================================= */
+
+/* Enable/disable direct calls on a route
+ * Returns: SIGNAL_OK, or SIGNAL_ERR_NO_ROUTE */
+int routing_set_direct(RoutingTable* table, uint32_t source_agent_id,
+                       uint32_t frequency_id, int enable);
+
+/* Handlers run inline on the calling thread, and how many of them failed
+ * (failed or unhandled), since the last call; resets both. The scheduler
+ * folds these into its totals so direct routes do not change them */
+void routing_take_direct_counts(uint64_t* handled, uint64_t* errors);
+
+/* =============================================================================
+ * REPLICATED AGENTS (routing.c)
+ *
+ * A logical agent can run as several replicas, each a registered agent
+ * with its own state and queue. Routes keep naming the logical ID; each
+ * delivery picks one replica. Keyed sets keep per-key order (one key, one
+ * replica); round-robin sets keep no order across replicas.
+ * ============================================================================= */
+
+/* Route signals for logical_agent_id to one of replica_count replicas,
+ * sharded by the payload bytes [key_offset, key_offset + key_size), or
+ * round robin if key_size is 0. Payloads too short for the key go to the
+ * first replica. replica_count <= 1 removes the set.
+ * Returns: SIGNAL_OK, SIGNAL_ERR_NULL_POINTER or SIGNAL_ERR_ALLOC_FAILED */
+int routing_set_replicas(RoutingTable* table, uint32_t logical_agent_id,
+                         uint32_t replica_count, const uint32_t* replica_ids,
+                         uint32_t key_offset, uint32_t key_size);
+
+/* Give to_agent_id a copy of every route from from_agent_id (same
+ * frequencies, destinations and flags), e.g. for a new replica
+ * Returns: SIGNAL_OK, SIGNAL_ERR_NULL_POINTER or SIGNAL_ERR_ALLOC_FAILED */
+int routing_copy_routes(RoutingTable* table, uint32_t from_agent_id, uint32_t to_agent_id);
+
+/* Replica IDs of a logical agent (count in out_count)
+ * Returns: Array of agent IDs, or NULL if the agent is not replicated */
+const uint32_t* routing_get_replicas(RoutingTable* table, uint32_t logical_agent_id,
+                                     uint32_t* out_count);
+
 /* =============================================================================
  * AGENT REGISTRY FUNCTIONS
  * ============================================================================= */
@@ -263,7 +508,7 @@ void routing_resolve_queues(RoutingTable* table, AgentRegistry* agents);
  * Returns: Pointer to registry, or NULL on failure */
 AgentRegistry* agent_registry_create(uint32_t capacity);
 
-/* Register an agent in the registry */
+/* Register an agent in the registry (grows it to fit the agent's ID) */
 int agent_registry_add(AgentRegistry* registry, Agent* agent);
 
 /* Get agent by ID
@@ -557,6 +557,12 @@ int test_process_batch(void) {
 int test_dispatch_stats(void) {
     printf("\n=== Test: Dispatch Stats ===\n");
 
+#ifndef DISPATCH_ENABLE_STATS
+    /* Counters are compiled out; build with -DDISPATCH_ENABLE_STATS */
+    printf("SKIP: Dispatch stats disabled at compile time\n");
+    return 0;
+#endif
+
     DispatchTable* table = dispatch_table_create(16, 1);
     TestAgentState state = { 0 };
     dispatch_set_state(table, &state);
@@ -615,6 +621,479 @@ int test_dispatch_stats(void) {
     return 0;
 }
 
+int test_jump_table(void) {
+    printf("\n=== Test: Jump Table Lookup ===\n");
+
+    /* Start small so registration has to grow the table */
+    DispatchTable* table = dispatch_table_create(4, 1);
+    TestAgentState state = { 0 };
+    dispatch_set_state(table, &state);
+
+    /* 40 dense handlers (orchestrator-sized) plus two sparse IDs */
+    for (uint32_t freq = 1; freq <= 40; freq++) {
+        if (dispatch_register(table, freq, handle_increment, NULL) != DISPATCH_OK) {
+            printf("FAIL: Could not register handler %u\n", freq);
+            dispatch_table_destroy(table);
+            return 1;
+        }
+    }
+    dispatch_register(table, 1000, handle_reset, NULL);
+    dispatch_register(table, 60000, handle_decrement, NULL);
+    printf("PASS: Registered 42 handlers (capacity grew to %u)\n", table->capacity);
+
+    if (dispatch_lookup(table, 40) != handle_increment ||
+        dispatch_lookup(table, 1000) != handle_reset ||
+        dispatch_lookup(table, 60000) != handle_decrement) {
+        printf("FAIL: Dense or sparse lookup returned wrong handler\n");
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    if (dispatch_lookup(table, 41) != NULL || dispatch_lookup(table, 999) != NULL ||
+        dispatch_lookup(table, 0) != NULL) {
+        printf("FAIL: Lookup of unregistered frequency should return NULL\n");
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Dense and sparse lookups correct\n");
+
+    /* Unregister drops the frequency from the index; re-register reuses slot */
+    uint32_t used = table->entry_count;
+    dispatch_unregister(table, 20);
+    dispatch_unregister(table, 1000);
+    if (dispatch_lookup(table, 20) != NULL || dispatch_lookup(table, 1000) != NULL) {
+        printf("FAIL: Unregistered handlers still found\n");
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    dispatch_register(table, 50, handle_reset, NULL);
+    if (table->entry_count != used || dispatch_lookup(table, 50) != handle_reset) {
+        printf("FAIL: Re-registration should reuse freed slot\n");
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Unregister/re-register keeps index consistent\n");
+
+    /* Dispatch through the index */
+    TestPayload payload = { .value = 3 };
+    Signal* sig = signal_create(60000, 1, &payload, sizeof(payload));
+    if (dispatch_invoke(table, sig) != DISPATCH_OK || state.count != -3) {
+        printf("FAIL: Dispatch via sparse index failed\n");
+        signal_free(sig);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    signal_free(sig);
+    printf("PASS: Dispatch via sparse index\n");
+
+    dispatch_table_destroy(table);
+    printf("PASS: Jump table test\n");
+    return 0;
+}
+
+/*
+ * Batch handler: sums p.value over a run of increment signals
+ * (handler_calls counts invocations, last_value holds the run length)
+ */
+int handle_increment_batch(void* agent_state, Signal** signals, uint32_t count) {
+    TestAgentState* state = (TestAgentState*)agent_state;
+
+    for (uint32_t i = 0; i < count; i++) {
+        TestPayload* payload = (TestPayload*)signal_get_payload(signals[i]);
+        state->count += payload->value;
+    }
+    state->last_value = (int)count;
+    state->handler_calls++;
+
+    return 0;
+}
+
+int test_batch_handler(void) {
+    printf("\n=== Test: Batch Handler ===\n");
+
+    DispatchTable* table = dispatch_table_create(16, 1);
+    TestAgentState state = { 0 };
+    dispatch_set_state(table, &state);
+
+    dispatch_register_batch(table, FREQ_INCREMENT, handle_increment_batch, NULL);
+    dispatch_register(table, FREQ_RESET, handle_reset, NULL);
+
+    /* Queue: inc inc inc reset inc inc */
+    SignalQueue* queue = signal_queue_create(16);
+    uint32_t freqs[6] = { FREQ_INCREMENT, FREQ_INCREMENT, FREQ_INCREMENT,
+                          FREQ_RESET, FREQ_INCREMENT, FREQ_INCREMENT };
+    for (int i = 0; i < 6; i++) {
+        TestPayload payload = { .value = i + 1 };
+        Signal* sig = signal_create(freqs[i], 1, &payload, sizeof(payload));
+        signal_queue_enqueue(queue, sig);
+        signal_free(sig);
+    }
+
+    int processed = dispatch_process_queue(table, queue);
+    if (processed != 6) {
+        printf("FAIL: Expected 6 processed, got %d\n", processed);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+
+    /* Runs: [1,2,3] batch, reset, [5,6] batch -> 3 calls, count = 11 */
+    if (state.handler_calls != 3 || state.count != 11 || state.last_value != 2) {
+        printf("FAIL: calls=%d count=%d last_run=%d (expected 3, 11, 2)\n",
+               state.handler_calls, state.count, state.last_value);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Two runs batched, reset dispatched singly\n");
+
+    /* Budget caps run length; guard filters inside a run */
+    state = (TestAgentState){ 0 };
+    dispatch_register_batch(table, FREQ_INCREMENT, handle_increment_batch,
+                            guard_value_gt_10);
+    for (int i = 0; i < 5; i++) {
+        TestPayload payload = { .value = (i % 2) ? 20 : 1 };
+        Signal* sig = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+        signal_queue_enqueue(queue, sig);
+        signal_free(sig);
+    }
+
+    processed = dispatch_process_batch(table, queue, 4);
+    if (processed != 4 || signal_queue_count(queue) != 1) {
+        printf("FAIL: Budget of 4 not respected (processed %d)\n", processed);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    if (state.handler_calls != 1 || state.count != 40 || state.last_value != 2) {
+        printf("FAIL: Guard filtering wrong: calls=%d count=%d run=%d\n",
+               state.handler_calls, state.count, state.last_value);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Run capped by budget, guard-failing signals dropped\n");
+
+    /* dispatch_invoke falls back to a run of one */
+    TestPayload payload = { .value = 50 };
+    Signal* sig = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+    if (dispatch_invoke(table, sig) != DISPATCH_OK || state.count != 90) {
+        printf("FAIL: dispatch_invoke on batch-only entry\n");
+        signal_free(sig);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    signal_free(sig);
+    printf("PASS: dispatch_invoke uses batch handler with run of 1\n");
+
+    signal_queue_destroy(queue);
+    dispatch_table_destroy(table);
+    printf("PASS: Batch handler test\n");
+    return 0;
+}
+
+int test_guard_predicates(void) {
+    printf("\n=== Test: Guard Predicates ===\n");
+
+    DispatchTable* table = dispatch_table_create(16, 1);
+    TestAgentState state = { 0 };
+    dispatch_set_state(table, &state);
+    dispatch_register(table, FREQ_INCREMENT, handle_increment, NULL);
+
+    /* value > 10 (state-free, bulk-evaluated over the run) */
+    GuardPredicate gt10 = {
+        .field_offset = offsetof(TestPayload, value),
+        .field_type = GUARD_FIELD_I32,
+        .op = GUARD_OP_GT,
+        .operand_kind = GUARD_OPERAND_CONST,
+        .constant = 10
+    };
+    if (dispatch_set_predicates(table, FREQ_INCREMENT, &gt10, 1) != DISPATCH_OK) {
+        printf("FAIL: Could not set predicates\n");
+        dispatch_table_destroy(table);
+        return 1;
+    }
+
+    SignalQueue* queue = signal_queue_create(16);
+    int values[4] = { 5, 20, 30, 1 };
+    for (int i = 0; i < 4; i++) {
+        TestPayload payload = { .value = values[i] };
+        Signal* sig = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+        signal_queue_enqueue(queue, sig);
+        signal_free(sig);
+    }
+
+    int processed = dispatch_process_queue(table, queue);
+    if (processed != 4 || state.handler_calls != 2 || state.count != 50) {
+        printf("FAIL: processed=%d calls=%d count=%d (expected 4, 2, 50)\n",
+               processed, state.handler_calls, state.count);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Run filtered by constant predicate\n");
+
+    /* value <= state.count (state operand) */
+    GuardPredicate le_count = {
+        .field_offset = offsetof(TestPayload, value),
+        .field_type = GUARD_FIELD_I32,
+        .op = GUARD_OP_LE,
+        .operand_kind = GUARD_OPERAND_STATE,
+        .state_offset = offsetof(TestAgentState, count)
+    };
+    GuardPredicate both[2] = { gt10, le_count };
+    dispatch_set_predicates(table, FREQ_INCREMENT, both, 2);
+
+    Signal* sigs[3];
+    int probe[3] = { 40, 60, 7 };
+    for (int i = 0; i < 3; i++) {
+        TestPayload payload = { .value = probe[i] };
+        sigs[i] = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+    }
+    uint8_t pass[3];
+    DispatchEntry* entry = dispatch_lookup_entry(table, FREQ_INCREMENT);
+    uint32_t passed = dispatch_filter_predicates(entry->predicates, &state, sigs, 3, pass);
+    for (int i = 0; i < 3; i++) {
+        signal_free(sigs[i]);
+    }
+    if (passed != 1 || pass[0] != 1 || pass[1] != 0 || pass[2] != 0) {
+        printf("FAIL: State predicate gave %u passing [%d %d %d]\n",
+               passed, pass[0], pass[1], pass[2]);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: State operand compared per run\n");
+
+    /* Payload too short for the field fails the predicate */
+    uint16_t tiny = 99;
+    Signal* sig = signal_create(FREQ_INCREMENT, 1, &tiny, sizeof(tiny));
+    int result = dispatch_invoke(table, sig);
+    signal_free(sig);
+    if (result != DISPATCH_ERR_GUARD_FAILED) {
+        printf("FAIL: Short payload should fail predicate, got %d\n", result);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+
+    /* Malformed predicates are rejected, count 0 removes */
+    GuardPredicate bad = gt10;
+    bad.op = 42;
+    if (dispatch_set_predicates(table, FREQ_INCREMENT, &bad, 1) != DISPATCH_ERR_INVALID_ARG) {
+        printf("FAIL: Invalid predicate accepted\n");
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    dispatch_set_predicates(table, FREQ_INCREMENT, NULL, 0);
+    TestPayload payload = { .value = 1 };
+    sig = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+    result = dispatch_invoke(table, sig);
+    signal_free(sig);
+    if (result != DISPATCH_OK || (entry->flags & DISPATCH_FLAG_HAS_PREDICATES)) {
+        printf("FAIL: Predicates not removed\n");
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Short payloads fail, invalid sets rejected, removal works\n");
+
+    signal_queue_destroy(queue);
+    dispatch_table_destroy(table);
+    return 0;
+}
+
+/* Reference result for one value, compared at the field's own width */
+static int guard_reference(int64_t value, uint8_t field_type, uint8_t op, int64_t operand) {
+    int lt, eq;
+    if (field_type == GUARD_FIELD_U64) {
+        lt = (uint64_t)value < (uint64_t)operand;
+    } else {
+        lt = value < operand;
+    }
+    eq = value == operand;
+    switch (op) {
+        case GUARD_OP_EQ: return eq;
+        case GUARD_OP_NE: return !eq;
+        case GUARD_OP_LT: return lt;
+        case GUARD_OP_LE: return lt || eq;
+        case GUARD_OP_GT: return !lt && !eq;
+        default:          return !lt;
+    }
+}
+
+int test_guard_column_compare(void) {
+    printf("\n=== Test: Guard Column Compare ===\n");
+
+    /* Payload: u8 @0, i16 @2, u32 @4, i64 @8; 37 signals covers full
+     * 16-wide steps and a tail */
+    enum { N = 37 };
+    Signal* sigs[N];
+    int64_t u8v[N], i16v[N], u32v[N], i64v[N];
+    for (int i = 0; i < N; i++) {
+        uint8_t raw[16] = { 0 };
+        uint8_t a = (uint8_t)(i * 7);
+        int16_t b = (int16_t)((i - 18) * 1000);
+        uint32_t c = (i & 1) ? 0xF0000000u + (uint32_t)i : (uint32_t)i * 3;
+        int64_t d = (int64_t)(i - 18) * ((int64_t)1 << 40);
+        memcpy(raw + 0, &a, 1);
+        memcpy(raw + 2, &b, 2);
+        memcpy(raw + 4, &c, 4);
+        memcpy(raw + 8, &d, 8);
+        u8v[i] = a; i16v[i] = b; u32v[i] = c; i64v[i] = d;
+        sigs[i] = signal_create(FREQ_INCREMENT, 1, raw, sizeof(raw));
+    }
+
+    struct { uint8_t type; uint16_t offset; const int64_t* values; } fields[] = {
+        { GUARD_FIELD_U8,  0, u8v },
+        { GUARD_FIELD_I16, 2, i16v },
+        { GUARD_FIELD_U32, 4, u32v },
+        { GUARD_FIELD_I64, 8, i64v },
+    };
+    int64_t operands[] = { -1, 0, 100, 0xF0000010LL, 5000000000LL,
+                           -3000, ((int64_t)3) << 40 };
+
+    int mismatches = 0;
+    for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+        for (size_t o = 0; o < sizeof(operands) / sizeof(operands[0]); o++) {
+            for (uint8_t op = GUARD_OP_EQ; op <= GUARD_OP_GE; op++) {
+                GuardPredicate pred = {
+                    .field_offset = fields[f].offset,
+                    .field_type = fields[f].type,
+                    .op = op,
+                    .operand_kind = GUARD_OPERAND_CONST,
+                    .constant = operands[o]
+                };
+                uint8_t set_buf[sizeof(GuardPredicateSet) + sizeof(GuardPredicate)];
+                GuardPredicateSet* set = (GuardPredicateSet*)set_buf;
+                set->count = 1;
+                set->flags = GUARD_SET_STATE_FREE;
+                set->predicates[0] = pred;
+
+                uint8_t pass[N];
+                dispatch_filter_predicates(set, NULL, sigs, N, pass);
+                for (int i = 0; i < N; i++) {
+                    int want = guard_reference(fields[f].values[i], fields[f].type,
+                                               op, operands[o]);
+                    if (pass[i] != want) {
+                        if (mismatches++ < 5) {
+                            printf("FAIL: type=%u op=%u operand=%lld value=%lld got %d\n",
+                                   fields[f].type, op, (long long)operands[o],
+                                   (long long)fields[f].values[i], pass[i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < N; i++) {
+        signal_free(sigs[i]);
+    }
+    if (mismatches != 0) {
+        return 1;
+    }
+    printf("PASS: Column compare matches per-signal reference\n");
+    return 0;
+}
+
+int test_handler_profiling(void) {
+    printf("\n=== Test: Handler Profiling ===\n");
+
+    DispatchTable* table = dispatch_table_create(4, 7);
+    TestAgentState state = { 0 };
+    dispatch_set_state(table, &state);
+    dispatch_register(table, FREQ_INCREMENT, handle_increment, NULL);
+    dispatch_register_batch(table, FREQ_DECREMENT, handle_increment_batch, NULL);
+
+    TestPayload payload = { .value = 1 };
+    Signal* sig = signal_create(FREQ_INCREMENT, 1, &payload, sizeof(payload));
+
+    /* Disabled: nothing recorded */
+    dispatch_invoke(table, sig);
+    if (dispatch_get_profile(table, FREQ_INCREMENT) != NULL) {
+        printf("FAIL: Profile recorded while disabled\n");
+        signal_free(sig);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+
+    /* Enabled: 3 single calls + one batch run of 4 */
+    dispatch_profiling_enable(1);
+    for (int i = 0; i < 3; i++) {
+        dispatch_invoke(table, sig);
+    }
+    signal_free(sig);
+
+    SignalQueue* queue = signal_queue_create(8);
+    for (int i = 0; i < 4; i++) {
+        sig = signal_create(FREQ_DECREMENT, 1, &payload, sizeof(payload));
+        signal_queue_enqueue(queue, sig);
+        signal_free(sig);
+    }
+    dispatch_process_queue(table, queue);
+    dispatch_profiling_enable(0);
+
+    const HandlerProfile* single = dispatch_get_profile(table, FREQ_INCREMENT);
+    const HandlerProfile* batch = dispatch_get_profile(table, FREQ_DECREMENT);
+    if (single == NULL || batch == NULL ||
+        single->invocations != 3 || batch->invocations != 4 ||
+        single->total_cycles == 0 || single->max_cycles == 0) {
+        printf("FAIL: Profiles not recorded correctly\n");
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+
+    uint64_t bucketed = 0;
+    for (int b = 0; b < DISPATCH_PROFILE_BUCKETS; b++) {
+        bucketed += single->histogram[b];
+    }
+    if (bucketed != 3) {
+        printf("FAIL: Histogram holds %llu samples, expected 3\n",
+               (unsigned long long)bucketed);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Calls, cycles and histogram recorded per handler\n");
+
+    /* Report lists both handlers */
+    char buffer[1024];
+    FILE* out = fmemopen(buffer, sizeof(buffer), "w");
+    int rows = dispatch_profile_report(out, 0);
+    fclose(out);
+    if (rows != 2 || strstr(buffer, "total_cycles") == NULL) {
+        printf("FAIL: Report listed %d handlers\n%s", rows, buffer);
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    printf("PASS: Report ranks handlers\n");
+
+    /* Reset clears counts; destroy unlinks the table */
+    dispatch_profile_reset();
+    if (single->invocations != 0) {
+        printf("FAIL: Reset did not clear profile\n");
+        signal_queue_destroy(queue);
+        dispatch_table_destroy(table);
+        return 1;
+    }
+    signal_queue_destroy(queue);
+    dispatch_table_destroy(table);
+
+    out = fmemopen(buffer, sizeof(buffer), "w");
+    rows = dispatch_profile_report(out, 0);
+    fclose(out);
+    if (rows != 0) {
+        printf("FAIL: Destroyed table still reported\n");
+        return 1;
+    }
+    printf("PASS: Handler profiling test\n");
+    return 0;
+}
+
 /* =============================================================================
  * MAIN
  * ============================================================================= */
@@ -635,6 +1114,11 @@ int main(void) {
     failures += test_process_queue();
     failures += test_process_batch();
     failures += test_dispatch_stats();
+    failures += test_jump_table();
+    failures += test_batch_handler();
+    failures += test_guard_predicates();
+    failures += test_guard_column_compare();
+    failures += test_handler_profiling();
 
     printf("\n==========================================\n");
     if (failures == 0) {
@@ -324,6 +324,34 @@ int test_emit_signal(void) {
     signal_free(s1);
     signal_free(s2);
 
+    /* Agent 65537 (1 + 2^16) has its own route: a 16-bit source field
+     * would send on agent 1's */
+    Agent high = { .agent_id = 65537, .input_queue = signal_queue_create(64) };
+    agent_registry_add(agents, &high);
+    uint32_t high_dest = 3;
+    routing_add_entry(table, 65537, FREQ_TEST, 1, &high_dest);
+    routing_resolve_queues(table, agents);
+
+    delivered = emit_signal(table, agents, FREQ_TEST, 65537, &value, sizeof(value));
+    Signal* rebroadcast = signal_create(FREQ_TEST, 65537, &value, sizeof(value));
+    delivered += routing_broadcast(table, rebroadcast, agents);
+    signal_free(rebroadcast);
+
+    s1 = signal_queue_dequeue(recv2.input_queue);
+    s2 = signal_queue_dequeue(recv2.input_queue);
+    if (delivered != 2 || !signal_queue_is_empty(recv1.input_queue) ||
+        s1 == NULL || s2 == NULL ||
+        signal_get_source(s1) != 65537 || signal_get_source(s2) != 65537) {
+        printf("FAIL: Agent 65537 routed as %d deliveries, sources %u/%u\n",
+               delivered, s1 ? signal_get_source(s1) : 0,
+               s2 ? signal_get_source(s2) : 0);
+        return 1;
+    }
+    signal_free(s1);
+    signal_free(s2);
+    signal_queue_destroy(high.input_queue);
+    printf("PASS: Agent IDs above 65535 route and report their own source\n");
+
     /* Cleanup */
     signal_queue_destroy(sender.input_queue);
     signal_queue_destroy(recv1.input_queue);
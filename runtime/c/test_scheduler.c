@@ -7,9 +7,14 @@
 
 #include "scheduler.h"
 #include "signal.h"
+#include "dispatch.h"
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
 
 /* Test frequency IDs */
 #define FREQ_PING 1
@@ -19,19 +24,572 @@
 #define AGENT_SENDER 0
 #define AGENT_RECEIVER 1
 
+/* Receiver state: counts handled PINGs */
+typedef struct {
+    int pings;
+} ReceiverState;
+
+/*
+ * PING handler (dispatched by the scheduler)
+ */
+int handle_ping(void* agent_state, Signal* sig) {
+    (void)sig;
+    ReceiverState* state = (ReceiverState*)agent_state;
+    state->pings++;
+    return 0;
+}
+
+/*
+ * Shared-table handler: counts the signal, fails odd payloads
+ */
+int handle_shared(void* agent_state, Signal* sig) {
+    ReceiverState* state = (ReceiverState*)agent_state;
+    uint32_t seq;
+    memcpy(&seq, signal_get_payload(sig), sizeof(seq));
+    state->pings++;
+    return (int)(seq & 1);
+}
+
+/* Pipeline stage state for the parallel test */
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t received;
+    uint32_t sent;
+    uint32_t out_of_order;
+    uint32_t next_seq[32];          /* Expected sequence per source agent */
+} StageState;
+
+/*
+ * Stage handler: check per-source order, forward a new sequence number
+ */
+int handle_stage(void* agent_state, Signal* sig) {
+    StageState* state = (StageState*)agent_state;
+    uint32_t seq;
+    memcpy(&seq, signal_get_payload(sig), sizeof(seq));
+
+    uint32_t source = sig->source_agent_id;
+    if (seq != state->next_seq[source]) {
+        state->out_of_order++;
+    }
+    state->next_seq[source] = seq + 1;
+    state->received++;
+
+    uint32_t out = state->sent++;
+    emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                &out, sizeof(out));
+    return 0;
+}
+
+/* Relay state for the ready-set test */
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t forwarded;
+} RelayState;
+
+/*
+ * Relay handler: forward every PING along this agent's route
+ */
+int handle_relay(void* agent_state, Signal* sig) {
+    (void)sig;
+    RelayState* state = (RelayState*)agent_state;
+    state->forwarded++;
+    emit_signal(state->routing, state->registry, FREQ_PING, state->id, NULL, 0);
+    return 0;
+}
+
+/* Tracing agent for the BSP determinism test */
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t received;
+    uint32_t sent;
+    uint64_t trace;                 /* Hash of (source, seq) in arrival order */
+} TraceState;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t ttl;
+} TracePayload;
+
+/*
+ * Fold the arrival into the trace, forward while the TTL lasts
+ */
+int handle_trace(void* agent_state, Signal* sig) {
+    TraceState* state = (TraceState*)agent_state;
+    TracePayload in;
+    memcpy(&in, signal_get_payload(sig), sizeof(in));
+
+    state->trace = state->trace * 1000003u ^ (((uint64_t)sig->source_agent_id << 32) | in.seq);
+    state->received++;
+
+    if (in.ttl > 0) {
+        TracePayload out = { .seq = state->sent++, .ttl = in.ttl - 1 };
+        emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                    &out, sizeof(out));
+    }
+    return 0;
+}
+
+#define BSP_AGENTS 7
+
+/*
+ * Run 1 -> {2,3,4,5} -> 6 -> 1 under the BSP scheduler with nthreads
+ *
+ * @return: Signals processed; per-agent traces/counts and cycles via out params
+ */
+static int run_bsp_network(uint32_t nthreads, uint64_t* traces, uint32_t* received,
+                           uint64_t* cycles) {
+    AgentRegistry* bsp_registry = agent_registry_create(BSP_AGENTS);
+    RoutingTable* bsp_routing = routing_table_create(16);
+    Agent agents[BSP_AGENTS];
+    TraceState states[BSP_AGENTS];
+    DispatchTable* tables[BSP_AGENTS];
+
+    for (uint32_t id = 1; id < BSP_AGENTS; id++) {
+        states[id] = (TraceState){ .routing = bsp_routing,
+                                   .registry = bsp_registry, .id = id };
+        tables[id] = dispatch_table_create(4, id);
+        dispatch_register(tables[id], FREQ_PING, handle_trace, NULL);
+        agents[id] = (Agent){ .agent_id = id, .state_ptr = &states[id],
+                              .dispatch_table = tables[id],
+                              .input_queue = signal_queue_create(1024) };
+        agent_registry_add(bsp_registry, &agents[id]);
+    }
+
+    uint32_t workers[] = { 2, 3, 4, 5 };
+    uint32_t to_join[] = { 6 };
+    uint32_t to_head[] = { 1 };
+    routing_add_entry(bsp_routing, 1, FREQ_PING, 4, workers);
+    for (uint32_t w = 0; w < 4; w++) {
+        routing_add_entry(bsp_routing, workers[w], FREQ_PING, 1, to_join);
+    }
+    routing_add_entry(bsp_routing, 6, FREQ_PING, 1, to_head);
+
+    for (uint32_t seq = 0; seq < 40; seq++) {
+        TracePayload seed = { .seq = seq, .ttl = 7 };
+        Signal* sig = signal_create(FREQ_PING, 0, &seed, sizeof(seed));
+        signal_queue_enqueue(agents[1].input_queue, sig);
+        signal_free(sig);
+    }
+
+    Scheduler* bsp = scheduler_create_bsp(bsp_registry, bsp_routing, nthreads);
+    assert(bsp != NULL);
+    scheduler_set_budget(bsp, SCHED_BUDGET_FIXED, 1, 8);
+    int processed = scheduler_run(bsp);
+    *cycles = scheduler_get_cycle_count(bsp);
+
+    for (uint32_t id = 1; id < BSP_AGENTS; id++) {
+        traces[id] = states[id].trace;
+        received[id] = states[id].received;
+        assert(signal_queue_is_empty(agents[id].input_queue));
+    }
+
+    scheduler_destroy(bsp);
+    for (uint32_t id = 1; id < BSP_AGENTS; id++) {
+        signal_queue_destroy(agents[id].input_queue);
+        dispatch_table_destroy(tables[id]);
+    }
+    routing_table_destroy(bsp_routing);
+    return processed;
+}
+
+/* External producer for the idle-policy test */
+typedef struct {
+    Scheduler* sched;
+    int signals;
+    useconds_t gap_us;
+    int close_input;                /* Close the input instead of shutting down */
+} InjectorArgs;
+
+/*
+ * Inject PINGs with gaps long enough for the scheduler to park, then stop
+ * it (or detach, letting quiescence end the run)
+ */
+static void* run_injector(void* arg) {
+    InjectorArgs* args = (InjectorArgs*)arg;
+    for (int i = 0; i < args->signals; i++) {
+        usleep(args->gap_us);
+        int rc = scheduler_inject(args->sched, AGENT_RECEIVER, FREQ_PING,
+                                  AGENT_SENDER, &i, sizeof(i));
+        assert(rc == SIGNAL_OK);
+    }
+    usleep(args->gap_us);
+    if (args->close_input) {
+        scheduler_close_input(args->sched);
+    } else {
+        scheduler_shutdown(args->sched);
+    }
+    return NULL;
+}
+
+/* Timer test state (mirrors tests/timed_handler_test.mycelial) */
+typedef struct {
+    Scheduler* sched;
+    SchedTimer* periodic;
+    SchedTimer* wall;
+    uint32_t count;
+    uint32_t fired;
+    uint64_t cycles[16];            /* Cycle of each firing, in order */
+    uint32_t periodic_fired;
+    uint32_t wall_fired;
+} TimerState;
+
+static void timer_log(TimerState* state, uint64_t cycle) {
+    if (state->fired < 16) {
+        state->cycles[state->fired] = cycle;
+    }
+    state->fired++;
+}
+
+static int on_cycle_3(void* agent_state, uint64_t cycle) {
+    TimerState* state = (TimerState*)agent_state;
+    state->count += 10;
+    timer_log(state, cycle);
+    return 0;
+}
+
+static int on_cycle_5(void* agent_state, uint64_t cycle) {
+    TimerState* state = (TimerState*)agent_state;
+    state->count += 20;
+    timer_log(state, cycle);
+    return 0;
+}
+
+static int on_cycle_log(void* agent_state, uint64_t cycle) {
+    timer_log((TimerState*)agent_state, cycle);
+    return 0;
+}
+
+/* Periodic timer that cancels itself after three firings */
+static int on_periodic(void* agent_state, uint64_t cycle) {
+    TimerState* state = (TimerState*)agent_state;
+    timer_log(state, cycle);
+    if (++state->periodic_fired == 3) {
+        scheduler_cancel_timer(state->sched, state->periodic);
+    }
+    return 0;
+}
+
+/* Periodic wall timer that stops itself and a parked scheduler after
+ * three firings */
+static int on_wall(void* agent_state, uint64_t cycle) {
+    (void)cycle;
+    TimerState* state = (TimerState*)agent_state;
+    if (++state->wall_fired == 3) {
+        scheduler_cancel_timer(state->sched, state->wall);
+        scheduler_shutdown(state->sched);
+    }
+    return 0;
+}
+
+/* Ping-pong state for the direct-call test */
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t handled;
+    uint32_t depth;                 /* Handlers of this agent on the stack */
+    uint32_t reentered;
+} BounceState;
+
 /*
- * Mock dispatch function (Phase 3 integration point)
- * For now, just acknowledges signal receipt
+ * Forward while the TTL lasts; records re-entry into a running handler
  */
-void mock_dispatch(void* agent_state, Signal* sig) {
-    printf("  [Dispatch] Agent received signal (freq=%u)\n", sig->frequency_id);
+static int handle_bounce(void* agent_state, Signal* sig) {
+    BounceState* state = (BounceState*)agent_state;
+    uint32_t ttl;
+    memcpy(&ttl, signal_get_payload(sig), sizeof(ttl));
 
-    /* In real implementation, this would:
-     * - Pattern match on frequency_id
-     * - Extract payload
-     * - Call handler function
-     * - Possibly emit new signals
-     */
+    if (++state->depth > 1) {
+        state->reentered++;
+    }
+    state->handled++;
+    if (ttl > 0) {
+        ttl--;
+        emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                    &ttl, sizeof(ttl));
+    }
+    state->depth--;
+    return 0;
+}
+
+/* Offload test: the writer's blocking handler waits for the ticker, which
+ * only makes progress if the scheduler keeps running meanwhile */
+static int g_ticker_done;
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t log[8];                /* Payloads in handling order */
+    uint32_t logged;
+    uint32_t saw_ticker;            /* Blocking calls that saw the ticker finish */
+} WriterState;
+
+static int handle_log(void* agent_state, Signal* sig) {
+    WriterState* state = (WriterState*)agent_state;
+    uint32_t value;
+    memcpy(&value, signal_get_payload(sig), sizeof(value));
+    if (state->logged < 8) {
+        state->log[state->logged] = value;
+    }
+    state->logged++;
+    return 0;
+}
+
+/*
+ * Blocking handler: waits (bounded) for the ticker, logs, emits a result
+ */
+static int handle_blocking_write(void* agent_state, Signal* sig) {
+    WriterState* state = (WriterState*)agent_state;
+    for (int i = 0; i < 2000 && !__atomic_load_n(&g_ticker_done, __ATOMIC_ACQUIRE); i++) {
+        usleep(1000);
+    }
+    if (__atomic_load_n(&g_ticker_done, __ATOMIC_ACQUIRE)) {
+        state->saw_ticker++;
+    }
+    handle_log(agent_state, sig);
+    uint32_t done = 1;
+    emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                &done, sizeof(done));
+    return 0;
+}
+
+/*
+ * Re-emit to itself while the TTL lasts, then release the writer
+ */
+static int handle_tick(void* agent_state, Signal* sig) {
+    BounceState* state = (BounceState*)agent_state;
+    uint32_t ttl;
+    memcpy(&ttl, signal_get_payload(sig), sizeof(ttl));
+    state->handled++;
+    if (ttl == 0) {
+        __atomic_store_n(&g_ticker_done, 1, __ATOMIC_RELEASE);
+        return 0;
+    }
+    ttl--;
+    emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                &ttl, sizeof(ttl));
+    return 0;
+}
+
+/* Coroutine test: the orchestrator protocol from tests/ as straight-line
+ * code, next to a plain handler on the same agent */
+#define FREQ_LEX_DONE   10
+#define FREQ_PARSE_DONE 11
+#define FREQ_LINK_DONE  12
+#define FREQ_STATUS     13
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t id;
+    uint32_t builds;                /* Full lex -> parse -> link rounds */
+    uint32_t statuses;              /* STATUS signals (plain handler) */
+    uint32_t strays;                /* PARSE/LINK handled by the table */
+    uint32_t steps[16];             /* Frequencies seen by the coroutine */
+    uint32_t step_count;
+    int cancelled;
+} OrchestratorState;
+
+static int handle_status(void* agent_state, Signal* sig) {
+    (void)sig;
+    ((OrchestratorState*)agent_state)->statuses++;
+    return 0;
+}
+
+static int handle_stray(void* agent_state, Signal* sig) {
+    (void)sig;
+    ((OrchestratorState*)agent_state)->strays++;
+    return 0;
+}
+
+static void orchestrator_step(OrchestratorState* state, Signal* sig) {
+    if (state->step_count < 16) {
+        state->steps[state->step_count] = sig->frequency_id;
+    }
+    state->step_count++;
+}
+
+static int orchestrate(void* agent_state, AgentCoroutine* coro) {
+    OrchestratorState* state = (OrchestratorState*)agent_state;
+    for (;;) {
+        Signal* sig = coroutine_await(coro, FREQ_LEX_DONE);
+        if (sig == NULL) {
+            break;
+        }
+        orchestrator_step(state, sig);
+
+        /* Either may finish first; wait for both */
+        static const uint32_t later[2] = { FREQ_PARSE_DONE, FREQ_LINK_DONE };
+        uint32_t seen = 0;
+        while (seen != 3) {
+            sig = coroutine_await_any(coro, later, 2);
+            if (sig == NULL) {
+                state->cancelled = 1;
+                return 0;
+            }
+            orchestrator_step(state, sig);
+            seen |= (sig->frequency_id == FREQ_PARSE_DONE) ? 1 : 2;
+        }
+
+        state->builds++;
+        emit_signal(state->routing, state->registry, FREQ_PING, state->id,
+                    &state->builds, sizeof(state->builds));
+        if (state->builds == 3) {
+            return 0;
+        }
+    }
+    state->cancelled = 1;
+    return 0;
+}
+
+/* Scheduling-class test: every handler appends its agent ID to one log */
+typedef struct {
+    uint32_t id;
+    uint32_t* log;
+    uint32_t* log_count;
+} ClassState;
+
+static int handle_class_log(void* agent_state, Signal* sig) {
+    (void)sig;
+    ClassState* state = (ClassState*)agent_state;
+    if (*state->log_count < 64) {
+        state->log[*state->log_count] = state->id;
+    }
+    (*state->log_count)++;
+    return 0;
+}
+
+/* Fair-share test: handlers that burn a fixed amount of CPU */
+typedef struct {
+    uint64_t spin_ns;
+    uint32_t handled;
+} FairWorkState;
+
+static int handle_fair_work(void* agent_state, Signal* sig) {
+    (void)sig;
+    FairWorkState* state = (FairWorkState*)agent_state;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t start = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    uint64_t now = start;
+    while (now - start < state->spin_ns) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        now = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    }
+    state->handled++;
+    return 0;
+}
+
+/* Prefetch test: every handler folds its agent ID into one trace */
+typedef struct {
+    uint32_t id;
+    uint64_t* trace;
+    uint32_t* handled;
+} SweepState;
+
+static int handle_sweep(void* agent_state, Signal* sig) {
+    (void)sig;
+    SweepState* state = (SweepState*)agent_state;
+    *state->trace = (*state->trace ^ state->id) * 1099511628211ULL;
+    (*state->handled)++;
+    return 0;
+}
+
+/* Pool test: PING folds its sequence number into a column, PONG forwards
+ * to the sink through the instance's own route */
+#define POOL_FIRST      2
+#define POOL_INSTANCES  200
+#define POOL_SINK       1
+
+typedef struct {
+    RoutingTable* routing;
+    AgentRegistry* registry;
+    uint32_t calls;                 /* Handler invocations (atomic) */
+    uint32_t unordered;             /* Batches with descending instances */
+    uint32_t out_of_order;          /* Signals not in their instance's FIFO order */
+    uint32_t largest;               /* Largest batch */
+} PoolTestContext;
+
+enum { POOL_COL_SUM, POOL_COL_SEQ };
+
+static void pool_check_batch(AgentPool* pool, const uint32_t* instances,
+                             Signal* const* signals, uint32_t count) {
+    PoolTestContext* ctx = (PoolTestContext*)pool->context;
+    uint32_t* last_seq = (uint32_t*)agent_pool_column(pool, POOL_COL_SEQ);
+    __atomic_fetch_add(&ctx->calls, 1, __ATOMIC_RELAXED);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq;
+        memcpy(&seq, signal_get_payload(signals[i]), sizeof(seq));
+        if (seq != last_seq[instances[i]] + 1) {
+            __atomic_fetch_add(&ctx->out_of_order, 1, __ATOMIC_RELAXED);
+        }
+        last_seq[instances[i]] = seq;
+        if (i > 0 && instances[i] <= instances[i - 1]) {
+            __atomic_fetch_add(&ctx->unordered, 1, __ATOMIC_RELAXED);
+        }
+    }
+    uint32_t largest = __atomic_load_n(&ctx->largest, __ATOMIC_RELAXED);
+    while (count > largest &&
+           !__atomic_compare_exchange_n(&ctx->largest, &largest, count, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static int pool_ping(AgentPool* pool, const uint32_t* instances,
+                     Signal* const* signals, uint32_t count) {
+    pool_check_batch(pool, instances, signals, count);
+    uint64_t* sum = (uint64_t*)agent_pool_column(pool, POOL_COL_SUM);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t seq;
+        memcpy(&seq, signal_get_payload(signals[i]), sizeof(seq));
+        sum[instances[i]] += seq;
+    }
+    return 0;
+}
+
+static int pool_pong(AgentPool* pool, const uint32_t* instances,
+                     Signal* const* signals, uint32_t count) {
+    pool_check_batch(pool, instances, signals, count);
+    PoolTestContext* ctx = (PoolTestContext*)pool->context;
+    for (uint32_t i = 0; i < count; i++) {
+        emit_signal(ctx->routing, ctx->registry, FREQ_PING, pool->first_id + instances[i],
+                    NULL, 0);
+    }
+    return 0;
+}
+
+/*
+ * Queue one signal with a sequence number
+ */
+static void enqueue_seq(Agent* agent, uint32_t frequency_id, uint32_t seq) {
+    Signal* sig = signal_create(frequency_id, 0, &seq, sizeof(seq));
+    assert(sig != NULL);
+    assert(signal_queue_enqueue(agent->input_queue, sig) == SIGNAL_OK);
+    signal_free(sig);
+}
+
+/*
+ * Enqueue n PING signals to an agent
+ */
+static void enqueue_pings(Agent* agent, int n) {
+    for (int i = 0; i < n; i++) {
+        Signal* sig = signal_alloc();
+        assert(sig != NULL);
+
+        sig->frequency_id = FREQ_PING;
+        sig->source_agent_id = AGENT_SENDER;
+        sig->ref_count = 1;
+
+        int enqueue_result = signal_queue_enqueue(agent->input_queue, sig);
+        assert(enqueue_result == 0);
+    }
 }
 
 int main(void) {
@@ -64,6 +622,12 @@ int main(void) {
     assert(routing != NULL);
     printf("✓ Routing table created\n");
 
+    /* Receiver dispatches PING to handle_ping */
+    ReceiverState receiver_state = { 0 };
+    DispatchTable* receiver_dispatch = dispatch_table_create(4, AGENT_RECEIVER);
+    assert(receiver_dispatch != NULL);
+    dispatch_register(receiver_dispatch, FREQ_PING, handle_ping, NULL);
+
     /* Register agents */
     Agent sender_agent = {
         .agent_id = AGENT_SENDER,
@@ -76,9 +640,9 @@ int main(void) {
     Agent receiver_agent = {
         .agent_id = AGENT_RECEIVER,
         .agent_type = 2,
-        .state_ptr = NULL,
-        .dispatch_table = NULL,
-        .input_queue = signal_queue_create(16)
+        .state_ptr = &receiver_state,
+        .dispatch_table = receiver_dispatch,
+        .input_queue = signal_queue_create(64)
     };
 
     agent_registry_add(registry, &sender_agent);
@@ -118,31 +682,52 @@ int main(void) {
     printf("=== Test 3: Signal Processing ===\n");
 
     /* Create and enqueue signals */
-    for (int i = 0; i < 5; i++) {
-        Signal* sig = signal_alloc();
-        assert(sig != NULL);
-
-        sig->frequency_id = FREQ_PING;
-        sig->source_agent_id = AGENT_SENDER;
-        sig->ref_count = 1;
-
-        /* Enqueue to receiver's input queue */
-        int enqueue_result = signal_queue_enqueue(receiver_agent.input_queue, sig);
-        assert(enqueue_result == 0);
-    }
+    enqueue_pings(&receiver_agent, 5);
     printf("✓ Enqueued 5 PING signals to receiver\n");
 
-    /* Run one cycle - should process 1 signal (fair scheduling) */
+    /* Run one cycle - default budget drains all 5 through dispatch */
     processed = scheduler_run_cycle(sched);
-    printf("✓ Cycle processed %d signals\n", processed);
-    if (processed != 1) {
-        printf("  Note: Expected 1 signal, got %d\n", processed);
-    }
+    assert(processed == 5);
+    assert(receiver_state.pings == 5);
+    printf("✓ Cycle dispatched %d signals to handle_ping\n", processed);
 
     uint64_t total_processed = scheduler_get_signals_processed(sched);
     printf("✓ Total signals processed: %lu\n", total_processed);
     printf("\n");
 
+    /* =========================================================================
+     * TEST 3b: Drain Budgets
+     * ========================================================================= */
+
+    printf("=== Test 3b: Drain Budgets ===\n");
+
+    /* Fixed budget of 2: 5 signals take 3 cycles */
+    scheduler_set_budget(sched, SCHED_BUDGET_FIXED, 1, 2);
+    enqueue_pings(&receiver_agent, 5);
+    assert(scheduler_run_cycle(sched) == 2);
+    assert(scheduler_run_cycle(sched) == 2);
+    assert(scheduler_run_cycle(sched) == 1);
+    printf("✓ Fixed budget drains 2 signals per cycle\n");
+
+    /* Adaptive: depth 40 -> 10, depth 30 -> 7 (clamped to [4, 16]) */
+    scheduler_set_budget(sched, SCHED_BUDGET_ADAPTIVE, 4, 16);
+    enqueue_pings(&receiver_agent, 40);
+    assert(scheduler_run_cycle(sched) == 10);
+    assert(scheduler_run_cycle(sched) == 7);
+    printf("✓ Adaptive budget scales with queue depth\n");
+
+    /* Fairness: both agents get a turn every cycle */
+    enqueue_pings(&sender_agent, 3);
+    scheduler_set_budget(sched, SCHED_BUDGET_FIXED, 1, 4);
+    processed = scheduler_run_cycle(sched);
+    assert(processed == 3 + 4);
+    assert(signal_queue_is_empty(sender_agent.input_queue));
+    printf("✓ Each agent drains within its own budget per cycle\n");
+
+    scheduler_set_budget(sched, SCHED_BUDGET_FIXED,
+                         SCHED_DEFAULT_BUDGET_MIN, SCHED_DEFAULT_BUDGET_MAX);
+    printf("\n");
+
     /* =========================================================================
      * TEST 4: Multiple Cycle Execution
      * ========================================================================= */
@@ -154,11 +739,9 @@ int main(void) {
     printf("✓ Ran 10 cycles, processed %d signals total\n", total_in_batch);
 
     /* Check queue status */
-    if (signal_queue_is_empty(receiver_agent.input_queue)) {
-        printf("✓ Receiver queue is now empty\n");
-    } else {
-        printf("  Note: Receiver queue still has signals\n");
-    }
+    assert(signal_queue_is_empty(receiver_agent.input_queue));
+    assert(receiver_state.pings == 50);
+    printf("✓ Receiver queue is now empty\n");
 
     uint64_t final_cycles = scheduler_get_cycle_count(sched);
     printf("✓ Total cycles run: %lu\n", final_cycles);
@@ -187,6 +770,1268 @@ int main(void) {
     printf("✓ Scheduler exited gracefully (processed %d signals)\n", shutdown_processed);
     printf("\n");
 
+    /* =========================================================================
+     * TEST 7: Parallel Work-Stealing Scheduler
+     * ========================================================================= */
+
+    printf("=== Test 7: Parallel Work-Stealing Scheduler ===\n");
+
+    /* Diamond: 1 -> {2, 3} -> 4 (agent 0 unused: source 0 has no routes) */
+    #define STAGES 5
+    #define STAGE_SIGNALS 1000
+    AgentRegistry* par_registry = agent_registry_create(STAGES);
+    RoutingTable* par_routing = routing_table_create(16);
+    Agent stages[STAGES];
+    StageState stage_state[STAGES];
+    DispatchTable* stage_dispatch[STAGES];
+
+    for (uint32_t id = 1; id < STAGES; id++) {
+        stage_state[id] = (StageState){ .routing = par_routing,
+                                        .registry = par_registry, .id = id };
+        stage_dispatch[id] = dispatch_table_create(4, id);
+        dispatch_register(stage_dispatch[id], FREQ_PING, handle_stage, NULL);
+        stages[id] = (Agent){ .agent_id = id, .state_ptr = &stage_state[id],
+                              .dispatch_table = stage_dispatch[id],
+                              .input_queue = signal_queue_create(4096) };
+        agent_registry_add(par_registry, &stages[id]);
+    }
+
+    uint32_t fan_out[] = { 2, 3 };
+    uint32_t to_sink[] = { 4 };
+    routing_add_entry(par_routing, 1, FREQ_PING, 2, fan_out);
+    routing_add_entry(par_routing, 2, FREQ_PING, 1, to_sink);
+    routing_add_entry(par_routing, 3, FREQ_PING, 1, to_sink);
+
+    for (uint32_t seq = 0; seq < STAGE_SIGNALS; seq++) {
+        Signal* sig = signal_create(FREQ_PING, 0, &seq, sizeof(seq));
+        signal_queue_enqueue(stages[1].input_queue, sig);
+        signal_free(sig);
+    }
+
+    Scheduler* par = scheduler_create_parallel(par_registry, par_routing, 4);
+    assert(par != NULL);
+    scheduler_set_budget(par, SCHED_BUDGET_FIXED, 1, 8);
+
+    int par_processed = scheduler_run(par);
+    assert(par_processed == STAGE_SIGNALS * 5);
+    assert(stage_state[4].received == STAGE_SIGNALS * 2);
+    for (uint32_t id = 1; id < STAGES; id++) {
+        assert(stage_state[id].out_of_order == 0);
+        assert(signal_queue_is_empty(stages[id].input_queue));
+    }
+    printf("✓ 4 workers processed %d signals, per-source order preserved\n",
+           par_processed);
+
+    SchedulerStats par_stats;
+    scheduler_get_stats(par, &par_stats);
+    assert(par_stats.threads == 4);
+    printf("✓ %lu agent runs, %lu steals\n", par_stats.agent_runs, par_stats.steals);
+
+    scheduler_destroy(par);
+    for (uint32_t id = 1; id < STAGES; id++) {
+        signal_queue_destroy(stages[id].input_queue);
+        dispatch_table_destroy(stage_dispatch[id]);
+    }
+    routing_table_destroy(par_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 8: Ready Set Skips Idle Agents
+     * ========================================================================= */
+
+    printf("=== Test 8: Ready Set Skips Idle Agents ===\n");
+
+    /* 1000 agents, only relays 10 and 900 get input:
+     *   10 -> 700 (higher ID: handled in the same cycle)
+     *   900 -> 5  (lower ID: handled next cycle) */
+    #define READY_AGENTS 1000
+    AgentRegistry* ready_registry = agent_registry_create(READY_AGENTS);
+    RoutingTable* ready_routing = routing_table_create(4);
+    Agent* ready_agents = heap_allocate(READY_AGENTS * sizeof(Agent));
+    assert(ready_registry != NULL && ready_routing != NULL && ready_agents != NULL);
+
+    RelayState relay_state[2] = {
+        { .routing = ready_routing, .registry = ready_registry, .id = 10 },
+        { .routing = ready_routing, .registry = ready_registry, .id = 900 },
+    };
+    ReceiverState sink_state[2] = { { 0 }, { 0 } };
+    DispatchTable* relay_dispatch = dispatch_table_create(4, 10);
+    DispatchTable* sink_dispatch = dispatch_table_create(4, 5);
+    dispatch_register(relay_dispatch, FREQ_PING, handle_relay, NULL);
+    dispatch_register(sink_dispatch, FREQ_PING, handle_ping, NULL);
+
+    for (uint32_t id = 1; id < READY_AGENTS; id++) {
+        ready_agents[id] = (Agent){ .agent_id = id,
+                                    .input_queue = signal_queue_create(4) };
+        assert(ready_agents[id].input_queue != NULL);
+        agent_registry_add(ready_registry, &ready_agents[id]);
+    }
+    ready_agents[10].state_ptr = &relay_state[0];
+    ready_agents[10].dispatch_table = relay_dispatch;
+    ready_agents[900].state_ptr = &relay_state[1];
+    ready_agents[900].dispatch_table = relay_dispatch;
+    ready_agents[700].state_ptr = &sink_state[0];
+    ready_agents[700].dispatch_table = sink_dispatch;
+    ready_agents[5].state_ptr = &sink_state[1];
+    ready_agents[5].dispatch_table = sink_dispatch;
+
+    uint32_t to_high[] = { 700 };
+    uint32_t to_low[] = { 5 };
+    routing_add_entry(ready_routing, 10, FREQ_PING, 1, to_high);
+    routing_add_entry(ready_routing, 900, FREQ_PING, 1, to_low);
+
+    Scheduler* ready = scheduler_create(ready_registry, ready_routing);
+    assert(ready != NULL);
+
+    enqueue_pings(&ready_agents[10], 1);
+    enqueue_pings(&ready_agents[900], 1);
+
+    assert(scheduler_run_cycle(ready) == 3);
+    assert(sink_state[0].pings == 1);
+    assert(sink_state[1].pings == 0);
+    assert(!signal_queue_is_empty(ready_agents[5].input_queue));
+    printf("✓ Cycle 1: relays and higher-ID sink ran, lower-ID sink deferred\n");
+
+    assert(scheduler_run_cycle(ready) == 1);
+    assert(sink_state[1].pings == 1);
+    assert(scheduler_run_cycle(ready) == 0);
+
+    SchedulerStats ready_stats;
+    scheduler_get_stats(ready, &ready_stats);
+    assert(ready_stats.agents_active == 4);
+    printf("✓ %lu agent turns over 3 cycles for %u registered agents\n",
+           ready_stats.agents_active, READY_AGENTS - 1);
+
+    /* An agent added later into an empty slot is picked up */
+    ready_agents[0] = (Agent){ .agent_id = 0, .state_ptr = &sink_state[1],
+                               .dispatch_table = sink_dispatch,
+                               .input_queue = signal_queue_create(4) };
+    enqueue_pings(&ready_agents[0], 2);
+    agent_registry_add(ready_registry, &ready_agents[0]);
+    assert(scheduler_run_cycle(ready) == 2);
+    assert(sink_state[1].pings == 3);
+    printf("✓ Agent registered after the first cycle is scheduled\n");
+
+    scheduler_destroy(ready);
+    for (uint32_t id = 0; id < READY_AGENTS; id++) {
+        signal_queue_destroy(ready_agents[id].input_queue);
+    }
+    dispatch_table_destroy(relay_dispatch);
+    dispatch_table_destroy(sink_dispatch);
+    routing_table_destroy(ready_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 9: Idle Policy & External Input
+     * ========================================================================= */
+
+    printf("=== Test 9: Idle Policy & External Input ===\n");
+
+    Scheduler* idle = scheduler_create(registry, routing);
+    assert(idle != NULL);
+
+    uint8_t big[SCHED_INBOX_PAYLOAD_MAX + 1] = { 0 };
+    assert(scheduler_inject(idle, AGENT_RECEIVER, FREQ_PING, AGENT_SENDER,
+                            big, sizeof(big)) == SIGNAL_ERR_PAYLOAD_TOO_LARGE);
+
+    /* Default policy: injected signals run, then the scheduler exits */
+    int pings_before = receiver_state.pings;
+    assert(scheduler_inject(idle, AGENT_RECEIVER, FREQ_PING, AGENT_SENDER, NULL, 0) == SIGNAL_OK);
+    assert(scheduler_run(idle) == 1);
+    assert(receiver_state.pings == pings_before + 1);
+    printf("✓ Injected signal delivered, exit-on-idle preserved\n");
+
+    /* Park policy: waits for the producer thread until shutdown */
+    scheduler_set_idle_policy(idle, SCHED_IDLE_PARK, 16, 16);
+    pings_before = receiver_state.pings;
+
+    InjectorArgs injector = { .sched = idle, .signals = 3, .gap_us = 20000 };
+    pthread_t injector_thread;
+    assert(pthread_create(&injector_thread, NULL, run_injector, &injector) == 0);
+    scheduler_run(idle);
+    pthread_join(injector_thread, NULL);
+
+    assert(receiver_state.pings == pings_before + 3);
+    SchedulerStats idle_stats;
+    scheduler_get_stats(idle, &idle_stats);
+    assert(idle_stats.idle_parks >= 1);
+    assert(idle_stats.wakeups == 3);
+    assert(idle_stats.idle_cpu_ns < idle_stats.idle_wall_ns);
+    printf("✓ Parked %lu times, %lu wake-ups (avg %lu ns)\n",
+           idle_stats.idle_parks, idle_stats.wakeups, idle_stats.wake_latency_avg_ns);
+
+    scheduler_print_stats(idle);
+    scheduler_destroy(idle);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 10: Deterministic BSP Cycles
+     * ========================================================================= */
+
+    printf("=== Test 10: Deterministic BSP Cycles ===\n");
+
+    uint64_t ref_traces[BSP_AGENTS], ref_cycles;
+    uint32_t ref_received[BSP_AGENTS];
+    int ref_processed = run_bsp_network(1, ref_traces, ref_received, &ref_cycles);
+
+    /* Every worker sees every broadcast from the head */
+    assert(ref_processed > 40);
+    for (uint32_t id = 3; id <= 5; id++) {
+        assert(ref_received[id] == ref_received[2]);
+    }
+    printf("✓ 1 thread: %d signals in %lu cycles\n", ref_processed, ref_cycles);
+
+    uint32_t thread_counts[] = { 2, 4 };
+    for (uint32_t t = 0; t < 2; t++) {
+        uint64_t traces[BSP_AGENTS], cycles;
+        uint32_t received[BSP_AGENTS];
+        int processed = run_bsp_network(thread_counts[t], traces, received, &cycles);
+
+        assert(processed == ref_processed);
+        assert(cycles == ref_cycles);
+        for (uint32_t id = 1; id < BSP_AGENTS; id++) {
+            assert(received[id] == ref_received[id]);
+            assert(traces[id] == ref_traces[id]);
+        }
+        printf("✓ %u threads: identical arrival order at every agent\n",
+               thread_counts[t]);
+    }
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 11: Timers
+     * ========================================================================= */
+
+    printf("=== Test 11: Timers ===\n");
+
+    AgentRegistry* timer_registry = agent_registry_create(2);
+    RoutingTable* timer_routing = routing_table_create(4);
+    TimerState timer_state = { 0 };
+    Agent timer_agent = { .agent_id = 1, .state_ptr = &timer_state,
+                          .input_queue = signal_queue_create(4) };
+    assert(timer_registry != NULL && timer_routing != NULL);
+    agent_registry_add(timer_registry, &timer_agent);
+
+    Scheduler* timed = scheduler_create(timer_registry, timer_routing);
+    assert(timed != NULL);
+    timer_state.sched = timed;
+
+    /* on cycle 3 / 5 / 10, a periodic timer at 2, 6, 10 (self-cancelled),
+     * one cancelled up front, and far timers that cascade down the wheel */
+    assert(scheduler_add_timer(timed, 1, 10, 0, on_cycle_log) != NULL);
+    assert(scheduler_add_timer(timed, 1, 5, 0, on_cycle_5) != NULL);
+    assert(scheduler_add_timer(timed, 1, 3, 0, on_cycle_3) != NULL);
+    timer_state.periodic = scheduler_add_timer(timed, 1, 2, 4, on_periodic);
+    assert(timer_state.periodic != NULL);
+    SchedTimer* cancelled = scheduler_add_timer(timed, 1, 7, 0, on_cycle_log);
+    assert(scheduler_cancel_timer(timed, cancelled) == SIGNAL_OK);
+    assert(scheduler_add_timer(timed, 1, 5000, 0, on_cycle_log) != NULL);
+    assert(scheduler_add_timer(timed, 1, 300000, 0, on_cycle_log) != NULL);
+    assert(scheduler_cycle_timers_pending(timed) == 6);
+
+    /* No signals at all: pending timers keep the cycles coming */
+    assert(scheduler_run(timed) == 0);
+
+    uint64_t expected_cycles[] = { 2, 3, 5, 6, 10, 10, 5000, 300000 };
+    assert(timer_state.fired == 8);
+    for (uint32_t i = 0; i < 8; i++) {
+        assert(timer_state.cycles[i] == expected_cycles[i]);
+    }
+    assert(timer_state.count == 30);
+    assert(scheduler_cycle_timers_pending(timed) == 0);
+    SchedulerStats timer_stats;
+    scheduler_get_stats(timed, &timer_stats);
+    assert(timer_stats.timers_fired == 8);
+    printf("✓ Cycle timers fired at 2, 3, 5, 6, 10, 10, 5000, 300000\n");
+
+    /* Wall timers: parked scheduler wakes for each deadline */
+    scheduler_set_idle_policy(timed, SCHED_IDLE_PARK, 4, 4);
+    timer_state.wall = scheduler_add_wall_timer(timed, 1, 2000000, 2000000, on_wall);
+    assert(timer_state.wall != NULL);
+    scheduler_run(timed);
+    assert(timer_state.wall_fired == 3);
+    scheduler_get_stats(timed, &timer_stats);
+    assert(timer_stats.idle_parks >= 2);
+    printf("✓ Periodic wall timer woke a parked scheduler 3 times\n");
+
+    /* Exit mode waits for a pending wall timer before finishing */
+    scheduler_set_idle_policy(timed, SCHED_IDLE_EXIT, 0, 0);
+    timed->running = 1;
+    uint32_t wall_before = timer_state.fired;
+    assert(scheduler_add_wall_timer(timed, 1, 3000000, 0, on_cycle_log) != NULL);
+    scheduler_run(timed);
+    assert(timer_state.fired == wall_before + 1);
+    printf("✓ Exit-on-idle waits for pending wall timers\n");
+
+    /* Destroy with timers still pending */
+    assert(scheduler_add_timer(timed, 1, UINT64_MAX / 2, 0, on_cycle_log) != NULL);
+    scheduler_destroy(timed);
+    signal_queue_destroy(timer_agent.input_queue);
+    routing_table_destroy(timer_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 12: Quiescence
+     * ========================================================================= */
+
+    printf("=== Test 12: Quiescence ===\n");
+
+    /* The run ends on the cycle that handles the last signal */
+    Scheduler* quiet = scheduler_create(registry, routing);
+    assert(quiet != NULL);
+    enqueue_pings(&receiver_agent, 5);
+    assert(scheduler_run(quiet) == 5);
+    assert(scheduler_get_cycle_count(quiet) == 1);
+    scheduler_destroy(quiet);
+    printf("✓ Exited after 1 cycle, no empty sweeps\n");
+
+    /* A slow producer keeps the network alive until it closes its input */
+    const char* quiet_names[] = { "sequential", "work-stealing", "BSP" };
+    for (int mode = 0; mode < 3; mode++) {
+        quiet = (mode == 0) ? scheduler_create(registry, routing)
+              : (mode == 1) ? scheduler_create_parallel(registry, routing, 2)
+                            : scheduler_create_bsp(registry, routing, 2);
+        assert(quiet != NULL);
+        pings_before = receiver_state.pings;
+
+        assert(scheduler_open_input(quiet) == SIGNAL_OK);
+        InjectorArgs slow = { .sched = quiet, .signals = 3, .gap_us = 10000,
+                              .close_input = 1 };
+        assert(pthread_create(&injector_thread, NULL, run_injector, &slow) == 0);
+        assert(scheduler_run(quiet) == 3);
+        pthread_join(injector_thread, NULL);
+
+        assert(receiver_state.pings == pings_before + 3);
+        scheduler_destroy(quiet);
+        printf("✓ %s: waited for an open input, exited once it closed\n",
+               quiet_names[mode]);
+    }
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 13: Direct Routes
+     * ========================================================================= */
+
+    printf("=== Test 13: Direct Routes ===\n");
+
+    /* Chain 1 -> 2 -> ... -> 16, every route direct. Agent 5 already has a
+     * queued signal, so 4 -> 5 must queue (no overtaking); the direct run
+     * from 5 hits the depth limit at 13 -> 14 */
+    #define CHAIN 17
+    AgentRegistry* chain_registry = agent_registry_create(CHAIN);
+    RoutingTable* chain_routing = routing_table_create(64);
+    Agent chain[CHAIN];
+    StageState chain_state[CHAIN];
+    DispatchTable* chain_dispatch[CHAIN];
+    for (uint32_t id = 1; id < CHAIN; id++) {
+        chain_state[id] = (StageState){ .routing = chain_routing,
+                                        .registry = chain_registry, .id = id };
+        chain_dispatch[id] = dispatch_table_create(4, id);
+        dispatch_register(chain_dispatch[id], FREQ_PING, handle_stage, NULL);
+        chain[id] = (Agent){ .agent_id = id, .state_ptr = &chain_state[id],
+                             .dispatch_table = chain_dispatch[id],
+                             .input_queue = signal_queue_create(16) };
+        agent_registry_add(chain_registry, &chain[id]);
+        if (id + 1 < CHAIN) {
+            uint32_t next = id + 1;
+            routing_add_entry(chain_routing, id, FREQ_PING, 1, &next);
+            assert(routing_set_direct(chain_routing, id, FREQ_PING, 1) == SIGNAL_OK);
+        }
+    }
+    assert(routing_set_direct(chain_routing, 16, FREQ_PING, 1) == SIGNAL_ERR_NO_ROUTE);
+
+    for (uint32_t seq = 0; seq < 3; seq++) {
+        Signal* sig = signal_create(FREQ_PING, 0, &seq, sizeof(seq));
+        signal_queue_enqueue(chain[1].input_queue, sig);
+        signal_free(sig);
+    }
+    uint32_t seed = 0;
+    Signal* early = signal_create(FREQ_PING, 0, &seed, sizeof(seed));
+    signal_queue_enqueue(chain[5].input_queue, early);
+    signal_free(early);
+
+    Scheduler* direct = scheduler_create(chain_registry, chain_routing);
+    assert(direct != NULL);
+
+    /* Only agents 1, 5 and 14 ever dispatch from a queue, but inline runs
+     * count as processed: 3 signals through 16 stages, the seed through 12 */
+    assert(scheduler_run(direct) == 3 * 16 + 12);
+    assert(scheduler_get_cycle_count(direct) == 1);
+    assert(chain_state[16].received == 4);
+    for (uint32_t id = 1; id < CHAIN; id++) {
+        assert(chain_state[id].out_of_order == 0);
+        assert(signal_queue_is_empty(chain[id].input_queue));
+    }
+
+    RouteEdgeStats edge;
+    routing_get_edge_stats(chain_routing, 1, FREQ_PING, 0, &edge);
+    assert(edge.direct_calls == 3 && edge.signals_delivered == 3);
+    routing_get_edge_stats(chain_routing, 4, FREQ_PING, 0, &edge);
+    assert(edge.direct_calls == 0 && edge.signals_delivered == 3);
+    routing_get_edge_stats(chain_routing, 12, FREQ_PING, 0, &edge);
+    assert(edge.direct_calls == 4);
+    routing_get_edge_stats(chain_routing, 13, FREQ_PING, 0, &edge);
+    assert(edge.direct_calls == 0 && edge.signals_delivered == 4);
+    routing_get_edge_stats(chain_routing, 14, FREQ_PING, 0, &edge);
+    assert(edge.direct_calls == 4);
+    printf("✓ 16-stage chain in 1 cycle, queued behind a backlog and past depth %d\n",
+           ROUTE_DIRECT_MAX_DEPTH);
+    scheduler_destroy(direct);
+
+    /* Ping-pong 1 <-> 2: the reply to a running agent is queued, never
+     * re-entered */
+    AgentRegistry* pong_registry = agent_registry_create(3);
+    RoutingTable* pong_routing = routing_table_create(8);
+    BounceState bounce[3];
+    Agent pong_agents[3];
+    DispatchTable* bounce_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(bounce_dispatch, FREQ_PING, handle_bounce, NULL);
+    for (uint32_t id = 1; id <= 2; id++) {
+        bounce[id] = (BounceState){ .routing = pong_routing,
+                                    .registry = pong_registry, .id = id };
+        pong_agents[id] = (Agent){ .agent_id = id, .state_ptr = &bounce[id],
+                                   .dispatch_table = bounce_dispatch,
+                                   .input_queue = signal_queue_create(4) };
+        agent_registry_add(pong_registry, &pong_agents[id]);
+        uint32_t other = 3 - id;
+        routing_add_entry(pong_routing, id, FREQ_PING, 1, &other);
+        routing_set_direct(pong_routing, id, FREQ_PING, 1);
+    }
+    uint32_t ttl = 4;
+    Signal* serve = signal_create(FREQ_PING, 0, &ttl, sizeof(ttl));
+    signal_queue_enqueue(pong_agents[1].input_queue, serve);
+    signal_free(serve);
+
+    Scheduler* pong = scheduler_create(pong_registry, pong_routing);
+    assert(pong != NULL);
+    assert(scheduler_run(pong) == 5);
+    assert(bounce[1].handled == 3 && bounce[2].handled == 2);
+    assert(bounce[1].reentered == 0 && bounce[2].reentered == 0);
+    printf("✓ Ping-pong: replies to a running agent are queued, not re-entered\n");
+    scheduler_destroy(pong);
+
+    /* Same workload queued and direct: 1 -> 2 -> 3, agent 3 has no handler
+     * for the frequency, so every delivery to it is a dispatch error */
+    AgentRegistry* same_registry = agent_registry_create(4);
+    RoutingTable* same_routing = routing_table_create(8);
+    Agent same[4];
+    StageState same_state[4];
+    DispatchTable* same_dispatch[4];
+    for (uint32_t id = 1; id <= 3; id++) {
+        same_state[id] = (StageState){ .routing = same_routing,
+                                       .registry = same_registry, .id = id };
+        same_dispatch[id] = dispatch_table_create(4, id);
+        if (id < 3) {
+            dispatch_register(same_dispatch[id], FREQ_PING, handle_stage, NULL);
+            uint32_t next = id + 1;
+            routing_add_entry(same_routing, id, FREQ_PING, 1, &next);
+        }
+        same[id] = (Agent){ .agent_id = id, .state_ptr = &same_state[id],
+                            .dispatch_table = same_dispatch[id],
+                            .input_queue = signal_queue_create(8) };
+        agent_registry_add(same_registry, &same[id]);
+    }
+    int same_processed[2];
+    uint64_t same_errors[2];
+    for (int use_direct = 0; use_direct <= 1; use_direct++) {
+        for (uint32_t id = 1; id < 3; id++) {
+            routing_set_direct(same_routing, id, FREQ_PING, use_direct);
+        }
+        for (uint32_t seq = 0; seq < 5; seq++) {
+            Signal* sig = signal_create(FREQ_PING, 0, &seq, sizeof(seq));
+            signal_queue_enqueue(same[1].input_queue, sig);
+            signal_free(sig);
+        }
+        Scheduler* same_sched = scheduler_create(same_registry, same_routing);
+        assert(same_sched != NULL);
+        same_processed[use_direct] = scheduler_run(same_sched);
+        SchedulerStats same_stats;
+        scheduler_get_stats(same_sched, &same_stats);
+        assert(same_stats.signals_processed == (uint64_t)same_processed[use_direct]);
+        same_errors[use_direct] = same_stats.dispatch_errors;
+        scheduler_destroy(same_sched);
+    }
+    assert(same_processed[0] == 15 && same_processed[1] == 15);
+    assert(same_errors[0] == 5 && same_errors[1] == 5);
+    printf("✓ Direct routes report the same processed and error counts as queued\n");
+    for (uint32_t id = 1; id <= 3; id++) {
+        signal_queue_destroy(same[id].input_queue);
+        dispatch_table_destroy(same_dispatch[id]);
+    }
+    routing_table_destroy(same_routing);
+
+    for (uint32_t id = 1; id < CHAIN; id++) {
+        signal_queue_destroy(chain[id].input_queue);
+        dispatch_table_destroy(chain_dispatch[id]);
+    }
+    for (uint32_t id = 1; id <= 2; id++) {
+        signal_queue_destroy(pong_agents[id].input_queue);
+    }
+    dispatch_table_destroy(bounce_dispatch);
+    routing_table_destroy(chain_routing);
+    routing_table_destroy(pong_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 14: Agent Placement
+     * ========================================================================= */
+
+    printf("=== Test 14: Agent Placement ===\n");
+
+    /* Two rings with interleaved IDs, 1 -> 2 -> 5 -> 6 -> 1 and
+     * 3 -> 4 -> 7 -> 8 -> 3: spreading by ID puts every hop across workers */
+    #define RING_AGENTS 9
+    #define RING_SIGNALS 50
+    #define RING_TTL 20
+    static const uint32_t ring_next[RING_AGENTS] = { 0, 2, 5, 4, 7, 6, 1, 8, 3 };
+    AgentRegistry* ring_registry = agent_registry_create(RING_AGENTS);
+    RoutingTable* ring_routing = routing_table_create(32);
+    Agent ring[RING_AGENTS];
+    TraceState ring_state[RING_AGENTS];
+    DispatchTable* ring_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(ring_dispatch, FREQ_PING, handle_trace, NULL);
+    for (uint32_t id = 1; id < RING_AGENTS; id++) {
+        ring_state[id] = (TraceState){ .routing = ring_routing,
+                                       .registry = ring_registry, .id = id };
+        ring[id] = (Agent){ .agent_id = id, .state_ptr = &ring_state[id],
+                            .dispatch_table = ring_dispatch,
+                            .input_queue = signal_queue_create(256) };
+        agent_registry_add(ring_registry, &ring[id]);
+        routing_add_entry(ring_routing, id, FREQ_PING, 1, &ring_next[id]);
+    }
+
+    int ring_expected = 2 * RING_SIGNALS * (RING_TTL + 1);
+    for (int round = 0; round < 2; round++) {
+        for (uint32_t seq = 0; seq < RING_SIGNALS; seq++) {
+            TracePayload payload = { .seq = seq, .ttl = RING_TTL };
+            Signal* sig = signal_create(FREQ_PING, 0, &payload, sizeof(payload));
+            signal_queue_enqueue(ring[1].input_queue, sig);
+            signal_queue_enqueue(ring[3].input_queue, sig);
+            signal_free(sig);
+        }
+
+        Scheduler* placed = scheduler_create_parallel(ring_registry, ring_routing, 2);
+        assert(placed != NULL);
+        if (round == 0) {
+            /* Warm-up: no plan yet, agents spread by ID */
+            assert(scheduler_agent_worker(placed, 5) == 1);
+            assert(scheduler_run(placed) == ring_expected);
+
+            assert(scheduler_plan_placement(placed) == SIGNAL_OK);
+            assert(scheduler_save_placement(placed, "/tmp/mycelial_placement.profile") == SIGNAL_OK);
+        } else {
+            /* Startup from the saved profile, workers pinned */
+            assert(scheduler_load_placement(placed, "/nonexistent/profile") == SIGNAL_ERR_IO);
+            assert(scheduler_load_placement(placed, "/tmp/mycelial_placement.profile") == SIGNAL_OK);
+            scheduler_set_affinity(placed, 1);
+            assert(scheduler_run(placed) == ring_expected);
+        }
+
+        uint32_t home_a = scheduler_agent_worker(placed, 1);
+        uint32_t home_b = scheduler_agent_worker(placed, 3);
+        assert(home_a != home_b);
+        assert(scheduler_agent_worker(placed, 2) == home_a);
+        assert(scheduler_agent_worker(placed, 5) == home_a);
+        assert(scheduler_agent_worker(placed, 6) == home_a);
+        assert(scheduler_agent_worker(placed, 4) == home_b);
+        assert(scheduler_agent_worker(placed, 7) == home_b);
+        assert(scheduler_agent_worker(placed, 8) == home_b);
+
+        SchedulerStats placed_stats;
+        scheduler_get_stats(placed, &placed_stats);
+        assert(placed_stats.placement_cut == 0);
+        /* Both plans see the warm-up's traffic */
+        assert(placed_stats.placement_traffic == 2 * RING_SIGNALS * RING_TTL);
+        scheduler_destroy(placed);
+    }
+    remove("/tmp/mycelial_placement.profile");
+    printf("✓ Rings placed one per worker (0 cross-worker signals), reloaded from profile\n");
+
+    /* Auto placement re-plans at run start once enough traffic is new */
+    Scheduler* auto_placed = scheduler_create_parallel(ring_registry, ring_routing, 2);
+    assert(auto_placed != NULL);
+    scheduler_set_auto_placement(auto_placed, 1);
+    assert(scheduler_run(auto_placed) == 0);
+    assert(scheduler_agent_worker(auto_placed, 2) == scheduler_agent_worker(auto_placed, 6));
+    assert(scheduler_agent_worker(auto_placed, 2) != scheduler_agent_worker(auto_placed, 8));
+    printf("✓ Auto placement planned at run start\n");
+    scheduler_destroy(auto_placed);
+
+    for (uint32_t id = 1; id < RING_AGENTS; id++) {
+        signal_queue_destroy(ring[id].input_queue);
+    }
+    dispatch_table_destroy(ring_dispatch);
+    routing_table_destroy(ring_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 15: Blocking Handler Offload
+     * ========================================================================= */
+
+    printf("=== Test 15: Blocking Handler Offload ===\n");
+
+    /* Writer (1) gets PING 10, PONG 20 (blocking), PING 30, PING 40; the
+     * ticker (2) bounces to itself; the blocking call's result goes to the
+     * sink (3) */
+    #define TICKER_TTL 100
+    AgentRegistry* off_registry = agent_registry_create(4);
+    RoutingTable* off_routing = routing_table_create(16);
+    uint32_t off_sink = 3;
+    uint32_t off_ticker = 2;
+    routing_add_entry(off_routing, 1, FREQ_PING, 1, &off_sink);
+    routing_add_entry(off_routing, 2, FREQ_PING, 1, &off_ticker);
+
+    WriterState writer_state = { .routing = off_routing, .registry = off_registry, .id = 1 };
+    BounceState ticker_state = { .routing = off_routing, .registry = off_registry, .id = 2 };
+    ReceiverState result_state = { 0 };
+
+    DispatchTable* writer_dispatch = dispatch_table_create(4, 2);
+    dispatch_register(writer_dispatch, FREQ_PING, handle_log, NULL);
+    dispatch_register(writer_dispatch, FREQ_PONG, handle_blocking_write, NULL);
+    assert(dispatch_set_blocking(writer_dispatch, FREQ_PONG, 1) == DISPATCH_OK);
+    assert(dispatch_set_blocking(writer_dispatch, 99, 1) == DISPATCH_ERR_NO_HANDLER);
+    DispatchTable* ticker_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(ticker_dispatch, FREQ_PING, handle_tick, NULL);
+    DispatchTable* result_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(result_dispatch, FREQ_PING, handle_ping, NULL);
+
+    Agent off_agents[4];
+    void* off_states[4] = { NULL, &writer_state, &ticker_state, &result_state };
+    DispatchTable* off_dispatch[4] = { NULL, writer_dispatch, ticker_dispatch, result_dispatch };
+    for (uint32_t id = 1; id < 4; id++) {
+        off_agents[id] = (Agent){ .agent_id = id, .state_ptr = off_states[id],
+                                  .dispatch_table = off_dispatch[id],
+                                  .input_queue = signal_queue_create(16) };
+        agent_registry_add(off_registry, &off_agents[id]);
+    }
+
+    static const uint32_t writer_input[4] = { 10, 20, 30, 40 };
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 4; i++) {
+            uint32_t freq = (round == 0 && i == 1) ? FREQ_PONG : FREQ_PING;
+            Signal* sig = signal_create(freq, 0, &writer_input[i], sizeof(uint32_t));
+            signal_queue_enqueue(off_agents[1].input_queue, sig);
+            signal_free(sig);
+        }
+        uint32_t ttl = TICKER_TTL;
+        Signal* tick = signal_create(FREQ_PING, 0, &ttl, sizeof(ttl));
+        signal_queue_enqueue(off_agents[2].input_queue, tick);
+        signal_free(tick);
+
+        if (round == 1) {
+            /* Whole agent marked blocking: every handler call is offloaded */
+            off_agents[1].flags |= AGENT_FLAG_BLOCKING;
+        }
+
+        __atomic_store_n(&g_ticker_done, 0, __ATOMIC_RELAXED);
+        writer_state.logged = 0;
+        Scheduler* off_sched = scheduler_create(off_registry, off_routing);
+        assert(scheduler_set_offload(off_sched, 2) == SIGNAL_OK);
+
+        int offload_expected = 4 + (TICKER_TTL + 1) + (round == 0 ? 1 : 0);
+        assert(scheduler_run(off_sched) == offload_expected);
+        assert(!g_runtime_threaded);
+
+        assert(writer_state.logged == 4);
+        for (int i = 0; i < 4; i++) {
+            assert(writer_state.log[i] == writer_input[i]);
+        }
+        SchedulerStats off_stats;
+        scheduler_get_stats(off_sched, &off_stats);
+        assert(off_stats.offloaded == (round == 0 ? 1 : 4));
+        assert(off_stats.dispatch_errors == 0);
+        scheduler_destroy(off_sched);
+    }
+    /* The first blocking call only returns once the ticker finished */
+    assert(writer_state.saw_ticker == 1);
+    assert(ticker_state.handled == 2 * (TICKER_TTL + 1));
+    assert(result_state.pings == 1);
+    printf("✓ Scheduler kept cycling during a blocking handler (%u ticks)\n", ticker_state.handled);
+    printf("✓ Agent order kept, emitted signals delivered after the call\n");
+
+    for (uint32_t id = 1; id < 4; id++) {
+        signal_queue_destroy(off_agents[id].input_queue);
+    }
+    dispatch_table_destroy(writer_dispatch);
+    dispatch_table_destroy(ticker_dispatch);
+    dispatch_table_destroy(result_dispatch);
+    routing_table_destroy(off_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 16: Coroutine Agents
+     * ========================================================================= */
+
+    printf("=== Test 16: Coroutine Agents ===\n");
+
+    AgentRegistry* co_registry = agent_registry_create(3);
+    RoutingTable* co_routing = routing_table_create(16);
+    uint32_t co_sink = 2;
+    routing_add_entry(co_routing, 1, FREQ_PING, 1, &co_sink);
+
+    OrchestratorState orch = { .routing = co_routing, .registry = co_registry, .id = 1 };
+    ReceiverState builds_seen = { 0 };
+    DispatchTable* orch_dispatch = dispatch_table_create(8, 1);
+    dispatch_register(orch_dispatch, FREQ_STATUS, handle_status, NULL);
+    dispatch_register(orch_dispatch, FREQ_PARSE_DONE, handle_stray, NULL);
+    dispatch_register(orch_dispatch, FREQ_LINK_DONE, handle_stray, NULL);
+    DispatchTable* builds_dispatch = dispatch_table_create(4, 2);
+    dispatch_register(builds_dispatch, FREQ_PING, handle_ping, NULL);
+
+    Agent orch_agent = { .agent_id = 1, .state_ptr = &orch, .dispatch_table = orch_dispatch,
+                         .input_queue = signal_queue_create(64) };
+    Agent builds_agent = { .agent_id = 2, .state_ptr = &builds_seen,
+                           .dispatch_table = builds_dispatch,
+                           .input_queue = signal_queue_create(64) };
+    agent_registry_add(co_registry, &orch_agent);
+    agent_registry_add(co_registry, &builds_agent);
+
+    /* A stray PARSE before any LEX goes to the table; STATUS always does */
+    static const uint32_t co_input[] = {
+        FREQ_PARSE_DONE, FREQ_LEX_DONE, FREQ_STATUS, FREQ_LINK_DONE, FREQ_PARSE_DONE,
+        FREQ_LEX_DONE, FREQ_PARSE_DONE, FREQ_STATUS, FREQ_LINK_DONE,
+        FREQ_LEX_DONE, FREQ_LINK_DONE, FREQ_PARSE_DONE, FREQ_LINK_DONE, FREQ_STATUS,
+    };
+    uint32_t co_count = sizeof(co_input) / sizeof(co_input[0]);
+
+    for (int parallel = 0; parallel < 2; parallel++) {
+        memset(&orch.builds, 0, sizeof(orch) - offsetof(OrchestratorState, builds));
+        builds_seen.pings = 0;
+
+        Scheduler* co_sched = parallel ? scheduler_create_parallel(co_registry, co_routing, 2)
+                                       : scheduler_create(co_registry, co_routing);
+        assert(co_sched != NULL);
+        assert(scheduler_spawn_coroutine(co_sched, 1, orchestrate, 0) == SIGNAL_OK);
+        assert(scheduler_coroutine_active(co_sched, 1));
+        assert(scheduler_spawn_coroutine(co_sched, 1, orchestrate, 0) == SIGNAL_ERR_BUSY);
+        assert(scheduler_spawn_coroutine(co_sched, 7, orchestrate, 0) == SIGNAL_ERR_NULL_POINTER);
+
+        for (uint32_t i = 0; i < co_count; i++) {
+            Signal* sig = signal_create(co_input[i], 0, NULL, 0);
+            signal_queue_enqueue(orch_agent.input_queue, sig);
+            signal_free(sig);
+        }
+        assert(scheduler_run(co_sched) == (int)co_count + 3);
+
+        /* Three builds, then the body returned: the last LINK is a stray */
+        assert(orch.builds == 3 && builds_seen.pings == 3);
+        assert(orch.statuses == 3);
+        assert(orch.strays == 2);
+        assert(orch.step_count == 9 && !orch.cancelled);
+        assert(orch.steps[0] == FREQ_LEX_DONE && orch.steps[1] == FREQ_LINK_DONE &&
+               orch.steps[2] == FREQ_PARSE_DONE && orch.steps[3] == FREQ_LEX_DONE);
+        assert(!scheduler_coroutine_active(co_sched, 1));
+        assert(!(orch_agent.flags & AGENT_FLAG_COROUTINE));
+        scheduler_destroy(co_sched);
+    }
+    printf("✓ Protocol awaited in order, other signals dispatched (sequential and parallel)\n");
+
+    /* A coroutine still waiting is unwound by scheduler_destroy */
+    memset(&orch.builds, 0, sizeof(orch) - offsetof(OrchestratorState, builds));
+    Scheduler* co_sched = scheduler_create(co_registry, co_routing);
+    assert(scheduler_spawn_coroutine(co_sched, 1, orchestrate, 16 * 1024) == SIGNAL_OK);
+    Signal* lex = signal_create(FREQ_LEX_DONE, 0, NULL, 0);
+    signal_queue_enqueue(orch_agent.input_queue, lex);
+    signal_free(lex);
+    assert(scheduler_run(co_sched) == 1);
+    assert(scheduler_coroutine_active(co_sched, 1) && orch.step_count == 1);
+    scheduler_destroy(co_sched);
+    assert(orch.cancelled && !(orch_agent.flags & AGENT_FLAG_COROUTINE));
+    printf("✓ Suspended coroutine unwound on destroy\n");
+
+    signal_queue_destroy(orch_agent.input_queue);
+    signal_queue_destroy(builds_agent.input_queue);
+    dispatch_table_destroy(orch_dispatch);
+    dispatch_table_destroy(builds_dispatch);
+    routing_table_destroy(co_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 17: Scheduling Classes
+     * ========================================================================= */
+
+    printf("=== Test 17: Scheduling Classes ===\n");
+
+    /* Bulk agents 1-3, deadline agents 4 (loose target) and 5 (tight) */
+    #define CLASS_AGENTS 6
+    AgentRegistry* cls_registry = agent_registry_create(CLASS_AGENTS);
+    RoutingTable* cls_routing = routing_table_create(4);
+    DispatchTable* cls_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(cls_dispatch, FREQ_PING, handle_class_log, NULL);
+    uint32_t cls_log[64];
+    uint32_t cls_logged = 0;
+    Agent cls_agents[CLASS_AGENTS];
+    ClassState cls_state[CLASS_AGENTS];
+    for (uint32_t id = 1; id < CLASS_AGENTS; id++) {
+        cls_state[id] = (ClassState){ .id = id, .log = cls_log, .log_count = &cls_logged };
+        cls_agents[id] = (Agent){ .agent_id = id, .state_ptr = &cls_state[id],
+                                  .dispatch_table = cls_dispatch,
+                                  .input_queue = signal_queue_create(64) };
+        agent_registry_add(cls_registry, &cls_agents[id]);
+    }
+
+    Scheduler* cls_sched = scheduler_create(cls_registry, cls_routing);
+    scheduler_set_budget(cls_sched, SCHED_BUDGET_FIXED, 1, 2);
+    assert(scheduler_set_agent_class(cls_sched, 9, SCHED_CLASS_WEIGHTED, 2) ==
+           SIGNAL_ERR_NULL_POINTER);
+    assert(scheduler_set_agent_class(cls_sched, 1, SCHED_CLASS_WEIGHTED, 3) == SIGNAL_OK);
+    assert(scheduler_set_agent_class(cls_sched, 4, SCHED_CLASS_DEADLINE, 1000000000) == SIGNAL_OK);
+    assert(scheduler_set_agent_class(cls_sched, 5, SCHED_CLASS_DEADLINE, 1) == SIGNAL_OK);
+
+    /* Agent 4's signal is older, but agent 5's deadline is earlier */
+    enqueue_pings(&cls_agents[4], 1);
+    for (uint32_t id = 1; id <= 3; id++) {
+        enqueue_pings(&cls_agents[id], 8);
+    }
+    enqueue_pings(&cls_agents[5], 1);
+    usleep(1000);
+
+    assert(scheduler_run_cycle(cls_sched) == 2 + 6 + 2 + 2);
+    static const uint32_t cls_expected[] = { 5, 4, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3 };
+    for (uint32_t i = 0; i < 12; i++) {
+        assert(cls_log[i] == cls_expected[i]);
+    }
+    printf("✓ Deadline agents first in EDF order, weight 3 drains 3x the budget\n");
+
+    /* Only the 1 ns target was missed */
+    assert(scheduler_deadline_misses(cls_sched, 5) == 1);
+    assert(scheduler_deadline_misses(cls_sched, 4) == 0);
+    SchedulerStats cls_stats;
+    scheduler_get_stats(cls_sched, &cls_stats);
+    assert(cls_stats.deadline_signals == 2 && cls_stats.deadline_misses == 1);
+    assert(cls_stats.deadline_max_late_ns >= 500000);
+
+    /* Back to best effort: plain ID order */
+    assert(scheduler_set_agent_class(cls_sched, 5, SCHED_CLASS_BEST_EFFORT, 0) == SIGNAL_OK);
+    assert(!(cls_agents[5].flags & AGENT_FLAG_DEADLINE));
+    enqueue_pings(&cls_agents[5], 1);
+    enqueue_pings(&cls_agents[4], 1);
+    cls_logged = 0;
+    scheduler_run(cls_sched);
+    assert(cls_log[0] == 4 && cls_log[1] == 1);
+    assert(cls_logged == 1 + 1 + 2 + 6 + 6);
+    printf("✓ Deadline misses counted (%lu of %lu, worst %lu ns late)\n",
+           cls_stats.deadline_misses, cls_stats.deadline_signals, cls_stats.deadline_max_late_ns);
+    scheduler_destroy(cls_sched);
+    assert(!(cls_agents[4].flags & AGENT_FLAG_DEADLINE));
+
+    for (uint32_t id = 1; id < CLASS_AGENTS; id++) {
+        signal_queue_destroy(cls_agents[id].input_queue);
+    }
+    dispatch_table_destroy(cls_dispatch);
+    routing_table_destroy(cls_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 18: Fair Share
+     * ========================================================================= */
+
+    printf("=== Test 18: Fair Share ===\n");
+
+    /* Agent 1 has 200 us handlers, agents 2-3 have near-free ones */
+    #define FAIR_AGENTS 4
+    AgentRegistry* fair_registry = agent_registry_create(FAIR_AGENTS);
+    RoutingTable* fair_routing = routing_table_create(4);
+    DispatchTable* fair_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(fair_dispatch, FREQ_PING, handle_fair_work, NULL);
+    Agent fair_agents[FAIR_AGENTS];
+    FairWorkState fair_state[FAIR_AGENTS];
+    for (uint32_t id = 1; id < FAIR_AGENTS; id++) {
+        fair_state[id] = (FairWorkState){ .spin_ns = (id == 1) ? 200000 : 0 };
+        fair_agents[id] = (Agent){ .agent_id = id, .state_ptr = &fair_state[id],
+                                   .dispatch_table = fair_dispatch,
+                                   .input_queue = signal_queue_create(64) };
+        agent_registry_add(fair_registry, &fair_agents[id]);
+    }
+
+    /* Same load twice: count budgets with metrics, then fair share */
+    uint64_t cheap_wait[2];
+    for (int mode = 0; mode < 2; mode++) {
+        Scheduler* fair_sched = scheduler_create(fair_registry, fair_routing);
+        scheduler_set_budget(fair_sched, SCHED_BUDGET_FIXED, 8, 8);
+        if (mode == 0) {
+            assert(scheduler_set_fairness_stats(fair_sched, 1) == SIGNAL_OK);
+        } else {
+            assert(scheduler_set_fair_share(fair_sched, 20000) == SIGNAL_OK);
+        }
+
+        enqueue_pings(&fair_agents[1], 16);
+        enqueue_pings(&fair_agents[2], 48);
+        enqueue_pings(&fair_agents[3], 48);
+        for (uint32_t id = 1; id < FAIR_AGENTS; id++) {
+            fair_state[id].handled = 0;
+        }
+        scheduler_run(fair_sched);
+
+        /* Nobody starves: every signal ran and the run did not exit early */
+        assert(fair_state[1].handled == 16);
+        assert(fair_state[2].handled == 48 && fair_state[3].handled == 48);
+
+        SchedFairnessStats heavy, cheap;
+        assert(scheduler_get_fairness(fair_sched, 1, &heavy) == SIGNAL_OK);
+        assert(scheduler_get_fairness(fair_sched, 2, &cheap) == SIGNAL_OK);
+        assert(heavy.signals == 16 && cheap.signals == 48);
+        assert(heavy.run_ns >= 16 * 200000);
+        assert(cheap.runnable_ns == cheap.run_ns + cheap.wait_ns);
+        cheap_wait[mode] = cheap.max_wait_ns;
+
+        SchedulerStats fair_stats;
+        scheduler_get_stats(fair_sched, &fair_stats);
+        assert(fair_stats.max_wait_ns >= cheap.max_wait_ns);
+        if (mode == 0) {
+            /* Count budget: the heavy agent takes 8 x 200 us per turn */
+            assert(heavy.deferred == 0 && fair_stats.fair_deferred == 0);
+            assert(cheap.max_wait_ns >= 8 * 200000);
+        } else {
+            /* One heavy signal per turn, then it sits out until paid off */
+            assert(heavy.turns == 16 && heavy.deferred > 0);
+            assert(cheap.deferred == 0);
+            assert(fair_stats.fair_deferred == heavy.deferred);
+        }
+        scheduler_destroy(fair_sched);
+    }
+    assert(cheap_wait[1] * 2 < cheap_wait[0]);
+    printf("✓ Fair share: cheap agent's worst wait %lu us (count budget %lu us)\n",
+           cheap_wait[1] / 1000, cheap_wait[0] / 1000);
+
+    for (uint32_t id = 1; id < FAIR_AGENTS; id++) {
+        signal_queue_destroy(fair_agents[id].input_queue);
+    }
+    dispatch_table_destroy(fair_dispatch);
+    routing_table_destroy(fair_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 19: Sweep Prefetch
+     * ========================================================================= */
+
+    printf("=== Test 19: Sweep Prefetch ===\n");
+
+    /* Enough agents for the pipeline to engage, with an idle stretch of
+     * whole ready words for its lookahead to skip */
+    #define TRACE_AGENTS (SCHED_PREFETCH_MIN_AGENTS + 100)
+    AgentRegistry* trace_registry = agent_registry_create(TRACE_AGENTS);
+    RoutingTable* trace_routing = routing_table_create(4);
+    DispatchTable* trace_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(trace_dispatch, FREQ_PING, handle_sweep, NULL);
+    Agent trace_agents[TRACE_AGENTS];
+    SweepState trace_state[TRACE_AGENTS];
+    uint64_t trace = 0;
+    uint32_t trace_handled = 0;
+    for (uint32_t id = 1; id < TRACE_AGENTS; id++) {
+        trace_state[id] = (SweepState){ .id = id, .trace = &trace, .handled = &trace_handled };
+        trace_agents[id] = (Agent){ .agent_id = id, .state_ptr = &trace_state[id],
+                                    .dispatch_table = trace_dispatch,
+                                    .input_queue = signal_queue_create(4) };
+        agent_registry_add(trace_registry, &trace_agents[id]);
+    }
+
+    assert(scheduler_set_prefetch(NULL, 8) == SIGNAL_ERR_NULL_POINTER);
+    static const uint32_t trace_distances[] = { 0, 1, SCHED_PREFETCH_DISTANCE, 1000 };
+    uint64_t trace_expected = 0;
+    uint64_t trace_cycles = 0;
+    for (uint32_t d = 0; d < 4; d++) {
+        Scheduler* trace_sched = scheduler_create(trace_registry, trace_routing);
+        scheduler_set_budget(trace_sched, SCHED_BUDGET_FIXED, 1, 1);
+        assert(scheduler_set_prefetch(trace_sched, trace_distances[d]) == SIGNAL_OK);
+        assert(trace_sched->prefetch_distance <= SCHED_PREFETCH_MAX);
+
+        for (uint32_t id = 1; id < TRACE_AGENTS; id++) {
+            if (id >= 128 && id < 320) {
+                continue;
+            }
+            enqueue_pings(&trace_agents[id], (id % 3 == 0) ? 3 : (id % 7 == 0) ? 1 : 0);
+        }
+        trace = 0;
+        trace_handled = 0;
+        scheduler_run(trace_sched);
+
+        SchedulerStats trace_stats;
+        scheduler_get_stats(trace_sched, &trace_stats);
+        if (d == 0) {
+            trace_expected = trace;
+            trace_cycles = trace_stats.cycles_run;
+        }
+        assert(trace == trace_expected && trace_stats.cycles_run == trace_cycles);
+        assert(trace_handled == trace_stats.signals_processed);
+        scheduler_destroy(trace_sched);
+    }
+    printf("✓ Same visit order and cycles with prefetch off and at distance 1..%d "
+           "(%u signals)\n", SCHED_PREFETCH_MAX, trace_handled);
+
+    for (uint32_t id = 1; id < TRACE_AGENTS; id++) {
+        signal_queue_destroy(trace_agents[id].input_queue);
+    }
+    dispatch_table_destroy(trace_dispatch);
+    routing_table_destroy(trace_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 20: Agent Pools
+     * ========================================================================= */
+
+    printf("=== Test 20: Agent Pools ===\n");
+
+    AgentRegistry* pool_registry = agent_registry_create(POOL_FIRST + POOL_INSTANCES);
+    RoutingTable* pool_routing = routing_table_create(512);
+    ReceiverState pool_sink_state = { 0 };
+    DispatchTable* pool_sink_dispatch = dispatch_table_create(4, POOL_SINK);
+    dispatch_register(pool_sink_dispatch, FREQ_PING, handle_ping, NULL);
+    Agent pool_sink_agent = { .agent_id = POOL_SINK, .state_ptr = &pool_sink_state,
+                         .dispatch_table = pool_sink_dispatch,
+                         .input_queue = signal_queue_create(256) };
+    agent_registry_add(pool_registry, &pool_sink_agent);
+
+    /* IDs must be free; instances span several ready-set words */
+    PoolTestContext pool_ctx = { .routing = pool_routing, .registry = pool_registry };
+    assert(agent_pool_create(pool_registry, POOL_SINK, 4, 8, NULL) == NULL);
+    AgentPool* pool = agent_pool_create(pool_registry, POOL_FIRST, POOL_INSTANCES, 8, &pool_ctx);
+    assert(pool != NULL);
+    assert(pool_registry->agents[POOL_FIRST + POOL_INSTANCES - 1] == &pool->agents[POOL_INSTANCES - 1]);
+    assert(agent_pool_add_column(pool, sizeof(uint64_t)) == POOL_COL_SUM);
+    assert(agent_pool_add_column(pool, sizeof(uint32_t)) == POOL_COL_SEQ);
+    assert(((uintptr_t)agent_pool_column(pool, POOL_COL_SUM) % POOL_COLUMN_ALIGN) == 0);
+    assert(((uintptr_t)agent_pool_column(pool, POOL_COL_SEQ) % POOL_COLUMN_ALIGN) == 0);
+    assert(agent_pool_column(pool, 2) == NULL);
+    assert(agent_pool_register(pool, FREQ_PING, pool_ping) == SIGNAL_OK);
+    assert(agent_pool_register(pool, FREQ_PONG, pool_pong) == SIGNAL_OK);
+    for (uint32_t i = 0; i < POOL_INSTANCES; i++) {
+        uint32_t sink = POOL_SINK;
+        routing_add_entry(pool_routing, POOL_FIRST + i, FREQ_PING, 1, &sink);
+    }
+
+    /* Even instances: PING 1, PONG 2, PING 3; odd: PING 1; instance 0 also
+     * gets a frequency without a handler */
+    for (int parallel = 0; parallel < 2; parallel++) {
+        uint64_t* pool_sum = (uint64_t*)agent_pool_column(pool, POOL_COL_SUM);
+        uint32_t* pool_seq = (uint32_t*)agent_pool_column(pool, POOL_COL_SEQ);
+        memset(pool_sum, 0, POOL_INSTANCES * sizeof(uint64_t));
+        memset(pool_seq, 0, POOL_INSTANCES * sizeof(uint32_t));
+        pool_ctx.calls = pool_ctx.unordered = pool_ctx.out_of_order = pool_ctx.largest = 0;
+        pool_sink_state.pings = 0;
+        for (uint32_t i = 0; i < POOL_INSTANCES; i++) {
+            enqueue_seq(&pool->agents[i], FREQ_PING, 1);
+            if (i % 2 == 0) {
+                enqueue_seq(&pool->agents[i], FREQ_PONG, 2);
+                enqueue_seq(&pool->agents[i], FREQ_PING, 3);
+            }
+        }
+        enqueue_seq(&pool->agents[0], 99, 4);
+
+        Scheduler* pool_sched = parallel ? scheduler_create_parallel(pool_registry, pool_routing, 2)
+                                         : scheduler_create(pool_registry, pool_routing);
+        scheduler_set_budget(pool_sched, SCHED_BUDGET_FIXED, 1, 1);
+        int pool_processed = scheduler_run(pool_sched);
+        SchedulerStats pool_stats;
+        scheduler_get_stats(pool_sched, &pool_stats);
+        scheduler_destroy(pool_sched);
+
+        assert(pool_processed == 100 * 3 + 100 + 1 + 100);
+        assert(pool_stats.dispatch_errors == 1);
+        assert(pool_sink_state.pings == 100);
+        assert(pool_ctx.out_of_order == 0 && pool_ctx.unordered == 0);
+        for (uint32_t i = 0; i < POOL_INSTANCES; i++) {
+            assert(pool_sum[i] == ((i % 2 == 0) ? 4u : 1u));
+            assert(pool->agents[i].signal_count == (uint32_t)(parallel + 1) * ((i % 2 == 0) ? 3 : 1) +
+                                                   (uint32_t)(parallel + 1) * (i == 0));
+        }
+        if (!parallel) {
+            /* One call per frequency per round: PINGs, PONGs, PINGs */
+            assert(pool_ctx.calls == 3 && pool_ctx.largest == POOL_INSTANCES);
+            assert(pool->handler_calls == 3 && pool->rounds == 4 &&
+                   pool->signals == 100 * 3 + 100);
+        } else {
+            assert(pool_ctx.calls == 100 * 3 + 100 && pool_ctx.largest == 1);
+        }
+    }
+    printf("✓ 200 instances: one handler call per frequency per round, FIFO per "
+           "instance; per-instance calls under the parallel scheduler\n");
+
+    agent_pool_destroy(pool, pool_registry);
+    assert(pool_registry->agents[POOL_FIRST] == NULL);
+
+    /* A pool created after its scheduler, beyond the registry, still runs;
+     * a failed create leaves the registry's count alone */
+    AgentRegistry* late_registry = agent_registry_create(4);
+    RoutingTable* late_routing = routing_table_create(4);
+    PoolTestContext late_ctx = { .routing = late_routing, .registry = late_registry };
+    Scheduler* late_sched = scheduler_create(late_registry, late_routing);
+    runtime_set_threaded(1);
+    assert(agent_pool_create(late_registry, 100, 64, 4, &late_ctx) == NULL);
+    runtime_set_threaded(0);
+    assert(late_registry->count == 0);
+    AgentPool* late_pool = agent_pool_create(late_registry, 100, 64, 4, &late_ctx);
+    assert(late_pool != NULL && late_registry->count == 164);
+    assert(agent_pool_add_column(late_pool, sizeof(uint64_t)) == POOL_COL_SUM);
+    assert(agent_pool_add_column(late_pool, sizeof(uint32_t)) == POOL_COL_SEQ);
+    assert(agent_pool_register(late_pool, FREQ_PING, pool_ping) == SIGNAL_OK);
+    for (uint32_t i = 0; i < 64; i++) {
+        enqueue_seq(&late_pool->agents[i], FREQ_PING, 1);
+    }
+    assert(scheduler_run(late_sched) == 64);
+    uint64_t* late_sum = (uint64_t*)agent_pool_column(late_pool, POOL_COL_SUM);
+    for (uint32_t i = 0; i < 64; i++) {
+        assert(late_sum[i] == 1);
+    }
+    assert(late_ctx.calls == 1 && late_ctx.out_of_order == 0);
+    scheduler_destroy(late_sched);
+    agent_pool_destroy(late_pool, late_registry);
+    routing_table_destroy(late_routing);
+    printf("✓ Pool registered after its scheduler was created runs in one call\n");
+    signal_queue_destroy(pool_sink_agent.input_queue);
+    dispatch_table_destroy(pool_sink_dispatch);
+    routing_table_destroy(pool_routing);
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 21: Registry Growth
+     * ========================================================================= */
+
+    printf("=== Test 21: Registry Growth ===\n");
+
+    /* An agent added beyond the registry after the scheduler exists, with
+     * the scheduler already run once, still gets scheduled */
+    const char* grow_names[] = { "sequential", "work-stealing", "BSP" };
+    for (int mode = 0; mode < 3; mode++) {
+        AgentRegistry* grow_registry = agent_registry_create(4);
+        RoutingTable* grow_routing = routing_table_create(4);
+        Scheduler* grow_sched = (mode == 0) ? scheduler_create(grow_registry, grow_routing)
+                              : (mode == 1) ? scheduler_create_parallel(grow_registry, grow_routing, 2)
+                                            : scheduler_create_bsp(grow_registry, grow_routing, 2);
+        assert(grow_sched != NULL);
+        assert(scheduler_set_fairness_stats(grow_sched, 1) == SIGNAL_OK);
+        assert(scheduler_run(grow_sched) == 0);
+
+        ReceiverState grow_state = { 0 };
+        DispatchTable* grow_dispatch = dispatch_table_create(4, 100);
+        dispatch_register(grow_dispatch, FREQ_PING, handle_ping, NULL);
+        Agent grow_agent = { .agent_id = 100, .state_ptr = &grow_state,
+                             .dispatch_table = grow_dispatch,
+                             .input_queue = signal_queue_create(4) };
+        assert(agent_registry_add(grow_registry, &grow_agent) == SIGNAL_OK);
+        assert(grow_registry->capacity > 100);
+        enqueue_pings(&grow_agent, 1);
+
+        assert(scheduler_run(grow_sched) == 1);
+        assert(grow_state.pings == 1);
+        assert(signal_queue_is_empty(grow_agent.input_queue));
+        SchedFairnessStats grow_fair;
+        scheduler_get_fairness(grow_sched, 100, &grow_fair);
+        assert(grow_fair.signals == 1);
+        scheduler_destroy(grow_sched);
+        signal_queue_destroy(grow_agent.input_queue);
+        dispatch_table_destroy(grow_dispatch);
+        routing_table_destroy(grow_routing);
+        printf("✓ %s: agent 100 added to a 4-slot registry after a run is scheduled\n",
+               grow_names[mode]);
+    }
+
+    /* Growing moves the slot array, so it is refused while workers run */
+    AgentRegistry* busy_registry = agent_registry_create(4);
+    Agent busy_agent = { .agent_id = 1000 };
+    runtime_set_threaded(1);
+    assert(agent_registry_add(busy_registry, &busy_agent) == SIGNAL_ERR_BUSY);
+    runtime_set_threaded(0);
+    assert(agent_registry_add(busy_registry, &busy_agent) == SIGNAL_OK);
+    printf("✓ Growth refused in threaded mode, allowed after\n");
+
+    /* A sparse high ID is capped instead of sizing every per-agent array
+     * to it; IDs under the cap still run */
+    AgentRegistry* sparse_registry = agent_registry_create(4);
+    RoutingTable* sparse_routing = routing_table_create(4);
+    Scheduler* sparse_sched = scheduler_create(sparse_registry, sparse_routing);
+    size_t sparse_heap = heap_get_used();
+    Agent far_agent = { .agent_id = 3000000000u };
+    assert(agent_registry_add(sparse_registry, &far_agent) == SIGNAL_ERR_ID_RANGE);
+    far_agent.agent_id = AGENT_REGISTRY_MAX_ID;
+    assert(agent_registry_add(sparse_registry, &far_agent) == SIGNAL_ERR_ID_RANGE);
+    assert(sparse_registry->capacity == 4 && sparse_registry->count == 0);
+    assert(heap_get_used() == sparse_heap);
+
+    ReceiverState sparse_state = { 0 };
+    DispatchTable* sparse_dispatch = dispatch_table_create(4, 1000000);
+    dispatch_register(sparse_dispatch, FREQ_PING, handle_ping, NULL);
+    Agent sparse_agent = { .agent_id = 1000000, .state_ptr = &sparse_state,
+                           .dispatch_table = sparse_dispatch,
+                           .input_queue = signal_queue_create(4) };
+    assert(agent_registry_add(sparse_registry, &sparse_agent) == SIGNAL_OK);
+    assert(sparse_registry->capacity <= AGENT_REGISTRY_MAX_ID);
+    enqueue_pings(&sparse_agent, 2);
+    assert(scheduler_run(sparse_sched) == 2 && sparse_state.pings == 2);
+    scheduler_destroy(sparse_sched);
+    signal_queue_destroy(sparse_agent.input_queue);
+    dispatch_table_destroy(sparse_dispatch);
+    routing_table_destroy(sparse_routing);
+    printf("✓ Agent 3000000000 refused without allocating; agent 1000000 runs\n");
+    printf("\n");
+
+    /* =========================================================================
+     * TEST 22: Shared Dispatch Tables
+     * ========================================================================= */
+
+    printf("=== Test 22: Shared Dispatch Tables ===\n");
+
+    /* Replicas share one table and run at once on different workers: each
+     * worker's errors and each agent's profile must stay its own */
+    #define SHARED_AGENTS 8
+    #define SHARED_SIGNALS 2000
+    AgentRegistry* shared_registry = agent_registry_create(SHARED_AGENTS + 1);
+    RoutingTable* shared_routing = routing_table_create(4);
+    DispatchTable* shared_dispatch = dispatch_table_create(4, 1);
+    dispatch_register(shared_dispatch, FREQ_PING, handle_shared, NULL);
+    Agent shared_agents[SHARED_AGENTS + 1];
+    ReceiverState shared_state[SHARED_AGENTS + 1];
+
+    for (uint32_t id = 1; id <= SHARED_AGENTS; id++) {
+        shared_state[id] = (ReceiverState){ 0 };
+        shared_agents[id] = (Agent){ .agent_id = id, .state_ptr = &shared_state[id],
+                                     .dispatch_table = shared_dispatch,
+                                     .input_queue = signal_queue_create(4096) };
+        agent_registry_add(shared_registry, &shared_agents[id]);
+        for (uint32_t seq = 0; seq < SHARED_SIGNALS; seq++) {
+            Signal* sig = signal_create(seq < SHARED_SIGNALS - 10 ? FREQ_PING : FREQ_PONG,
+                                        0, &seq, sizeof(seq));
+            signal_queue_enqueue(shared_agents[id].input_queue, sig);
+            signal_free(sig);
+        }
+    }
+
+    dispatch_profiling_enable(1);
+    Scheduler* shared_sched = scheduler_create_parallel(shared_registry, shared_routing, 4);
+    assert(shared_sched != NULL);
+    scheduler_set_budget(shared_sched, SCHED_BUDGET_FIXED, 1, 16);
+    assert(scheduler_run(shared_sched) == SHARED_AGENTS * SHARED_SIGNALS);
+    dispatch_profiling_enable(0);
+
+    /* Per agent: half the PINGs fail, the 10 PONGs have no handler */
+    uint32_t shared_expected = SHARED_AGENTS * ((SHARED_SIGNALS - 10) / 2 + 10);
+    SchedulerStats shared_stats;
+    scheduler_get_stats(shared_sched, &shared_stats);
+    assert(shared_stats.dispatch_errors == shared_expected);
+    assert(dispatch_get_error_count(shared_dispatch) == shared_expected);
+    printf("✓ %u errors counted once each, by the scheduler and the shared table\n",
+           shared_expected);
+
+    for (uint32_t id = 1; id <= SHARED_AGENTS; id++) {
+        const HandlerProfile* prof = dispatch_get_agent_profile(shared_dispatch, id, FREQ_PING);
+        assert(prof != NULL && prof->invocations == SHARED_SIGNALS - 10);
+        assert(shared_state[id].pings == SHARED_SIGNALS - 10);
+    }
+    FILE* shared_report = tmpfile();
+    assert(shared_report != NULL);
+    assert(dispatch_profile_report(shared_report, 0) == SHARED_AGENTS);
+    fclose(shared_report);
+    printf("✓ Each of %d agents sharing the table has its own profile row\n",
+           SHARED_AGENTS);
+
+    scheduler_destroy(shared_sched);
+    for (uint32_t id = 1; id <= SHARED_AGENTS; id++) {
+        signal_queue_destroy(shared_agents[id].input_queue);
+    }
+    dispatch_table_destroy(shared_dispatch);
+    routing_table_destroy(shared_routing);
+    printf("\n");
+
     /* =========================================================================
      * CLEANUP
      * ========================================================================= */
@@ -200,6 +2045,9 @@ int main(void) {
     signal_queue_destroy(receiver_agent.input_queue);
     printf("✓ Queues destroyed\n");
 
+    dispatch_table_destroy(receiver_dispatch);
+    printf("✓ Dispatch table destroyed\n");
+
     routing_table_destroy(routing);
     printf("✓ Routing table destroyed\n");
 
@@ -67,6 +67,38 @@ int handle_data(void* agent_state, Signal* signal) {
     return 0;
 }
 
+/* Replicated counter: which keys it saw and how many signals */
+typedef struct {
+    uint32_t count;
+    uint32_t keys_seen;             /* Bit per key */
+} ShardState;
+
+static uint32_t g_merged_count;
+
+/*
+ * Handler: on signal(data, d) { state.count += 1; state.keys_seen |= bit(d.key) }
+ */
+int handle_shard(void* agent_state, Signal* signal) {
+    ShardState* state = (ShardState*)agent_state;
+    uint32_t* payload = (uint32_t*)signal_get_payload(signal);
+    state->count++;
+    if (payload != NULL) {
+        state->keys_seen |= 1u << (*payload & 31);
+    }
+    return 0;
+}
+
+/*
+ * Shutdown merge: fold a replica's counts into the primary
+ */
+void merge_shard(void* primary_state, const void* replica_state) {
+    ShardState* primary = (ShardState*)primary_state;
+    const ShardState* replica = (const ShardState*)replica_state;
+    primary->count += replica->count;
+    primary->keys_seen |= replica->keys_seen;
+    g_merged_count = primary->count;
+}
+
 /* =============================================================================
  * TESTS
  * ============================================================================= */
@@ -547,6 +579,682 @@ int test_registry_print(void) {
     return 0;
 }
 
+int test_traffic_stats(void) {
+    printf("\n=== Test: Traffic Stats & Export ===\n");
+
+    AgentInfo agents[2] = {
+        { .agent_id = 1, .name = "source", .state_size = sizeof(SourceState), .queue_capacity = 4 },
+        { .agent_id = 2, .name = "sink", .state_size = sizeof(SinkState), .queue_capacity = 4 }
+    };
+    SocketDef sockets[1] = {
+        { .source_agent_id = 1, .frequency_id = FREQ_DATA, .dest_agent_id = 2 }
+    };
+    NetworkTopology topology = {
+        .agents = agents, .agent_count = 2,
+        .sockets = sockets, .socket_count = 1
+    };
+
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: Could not initialize network\n");
+        return 1;
+    }
+
+    /* Split counters into 4 shards and write from shard 2 */
+    if (routing_set_stats_shards(registry->routing, 4) != SIGNAL_OK) {
+        printf("FAIL: routing_set_stats_shards failed\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    routing_set_thread_shard(2);
+
+    /* 6 sends into a 4-slot queue: 4 delivered, 2 dropped */
+    uint32_t value = 7;
+    for (int i = 0; i < 6; i++) {
+        Signal* sig = signal_create(FREQ_DATA, 1, &value, sizeof(value));
+        routing_broadcast(registry->routing, sig, NULL);
+        signal_free(sig);
+    }
+    routing_set_thread_shard(0);
+
+    RouteEdgeStats stats;
+    if (routing_get_edge_stats(registry->routing, 1, FREQ_DATA, 0, &stats) != SIGNAL_OK) {
+        printf("FAIL: Edge stats not found\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    if (stats.signals_delivered != 4 || stats.drops_queue_full != 2 ||
+        stats.bytes_delivered != 4 * sizeof(uint32_t) || stats.max_queue_depth != 4) {
+        printf("FAIL: Unexpected stats: sig=%lu drops=%lu bytes=%lu depth=%u\n",
+               stats.signals_delivered, stats.drops_queue_full,
+               stats.bytes_delivered, stats.max_queue_depth);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: 4 delivered, 2 dropped, max depth 4 (summed across shards)\n");
+
+    /* Folding shards back down keeps the counts */
+    routing_set_stats_shards(registry->routing, 1);
+    routing_get_edge_stats(registry->routing, 1, FREQ_DATA, 0, &stats);
+    if (stats.signals_delivered != 4 || stats.drops_queue_full != 2) {
+        printf("FAIL: Counts lost when re-sharding\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Counts preserved across re-sharding\n");
+
+    /* Export */
+    FrequencyRegistry* freqs = frequency_registry_create(8);
+    frequency_register(freqs, FREQ_DATA, "data", sizeof(uint32_t));
+
+    char buffer[2048];
+    FILE* out = fmemopen(buffer, sizeof(buffer), "w");
+    topology_export_dot(registry, freqs, out, 1000000000ull);
+    fclose(out);
+    if (strstr(buffer, "a1 -> a2") == NULL || strstr(buffer, "data") == NULL ||
+        strstr(buffer, "4 sig") == NULL) {
+        printf("FAIL: DOT export missing edge:\n%s\n", buffer);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: DOT export contains annotated edge\n");
+
+    out = fmemopen(buffer, sizeof(buffer), "w");
+    topology_export_json(registry, freqs, out, 1000000000ull);
+    fclose(out);
+    if (strstr(buffer, "\"signals\": 4") == NULL ||
+        strstr(buffer, "\"drops\": 2") == NULL ||
+        strstr(buffer, "\"name\": \"sink\"") == NULL) {
+        printf("FAIL: JSON export missing fields:\n%s\n", buffer);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: JSON export contains annotated edge\n");
+
+    topology_shutdown(registry);
+    printf("PASS: Traffic stats test\n");
+    return 0;
+}
+
+int test_replicas(void) {
+    printf("\n=== Test: Replicated Agents ===\n");
+
+    /* Source feeds a keyed counter (3 replicas) and a stateless stage (4) */
+    AgentInfo agents[3] = {
+        { .agent_id = 1, .name = "source", .state_size = sizeof(SourceState), .queue_capacity = 64 },
+        { .agent_id = 2, .name = "counter", .state_size = sizeof(ShardState), .queue_capacity = 64 },
+        { .agent_id = 3, .name = "stage", .state_size = sizeof(SinkState), .queue_capacity = 64 }
+    };
+    SocketDef sockets[3] = {
+        { .source_agent_id = 1, .frequency_id = FREQ_DATA, .dest_agent_id = 2 },
+        { .source_agent_id = 1, .frequency_id = FREQ_INIT, .dest_agent_id = 3 },
+        { .source_agent_id = 3, .frequency_id = FREQ_ACK, .dest_agent_id = 1 }
+    };
+    ReplicaDef replicas[2] = {
+        { .agent_id = 2, .replicas = 3, .key_offset = 0, .key_size = sizeof(uint32_t),
+          .merge = merge_shard },
+        { .agent_id = 3, .replicas = 4 }
+    };
+    NetworkTopology topology = {
+        .agents = agents, .agent_count = 3,
+        .sockets = sockets, .socket_count = 3,
+        .replicas = replicas, .replica_count = 2
+    };
+
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: Could not initialize network\n");
+        return 1;
+    }
+
+    /* Counter replicas are 4-5, stage replicas 6-8, sharing a dispatch table */
+    uint32_t counter_count, stage_count;
+    const uint32_t* counter_ids = routing_get_replicas(registry->routing, 2, &counter_count);
+    const uint32_t* stage_ids = routing_get_replicas(registry->routing, 3, &stage_count);
+    AgentInfo* replica = registry_get_agent(registry, 5);
+    if (counter_count != 3 || stage_count != 4 || counter_ids[1] != 4 || stage_ids[3] != 8 ||
+        replica == NULL || strcmp(replica->name, "counter#2") != 0 ||
+        !(replica->flags & AGENT_FLAG_REPLICA) ||
+        replica->dispatch != registry_get_dispatch(registry, 2)) {
+        printf("FAIL: Replicas not created as declared\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Replicas %s..%s registered\n", registry_get_name(registry, 4),
+           registry_get_name(registry, 5));
+
+    /* 48 keyed signals over 8 keys: each key sticks to one replica */
+    for (uint32_t i = 0; i < 48; i++) {
+        uint32_t key = i % 8;
+        Signal* sig = signal_create(FREQ_DATA, 1, &key, sizeof(key));
+        routing_broadcast(registry->routing, sig, NULL);
+        signal_free(sig);
+    }
+    DispatchTable* counter_dispatch = registry_get_dispatch(registry, 2);
+    dispatch_register(counter_dispatch, FREQ_DATA, handle_shard, NULL);
+    uint32_t keys_union = 0, total = 0;
+    for (uint32_t r = 0; r < counter_count; r++) {
+        AgentInfo* info = registry_get_agent(registry, counter_ids[r]);
+        dispatch_process_batch_with_state(counter_dispatch, info->state, info->queue, 64);
+        ShardState* state = (ShardState*)info->state;
+        if (state->keys_seen & keys_union) {
+            printf("FAIL: A key reached two replicas\n");
+            topology_shutdown(registry);
+            return 1;
+        }
+        keys_union |= state->keys_seen;
+        total += state->count;
+    }
+    if (keys_union != 0xFF || total != 48) {
+        printf("FAIL: Keys 0x%x, %u signals\n", keys_union, total);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Keyed signals sharded, one replica per key\n");
+
+    /* Stateless stage: round robin, 40 signals -> 10 per replica */
+    for (uint32_t i = 0; i < 40; i++) {
+        Signal* sig = signal_create(FREQ_INIT, 1, NULL, 0);
+        routing_broadcast(registry->routing, sig, NULL);
+        signal_free(sig);
+    }
+    for (uint32_t r = 0; r < stage_count; r++) {
+        if (signal_queue_count(registry_get_queue(registry, stage_ids[r])) != 10) {
+            printf("FAIL: Uneven round robin at replica %u\n", r);
+            topology_shutdown(registry);
+            return 1;
+        }
+    }
+    printf("PASS: Stateless signals spread round robin\n");
+
+    /* Replicas emit under their own ID along the primary's routes */
+    uint32_t dest_count;
+    uint32_t* dests = routing_lookup(registry->routing, 7, FREQ_ACK, &dest_count);
+    if (dests == NULL || dest_count != 1 || dests[0] != 1) {
+        printf("FAIL: Replica has no copy of the primary's routes\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Replica routes copied from primary\n");
+
+    /* Shutdown folds the replicas' counts into the primary */
+    g_merged_count = 0;
+    topology_shutdown(registry);
+    if (g_merged_count != 48) {
+        printf("FAIL: Merged count %u, expected 48\n", g_merged_count);
+        return 1;
+    }
+    printf("PASS: Replica state merged at shutdown\n");
+    return 0;
+}
+
+/* Ring of agents past the old 256-agent limit, plus one far-off ID */
+#define LARGE_RING      1000
+#define LARGE_SPARSE_ID 5000000
+
+int test_large_registry(void) {
+    printf("\n=== Test: Large Sparse Registry ===\n");
+
+    static AgentInfo agents[LARGE_RING + 1];
+    static SocketDef sockets[LARGE_RING + 1];
+    for (uint32_t i = 0; i < LARGE_RING; i++) {
+        agents[i] = (AgentInfo){ .agent_id = i + 1, .state_size = sizeof(SinkState),
+                                 .queue_capacity = 4 };
+        sockets[i] = (SocketDef){ i + 1, FREQ_DATA, (i + 1) % LARGE_RING + 1, 0 };
+    }
+    agents[LARGE_RING] = (AgentInfo){ .agent_id = LARGE_SPARSE_ID, .name = "far",
+                                      .state_size = sizeof(SinkState), .queue_capacity = 4 };
+    sockets[LARGE_RING] = (SocketDef){ LARGE_RING, FREQ_ACK, LARGE_SPARSE_ID, 0 };
+
+    NetworkTopology topology = {
+        .agents = agents,
+        .agent_count = LARGE_RING + 1,
+        .sockets = sockets,
+        .socket_count = LARGE_RING + 1,
+        .network_name = "large"
+    };
+
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: topology_init returned NULL\n");
+        return 1;
+    }
+    if (registry_get_count(registry) != LARGE_RING + 1) {
+        printf("FAIL: Expected %u agents, got %u\n", LARGE_RING + 1,
+               registry_get_count(registry));
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Registered %u agents\n", LARGE_RING + 1);
+
+    AgentInfo* far = registry_get_agent_by_name(registry, "far");
+    if (far == NULL || far->agent_id != LARGE_SPARSE_ID || far->queue == NULL ||
+        registry_get_agent(registry, LARGE_SPARSE_ID - 1) != NULL) {
+        printf("FAIL: Sparse agent %u not found\n", LARGE_SPARSE_ID);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Sparse agent %u found by ID and name\n", LARGE_SPARSE_ID);
+
+    /* Iteration visits every agent once, in ID order */
+    uint32_t visited = 0;
+    uint32_t last_id = 0;
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        if (agent->agent_id <= last_id) {
+            printf("FAIL: Iteration out of order at %u\n", agent->agent_id);
+            topology_shutdown(registry);
+            return 1;
+        }
+        last_id = agent->agent_id;
+        visited++;
+    }
+    if (visited != LARGE_RING + 1 || last_id != LARGE_SPARSE_ID) {
+        printf("FAIL: Iterated %u agents, last %u\n", visited, last_id);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Iterated %u agents in ID order\n", visited);
+
+    /* Every destination, including the far one, resolved to its queue */
+    RoutingTable* routing = registry->routing;
+    uint32_t resolved = 0;
+    for (uint32_t i = 0; i < routing->capacity; i++) {
+        RoutingEntry* entry = &routing->entries[i];
+        for (uint32_t d = 0; d < entry->dest_count; d++) {
+            if (entry->dest_queues == NULL || entry->dest_queues[d] !=
+                registry_get_queue(registry, entry->dest_agent_ids[d])) {
+                printf("FAIL: Route %u -> %u not resolved\n", entry->source_agent_id,
+                       entry->dest_agent_ids[d]);
+                topology_shutdown(registry);
+                return 1;
+            }
+            resolved++;
+        }
+    }
+    if (resolved != LARGE_RING + 1) {
+        printf("FAIL: Resolved %u routes, expected %u\n", resolved, LARGE_RING + 1);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: All %u routes resolved to queues\n", resolved);
+
+    topology_shutdown(registry);
+    return 0;
+}
+
+int test_state_slabs(void) {
+    printf("\n=== Test: State Slabs ===\n");
+
+    /* Two types interleaved by ID; agent 4 brings its own state */
+    static SinkState own_state;
+    AgentInfo agents[5] = {
+        { .agent_id = 1, .agent_type = 1, .state_size = sizeof(SourceState), .queue_capacity = 4 },
+        { .agent_id = 2, .agent_type = 2, .state_size = 100, .queue_capacity = 4 },
+        { .agent_id = 3, .agent_type = 1, .state_size = sizeof(SourceState), .queue_capacity = 4 },
+        { .agent_id = 4, .agent_type = 2, .state = &own_state, .state_size = 0,
+          .queue_capacity = 4 },
+        { .agent_id = 5, .agent_type = 2, .state_size = 100, .queue_capacity = 4 },
+    };
+    ReplicaDef replicas[1] = { { .agent_id = 3, .replicas = 2 } };
+    NetworkTopology topology = {
+        .agents = agents,
+        .agent_count = 5,
+        .network_name = "slabs",
+        .replicas = replicas,
+        .replica_count = 1
+    };
+
+    size_t heap_before = heap_get_used();
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: topology_init returned NULL\n");
+        return 1;
+    }
+
+    /* Same type: consecutive cache lines (replica 6 included); 100 bytes: two lines */
+    AgentInfo* a1 = registry_get_agent(registry, 1);
+    AgentInfo* a3 = registry_get_agent(registry, 3);
+    AgentInfo* a6 = registry_get_agent(registry, 6);
+    AgentInfo* a2 = registry_get_agent(registry, 2);
+    AgentInfo* a5 = registry_get_agent(registry, 5);
+    if (a1 == NULL || a3 == NULL || a6 == NULL || a2 == NULL || a5 == NULL ||
+        (uintptr_t)a1->state % AGENT_STATE_ALIGN != 0 ||
+        (char*)a3->state != (char*)a1->state + AGENT_STATE_ALIGN ||
+        (char*)a6->state != (char*)a3->state + AGENT_STATE_ALIGN ||
+        (uintptr_t)a2->state % AGENT_STATE_ALIGN != 0 ||
+        (char*)a5->state != (char*)a2->state + 2 * AGENT_STATE_ALIGN) {
+        printf("FAIL: States not laid out per type on cache lines\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    if (!(a1->flags & AGENT_FLAG_SLAB_STATE) || a1->agent_type != 1 || a6->agent_type != 1 ||
+        registry_get_agent(registry, 4)->state != &own_state) {
+        printf("FAIL: Slab flags or types wrong\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: States contiguous per type, cache-line aligned\n");
+
+    /* Hot lookups agree with the cold records */
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        if (registry_get_queue(registry, agent->agent_id) != agent->queue ||
+            registry_get_dispatch(registry, agent->agent_id) != agent->dispatch) {
+            printf("FAIL: Hot pointers differ for agent %u\n", agent->agent_id);
+            topology_shutdown(registry);
+            return 1;
+        }
+    }
+    printf("PASS: Hot queue/dispatch arrays match agent records\n");
+
+    /* Standalone states are aligned too */
+    void* state = agent_state_alloc(24);
+    if ((uintptr_t)state % AGENT_STATE_ALIGN != 0) {
+        printf("FAIL: agent_state_alloc not aligned\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    agent_state_free(state, 24);
+
+    topology_shutdown(registry);
+    if (heap_get_used() != heap_before) {
+        printf("FAIL: Shutdown left %zu bytes\n", heap_get_used() - heap_before);
+        return 1;
+    }
+    printf("PASS: Slabs freed at shutdown\n");
+    return 0;
+}
+
+int test_agent_types(void) {
+    printf("\n=== Test: Agent Types ===\n");
+
+    /* Three sinks of one type, one untyped source (the registry takes over
+     * the type's table) */
+    size_t heap_before = heap_get_used();
+    SinkState template_state = { .received = 0, .last_value = 7 };
+    DispatchTable* sink_table = dispatch_table_create(4, 0);
+    dispatch_register(sink_table, FREQ_DATA, handle_data, NULL);
+    AgentTypeDef types[1] = {
+        { .agent_type = 5, .name = "sink", .dispatch = sink_table,
+          .state_size = sizeof(SinkState), .initial_state = &template_state,
+          .queue_capacity = 8 }
+    };
+    AgentInfo agents[4] = {
+        { .agent_id = 1, .name = "source", .state_size = sizeof(SourceState) },
+        { .agent_id = 2, .agent_type = 5 },
+        { .agent_id = 3, .agent_type = 5 },
+        { .agent_id = 4, .agent_type = 5 },
+    };
+    NetworkTopology topology = {
+        .agents = agents,
+        .agent_count = 4,
+        .network_name = "typed",
+        .types = types,
+        .type_count = 1
+    };
+
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: topology_init returned NULL\n");
+        return 1;
+    }
+
+    AgentTypeDef* type = registry_get_type(registry, 5);
+    if (type == NULL || type->dispatch != sink_table || type->instance_count != 3) {
+        printf("FAIL: Type not defined with 3 instances\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    for (uint32_t id = 2; id <= 4; id++) {
+        AgentInfo* agent = registry_get_agent(registry, id);
+        SinkState* state = (SinkState*)agent->state;
+        if (agent->dispatch != sink_table || !(agent->flags & AGENT_FLAG_TYPE_DISPATCH) ||
+            agent->state_size != sizeof(SinkState) || state == NULL ||
+            state->last_value != 7 || signal_queue_capacity(agent->queue) != 8) {
+            printf("FAIL: Instance %u not built from its type\n", id);
+            topology_shutdown(registry);
+            return 1;
+        }
+    }
+    AgentInfo* source = registry_get_agent(registry, 1);
+    if (source->dispatch == sink_table || (source->flags & AGENT_FLAG_TYPE_DISPATCH)) {
+        printf("FAIL: Untyped agent should have its own table\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: 3 instances share one table and start from the template\n");
+
+    /* The shared table runs against each instance's own state */
+    uint32_t value = 99;
+    Signal* sig = signal_create(FREQ_DATA, AGENT_SOURCE, &value, sizeof(value));
+    AgentInfo* target = registry_get_agent(registry, 3);
+    dispatch_invoke_with_state(target->dispatch, target->state, sig);
+    signal_free(sig);
+    SinkState* s2 = (SinkState*)registry_get_agent(registry, 2)->state;
+    SinkState* s3 = (SinkState*)target->state;
+    if (s3->received != 1 || s3->last_value != 99 || s2->received != 0 || s2->last_value != 7) {
+        printf("FAIL: Shared handler wrote the wrong instance\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Shared handler updates only the target instance\n");
+
+    /* Instances run through the registry are profiled under their own IDs;
+     * a call that names no instance is reported as "shared" */
+    dispatch_profiling_enable(1);
+    for (uint32_t id = 2; id <= 4; id++) {
+        sig = signal_create(FREQ_DATA, AGENT_SOURCE, &value, sizeof(value));
+        signal_queue_enqueue(registry_get_queue(registry, id), sig);
+        signal_free(sig);
+    }
+    uint32_t errors = 1;
+    int processed = 0;
+    for (uint32_t id = 2; id <= 4; id++) {
+        processed += registry_process_agent(registry, id, 8, &errors);
+    }
+    sig = signal_create(FREQ_DATA, AGENT_SOURCE, &value, sizeof(value));
+    dispatch_invoke_with_state(target->dispatch, target->state, sig);
+    signal_free(sig);
+    dispatch_profiling_enable(0);
+
+    const HandlerProfile* shared_profile = dispatch_get_profile(sink_table, FREQ_DATA);
+    char report[2048];
+    FILE* out = tmpfile();
+    int rows = dispatch_profile_report(out, 0);
+    rewind(out);
+    report[fread(report, 1, sizeof(report) - 1, out)] = '\0';
+    fclose(out);
+    if (processed != 3 || errors != 0 || rows != 4 || strstr(report, "shared") == NULL ||
+        shared_profile == NULL || shared_profile->invocations != 1) {
+        printf("FAIL: Type table profiles (%d processed, %d rows)\n", processed, rows);
+        topology_shutdown(registry);
+        return 1;
+    }
+    for (uint32_t id = 2; id <= 4; id++) {
+        const HandlerProfile* p = dispatch_get_agent_profile(sink_table, id, FREQ_DATA);
+        if (p == NULL || p->invocations != 1) {
+            printf("FAIL: Instance %u not profiled under its own ID\n", id);
+            topology_shutdown(registry);
+            return 1;
+        }
+    }
+    printf("PASS: Instances profiled per ID, table-only calls reported as shared\n");
+
+    if (registry_define_type(registry, &types[0]) != TOPOLOGY_ERR_TYPE_EXISTS) {
+        printf("FAIL: Redefining a type should fail\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+
+    /* The registry keeps its own copy of the template */
+    template_state.last_value = 123;
+    AgentInfo late = { .agent_id = 6, .agent_type = 5 };
+    if (topology_init_agent(registry, &late) != TOPOLOGY_OK ||
+        registry_get_type(registry, 5)->initial_state == &template_state ||
+        ((SinkState*)registry_get_agent(registry, 6)->state)->last_value != 7) {
+        printf("FAIL: Type template should be copied at definition\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Template copied; later instances ignore the caller's changes\n");
+
+    topology_shutdown(registry);
+    if (heap_get_used() != heap_before) {
+        printf("FAIL: Shutdown left %zu bytes\n", heap_get_used() - heap_before);
+        return 1;
+    }
+    printf("PASS: Type table freed once at shutdown\n");
+    return 0;
+}
+
+#define LAZY_AGENTS     20000
+#define LAZY_SPARSE_ID  3000000
+
+int test_lazy_materialization(void) {
+    printf("\n=== Test: Lazy Materialization ===\n");
+
+    /* A typed ring of 20k sinks plus one untyped far agent; agent 3 is
+     * replicated (stays eager) */
+    size_t heap_before = heap_get_used();
+    SignalQueue* probe = signal_queue_create(256);
+    size_t queue_bytes = heap_get_used() - heap_before;
+    signal_queue_destroy(probe);
+
+    SinkState template_state = { .received = 0, .last_value = 7 };
+    DispatchTable* sink_table = dispatch_table_create(4, 0);
+    dispatch_register(sink_table, FREQ_DATA, handle_data, NULL);
+    AgentTypeDef types[1] = {
+        { .agent_type = 5, .name = "sink", .dispatch = sink_table,
+          .state_size = sizeof(SinkState), .initial_state = &template_state }
+    };
+    static AgentInfo agents[LAZY_AGENTS + 1];
+    static SocketDef sockets[LAZY_AGENTS + 1];
+    for (uint32_t i = 0; i < LAZY_AGENTS; i++) {
+        agents[i] = (AgentInfo){ .agent_id = i + 1, .agent_type = 5 };
+        sockets[i] = (SocketDef){ i + 1, FREQ_DATA, (i + 1) % LAZY_AGENTS + 1, 0 };
+    }
+    agents[LAZY_AGENTS] = (AgentInfo){ .agent_id = LAZY_SPARSE_ID, .name = "far",
+                                       .state_size = sizeof(SinkState) };
+    sockets[LAZY_AGENTS] = (SocketDef){ 1, FREQ_ACK, LAZY_SPARSE_ID, 0 };
+    ReplicaDef replicas[1] = { { .agent_id = 3, .replicas = 2 } };
+
+    NetworkTopology topology = {
+        .agents = agents,
+        .agent_count = LAZY_AGENTS + 1,
+        .sockets = sockets,
+        .socket_count = LAZY_AGENTS + 1,
+        .network_name = "lazy",
+        .flags = TOPOLOGY_FLAG_LAZY,
+        .replicas = replicas,
+        .replica_count = 1,
+        .types = types,
+        .type_count = 1
+    };
+
+    AgentRegistry2* registry = topology_init(&topology);
+    if (registry == NULL) {
+        printf("FAIL: topology_init returned NULL\n");
+        return 1;
+    }
+    size_t heap_init_bytes = heap_get_used() - heap_before;
+    if (registry_get_count(registry) != LAZY_AGENTS + 2 ||
+        registry->dormant_count != LAZY_AGENTS) {
+        printf("FAIL: Expected %u agents (%u dormant), got %u (%u)\n", LAZY_AGENTS + 2,
+               LAZY_AGENTS, registry_get_count(registry), registry->dormant_count);
+        topology_shutdown(registry);
+        return 1;
+    }
+    if (heap_init_bytes >= (size_t)LAZY_AGENTS * queue_bytes / 4) {
+        printf("FAIL: Startup used %zu bytes\n", heap_init_bytes);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: %u agents registered dormant in %zu KB\n", LAZY_AGENTS,
+           heap_init_bytes / 1024);
+
+    AgentInfo* sink = registry_get_agent(registry, 2);
+    AgentInfo* replicated = registry_get_agent(registry, 3);
+    if (!(sink->flags & AGENT_FLAG_DORMANT) || sink->state != NULL ||
+        registry_get_queue(registry, 2) != NULL || registry_get_dispatch(registry, 2) != NULL ||
+        sink->queue_capacity != 256 || (replicated->flags & AGENT_FLAG_DORMANT) ||
+        replicated->queue == NULL || registry_get_agent(registry, LAZY_SPARSE_ID + 1) == NULL) {
+        printf("FAIL: Dormant or replicated agent set up wrong\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Dormant agents have no queue; replicated agent is eager\n");
+
+    /* First delivery materializes the destination only */
+    uint32_t value = 99;
+    for (int i = 0; i < 2; i++) {
+        Signal* sig = signal_create(FREQ_DATA, 1, &value, sizeof(value));
+        routing_broadcast(registry->routing, sig, NULL);
+        signal_free(sig);
+    }
+    Signal* ack = signal_create(FREQ_ACK, 1, &value, sizeof(value));
+    routing_broadcast(registry->routing, ack, NULL);
+    signal_free(ack);
+
+    SinkState* state = (SinkState*)sink->state;
+    if ((sink->flags & AGENT_FLAG_DORMANT) || !(sink->flags & AGENT_FLAG_TYPE_DISPATCH) ||
+        !(sink->flags & AGENT_FLAG_HAS_HANDLERS) || sink->dispatch != sink_table || registry_get_dispatch(registry, 2) != sink_table ||
+        registry_get_queue(registry, 2) != sink->queue ||
+        signal_queue_count(sink->queue) != 2 || signal_queue_capacity(sink->queue) != 256 ||
+        state == NULL || state->last_value != 7) {
+        printf("FAIL: Sink not materialized from its type\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    AgentInfo* far = registry_get_agent_by_name(registry, "far");
+    if (far->queue == NULL || signal_queue_count(far->queue) != 1 || far->dispatch == NULL ||
+        (far->flags & (AGENT_FLAG_DORMANT | AGENT_FLAG_TYPE_DISPATCH |
+                       AGENT_FLAG_HAS_HANDLERS)) ||
+        far->state == NULL) {
+        printf("FAIL: Untyped agent not materialized with its own (empty) table\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    uint32_t materialized = 0;
+    for (AgentInfo* agent = registry_next(registry, NULL); agent != NULL;
+         agent = registry_next(registry, agent)) {
+        materialized += (agent->queue != NULL);
+    }
+    if (materialized != 4 || registry->dormant_count != LAZY_AGENTS - 2) {
+        printf("FAIL: %u agents materialized, %u dormant\n", materialized,
+               registry->dormant_count);
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Deliveries materialized 2 agents, cached for the next\n");
+
+    /* The shared table runs against the new state */
+    Signal* received = signal_queue_dequeue(sink->queue);
+    dispatch_invoke_with_state(sink->dispatch, sink->state, received);
+    signal_free(received);
+    if (state->received != 1 || state->last_value != 99) {
+        printf("FAIL: Handler did not update the materialized state\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    if (registry_materialize(registry, 2) != TOPOLOGY_OK ||
+        registry_materialize(registry, LAZY_SPARSE_ID - 1) != TOPOLOGY_ERR_AGENT_NOT_FOUND ||
+        sink->state != state) {
+        printf("FAIL: registry_materialize on live or missing agents\n");
+        topology_shutdown(registry);
+        return 1;
+    }
+    printf("PASS: Materialized agent handles its signals\n");
+
+    topology_shutdown(registry);
+    if (heap_get_used() != heap_before) {
+        printf("FAIL: Shutdown left %zu bytes\n", heap_get_used() - heap_before);
+        return 1;
+    }
+    printf("PASS: Dormant and materialized agents freed at shutdown\n");
+    return 0;
+}
+
 /* =============================================================================
  * MAIN
  * ============================================================================= */
@@ -566,6 +1274,12 @@ int main(void) {
     failures += test_end_to_end();
     failures += test_frequency_registry();
     failures += test_registry_print();
+    failures += test_traffic_stats();
+    failures += test_replicas();
+    failures += test_large_registry();
+    failures += test_state_slabs();
+    failures += test_agent_types();
+    failures += test_lazy_materialization();
 
     printf("\n==========================================\n");
     if (failures == 0) {